@@ -234,6 +234,14 @@ check_c_source_compiles("
      return 0;
   }" AK_HAVE_BYTESWAP_H )
 
+# -------------------------------------------------------------------------------------------------- #
+check_c_source_compiles("
+  #include <sys/random.h>
+  int main( void ) {
+     char buffer[16];
+     return ( int )getrandom( buffer, sizeof( buffer ), 0 ) < 0;
+  }" AK_HAVE_SYSRANDOM_H )
+
 # -------------------------------------------------------------------------------------------------- #
 if( LIBAKRYPT_PTHREAD )
   check_c_source_compiles("
@@ -20,15 +20,21 @@ if( AK_HAVE_BUILTIN_MULQ_GCC )
 endif()
 
 # -------------------------------------------------------------------------------------------------- #
+# команда pclmulqdq компилируется с помощью атрибута target и без флагов -mpclmul или -march;
+# решение об ее использовании принимается во время выполнения, после проверки возможностей процессора
 # -------------------------------------------------------------------------------------------------- #
 check_c_source_compiles("
   #include <wmmintrin.h>
-  int main( void ) {
+  #if defined( __GNUC__ )
+   __attribute__(( target( \"pclmul,sse2\" )))
+  #endif
+  static __m128i clmul( __m128i a, __m128i b ) { return _mm_clmulepi64_si128( a, b, 0x00 ); }
 
-   __m128i a, b, c;
-   c = _mm_clmulepi64_si128( a, b, 0x00 );
+  int main( void ) {
+   __m128i a = _mm_set_epi64x( 0, 3 ), b = _mm_set_epi64x( 0, 5 ), c;
+   c = clmul( a, b );
 
-  return 0;
+  return ( int )_mm_cvtsi128_si32( c );
  }" AK_HAVE_BUILTIN_CLMULEPI64 )
 
 if( AK_HAVE_BUILTIN_CLMULEPI64 )
@@ -53,3 +59,26 @@ check_c_source_compiles("
 if( AK_HAVE_BUILTIN_MM256_SLL )
     set( CMAKE_C_FLAGS "${CMAKE_C_FLAGS} -DAK_HAVE_BUILTIN_MM256_SLL" )
 endif()
+
+# -------------------------------------------------------------------------------------------------- #
+# команды mulx, adcx и adox (наборы BMI2 и ADX) используются при умножении вычетов
+# в представлении Монтгомери; код компилируется всегда, когда их поддерживает ассемблер,
+# а используется только на процессорах, поддерживающих оба набора команд
+# -------------------------------------------------------------------------------------------------- #
+check_c_source_compiles("
+  #include <sys/types.h>
+  int main( void ) {
+    #if defined( __x86_64__ ) && defined( __GNUC__ )
+      u_int64_t t = 1, a = 2, b[1] = { 3 };
+      __asm__ volatile (
+        \"xorl %%ecx, %%ecx; mulxq 0(%[b]), %%r8, %%r9; adcxq %%r8, %[t]; adoxq %%r9, %[t]\"
+        : [t] \"+r\" (t) : [b] \"r\" (b), \"d\" (a) : \"rcx\", \"r8\", \"r9\", \"cc\" );
+      return ( int )t;
+    #else
+      #error Unsupported architecture
+    #endif
+  }" AK_HAVE_BUILTIN_MULX_ADX )
+
+if( AK_HAVE_BUILTIN_MULX_ADX )
+    set( CMAKE_C_FLAGS "${CMAKE_C_FLAGS} -DAK_HAVE_BUILTIN_MULX_ADX" )
+endif()
@@ -95,6 +95,7 @@ else()
 
   else()
     if( LIBAKRYPT_PTHREAD )
+      set( LIBAKRYPT_LIBS ${LIBAKRYPT_LIBS} pthread )
       set( CMAKE_C_FLAGS "${CMAKE_C_FLAGS} -DAK_HAVE_PTHREAD_H" )
     endif()
   endif()
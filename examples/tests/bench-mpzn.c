@@ -0,0 +1,269 @@
+/* ----------------------------------------------------------------------------------------------- */
+/* Сравнение скорости арифметики вычетов libakrypt и функций библиотеки GMP.
+
+   Для модулей 256 и 512 бит измеряется количество тактов процессора (на платформах,
+   отличных от x86, - количество наносекунд), затрачиваемых на выполнение одной операции.
+   Результаты выводятся в виде таблицы и, если задано имя файла, сохраняются в формате csv:
+
+     bench-mpzn [report.csv]                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <time.h>
+ #include <libakrypt.h>
+ #include <gmp.h>
+#if defined( __GNUC__ ) && ( defined( __x86_64__ ) || defined( __i386__ ))
+ #include <x86intrin.h>
+ #define bench_unit "cycles"
+#else
+ #define bench_unit "ns"
+#endif
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! количество повторений измерения, из которых выбирается наименьшее значение */
+ #define bench_rounds (5)
+
+/* ----------------------------------------------------------------------------------------------- */
+/* операнды, общие для всех измеряемых операций */
+ typedef struct bench_context {
+  size_t size;
+  ak_wcurve wc;
+  ak_mpznmax x, y, z, w, e;
+  mp_limb_t gx[ak_mpznmax_size], gy[ak_mpznmax_size], gz[ak_mpznmax_size],
+            gw[ak_mpznmax_size], gq[ak_mpznmax_size], gp[ak_mpznmax_size];
+  mpz_t mx, mz, me, mp;
+  ak_uint64 sink;
+} *bench_context;
+
+ typedef void ( bench_function )( bench_context , size_t );
+
+/* ----------------------------------------------------------------------------------------------- */
+ static ak_uint64 bench_counter( void )
+{
+#if defined( __GNUC__ ) && ( defined( __x86_64__ ) || defined( __i386__ ))
+  return __rdtsc();
+#else
+  struct timespec ts;
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+ return ( ak_uint64 )ts.tv_sec*1000000000ull + ( ak_uint64 )ts.tv_nsec;
+#endif
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*                                       функции libakrypt                                         */
+/* ----------------------------------------------------------------------------------------------- */
+ static void mpzn_add( bench_context bx, size_t count )
+{
+  while( count-- ) ak_mpzn_add( bx->x, bx->x, bx->y, bx->size );
+}
+
+ static void mpzn_sub( bench_context bx, size_t count )
+{
+  while( count-- ) ak_mpzn_sub( bx->x, bx->x, bx->y, bx->size );
+}
+
+ static void mpzn_mul( bench_context bx, size_t count )
+{
+  while( count-- ) { ak_mpzn_mul( bx->w, bx->x, bx->y, bx->size ); bx->x[0] ^= bx->w[0]; }
+}
+
+ static void mpzn_mul_montgomery( bench_context bx, size_t count )
+{
+  while( count-- )
+    ak_mpzn_mul_montgomery( bx->x, bx->x, bx->y, bx->wc->p, bx->wc->n, bx->size );
+}
+
+ static void mpzn_sqr_montgomery( bench_context bx, size_t count )
+{
+  while( count-- ) ak_mpzn_sqr_montgomery( bx->x, bx->x, bx->wc->p, bx->wc->n, bx->size );
+}
+
+ static void mpzn_modpow( bench_context bx, size_t count )
+{
+  while( count-- )
+    ak_mpzn_modpow_montgomery( bx->x, bx->x, bx->e, bx->wc->p, bx->wc->n, bx->size );
+}
+
+ static void mpzn_rem( bench_context bx, size_t count )
+{
+  while( count-- ) {
+    ak_mpzn_rem_barrett( bx->z, bx->w, bx->wc->p, bx->wc->mu, bx->size );
+    bx->w[0] ^= bx->z[0];
+  }
+}
+
+ static void mpzn_rem_uint32( bench_context bx, size_t count )
+{
+  while( count-- ) bx->sink += ak_mpzn_rem_uint32( bx->x, bx->size, 0xfffffffb );
+}
+
+ static void mpzn_inverse( bench_context bx, size_t count )
+{
+  while( count-- ) ak_mpzn_inverse( bx->x, bx->x, bx->wc->p, bx->size );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*                                          функции GMP                                            */
+/* ----------------------------------------------------------------------------------------------- */
+ static void gmp_add( bench_context bx, size_t count )
+{
+  while( count-- ) mpn_add_n( bx->gx, bx->gx, bx->gy, bx->size );
+}
+
+ static void gmp_sub( bench_context bx, size_t count )
+{
+  while( count-- ) mpn_sub_n( bx->gx, bx->gx, bx->gy, bx->size );
+}
+
+ static void gmp_mul( bench_context bx, size_t count )
+{
+  while( count-- ) { mpn_mul_n( bx->gw, bx->gx, bx->gy, bx->size ); bx->gx[0] ^= bx->gw[0]; }
+}
+
+ static void gmp_mul_modulo( bench_context bx, size_t count )
+{
+  while( count-- ) {
+    mpn_mul_n( bx->gw, bx->gx, bx->gy, bx->size );
+    mpn_tdiv_qr( bx->gq, bx->gx, 0, bx->gw, 2*bx->size, bx->gp, bx->size );
+  }
+}
+
+ static void gmp_sqr_modulo( bench_context bx, size_t count )
+{
+  while( count-- ) {
+    mpn_sqr( bx->gw, bx->gx, bx->size );
+    mpn_tdiv_qr( bx->gq, bx->gx, 0, bx->gw, 2*bx->size, bx->gp, bx->size );
+  }
+}
+
+ static void gmp_modpow( bench_context bx, size_t count )
+{
+  while( count-- ) mpz_powm_sec( bx->mx, bx->mx, bx->me, bx->mp );
+}
+
+ static void gmp_rem( bench_context bx, size_t count )
+{
+  while( count-- ) {
+    mpn_tdiv_qr( bx->gq, bx->gz, 0, bx->gw, 2*bx->size, bx->gp, bx->size );
+    bx->gw[0] ^= bx->gz[0];
+  }
+}
+
+ static void gmp_rem_uint32( bench_context bx, size_t count )
+{
+  while( count-- ) bx->sink += mpn_mod_1( bx->gx, bx->size, 0xfffffffb );
+}
+
+ static void gmp_inverse( bench_context bx, size_t count )
+{
+  while( count-- ) mpz_invert( bx->mx, bx->mx, bx->mp );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+ static struct bench_operation {
+  const char *name;
+  bench_function *mpzn;
+  bench_function *gmp;
+  size_t count;
+} operations[] = {
+  { "add",              mpzn_add,            gmp_add,         1000000 },
+  { "sub",              mpzn_sub,            gmp_sub,         1000000 },
+  { "mul",              mpzn_mul,            gmp_mul,          500000 },
+  { "mul_montgomery",   mpzn_mul_montgomery, gmp_mul_modulo,   500000 },
+  { "sqr_montgomery",   mpzn_sqr_montgomery, gmp_sqr_modulo,   500000 },
+  { "modpow",           mpzn_modpow,         gmp_modpow,          500 },
+  { "rem",              mpzn_rem,            gmp_rem,          500000 },
+  { "rem_uint32",       mpzn_rem_uint32,     gmp_rem_uint32,   500000 },
+  { "inverse",          mpzn_inverse,        gmp_inverse,       20000 },
+  { NULL, NULL, NULL, 0 }
+};
+
+/* ----------------------------------------------------------------------------------------------- */
+/* наименьшее среди bench_rounds измерений значение тактов на одну операцию */
+ static double bench_measure( bench_function *func, bench_context bx, size_t count )
+{
+  size_t i = 0;
+  double best = 0;
+
+  func( bx, count/10 +1 ); /* прогрев */
+  for( i = 0; i < bench_rounds; i++ ) {
+     ak_uint64 start = bench_counter();
+     func( bx, count );
+     double value = ( double )( bench_counter() - start )/( double )count;
+     if(( i == 0 ) || ( value < best )) best = value;
+  }
+ return best;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+ static void bench_context_set( bench_context bx, ak_wcurve wc, ak_random generator )
+{
+  bx->wc = wc;
+  bx->size = wc->size;
+  ak_mpzn_set_random_modulo( bx->x, wc->p, wc->size, generator );
+  ak_mpzn_set_random_modulo( bx->y, wc->p, wc->size, generator );
+  ak_mpzn_set_random( bx->w, 2*wc->size, generator );
+  ak_mpzn_set_ui( bx->e, wc->size, 2 );
+  ak_mpzn_sub( bx->e, wc->p, bx->e, wc->size );
+
+  memcpy( bx->gx, bx->x, sizeof( bx->gx ));
+  memcpy( bx->gy, bx->y, sizeof( bx->gy ));
+  memcpy( bx->gw, bx->w, sizeof( bx->gw ));
+  memcpy( bx->gp, wc->p, wc->size*sizeof( ak_uint64 ));
+  ak_mpzn_to_mpz( bx->x, wc->size, bx->mx );
+  ak_mpzn_to_mpz( bx->e, wc->size, bx->me );
+  ak_mpzn_to_mpz( wc->p, wc->size, bx->mp );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+ int main( int argc, char *argv[] )
+{
+  size_t i = 0, j = 0;
+  FILE *report = NULL;
+  struct random generator;
+  struct bench_context bx;
+  ak_wcurve curves[] = {
+    ( ak_wcurve ) &id_tc26_gost_3410_2012_256_paramSetB,
+    ( ak_wcurve ) &id_tc26_gost_3410_2012_512_paramSetB
+  };
+
+  if( sizeof( mp_limb_t ) != sizeof( ak_uint64 )) {
+    printf("gmp limb size is not equal to 64 bits, benchmark is not supported\n");
+    return EXIT_SUCCESS;
+  }
+  if(( argc > 1 ) && (( report = fopen( argv[1], "w" )) == NULL )) {
+    printf("unable to create report file %s\n", argv[1] );
+    return EXIT_FAILURE;
+  }
+
+  ak_libakrypt_create( ak_function_log_stderr );
+  ak_random_create_lcg( &generator );
+  memset( &bx, 0, sizeof( struct bench_context ));
+  mpz_init( bx.mx ); mpz_init( bx.mz ); mpz_init( bx.me ); mpz_init( bx.mp );
+
+  if( report ) fprintf( report, "operation,bits,mpzn,gmp,unit\n" );
+  printf("%-16s %5s %12s %12s %8s\n", "operation", "bits", "mpzn", "gmp", "ratio" );
+  for( j = 0; j < sizeof( curves )/sizeof( ak_wcurve ); j++ ) {
+     for( i = 0; operations[i].name != NULL; i++ ) {
+        double tm, tg;
+
+        bench_context_set( &bx, curves[j], &generator );
+        tm = bench_measure( operations[i].mpzn, &bx, operations[i].count );
+        tg = bench_measure( operations[i].gmp, &bx, operations[i].count );
+        printf("%-16s %5u %12.1f %12.1f %8.2f\n", operations[i].name,
+                       (unsigned int)( 64*curves[j]->size ), tm, tg, tg > 0 ? tm/tg : 0 );
+        if( report ) fprintf( report, "%s,%u,%.1f,%.1f,%s\n", operations[i].name,
+                                 (unsigned int)( 64*curves[j]->size ), tm, tg, bench_unit );
+     }
+  }
+  printf("values are measured in %s per operation (sink: %llu)\n",
+                                               bench_unit, (unsigned long long int)bx.sink );
+
+  mpz_clear( bx.mp ); mpz_clear( bx.me ); mpz_clear( bx.mz ); mpz_clear( bx.mx );
+  ak_random_destroy( &generator );
+  ak_libakrypt_destroy();
+  if( report ) fclose( report );
+
+ return EXIT_SUCCESS;
+}
@@ -0,0 +1,79 @@
+/* ----------------------------------------------------------------------------------------------- */
+/* Тест проверяет режим гаммирования с преобразованием ключа ACPKM: кроме контрольного примера
+   из Р 1323565.1.017—2018 проверяется, что каждая секция зашифровывается в режиме гаммирования
+   на ключе, полученном соответствующим количеством вызовов ak_bckey_next_acpkm_key().
+
+   test-acpkm01.c                                                                                  */
+/* ----------------------------------------------------------------------------------------------- */
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <libakrypt.h>
+ #include <libakrypt-internal.h>
+
+/* ----------------------------------------------------------------------------------------------- */
+ #define sections_count  (5)
+ #define section_blocks  (2)
+
+/* ----------------------------------------------------------------------------------------------- */
+ static bool_t check_sections( const char *name )
+{
+  size_t i = 0, section = 0, size = 0;
+  bool_t result = ak_false;
+  struct bckey key, nkey;
+  ak_uint8 iv[8] = { 0xf0, 0xce, 0xab, 0x90, 0x78, 0x56, 0x34, 0x12 };
+  ak_uint8 skey[32], in[sections_count*section_blocks*16 +16],
+                    out[sizeof( in )], expected[sizeof( in )];
+
+  for( i = 0; i < sizeof( skey ); i++ ) skey[i] = ( ak_uint8 )( 7*i +1 );
+  for( i = 0; i < sizeof( in ); i++ ) in[i] = ( ak_uint8 )( 3*i +5 );
+
+  if( ak_bckey_create_oid( &key, ak_oid_find_by_name( name )) != ak_error_ok ) return ak_false;
+  if( ak_bckey_set_key( &key, skey, sizeof( skey )) != ak_error_ok ) goto ex;
+  if( ak_bckey_create_and_set_bckey( &nkey, &key ) != ak_error_ok ) goto ex;
+
+ /* длина сообщения не кратна длине секции: последний фрагмент состоит из одного блока */
+  section = section_blocks*key.bsize;
+  size = sections_count*section +key.bsize;
+  if( ak_bckey_ctr_acpkm( &key, in, out, size, section, iv, key.bsize >> 1 ) != ak_error_ok )
+    goto ex2;
+
+ /* каждая секция (и последний фрагмент) зашифровывается на очередном производном ключе */
+  for( i = 0; i <= sections_count; i++ ) {
+     if( ak_bckey_ctr( &nkey, in, expected, size, iv, nkey.bsize >> 1 ) != ak_error_ok ) goto ex2;
+     if( !ak_ptr_is_equal( out +i*section, expected +i*section,
+                                                ak_min( section, size -i*section ))) {
+       printf("%s: section %u is wrong\n", name, (unsigned int) i );
+       goto ex2;
+     }
+     if( ak_bckey_next_acpkm_key( &nkey ) != ak_error_ok ) goto ex2;
+  }
+  printf("%s: %u sections: Ok\n", name, (unsigned int) sections_count );
+  result = ak_true;
+
+  ex2:
+   ak_bckey_destroy( &nkey );
+  ex:
+   ak_bckey_destroy( &key );
+ return result;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+ int main( void )
+{
+  int exitcode = EXIT_FAILURE;
+
+  ak_libakrypt_create( ak_function_log_stderr );
+
+ /* контрольные примеры из рекомендаций по стандартизации */
+  if( ak_libakrypt_test_acpkm() != ak_true ) goto ex;
+  printf("acpkm test vectors: Ok\n");
+
+  if( !check_sections( "magma" )) goto ex;
+  if( !check_sections( "kuznechik" )) goto ex;
+  exitcode = EXIT_SUCCESS;
+
+  ex:
+   ak_libakrypt_destroy();
+ return exitcode;
+}
@@ -0,0 +1,148 @@
+/* ----------------------------------------------------------------------------------------------- */
+/* Тест проверяет совпадение ключей абонентов схемы Блома, выработанных пакетно с использованием
+   нескольких потоков, с ключами, выработанными последовательно, а также экспорт ключей в файлы    */
+/* ----------------------------------------------------------------------------------------------- */
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <libakrypt.h>
+
+/* ----------------------------------------------------------------------------------------------- */
+ #define abonents_count (21)
+
+ static char *password = "password";
+
+/* ----------------------------------------------------------------------------------------------- */
+/* сравнение двух ключей абонентов */
+ static bool_t is_equal_keys( ak_blomkey one, ak_blomkey two )
+{
+  if(( one->size != two->size ) || ( one->count != two->count )) return ak_false;
+  if( !ak_ptr_is_equal( one->icode, two->icode, 32 )) return ak_false;
+ return ak_ptr_is_equal( one->data, two->data, one->size*one->count );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+ static bool_t check_batch( ak_blomkey matrix, ak_blomkey expected, size_t threads )
+{
+  size_t i = 0;
+  bool_t result = ak_false;
+  struct blomkey keys[abonents_count], imported;
+  struct blomkey_batch_item items[abonents_count];
+  char ids[abonents_count][32], files[abonents_count][128];
+
+  memset( items, 0, sizeof( items ));
+  for( i = 0; i < abonents_count; i++ ) {
+     ak_snprintf( ids[i], sizeof( ids[i] ), "abonent-%u", (unsigned int) i );
+     items[i].id = ids[i];
+     items[i].idsize = strlen( ids[i] );
+     items[i].error = ak_error_ok;
+    /* ключи с номерами i = 1 (mod 4) только экспортируются в файлы, остальные ключи
+       сохраняются в контекстах, а ключи с номерами i = 0 (mod 3) - еще и экспортируются */
+     if( i%4 != 1 ) items[i].key = keys +i;
+     if(( i%3 == 0 ) || ( i%4 == 1 )) {
+       items[i].password = password;
+       items[i].pass_size = strlen( password );
+       items[i].filename = files[i];
+       items[i].fsize = sizeof( files[i] );
+     }
+  }
+ /* для одного абонента не задан ни контекст ключа, ни файл */
+  items[13].key = NULL;
+  items[13].filename = NULL;
+
+  if( ak_blomkey_create_abonent_keys( matrix, items,
+                                              abonents_count, threads ) != ak_error_null_pointer ) {
+    printf("unexpected result of batch generation\n");
+    return ak_false;
+  }
+
+  for( i = 0; i < abonents_count; i++ ) {
+     if( i == 13 ) {
+       if( items[i].error != ak_error_null_pointer ) goto ex;
+       continue;
+     }
+     if( items[i].error != ak_error_ok ) {
+       printf("abonent %u: error %d\n", (unsigned int) i, items[i].error );
+       goto ex;
+     }
+     if(( items[i].key != NULL ) && !is_equal_keys( items[i].key, expected +i )) {
+       printf("abonent %u: batch key is wrong\n", (unsigned int) i );
+       goto ex;
+     }
+     if( items[i].filename != NULL ) {
+       if( ak_blomkey_import_from_file_with_password( &imported,
+                                      password, strlen( password ), files[i] ) != ak_error_ok ) {
+         printf("abonent %u: import from %s is wrong\n", (unsigned int) i, files[i] );
+         goto ex;
+       }
+       result = is_equal_keys( &imported, expected +i );
+       ak_blomkey_destroy( &imported );
+       if( !result ) {
+         printf("abonent %u: exported key is wrong\n", (unsigned int) i );
+         goto ex;
+       }
+       result = ak_false;
+     }
+  }
+  result = ak_true;
+  printf("[size: %u, field: GF(2^%u)] threads: %u, abonents: %u, Ok\n",
+                  matrix->size, matrix->count << 3, (unsigned int) threads, abonents_count );
+
+  ex:
+   for( i = 0; i < abonents_count; i++ ) {
+      if(( items[i].key != NULL ) && ( items[i].error == ak_error_ok ))
+        ak_blomkey_destroy( items[i].key );
+      if(( items[i].filename != NULL ) && ( items[i].error == ak_error_ok ))
+        remove( items[i].filename );
+   }
+ return result;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+ static bool_t check_matrix( const ak_uint32 size, const ak_uint32 count, ak_random generator )
+{
+  size_t i = 0, j = 0, threads[] = { 1, 4, 0 };
+  bool_t result = ak_false;
+  struct blomkey matrix, expected[abonents_count];
+  char id[32];
+
+  if( ak_blomkey_create_matrix( &matrix, size, count, generator ) != ak_error_ok ) return ak_false;
+  for( i = 0; i < abonents_count; i++ ) {
+     ak_snprintf( id, sizeof( id ), "abonent-%u", (unsigned int) i );
+     if( ak_blomkey_create_abonent_key( expected +i, &matrix, id, strlen( id )) != ak_error_ok ) {
+       while( i > 0 ) ak_blomkey_destroy( expected + --i );
+       goto ex;
+     }
+  }
+
+  for( j = 0; j < sizeof( threads )/sizeof( size_t ); j++ )
+     if( !check_batch( &matrix, expected, threads[j] )) goto ex2;
+  result = ak_true;
+
+  ex2:
+   for( i = 0; i < abonents_count; i++ ) ak_blomkey_destroy( expected +i );
+  ex:
+   ak_blomkey_destroy( &matrix );
+ return result;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+ int main( void )
+{
+  struct random generator;
+  ak_uint32 seed = 1104;
+  int exitcode = EXIT_FAILURE;
+
+  ak_libakrypt_create( ak_function_log_stderr );
+  ak_random_create_lcg( &generator );
+  ak_random_randomize( &generator, &seed, sizeof( seed ));
+
+  if( !check_matrix( 100, ak_galois256_size, &generator )) goto ex;
+  if( !check_matrix( 37, ak_galois512_size, &generator )) goto ex;
+  exitcode = EXIT_SUCCESS;
+
+  ex:
+   ak_random_destroy( &generator );
+   ak_libakrypt_destroy();
+ return exitcode;
+}
@@ -0,0 +1,211 @@
+/* ----------------------------------------------------------------------------------------------- */
+/* Тест проверяет кэш ключей парной связи схемы Блома: ключи, полученные из кэша, должны
+   совпадать с ключами, вычисленными без кэша, а вытеснение - соответствовать заданному правилу   */
+/* ----------------------------------------------------------------------------------------------- */
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <libakrypt.h>
+ #ifdef AK_HAVE_PTHREAD_H
+  #include <pthread.h>
+ #endif
+
+/* ----------------------------------------------------------------------------------------------- */
+ #define peers_count    (40)
+ #define cache_capacity  (8)
+ #define threads_count   (4)
+
+ static char *ID = "Mr. Eric Arthur Blair known as George Orwell";
+
+/* ----------------------------------------------------------------------------------------------- */
+/* выработка ключа парной связи и сравнение с ключом, вычисленным без кэша */
+ static bool_t check_peer( ak_blomkey abonent, ak_uint8 expected[][64], const size_t peer )
+{
+  char id[32];
+  ak_uint8 key[64];
+
+  ak_snprintf( id, sizeof( id ), "peer-%u", (unsigned int) peer );
+  if( ak_blomkey_create_pairwise_key_as_ptr( abonent, id, strlen( id ),
+                                                          key, sizeof( key )) != ak_error_ok ) {
+    printf("peer %u: incorrect generation of pairwise key\n", (unsigned int) peer );
+    return ak_false;
+  }
+  if( !ak_ptr_is_equal( key, expected[peer], abonent->count )) {
+    printf("peer %u: pairwise key is wrong\n", (unsigned int) peer );
+    return ak_false;
+  }
+ return ak_true;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/* проверка значений счетчиков кэша */
+ static bool_t check_stat( ak_blomkey abonent, size_t count, size_t hits, size_t misses )
+{
+  size_t c = 0, h = 0, m = 0;
+
+  if( ak_blomkey_cache_get_stat( abonent, &c, &h, &m ) != ak_error_ok ) return ak_false;
+  if(( c != count ) || ( h != hits ) || ( m != misses )) {
+    printf("unexpected cache statistics: count %u, hits %u, misses %u\n",
+                                          (unsigned int) c, (unsigned int) h, (unsigned int) m );
+    return ak_false;
+  }
+ return ak_true;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+ static bool_t check_policy( ak_blomkey abonent, ak_uint8 expected[][64], blom_cache_t policy,
+                                                                            ak_random generator )
+{
+  size_t i = 0, peer = 0, count = 0, hits = 0, misses = 0;
+
+  if( ak_blomkey_cache_create( abonent, cache_capacity, policy ) != ak_error_ok ) return ak_false;
+
+ /* заполняем кэш и обращаемся к первому помещенному ключу */
+  for( i = 0; i < cache_capacity; i++ ) if( !check_peer( abonent, expected, i )) return ak_false;
+  if( !check_peer( abonent, expected, 0 )) return ak_false;
+  if( !check_stat( abonent, cache_capacity, 1, cache_capacity )) return ak_false;
+
+ /* новый ключ вытесняет ключ peer-1 (lru) или ключ peer-0 (fifo) */
+  if( !check_peer( abonent, expected, cache_capacity )) return ak_false;
+  if( !check_peer( abonent, expected, 0 )) return ak_false;
+  if( policy == blom_cache_lru ) {
+    if( !check_stat( abonent, cache_capacity, 2, cache_capacity +1 )) return ak_false;
+  } else {
+    if( !check_stat( abonent, cache_capacity, 1, cache_capacity +2 )) return ak_false;
+  }
+
+ /* случайные обращения с многократным вытеснением ключей */
+  for( i = 0; i < 1000; i++ ) {
+     ak_random_ptr( generator, &peer, sizeof( peer ));
+     if( !check_peer( abonent, expected, peer%( peer&1 ? peers_count : cache_capacity +2 )))
+       return ak_false;
+  }
+ /* точные значения счетчиков зависят от последовательности обращений */
+  ak_blomkey_cache_get_stat( abonent, &count, &hits, &misses );
+  if(( count != cache_capacity ) || ( hits +misses != cache_capacity +1003 ) || ( hits < 3 )) {
+    printf("cache statistics is wrong\n");
+    return ak_false;
+  }
+  printf("[size: %u, field: GF(2^%u)] %s cache: Ok\n", abonent->size, abonent->count << 3,
+                                                      policy == blom_cache_lru ? "lru" : "fifo" );
+ return ak_true;
+}
+
+#ifdef AK_HAVE_PTHREAD_H
+/* ----------------------------------------------------------------------------------------------- */
+/* ключи парной связи одновременно вырабатываются несколькими потоками для одного ключа абонента */
+ typedef struct concurrent_task {
+   ak_blomkey abonent;
+   ak_uint8 (*expected)[64];
+   size_t start;
+   bool_t result;
+ } *ak_concurrent_task;
+
+ static void *concurrent_worker( void *ptr )
+{
+  size_t i = 0;
+  ak_concurrent_task task = ptr;
+
+  task->result = ak_true;
+  for( i = 0; i < 500; i++ )
+     if( !check_peer( task->abonent, task->expected, ( task->start +7*i )%peers_count )) {
+       task->result = ak_false;
+       break;
+     }
+ return NULL;
+}
+
+ static bool_t check_concurrent( ak_blomkey abonent, ak_uint8 expected[][64] )
+{
+  size_t i = 0, started = 0;
+  bool_t result = ak_true;
+  pthread_t threads[threads_count];
+  struct concurrent_task tasks[threads_count];
+
+  if( ak_blomkey_cache_create( abonent, cache_capacity, blom_cache_lru ) != ak_error_ok )
+    return ak_false;
+  for( started = 0; started < threads_count; started++ ) {
+     tasks[started].abonent = abonent;
+     tasks[started].expected = expected;
+     tasks[started].start = started;
+     if( pthread_create( threads +started, NULL, concurrent_worker, tasks +started ) != 0 ) {
+       result = ak_false;
+       break;
+     }
+  }
+  for( i = 0; i < started; i++ ) {
+     pthread_join( threads[i], NULL );
+     if( !tasks[i].result ) result = ak_false;
+  }
+  printf("[size: %u, field: GF(2^%u)] concurrent access: %s\n", abonent->size,
+                                                abonent->count << 3, result ? "Ok" : "Wrong" );
+ return result;
+}
+#endif
+
+/* ----------------------------------------------------------------------------------------------- */
+ static bool_t check_matrix( const ak_uint32 size, const ak_uint32 count, ak_random generator )
+{
+  size_t i = 0;
+  char id[32];
+  bool_t result = ak_false;
+  ak_pointer key = NULL;
+  struct blomkey matrix, abonent;
+  static ak_uint8 expected[peers_count][64];
+
+  if( ak_blomkey_create_matrix( &matrix, size, count, generator ) != ak_error_ok ) return ak_false;
+  if( ak_blomkey_create_abonent_key( &abonent, &matrix, ID, strlen( ID )) != ak_error_ok )
+    goto ex;
+
+ /* кэш может быть связан только с ключом абонента */
+  if( ak_blomkey_cache_create( &matrix, cache_capacity, blom_cache_lru ) == ak_error_ok ) goto ex2;
+  if( ak_blomkey_cache_create( &abonent, 0, blom_cache_lru ) == ak_error_ok ) goto ex2;
+  if( ak_blomkey_cache_get_stat( &abonent, NULL, NULL, NULL ) == ak_error_ok ) goto ex2;
+
+ /* ключи, вычисленные без кэша */
+  for( i = 0; i < peers_count; i++ ) {
+     ak_snprintf( id, sizeof( id ), "peer-%u", (unsigned int) i );
+     if( ak_blomkey_create_pairwise_key_as_ptr( &abonent, id, strlen( id ),
+                                         expected[i], sizeof( expected[i] )) != ak_error_ok )
+       goto ex2;
+  }
+
+  if( !check_policy( &abonent, expected, blom_cache_lru, generator )) goto ex2;
+  if( !check_policy( &abonent, expected, blom_cache_fifo, generator )) goto ex2;
+ #ifdef AK_HAVE_PTHREAD_H
+  if( !check_concurrent( &abonent, expected )) goto ex2;
+ #endif
+
+ /* контекст ключа парной связи создается из значения, найденного в кэше */
+  if(( key = ak_blomkey_new_pairwise_key( &abonent, "peer-0", 6,
+                                          ak_oid_find_by_name( "kuznechik" ))) == NULL ) goto ex2;
+  ak_oid_delete_object( ak_oid_find_by_name( "kuznechik" ), key );
+  result = ak_true;
+
+  ex2:
+   ak_blomkey_destroy( &abonent ); /* кэш уничтожается вместе с ключом */
+  ex:
+   ak_blomkey_destroy( &matrix );
+ return result;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+ int main( void )
+{
+  struct random generator;
+  ak_uint32 seed = 1204;
+  int exitcode = EXIT_FAILURE;
+
+  ak_libakrypt_create( ak_function_log_stderr );
+  ak_random_create_lcg( &generator );
+  ak_random_randomize( &generator, &seed, sizeof( seed ));
+
+  if( !check_matrix( 64, ak_galois256_size, &generator )) goto ex;
+  if( !check_matrix( 37, ak_galois512_size, &generator )) goto ex;
+  exitcode = EXIT_SUCCESS;
+
+  ex:
+   ak_random_destroy( &generator );
+   ak_libakrypt_destroy();
+ return exitcode;
+}
@@ -0,0 +1,75 @@
+/* ----------------------------------------------------------------------------------------------- */
+/* Тест проверяет, что вычисление хеш-кода и имитовставки для файла совпадает с вычислением для
+   области памяти при всех способах опережающего чтения и различных длинах файлов                  */
+/* ----------------------------------------------------------------------------------------------- */
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <libakrypt.h>
+
+/* ----------------------------------------------------------------------------------------------- */
+ static ak_uint8 testkey[32] = {
+    0xef, 0xcd, 0xab, 0x89, 0x67, 0x45, 0x27, 0x01, 0x10, 0x32, 0x54, 0x76, 0x98, 0xba, 0xdc, 0xfe,
+    0x77, 0x66, 0x55, 0x44, 0x33, 0x22, 0x11, 0x00, 0xff, 0xee, 0xdd, 0xcc, 0xbb, 0xaa, 0x99, 0x38 };
+
+/* ----------------------------------------------------------------------------------------------- */
+ int main( void )
+{
+  size_t i = 0, j = 0;
+  struct hash ctx;
+  struct bckey bkey;
+  struct random generator;
+  ak_uint32 seed = 1317;
+  ak_uint8 *data = NULL, out1[64], out2[64];
+  const char *filename = "test-file-read.dat";
+  int exitcode = EXIT_FAILURE;
+  size_t lengths[] = { 0, 1, 16, 4095, 4096, 4097, 12288, 12301, 65536 +11 };
+
+  ak_libakrypt_create( ak_function_log_stderr );
+  ak_libakrypt_set_option( "file_read_chunk_size", 4096 );
+
+  ak_random_create_lcg( &generator );
+  ak_random_randomize( &generator, &seed, 4 );
+  ak_hash_create_streebog256( &ctx );
+  ak_bckey_create_kuznechik( &bkey );
+  ak_bckey_set_key( &bkey, testkey, 32 );
+  if(( data = malloc( 65536 +11 )) == NULL ) goto ex;
+  ak_random_ptr( &generator, data, 65536 +11 );
+
+  for( i = 0; i < sizeof( lengths )/sizeof( size_t ); i++ ) {
+     FILE *fp = fopen( filename, "wb" );
+     if( fp == NULL ) goto ex;
+     if( lengths[i] ) fwrite( data, 1, lengths[i], fp );
+     fclose( fp );
+
+     for( j = file_read_auto; j <= file_read_thread; j++ ) {
+        ak_libakrypt_set_option( "file_read_mode", ( ak_int64 )j );
+
+       /* сравниваем хеш-коды */
+        memset( out1, 0, sizeof( out1 )); memset( out2, 0, sizeof( out2 ));
+        ak_hash_ptr( &ctx, data, lengths[i], out1, 32 );
+        if( ak_hash_file( &ctx, filename, out2, 32 ) != ak_error_ok ) goto ex;
+        printf("length: %6u, mode: %u, hash: %s ", (unsigned int) lengths[i],
+                                        (unsigned int) j, ak_ptr_to_hexstr( out2, 16, ak_false ));
+        if( !ak_ptr_is_equal_with_log( out1, out2, 32 )) { printf("Wrong\n"); goto ex; }
+
+       /* сравниваем имитовставки */
+        memset( out1, 0, sizeof( out1 )); memset( out2, 0, sizeof( out2 ));
+        ak_bckey_cmac( &bkey, data, lengths[i], out1, 16 );
+        if( ak_bckey_cmac_file( &bkey, filename, out2, 16 ) != ak_error_ok ) goto ex;
+        if( !ak_ptr_is_equal_with_log( out1, out2, 16 )) { printf("Wrong\n"); goto ex; }
+        printf("Ok\n");
+     }
+  }
+  exitcode = EXIT_SUCCESS;
+
+  ex:
+   remove( filename );
+   if( data ) free( data );
+   ak_bckey_destroy( &bkey );
+   ak_hash_destroy( &ctx );
+   ak_random_destroy( &generator );
+   ak_libakrypt_destroy();
+
+ return exitcode;
+}
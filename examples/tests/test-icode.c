@@ -0,0 +1,125 @@
+/* ----------------------------------------------------------------------------------------------- */
+/* Тест проверяет инкрементальный контроль целостности каталога                                    */
+/* ----------------------------------------------------------------------------------------------- */
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <sys/stat.h>
+ #include <libakrypt.h>
+#ifdef _WIN32
+ #include <direct.h>
+#endif
+
+/* ----------------------------------------------------------------------------------------------- */
+ static const char *dirname = "test-icode.dir";
+ static const char *indexname = "test-icode.idx";
+
+/* ----------------------------------------------------------------------------------------------- */
+ static void write_file( const char *name, const char *content )
+{
+  char filename[256];
+  FILE *fp = NULL;
+
+  ak_snprintf( filename, sizeof( filename ), "%s/%s", dirname, name );
+  if(( fp = fopen( filename, "wb" )) == NULL ) return;
+  fwrite( content, 1, strlen( content ), fp );
+  fclose( fp );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+ static int report( const char *filename, icode_event_t event, ak_pointer ptr )
+{
+  const char *names[] = { "added", "changed", "removed", "failed" };
+  (void)ptr;
+  printf("  %s: %s\n", filename, names[event] );
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+ static bool_t check( struct icode_stat *st, size_t total, size_t hashed,
+                                             size_t added, size_t changed, size_t removed )
+{
+  printf("total: %u, hashed: %u, skipped: %u, added: %u, changed: %u, removed: %u, failed: %u\n",
+     (unsigned int)st->total, (unsigned int)st->hashed, (unsigned int)st->skipped,
+     (unsigned int)st->added, (unsigned int)st->changed, (unsigned int)st->removed,
+                                                                     (unsigned int)st->failed );
+  return ( st->total == total ) && ( st->hashed == hashed ) && ( st->added == added ) &&
+         ( st->changed == changed ) && ( st->removed == removed ) && ( st->failed == 0 );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+ int main( void )
+{
+  size_t i = 0;
+  struct hash ctx;
+  struct icode_stat st;
+  struct icode_index idx, idx2;
+  ak_icode_record rec = NULL;
+  ak_uint8 out[32];
+  char filename[256];
+  int exitcode = EXIT_FAILURE;
+
+  memset( &idx, 0, sizeof( struct icode_index ));
+  memset( &idx2, 0, sizeof( struct icode_index ));
+  ak_libakrypt_create( ak_function_log_stderr );
+ #ifdef _WIN32
+  _mkdir( dirname );
+ #else
+  mkdir( dirname, S_IRWXU );
+ #endif
+  for( i = 0; i < 16; i++ ) {
+     char name[32], content[64];
+     ak_snprintf( name, sizeof( name ), "file%02u.txt", (unsigned int)i );
+     ak_snprintf( content, sizeof( content ), "content of file number %u", (unsigned int)i );
+     write_file( name, content );
+  }
+
+ /* первая проверка: все файлы новые */
+  ak_icode_index_create( &idx, ak_oid_find_by_name( "streebog256" ));
+  ak_icode_index_scan( &idx, dirname, "*.txt", ak_true, 4, ak_false, &st, report, NULL );
+  if( !check( &st, 16, 16, 16, 0, 0 )) goto ex;
+  if( ak_icode_index_save( &idx, indexname ) != ak_error_ok ) goto ex;
+
+ /* сравниваем хеш-код с вычисленным напрямую */
+  ak_snprintf( filename, sizeof( filename ), "%s/file07.txt", dirname );
+  ak_hash_create_streebog256( &ctx );
+  ak_hash_file( &ctx, filename, out, sizeof( out ));
+  ak_hash_destroy( &ctx );
+  if(( rec = ak_icode_index_find( &idx, filename )) == NULL ) goto ex;
+  if( !ak_ptr_is_equal_with_log( rec->tag, out, 32 )) goto ex;
+
+ /* повторная проверка по считанному индексу: хеш-коды не вычисляются */
+  if( ak_icode_index_create_from_file( &idx2, indexname ) != ak_error_ok ) goto ex;
+  if( idx2.count != idx.count ) goto ex;
+  if( ak_icode_index_scan( &idx2, dirname, "*.txt", ak_true, 4,
+                                                    ak_false, &st, report, NULL ) != ak_error_ok ) goto ex;
+  if( !check( &st, 16, 0, 0, 0, 0 )) goto ex;
+
+ /* изменяем, удаляем и добавляем файлы */
+  write_file( "file03.txt", "modified content of the third file" );
+  ak_snprintf( filename, sizeof( filename ), "%s/file05.txt", dirname );
+  remove( filename );
+  write_file( "file16.txt", "new file" );
+  if( ak_icode_index_scan( &idx2, dirname, "*.txt", ak_true, 0,
+                                            ak_false, &st, report, NULL ) != ak_error_not_equal_data ) goto ex;
+  if( !check( &st, 16, 2, 1, 1, 1 )) goto ex;
+
+ /* принудительная проверка всех файлов без изменений */
+  if( ak_icode_index_scan( &idx2, dirname, "*.txt", ak_true, 1,
+                                                     ak_true, &st, report, NULL ) != ak_error_ok ) goto ex;
+  if( !check( &st, 16, 16, 0, 0, 0 )) goto ex;
+  exitcode = EXIT_SUCCESS;
+
+  ex:
+   for( i = 0; i < 17; i++ ) {
+      ak_snprintf( filename, sizeof( filename ), "%s/file%02u.txt", dirname, (unsigned int)i );
+      remove( filename );
+   }
+   remove( dirname );
+   remove( indexname );
+   ak_icode_index_destroy( &idx2 );
+   ak_icode_index_destroy( &idx );
+   ak_libakrypt_destroy();
+
+ return exitcode;
+}
@@ -51,6 +51,40 @@
   ak_kdf_state_destroy( &ks );
 }
 
+/* ----------------------------------------------------------------------------------------------- */
+/* проверяем, что выработка ключевой информации для массива контекстов совпадает
+   с последовательной выработкой для каждого контекста */
+ bool_t check_many( kdf_t type )
+{
+  size_t i = 0;
+  bool_t result = ak_false;
+  struct kdf_state ks, states[12];
+  ak_uint8 key[100], keys[12*100];
+
+  for( i = 0; i < 12; i++ ) {
+     seed[0] = ( ak_uint8 )i;
+     if( ak_kdf_state_create( states +i, kin, 32, type,
+                              label, 77, seed, 32, iv, 64, 32768 ) != ak_error_ok ) return ak_false;
+  }
+  if( ak_kdf_state_next_many( states, 12, keys, 100, 4 ) != ak_error_ok ) goto ex;
+
+  for( i = 0; i < 12; i++ ) {
+     seed[0] = ( ak_uint8 )i;
+     if( ak_kdf_state_create( &ks, kin, 32, type,
+                                      label, 77, seed, 32, iv, 64, 32768 ) != ak_error_ok ) goto ex;
+     ak_kdf_state_next( &ks, key, 100 );
+     ak_kdf_state_destroy( &ks );
+     if( !ak_ptr_is_equal_with_log( key, keys +i*100, 100 )) goto ex;
+  }
+  result = ak_true;
+
+  ex:
+   for( i = 0; i < 12; i++ ) ak_kdf_state_destroy( states +i );
+   seed[0] = 'a';
+   printf("many states (0x%X): %s\n", type, result ? "Ok" : "Wrong" );
+ return result;
+}
+
 /* ----------------------------------------------------------------------------------------------- */
  int main( void )
 {
@@ -142,6 +176,11 @@
   if( strncmp( ptr, "7021e470615353420609e2236d253140b10c7309565f7790516c9202b1708b47ec1b80d5e8e260c18124", 42 ) != 0 )
     return EXIT_FAILURE;
 
+/* массивы контекстов */
+  if( !check_many( hmac_cmac_kuznechik_kdf )) return EXIT_FAILURE;
+  if( !check_many( nmac_hmac256_kdf )) return EXIT_FAILURE;
+  if( !check_many( xor_hmac512_kdf )) return EXIT_FAILURE;
+
   ak_libakrypt_destroy();
  return EXIT_SUCCESS;
 }
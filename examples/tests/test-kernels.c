@@ -0,0 +1,137 @@
+/* ----------------------------------------------------------------------------------------------- */
+/* Тест проверяет выбор реализаций вычислительных ядер во время выполнения программы:
+   результаты умножения в конечных полях GF(2^n), ключи схемы Блома и результаты умножения
+   Монтгомери не должны зависеть от выбранной реализации                                           */
+/* ----------------------------------------------------------------------------------------------- */
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <libakrypt.h>
+
+/* ----------------------------------------------------------------------------------------------- */
+ #define tests_count (64)
+
+/* ----------------------------------------------------------------------------------------------- */
+/* вычисление произведений в полях GF(2^128) и GF(2^512) для набора случайных элементов,
+   а также ключей абонента и ключей парной связи схемы Блома (значений многочленов) */
+ static void gf_products( ak_uint8 *out, ak_random generator )
+{
+  size_t i = 0;
+  ak_uint8 x[64], y[64];
+  struct blomkey matrix, abonent;
+  ak_uint32 fields[2] = { ak_galois256_size, ak_galois512_size };
+
+  for( i = 0; i < tests_count; i++ ) {
+     ak_random_ptr( generator, x, sizeof( x ));
+     ak_random_ptr( generator, y, sizeof( y ));
+     ak_gf128_mul( out +80*i, x, y );
+     ak_gf512_mul( out +80*i +16, x, y );
+  }
+  out += 80*tests_count;
+
+ /* размер матрицы не кратен количеству коэффициентов, обрабатываемых за одно приведение */
+  for( i = 0; i < 2; i++ ) {
+     if( ak_blomkey_create_matrix( &matrix, 37, fields[i], generator ) != ak_error_ok ) return;
+     if( ak_blomkey_create_abonent_key( &abonent, &matrix, "alice", 5 ) == ak_error_ok ) {
+       memcpy( out +96*i, abonent.icode, 32 );
+       ak_blomkey_create_pairwise_key_as_ptr( &abonent, "bob", 3, out +96*i +32, 64 );
+       ak_blomkey_destroy( &abonent );
+     }
+     ak_blomkey_destroy( &matrix );
+  }
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/* вычисление произведений Монтгомери по модулям p и q кривой для набора случайных вычетов */
+ static void montgomery_products( ak_uint64 *out, ak_wcurve wc, ak_random generator )
+{
+  size_t i = 0;
+  ak_mpznmax x, y;
+
+  for( i = 0; i < tests_count; i++ ) {
+     ak_mpzn_set_random_modulo( x, wc->p, wc->size, generator );
+     ak_mpzn_set_random_modulo( y, wc->p, wc->size, generator );
+     ak_mpzn_mul_montgomery( out +2*i*wc->size, x, y, wc->p, wc->n, wc->size );
+     ak_mpzn_set_random_modulo( x, wc->q, wc->size, generator );
+     ak_mpzn_mul_montgomery( out +(2*i+1)*wc->size, x, x, wc->q, wc->nq, wc->size );
+  }
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/* сравнение результатов обобщенной и ускоренной реализаций ядра */
+ static bool_t check_kernel( const char *kernel, const char *accelerated, ak_wcurve wc )
+{
+  struct random generator;
+  ak_uint32 seed = 1703;
+  bool_t result = ak_false;
+  static ak_uint64 generic[2*tests_count*ak_mpznmax_size], fast[2*tests_count*ak_mpznmax_size];
+
+  if( ak_libakrypt_set_kernel( kernel, "generic" ) != ak_error_ok ) return ak_false;
+  if( strcmp( ak_libakrypt_get_kernel( kernel ), "generic" ) != 0 ) return ak_false;
+ /* буферы общие для всех ядер: удаляем результаты предыдущей проверки */
+  memset( generic, 0, sizeof( generic ));
+  memset( fast, 0, sizeof( fast ));
+
+  ak_random_create_lcg( &generator );
+  ak_random_randomize( &generator, &seed, sizeof( seed ));
+  if( wc == NULL ) gf_products( (ak_uint8 *)generic, &generator );
+    else montgomery_products( generic, wc, &generator );
+
+ /* ускоренная реализация может отсутствовать или не поддерживаться процессором */
+  if( ak_libakrypt_set_kernel( kernel, accelerated ) != ak_error_ok ) {
+    printf("%s: %s is not available\n", kernel, accelerated );
+    result = ak_true;
+    goto ex;
+  }
+  if( strcmp( ak_libakrypt_get_kernel( kernel ), accelerated ) != 0 ) goto ex;
+
+  ak_random_randomize( &generator, &seed, sizeof( seed ));
+  if( wc == NULL ) gf_products( (ak_uint8 *)fast, &generator );
+    else montgomery_products( fast, wc, &generator );
+
+  if(( result = ak_ptr_is_equal( generic, fast, sizeof( generic ))) == ak_true )
+    printf("%s: generic and %s are equal\n", kernel, accelerated );
+   else printf("%s: generic and %s are different\n", kernel, accelerated );
+
+  ex:
+   ak_random_destroy( &generator );
+ return result;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+ int main( void )
+{
+  size_t i = 0;
+  int exitcode = EXIT_FAILURE;
+  const char *gf2n = NULL, *montgomery = NULL;
+  ak_wcurve curves[] = {
+    ( ak_wcurve ) &id_tc26_gost_3410_2012_256_paramSetB,
+    ( ak_wcurve ) &id_tc26_gost_3410_2012_512_paramSetC
+  };
+
+  ak_libakrypt_create( ak_function_log_stderr );
+  if(( gf2n = ak_libakrypt_get_kernel( "gf2n" )) == NULL ) goto ex;
+  if(( montgomery = ak_libakrypt_get_kernel( "montgomery" )) == NULL ) goto ex;
+  printf("kernels: gf2n: %s, montgomery: %s\n", gf2n, montgomery );
+
+ /* неизвестные ядра и реализации должны отвергаться */
+  if( ak_libakrypt_get_kernel( "kuznechik" ) != NULL ) goto ex;
+  if( ak_libakrypt_set_kernel( "kuznechik", "generic" ) == ak_error_ok ) goto ex;
+  if( ak_libakrypt_set_kernel( "gf2n", "mulx-adx" ) == ak_error_ok ) goto ex;
+  if( strcmp( ak_libakrypt_get_kernel( "gf2n" ), gf2n ) != 0 ) goto ex;
+
+  if( !check_kernel( "gf2n", "pclmul", NULL )) goto ex;
+  for( i = 0; i < sizeof( curves )/sizeof( ak_wcurve ); i++ )
+     if( !check_kernel( "montgomery", "mulx-adx", curves[i] )) goto ex;
+
+ /* после автоматического выбора восстанавливаются исходные реализации */
+  if( ak_libakrypt_set_kernel( "gf2n", "auto" ) != ak_error_ok ) goto ex;
+  if( ak_libakrypt_set_kernel( "montgomery", "auto" ) != ak_error_ok ) goto ex;
+  if( strcmp( ak_libakrypt_get_kernel( "gf2n" ), gf2n ) != 0 ) goto ex;
+  if( strcmp( ak_libakrypt_get_kernel( "montgomery" ), montgomery ) != 0 ) goto ex;
+  exitcode = EXIT_SUCCESS;
+
+  ex:
+   ak_libakrypt_destroy();
+ return exitcode;
+}
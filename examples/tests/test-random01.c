@@ -9,6 +9,10 @@
  #include <string.h>
  #include <stdlib.h>
  #include <libakrypt.h>
+#if defined(__unix__) || defined(__APPLE__)
+ #include <unistd.h>
+ #include <sys/wait.h>
+#endif
 
 /* основная тестирующая функция */
  int test_function( ak_function_random create, const char *result )
@@ -47,6 +51,88 @@
  return retval;
 }
 
+/* создание генератора по его идентификатору */
+ bool_t create_oid( const char *name )
+{
+  struct random generator;
+  ak_uint8 buffer[100], zero[100];
+
+  memset( buffer, 0, sizeof( buffer ));
+  memset( zero, 0, sizeof( zero ));
+  if( ak_random_create_oid( &generator, ak_oid_find_by_name( name )) != ak_error_ok ) return ak_false;
+  ak_random_ptr( &generator, buffer, sizeof( buffer ));
+  ak_random_destroy( &generator );
+  printf( "%13s: created by oid %s\n", name,
+                                memcmp( buffer, zero, sizeof( buffer )) != 0 ? "Ok" : "Wrong" );
+ return memcmp( buffer, zero, sizeof( buffer )) != 0 ? ak_true : ak_false;
+}
+
+/* проверка генераторов, связанных с потоками */
+ bool_t thread_local_check( void )
+{
+  ak_random rnd = ak_random_thread_local();
+  struct random_thread_stat st;
+  ak_uint8 buffer[1024], out[32];
+  int i = 0;
+
+  if( rnd == NULL ) return ak_false;
+  if( ak_random_thread_local() != rnd ) return ak_false;
+
+ /* повторная инициализация после выработки каждых 64 Кб данных */
+  ak_random_thread_local_set_reseed_interval( 65536 );
+  for( i = 0; i < 300; i++ ) ak_random_ptr( ak_random_thread_local(), buffer, sizeof( buffer ));
+  ak_random_thread_local_get_stat( &st );
+  printf( " thread local: generators: %u, served: %llu, reseeds: %llu ",
+         (unsigned int)st.generators, (unsigned long long)st.served, (unsigned long long)st.reseeds );
+  if(( st.generators != 1 ) || ( st.created != 1 ) ||
+                                         ( st.served < 300*1024 ) || ( st.reseeds < 3 )) {
+    printf("Wrong\n");
+    return ak_false;
+  }
+  printf("Ok\n");
+
+ #if defined(__unix__) || defined(__APPLE__)
+  {
+   /* дочерний процесс не должен повторять данные родительского процесса,
+      в том числе при использовании указателя на генератор, полученного до вызова fork() */
+    int fd[2], status = 0;
+    pid_t pid;
+    ak_uint8 child[64];
+
+    if( pipe( fd ) != 0 ) return ak_false;
+    if(( pid = fork()) < 0 ) return ak_false;
+    if( pid == 0 ) {
+      close( fd[0] );
+      ak_random_ptr( rnd, child, 32 );
+      ak_random_ptr( ak_random_thread_local(), child +32, 32 );
+      if( write( fd[1], child, sizeof( child )) != sizeof( child )) _exit( EXIT_FAILURE );
+      _exit( EXIT_SUCCESS );
+    }
+    close( fd[1] );
+    memset( child, 0, sizeof( child ));
+    i = ( int )read( fd[0], child, sizeof( child ));
+    close( fd[0] );
+    waitpid( pid, &status, 0 );
+    printf( " thread local: after fork %s\n", ak_ptr_to_hexstr( child, 32, ak_false ));
+    if( i != sizeof( child )) {
+      printf(" thread local: fork check Wrong\n");
+      return ak_false;
+    }
+    ak_random_ptr( rnd, out, sizeof( out ));
+    if( memcmp( out, child, sizeof( out )) == 0 ) {
+      printf(" thread local: fork check (cached pointer) Wrong\n");
+      return ak_false;
+    }
+    ak_random_ptr( ak_random_thread_local(), out, sizeof( out ));
+    if( memcmp( out, child +32, sizeof( out )) == 0 ) {
+      printf(" thread local: fork check Wrong\n");
+      return ak_false;
+    }
+  }
+ #endif
+ return ak_true;
+}
+
  int main( void )
 {
  int error = EXIT_SUCCESS;
@@ -67,6 +153,22 @@
       "ea225f4cf869abf48af25ae23c42a9408b2589d5bc0a218ad0e809e270f40913" ) != ak_true )
      error = EXIT_FAILURE;
 
+  /* для воспроизводимости результата отключаем повторную инициализацию генератора */
+   ak_libakrypt_set_option( "random_ctr_reseed_interval", 0 );
+   if( test_function( ak_random_create_ctr_kuznechik,
+      "b3824e8ed551f6055bda18894f4b4f9ddea421044b1683400c3ea5dafb646e58" ) != ak_true )
+     error = EXIT_FAILURE;
+   ak_libakrypt_set_option( "random_ctr_reseed_interval", 1048576 );
+   if( test_function( ak_random_create_ctr_kuznechik, NULL ) != ak_true ) error = EXIT_FAILURE;
+   if( create_oid( "ctr-drbg-kuznechik" ) != ak_true ) error = EXIT_FAILURE;
+
+   if( thread_local_check() != ak_true ) error = EXIT_FAILURE;
+
+  #ifdef AK_HAVE_SYSRANDOM_H
+   if( test_function( ak_random_create_getrandom, NULL ) != ak_true ) error = EXIT_FAILURE;
+   if( create_oid( "getrandom" ) != ak_true ) error = EXIT_FAILURE;
+  #endif
+
   #ifdef _WIN32
    if( test_function( ak_random_create_winrtl, NULL ) != ak_true ) error = EXIT_FAILURE;
   #endif
@@ -11,7 +11,7 @@
  int main( int argc, char *argv[] )
 {
   struct signkey sk;
-  struct verifykey pk;
+  struct verifykey pk, pk2;
   struct random generator;
   int result = EXIT_SUCCESS;
   ak_uint8 sign[128];
@@ -54,8 +54,24 @@
     printf("verify: Ok\n");
    else { printf("verify: Wrong\n"); result = EXIT_FAILURE; }
 
-  ak_signkey_destroy( &sk );
+ /* повторяем проверку с использованием таблицы предвычислений,
+    второй контекст того же ключа должен получить таблицу из кэша */
+  ak_verifykey_create_from_signkey( &pk2, &sk );
+  if(( ak_verifykey_precompute( &pk ) != ak_error_ok ) ||
+     ( ak_verifykey_precompute( &pk2 ) != ak_error_ok ) || ( pk.table != pk2.table )) {
+    printf("precompute: Wrong\n"); result = EXIT_FAILURE;
+  }
   ak_verifykey_destroy( &pk );
+  if( ak_verifykey_verify_file( &pk2, argv[0], sign ) == ak_true )
+    printf("verify (precomputed): Ok\n");
+   else { printf("verify (precomputed): Wrong\n"); result = EXIT_FAILURE; }
+  sign[0] ^= 1;
+  if( ak_verifykey_verify_file( &pk2, argv[0], sign ) != ak_true )
+    printf("verify (precomputed, wrong sign): Ok\n");
+   else { printf("verify (precomputed, wrong sign): Wrong\n"); result = EXIT_FAILURE; }
+
+  ak_signkey_destroy( &sk );
+  ak_verifykey_destroy( &pk2 );
 
   exlab:
     ak_random_destroy( &generator );
@@ -0,0 +1,92 @@
+/* ----------------------------------------------------------------------------------------------- */
+/* Тест проверяет совпадение результатов пакетной проверки электронных подписей
+   с результатами последовательной проверки каждой подписи                                        */
+/* ----------------------------------------------------------------------------------------------- */
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <libakrypt.h>
+
+/* ----------------------------------------------------------------------------------------------- */
+ #define keys_count    (3)
+ #define signs_count (100)
+
+ static const char *curves[keys_count] = {
+   "id-tc26-gost-3410-2012-256-paramSetB",
+   "id-tc26-gost-3410-2012-512-paramSetC",
+   "id-tc26-gost-3410-2012-256-paramSetA"
+ };
+
+/* ----------------------------------------------------------------------------------------------- */
+ int main( void )
+{
+  size_t i = 0, j = 0, threads[] = { 1, 4, 0 };
+  struct signkey sk[keys_count];
+  struct verifykey vk[keys_count];
+  struct random generator;
+  struct verifykey_batch_item items[signs_count];
+  ak_uint8 hashes[signs_count][64], signs[signs_count][128];
+  bool_t expected[signs_count];
+  ak_uint32 seed = 2103;
+  int exitcode = EXIT_FAILURE;
+
+  ak_libakrypt_create( ak_function_log_stderr );
+  ak_random_create_lcg( &generator );
+  ak_random_randomize( &generator, &seed, sizeof( seed ));
+  memset( sk, 0, sizeof( sk ));
+  memset( vk, 0, sizeof( vk ));
+
+  for( i = 0; i < keys_count; i++ ) {
+     if( ak_signkey_create_str( sk +i, curves[i] ) != ak_error_ok ) goto ex;
+     if( ak_signkey_set_key_random( sk +i, &generator ) != ak_error_ok ) goto ex;
+     if( ak_verifykey_create_from_signkey( vk +i, sk +i ) != ak_error_ok ) goto ex;
+  }
+ /* для одного из ключей используется таблица предвычислений */
+  ak_verifykey_precompute( vk );
+
+ /* подписи вырабатываются ключами на разных кривых в перемешанном порядке;
+    каждая пятая подпись искажается, одна подпись имеет хеш-код неверной длины */
+  for( i = 0; i < signs_count; i++ ) {
+     ak_signkey skey = sk +(( i/7 +i )%keys_count );
+     size_t hsize = ak_signkey_get_tag_size( skey )/2;
+
+     ak_random_ptr( &generator, hashes[i], hsize );
+     ak_signkey_sign_hash( skey, &generator, hashes[i], hsize, signs[i], sizeof( signs[i] ));
+     if( i%5 == 3 ) signs[i][i%hsize] ^= 0x10;
+     items[i].key = vk +(( i/7 +i )%keys_count );
+     items[i].hash = hashes[i];
+     items[i].hsize = ( i == 42 ) ? hsize -1 : hsize;
+     items[i].sign = signs[i];
+     expected[i] = ak_verifykey_verify_hash( items[i].key, items[i].hash,
+                                                                  items[i].hsize, items[i].sign );
+     if( expected[i] != (( i%5 != 3 ) && ( i != 42 ))) {
+       printf("sequential verification is wrong for signature %u\n", (unsigned int)i );
+       goto ex;
+     }
+  }
+
+  for( j = 0; j < sizeof( threads )/sizeof( size_t ); j++ ) {
+     for( i = 0; i < signs_count; i++ ) items[i].result = !expected[i];
+     if( ak_verifykey_verify_hash_batch( items, signs_count,
+                                                 threads[j] ) != ak_error_wrong_length ) goto ex;
+     for( i = 0; i < signs_count; i++ ) {
+        if( items[i].result != expected[i] ) {
+          printf("batch verification is wrong for signature %u\n", (unsigned int)i );
+          goto ex;
+        }
+        if(( items[i].error != ak_error_ok ) != ( i == 42 )) goto ex;
+     }
+     printf("threads: %u, signatures: %u, Ok\n", (unsigned int)threads[j], signs_count );
+  }
+  exitcode = EXIT_SUCCESS;
+
+  ex:
+   for( i = 0; i < keys_count; i++ ) {
+      ak_verifykey_destroy( vk +i );
+      ak_signkey_destroy( sk +i );
+   }
+   ak_random_destroy( &generator );
+   ak_libakrypt_destroy();
+
+ return exitcode;
+}
@@ -0,0 +1,214 @@
+/* ----------------------------------------------------------------------------------------------- */
+/* Тест проверяет выработку электронной подписи с использованием пула заранее вычисленных
+   значений (k, r): подписи должны проверяться, а каждое значение использоваться один раз          */
+/* ----------------------------------------------------------------------------------------------- */
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <libakrypt.h>
+#if defined(__unix__) || defined(__APPLE__)
+ #include <unistd.h>
+ #include <sys/wait.h>
+#endif
+#ifdef AK_HAVE_PTHREAD_H
+ #include <pthread.h>
+#endif
+
+/* ----------------------------------------------------------------------------------------------- */
+ #define pool_capacity  (8)
+ #define signs_count   (24)
+ #define forks_count   (32)
+
+/* ----------------------------------------------------------------------------------------------- */
+/* выработка и проверка signs_count подписей; значения r всех подписей должны быть различны */
+ static bool_t check_signs( ak_signkey sk, ak_verifykey vk, ak_random generator )
+{
+  size_t i = 0, j = 0;
+  size_t hsize = ak_signkey_get_tag_size( sk )/2;
+  ak_uint8 hash[64], signs[signs_count][128];
+
+  for( i = 0; i < signs_count; i++ ) {
+     ak_random_ptr( generator, hash, hsize );
+     if( ak_signkey_sign_hash( sk, generator, hash, hsize,
+                                            signs[i], sizeof( signs[i] )) != ak_error_ok ) return ak_false;
+     if( !ak_verifykey_verify_hash( vk, hash, hsize, signs[i] )) {
+       printf("signature %u is wrong\n", (unsigned int)i );
+       return ak_false;
+     }
+     for( j = 0; j < i; j++ )
+        if( memcmp( signs[i] +hsize, signs[j] +hsize, hsize ) == 0 ) {
+          printf("signatures %u and %u use the same nonce\n", (unsigned int)j, (unsigned int)i );
+          return ak_false;
+        }
+  }
+ return ak_true;
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+/* ----------------------------------------------------------------------------------------------- */
+/* после вызова fork() пул дочернего процесса должен быть пуст, а подпись, выработанная
+   в дочернем процессе, не должна использовать значения из пула родительского процесса */
+ static bool_t check_fork( ak_signkey sk, ak_verifykey vk, ak_random generator )
+{
+  pid_t pid;
+  int fd[2], status = 0;
+  size_t i = 0, hsize = ak_signkey_get_tag_size( sk )/2;
+  ak_uint8 hash[64], sign[128], child[128];
+
+  if( ak_signkey_nonce_pool_count( sk ) != pool_capacity ) return ak_false;
+  ak_random_ptr( generator, hash, hsize );
+  if( pipe( fd ) != 0 ) return ak_false;
+  if(( pid = fork()) < 0 ) return ak_false;
+  if( pid == 0 ) {
+    close( fd[0] );
+    if( ak_signkey_nonce_pool_count( sk ) != 0 ) _exit( EXIT_FAILURE );
+    if( ak_signkey_sign_hash( sk, ak_random_thread_local(), hash, hsize,
+                                                   sign, sizeof( sign )) != ak_error_ok )
+      _exit( EXIT_FAILURE );
+    if( !ak_verifykey_verify_hash( vk, hash, hsize, sign )) _exit( EXIT_FAILURE );
+    if( write( fd[1], sign, 2*hsize ) != ( ssize_t )( 2*hsize )) _exit( EXIT_FAILURE );
+    _exit( EXIT_SUCCESS );
+  }
+  close( fd[1] );
+  memset( child, 0, sizeof( child ));
+  i = ( size_t )read( fd[0], child, 2*hsize );
+  close( fd[0] );
+  waitpid( pid, &status, 0 );
+  if(( i != 2*hsize ) || !WIFEXITED( status ) || ( WEXITSTATUS( status ) != EXIT_SUCCESS )) {
+    printf("child process uses nonce pool of parent process\n");
+    return ak_false;
+  }
+
+ /* родительский процесс использует все значения своего пула */
+  for( i = 0; i < pool_capacity; i++ ) {
+     ak_random_ptr( generator, hash, hsize );
+     if( ak_signkey_sign_hash( sk, generator, hash, hsize, sign, sizeof( sign )) != ak_error_ok )
+       return ak_false;
+     if( memcmp( sign +hsize, child +hsize, hsize ) == 0 ) {
+       printf("parent and child processes use the same nonce\n");
+       return ak_false;
+     }
+  }
+ return ( ak_signkey_nonce_pool_count( sk ) == 0 );
+}
+
+#ifdef AK_HAVE_PTHREAD_H
+/* ----------------------------------------------------------------------------------------------- */
+/* поток, постоянно захватывающий мьютекс пула */
+ static volatile bool_t counter_stop = ak_false;
+
+ static void *counter_worker( void *ptr )
+{
+  while( !counter_stop ) ak_signkey_nonce_pool_count( ptr );
+ return NULL;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/* вызов fork() при работающем фоновом потоке: мьютекс пула может быть захвачен в момент вызова,
+   однако дочерний процесс должен использовать пул без взаимной блокировки */
+ static bool_t check_fork_background( ak_signkey sk, ak_verifykey vk, ak_random generator )
+{
+  pid_t pid;
+  pthread_t counter;
+  int status = 0;
+  size_t i = 0, hsize = ak_signkey_get_tag_size( sk )/2;
+  ak_uint8 hash[64], sign[128];
+  bool_t result = ak_true;
+
+  if( ak_signkey_nonce_pool_create( sk, pool_capacity, ak_true ) != ak_error_ok ) return ak_false;
+  counter_stop = ak_false;
+  if( pthread_create( &counter, NULL, counter_worker, sk ) != 0 ) return ak_false;
+
+  for( i = 0; ( i < forks_count ) && result; i++ ) {
+     ak_random_ptr( generator, hash, hsize );
+     if(( pid = fork()) < 0 ) { result = ak_false; break; }
+     if( pid == 0 ) {
+       alarm( 10 ); /* взаимная блокировка завершает дочерний процесс сигналом */
+       if( ak_signkey_nonce_pool_count( sk ) != 0 ) _exit( EXIT_FAILURE );
+       if( ak_signkey_sign_hash( sk, ak_random_thread_local(), hash, hsize,
+                                                     sign, sizeof( sign )) != ak_error_ok )
+         _exit( EXIT_FAILURE );
+       if( !ak_verifykey_verify_hash( vk, hash, hsize, sign )) _exit( EXIT_FAILURE );
+       if( ak_signkey_nonce_pool_destroy( sk ) != ak_error_ok ) _exit( EXIT_FAILURE );
+       _exit( EXIT_SUCCESS );
+     }
+     waitpid( pid, &status, 0 );
+     if( !WIFEXITED( status ) || ( WEXITSTATUS( status ) != EXIT_SUCCESS )) {
+       printf("child process %u can't use nonce pool\n", (unsigned int) i );
+       result = ak_false;
+     }
+  }
+
+  counter_stop = ak_true;
+  pthread_join( counter, NULL );
+ return result;
+}
+#endif
+#endif
+
+/* ----------------------------------------------------------------------------------------------- */
+ int main( void )
+{
+  size_t i = 0;
+  struct signkey sk;
+  struct verifykey vk;
+  struct random generator;
+  ak_uint32 seed = 3105;
+  int exitcode = EXIT_FAILURE;
+  const char *curves[] = {
+    "id-tc26-gost-3410-2012-256-paramSetB", "id-tc26-gost-3410-2012-512-paramSetC" };
+
+  ak_libakrypt_create( ak_function_log_stderr );
+  ak_random_create_lcg( &generator );
+  ak_random_randomize( &generator, &seed, sizeof( seed ));
+
+  for( i = 0; i < sizeof( curves )/sizeof( char * ); i++ ) {
+     if( ak_signkey_create_str( &sk, curves[i] ) != ak_error_ok ) goto ex;
+     ak_signkey_set_key_random( &sk, &generator );
+     ak_verifykey_create_from_signkey( &vk, &sk );
+
+    /* пул заполняется явным вызовом функции и исчерпывается в процессе выработки подписей */
+     if( ak_signkey_nonce_pool_create( &sk, pool_capacity, ak_false ) != ak_error_ok ) goto ex2;
+     if( ak_signkey_nonce_pool_fill( &sk ) != ak_error_ok ) goto ex2;
+     if( ak_signkey_nonce_pool_count( &sk ) != pool_capacity ) goto ex2;
+     if( !check_signs( &sk, &vk, &generator )) goto ex2;
+     if( ak_signkey_nonce_pool_count( &sk ) != 0 ) goto ex2;
+     printf("%s: pool: Ok\n", curves[i] );
+
+   #if defined(__unix__) || defined(__APPLE__)
+    /* значения пула не копируются в дочерний процесс */
+     if( ak_signkey_nonce_pool_fill( &sk ) != ak_error_ok ) goto ex2;
+     if( !check_fork( &sk, &vk, &generator )) goto ex2;
+     printf("%s: pool after fork: Ok\n", curves[i] );
+   #endif
+
+   #ifdef AK_HAVE_PTHREAD_H
+    /* пул заполняется фоновым потоком одновременно с выработкой подписей */
+     if( ak_signkey_nonce_pool_create( &sk, pool_capacity, ak_true ) != ak_error_ok ) goto ex2;
+     if( !check_signs( &sk, &vk, &generator )) goto ex2;
+     printf("%s: background pool: Ok\n", curves[i] );
+   #endif
+
+   #if ( defined(__unix__) || defined(__APPLE__)) && defined( AK_HAVE_PTHREAD_H )
+    /* fork() при работающем фоновом потоке */
+     if( !check_fork_background( &sk, &vk, &generator )) goto ex2;
+     printf("%s: fork with background pool: Ok\n", curves[i] );
+   #endif
+
+    /* пул уничтожается вместе с ключом */
+     ak_signkey_destroy( &sk );
+     ak_verifykey_destroy( &vk );
+  }
+  exitcode = EXIT_SUCCESS;
+  goto ex;
+
+  ex2:
+   printf("%s: Wrong\n", curves[i] );
+   ak_signkey_destroy( &sk );
+   ak_verifykey_destroy( &vk );
+  ex:
+   ak_random_destroy( &generator );
+   ak_libakrypt_destroy();
+
+ return exitcode;
+}
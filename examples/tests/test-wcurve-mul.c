@@ -0,0 +1,353 @@
+/* ----------------------------------------------------------------------------------------------- */
+/* Тест проверяет умножение вычетов в представлении Монтгомери и совпадение кратных точек,
+   вычисляемых различными способами, для всех эллиптических кривых, известных библиотеке          */
+/* ----------------------------------------------------------------------------------------------- */
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <libakrypt.h>
+
+/* ----------------------------------------------------------------------------------------------- */
+ static bool_t is_equal( ak_wpoint wp, ak_wpoint wq, ak_wcurve ec )
+{
+  ak_wpoint_reduce( wp, ec );
+  ak_wpoint_reduce( wq, ec );
+  if( ak_mpzn_cmp( wp->x, wq->x, ec->size ) != 0 ) return ak_false;
+  if( ak_mpzn_cmp( wp->y, wq->y, ec->size ) != 0 ) return ak_false;
+  if( ak_mpzn_cmp( wp->z, wq->z, ec->size ) != 0 ) return ak_false;
+ return ak_true;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/* вычисление xy (mod p) с помощью сложений и удвоений */
+ static void mul_slow( ak_uint64 *z, ak_uint64 *x, ak_uint64 *y, ak_uint64 *p, size_t size )
+{
+  long long int i = 0;
+  ak_mpzn512 r = ak_mpzn512_zero;
+
+  for( i = 64*size -1; i >= 0; i-- ) {
+     ak_mpzn_lshift_montgomery( r, r, p, size );
+     if(( y[i>>6] >> ( i&0x3f ))&1 ) ak_mpzn_add_montgomery( r, r, x, p, size );
+  }
+  ak_mpzn_set( z, r, size );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/* сравнение умножения и возведения в квадрат в представлении Монтгомери, а также
+   редукции Барретта с умножением с помощью сложений по модулям p и q */
+ static bool_t check_montgomery_modulo( ak_uint64 *p, ak_uint64 *r2, ak_uint64 n,
+                                      ak_uint64 *mu, ak_wcurve ec, ak_random generator )
+{
+  size_t i = 0;
+  ak_mpzn512 x, y, a, b, c;
+  ak_mpznmax u;
+
+  for( i = 0; i < 20; i++ ) {
+     ak_mpzn_set_random_modulo( x, p, ec->size, generator );
+     ak_mpzn_set_random_modulo( y, p, ec->size, generator );
+     if( i == 0 ) { ak_mpzn_set_ui( a, ec->size, 1 ); ak_mpzn_sub( x, p, a, ec->size ); }
+     if( i == 1 ) ak_mpzn_set( y, x, ec->size );
+     mul_slow( c, x, y, p, ec->size );
+
+     ak_mpzn_mul_montgomery( a, x, r2, p, n, ec->size );
+     ak_mpzn_mul_montgomery( b, a, y, p, n, ec->size );
+     if( ak_mpzn_cmp( b, c, ec->size ) != 0 ) {
+       printf(" montgomery multiplication is wrong for x = %s", ak_mpzn_to_hexstr( x, ec->size ));
+       printf(", y = %s\n", ak_mpzn_to_hexstr( y, ec->size ));
+       return ak_false;
+     }
+    /* xy (mod p) = barrett( xy ) */
+     ak_mpzn_mul( u, x, y, ec->size );
+     ak_mpzn_rem_barrett( b, u, p, mu, ec->size );
+     if( ak_mpzn_cmp( b, c, ec->size ) != 0 ) {
+       printf(" barrett reduction is wrong for x = %s", ak_mpzn_to_hexstr( x, ec->size ));
+       printf(", y = %s\n", ak_mpzn_to_hexstr( y, ec->size ));
+       return ak_false;
+     }
+    /* x^2 = mont( mont( xR, xR ), 1 ) */
+     mul_slow( c, x, x, p, ec->size );
+     ak_mpzn_sqr_montgomery( b, a, p, n, ec->size );
+     ak_mpzn_set_ui( y, ec->size, 1 );
+     ak_mpzn_mul_montgomery( b, b, y, p, n, ec->size );
+     if( ak_mpzn_cmp( b, c, ec->size ) != 0 ) {
+       printf(" montgomery squaring is wrong for x = %s\n", ak_mpzn_to_hexstr( x, ec->size ));
+       return ak_false;
+     }
+    /* x*x^{-1} = 1, обращение в представлении Монтгомери: mont( (xR)^{-1}R, xR ) = R */
+     if( ak_mpzn_cmp_ui( x, ec->size, 0 )) continue;
+     ak_mpzn_inverse( b, x, p, ec->size );
+     mul_slow( c, x, b, p, ec->size );
+     if( !ak_mpzn_cmp_ui( c, ec->size, 1 )) {
+       printf(" inversion is wrong for x = %s\n", ak_mpzn_to_hexstr( x, ec->size ));
+       return ak_false;
+     }
+     ak_mpzn_inverse_montgomery( b, a, p, n, r2, ec->size );
+     ak_mpzn_mul_montgomery( b, b, a, p, n, ec->size );
+     ak_mpzn_mul_montgomery( b, b, y, p, n, ec->size );
+     if( !ak_mpzn_cmp_ui( b, ec->size, 1 )) {
+       printf(" montgomery inversion is wrong for x = %s\n", ak_mpzn_to_hexstr( x, ec->size ));
+       return ak_false;
+     }
+  }
+ return ak_true;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+ static bool_t check_montgomery( ak_wcurve ec, ak_random generator )
+{
+  if( !check_montgomery_modulo( ec->p, ec->r2, ec->n, ec->mu, ec, generator )) return ak_false;
+ return check_montgomery_modulo( ec->q, ec->r2q, ec->nq, ec->muq, ec, generator );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/* сравнение редукции Барретта для вычетов u = h*2^{64*size} + l произвольной двойной длины
+   с вычислением (h mod p)*(2^{64*size} mod p) + (l mod p) */
+ static bool_t check_barrett_modulo( ak_uint64 *p, ak_uint64 *r2, ak_uint64 n,
+                                      ak_uint64 *mu, ak_wcurve ec, ak_random generator )
+{
+  size_t i = 0;
+  ak_mpznmax u;
+  ak_mpzn512 r, h, l, c, one = ak_mpzn512_one;
+
+ /* r = 2^{64*size} (mod p) */
+  ak_mpzn_mul_montgomery( r, r2, one, p, n, ec->size );
+  for( i = 0; i < 20; i++ ) {
+     if( i == 0 ) memset( u, 0xff, sizeof( u ));
+      else ak_mpzn_set_random( u, 2*ec->size, generator );
+     ak_mpzn_rem( h, u +ec->size, p, ec->size );
+     ak_mpzn_rem( l, u, p, ec->size );
+     mul_slow( c, h, r, p, ec->size );
+     ak_mpzn_add_montgomery( c, c, l, p, ec->size );
+
+     ak_mpzn_rem_barrett( h, u, p, mu, ec->size );
+     if( ak_mpzn_cmp( h, c, ec->size ) != 0 ) {
+       printf(" barrett reduction is wrong for u = %s\n", ak_mpzn_to_hexstr( u, 2*ec->size ));
+       return ak_false;
+     }
+  }
+ return ak_true;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+ static bool_t check_barrett( ak_wcurve ec, ak_random generator )
+{
+  if( !check_barrett_modulo( ec->p, ec->r2, ec->n, ec->mu, ec, generator )) return ak_false;
+ return check_barrett_modulo( ec->q, ec->r2q, ec->nq, ec->muq, ec, generator );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/* вычисление [k]P методом "удвоить и сложить" с использованием только формул
+   для кривой в форме Вейерштрасса (для кривых Эдвардса ak_wpoint_pow() их не использует) */
+ static void pow_slow( ak_wpoint wq, ak_wpoint wp, ak_uint64 *k, ak_wcurve ec )
+{
+  long long int i = 0;
+
+  ak_wpoint_set_as_unit( wq, ec );
+  for( i = 64*ec->size -1; i >= 0; i-- ) {
+     ak_wpoint_double( wq, ec );
+     if(( k[i >> 6] >> ( i&0x3f ))&1 ) ak_wpoint_add( wq, wp, ec );
+  }
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/* сравнение ak_wpoint_pow() с методом "удвоить и сложить" для граничных значений k:
+   2^{64size}-1 (старшее окно заполнено полностью), 2^{64size}-2 (четное k) и q */
+ static bool_t check_pow( ak_wcurve ec, ak_random generator )
+{
+  size_t i = 0, l = 0;
+  struct wpoint wp, wq, wr;
+  ak_mpzn512 k;
+
+ /* в качестве исходной точки используется случайная кратная образующей точки */
+  ak_mpzn_set_random_modulo( k, ec->q, ec->size, generator );
+  ak_wpoint_pow_base( &wr, k, ec );
+  for( i = 0; i < 3; i++ ) {
+     for( l = 0; l < ec->size; l++ ) k[l] = 0xffffffffffffffffLL;
+     if( i == 1 ) k[0]--;
+     if( i == 2 ) ak_mpzn_set( k, ec->q, ec->size );
+     ak_wpoint_pow( &wp, &wr, k, ec->size, ec );
+     pow_slow( &wq, &wr, k, ec );
+     if( !is_equal( &wp, &wq, ec )) {
+       printf(" point multiplication is wrong for k = %s\n", ak_mpzn_to_hexstr( k, ec->size ));
+       return ak_false;
+     }
+  }
+ /* [q]P является бесконечно удаленной точкой */
+ return ak_mpzn_cmp_ui( wp.z, ec->size, 0 );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/* сравнение ak_wpoint_pow_base() с ak_wpoint_pow() */
+ static bool_t check_base( ak_wcurve ec, ak_random generator )
+{
+  size_t i = 0;
+  struct wpoint wp, wq;
+  ak_mpzn512 k;
+
+  for( i = 0; i < 20; i++ ) {
+     switch( i ) {
+       case 0: ak_mpzn_set_ui( k, ec->size, 0 ); break;
+       case 1: ak_mpzn_set_ui( k, ec->size, 1 ); break;
+       case 2: ak_mpzn_set_ui( k, ec->size, 2 ); break;
+       case 3: ak_mpzn_set_ui( k, ec->size, 1 );
+               ak_mpzn_sub( k, ec->q, k, ec->size ); break;
+       default: ak_mpzn_set_random_modulo( k, ec->q, ec->size, generator );
+     }
+     ak_wpoint_pow( &wp, &ec->point, k, ec->size, ec );
+     ak_wpoint_pow_base( &wq, k, ec );
+     if( !is_equal( &wp, &wq, ec )) {
+       printf(" base point multiplication is wrong for k = %s\n", ak_mpzn_to_hexstr( k, ec->size ));
+       return ak_false;
+     }
+     if( i < 6 ) {
+       pow_slow( &wq, &ec->point, k, ec );
+       if( !is_equal( &wp, &wq, ec )) {
+         printf(" point multiplication differs from double-and-add for k = %s\n",
+                                                               ak_mpzn_to_hexstr( k, ec->size ));
+         return ak_false;
+       }
+     }
+    /* удвоение, выбранное по виду кривой: [2]([k]P) = [2k]P */
+     ak_wpoint_double( &wp, ec );
+     ak_mpzn_lshift_montgomery( k, k, ec->q, ec->size );
+     ak_wpoint_pow_base( &wq, k, ec );
+     if( !ak_wpoint_is_ok( &wp, ec ) || !is_equal( &wp, &wq, ec )) {
+       printf(" point doubling is wrong for k = %s\n", ak_mpzn_to_hexstr( k, ec->size ));
+       return ak_false;
+     }
+  }
+ return ak_true;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/* сравнение ak_wpoint_pow_pair() с суммой двух вызовов ak_wpoint_pow() */
+ static bool_t check_pair( ak_wcurve ec, ak_random generator )
+{
+  size_t i = 0;
+  struct wpoint wp, wq, wr, tp;
+  struct wpoint_table wt;
+  ak_mpzn512 k1, k2, t;
+  ak_wcurve other = NULL;
+
+ /* в качестве второй точки используется случайная кратная образующей точки */
+  ak_mpzn_set_random_modulo( t, ec->q, ec->size, generator );
+  ak_wpoint_pow( &wq, &ec->point, t, ec->size, ec );
+  ak_wpoint_reduce( &wq, ec );
+  if( ak_wpoint_table_create( &wt, &wq, 7, ec ) != ak_error_ok ) return ak_false;
+
+  for( i = 0; i < 20; i++ ) {
+     ak_mpzn_set_random_modulo( k1, ec->q, ec->size, generator );
+     ak_mpzn_set_random_modulo( k2, ec->q, ec->size, generator );
+     switch( i ) {
+       case 0: ak_mpzn_set_ui( k1, ec->size, 0 ); break;
+       case 1: ak_mpzn_set_ui( k2, ec->size, 0 ); break;
+       case 2: ak_mpzn_set_ui( k1, ec->size, 1 ); ak_mpzn_set_ui( k2, ec->size, 1 ); break;
+       case 3: ak_mpzn_set_ui( k1, ec->size, 1 );
+               ak_mpzn_sub( k1, ec->q, k1, ec->size );
+               ak_mpzn_set( k2, k1, ec->size ); break;
+       default: break;
+     }
+     ak_wpoint_pow( &wp, &ec->point, k1, ec->size, ec );
+     ak_wpoint_pow( &tp, &wq, k2, ec->size, ec );
+     ak_wpoint_add( &wp, &tp, ec );
+     ak_wpoint_pow_pair( &wr, k1, &wq, k2, ec );
+     if( !is_equal( &wp, &wr, ec )) {
+       printf(" double scalar multiplication is wrong for k1 = %s", ak_mpzn_to_hexstr( k1, ec->size ));
+       printf(", k2 = %s\n", ak_mpzn_to_hexstr( k2, ec->size ));
+       return ak_false;
+     }
+     if(( ak_wpoint_pow_pair_table( &wr, k1, &wt, k2, ec ) != ak_error_ok ) ||
+                                                                    ( !is_equal( &wp, &wr, ec ))) {
+       printf(" double scalar multiplication with table is wrong for k1 = %s",
+                                                               ak_mpzn_to_hexstr( k1, ec->size ));
+       printf(", k2 = %s\n", ak_mpzn_to_hexstr( k2, ec->size ));
+       ak_wpoint_table_destroy( &wt );
+       return ak_false;
+     }
+  }
+
+ /* таблица, созданная для другой кривой, не должна использоваться */
+  other = ( ak_wcurve ) &id_tc26_gost_3410_2012_256_paramSetA;
+  if( other == ec ) other = ( ak_wcurve ) &id_rfc4357_gost_3410_2001_paramSetA;
+  if( ak_wpoint_pow_pair_table( &wr, k1, &wt, k2, other ) != ak_error_curve_not_equal ) {
+    printf(" table created for another curve is accepted\n");
+    ak_wpoint_table_destroy( &wt );
+    return ak_false;
+  }
+  ak_wpoint_table_destroy( &wt );
+  if( ak_wpoint_pow_pair_table( &wr, k1, &wt, k2, ec ) != ak_error_null_pointer ) {
+    printf(" undefined table is accepted\n");
+    return ak_false;
+  }
+
+ /* вторая точка совпадает с образующей: проверяем случаи совпадения слагаемых
+    и получения бесконечно удаленной точки */
+  ak_wpoint_set_wpoint( &wq, &ec->point, ec );
+  for( i = 0; i < 4; i++ ) {
+     ak_mpzn_set_random_modulo( k1, ec->q, ec->size, generator );
+     if( i&1 ) ak_mpzn_sub( k2, ec->q, k1, ec->size );
+      else ak_mpzn_set( k2, k1, ec->size );
+     ak_wpoint_pow( &wp, &ec->point, k1, ec->size, ec );
+     ak_wpoint_pow( &tp, &wq, k2, ec->size, ec );
+     ak_wpoint_add( &wp, &tp, ec );
+     ak_wpoint_pow_pair( &wr, k1, &wq, k2, ec );
+     if( !is_equal( &wp, &wr, ec )) {
+       printf(" double scalar multiplication is wrong for equal points\n");
+       return ak_false;
+     }
+  }
+ return ak_true;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/* сравнение ak_mpzn_rem_uint32() с побитовым вычислением остатка для вычетов максимальной длины */
+ static bool_t check_rem_uint32( ak_random generator )
+{
+  long long int j = 0;
+  size_t i = 0;
+  ak_mpznmax x;
+  ak_uint32 p[] = { 3, 65537, 0x7fffffff, 0xfffffffb, 0xffffffff };
+
+  for( i = 0; i < sizeof( p )/sizeof( ak_uint32 ); i++ ) {
+     ak_uint64 r = 0;
+     if( i&1 ) memset( x, 0xff, sizeof( x ));
+      else ak_mpzn_set_random( x, ak_mpznmax_size, generator );
+     for( j = 64*ak_mpznmax_size -1; j >= 0; j-- ) r = ( 2*r + (( x[j>>6] >> ( j&0x3f ))&1 ))%p[i];
+     if( ak_mpzn_rem_uint32( x, ak_mpznmax_size, p[i] ) != r ) {
+       printf("remainder modulo %u is wrong\n", p[i] );
+       return ak_false;
+     }
+  }
+ return ak_true;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+ int main( void )
+{
+  struct random generator;
+  int exitcode = EXIT_SUCCESS;
+  ak_oid oid = NULL;
+
+  ak_libakrypt_create( ak_function_log_stderr );
+  ak_random_create_lcg( &generator );
+  if( !check_rem_uint32( &generator )) exitcode = EXIT_FAILURE;
+
+  oid = ak_oid_find_by_engine( identifier );
+  while( oid != NULL ) {
+    if( oid->mode == wcurve_params ) {
+      ak_wcurve ec = ( ak_wcurve ) oid->data;
+      bool_t result = check_montgomery( ec, &generator ) && check_barrett( ec, &generator ) &&
+                      check_base( ec, &generator ) && check_pow( ec, &generator ) &&
+                                                                     check_pair( ec, &generator );
+
+      printf("%s: %s\n", oid->name[0], result ? "Ok" : "Wrong" );
+      if( !result ) exitcode = EXIT_FAILURE;
+    }
+    oid = ak_oid_findnext_by_engine( oid, identifier );
+  }
+
+  ak_random_destroy( &generator );
+  ak_libakrypt_destroy();
+
+ return exitcode;
+}
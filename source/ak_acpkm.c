@@ -7,6 +7,97 @@
 /* ----------------------------------------------------------------------------------------------- */
  #include "libakrypt-internal.h"
 
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Параметры режима ACPKM, определяемые опциями библиотеки.
+    \details Параметры считываются один раз при обращении к функциям режима и используются
+    на всех границах секций.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ typedef struct acpkm_params {
+  /*! \brief длина секции (ресурс производного ключа) в блоках */
+   ssize_t section;
+  /*! \brief ресурс ключа алгоритма блочного шифрования (количество блоков) */
+   ssize_t resource;
+  /*! \brief признак разворота производного ключа Магма (режим совместимости с openssl) */
+   bool_t reverse;
+ } *ak_acpkm_params;
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция считывает значения опций, определяющих параметры режима ACPKM.
+
+    @param bkey Контекст ключа алгоритма блочного шифрования.
+    @param params Структура, в которую помещаются параметры режима.
+    @return В случае возникновения ошибки функция возвращает ее код, в противном случае
+    возвращается \ref ak_error_ok (ноль)                                                           */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_bckey_acpkm_params( ak_bckey bkey, ak_acpkm_params params )
+{
+  switch( bkey->bsize ) {
+    case  8: /* шифр с длиной блока 64 бита */
+       params->section = ak_libakrypt_get_option_by_name( "acpkm_section_magma_block_count" );
+       params->resource = ak_libakrypt_get_option_by_name( "magma_cipher_resource" );
+       params->reverse = ( ak_libakrypt_get_option_by_name( "openssl_compability" ) == 1 ) &&
+                                         ( strncmp( bkey->key.oid->name[0], "magma", 5 ) == 0 );
+       break;
+    case 16: /* шифр с длиной блока 128 бит */
+       params->section = ak_libakrypt_get_option_by_name( "acpkm_section_kuznechik_block_count" );
+       params->resource = ak_libakrypt_get_option_by_name( "kuznechik_cipher_resource" );
+       params->reverse = ak_false;
+       break;
+    default: return ak_error_message( ak_error_wrong_block_cipher,
+                                           __func__ , "incorrect block size of block cipher key" );
+  }
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция вычисляет новое значение секретного ключа и устанавливает его ресурс.
+
+    Новое значение помещается непосредственно в буффер ключа, после чего ключ маскируется,
+    для него вычисляется контрольная сумма (она проверяется процедурой развертки) и
+    вырабатываются раундовые ключи. Функция не выполняет проверок контекста и не обращается
+    к опциям библиотеки: используются параметры, считанные вызывающей функцией.
+
+    @param bkey Контекст ключа алгоритма блочного шифрования.
+    @param params Параметры режима ACPKM.
+    @return В случае возникновения ошибки функция возвращает ее код, в противном случае
+    возвращается \ref ak_error_ok (ноль)                                                           */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_bckey_acpkm_key_step( ak_bckey bkey, ak_acpkm_params params )
+{
+  size_t i = 0;
+  ak_uint8 new_key[32], acpkm[32] = {
+     0x9f, 0x9e, 0x9d, 0x9c, 0x9b, 0x9a, 0x99, 0x98, 0x97, 0x96, 0x95, 0x94, 0x93, 0x92, 0x91, 0x90,
+     0x8f, 0x8e, 0x8d, 0x8c, 0x8b, 0x8a, 0x89, 0x88, 0x87, 0x86, 0x85, 0x84, 0x83, 0x82, 0x81, 0x80 };
+  ak_skey skey = &bkey->key;
+  int error = ak_error_ok;
+
+ /* выработка нового значения */
+  for( i = 0; i < sizeof( new_key ); i += bkey->bsize )
+     bkey->encrypt( skey, acpkm +i, new_key +i );
+
+ /* присваиваем ключу значение (ключ Магма в режиме совместимости с openssl разворачивается) */
+  if( params->reverse ) {
+    for( i = 0; i < sizeof( new_key ); i++ ) skey->key[i] = new_key[sizeof( new_key )-1-i];
+  } else memcpy( skey->key, new_key, sizeof( new_key ));
+  memset( skey->key +sizeof( new_key ), 0, sizeof( new_key ));
+  ak_ptr_wipe( new_key, sizeof( new_key ), &skey->generator );
+
+ /* маскируем ключ, вычисляем контрольную сумму и раундовые ключи */
+  skey->flags &= (0xFFFFFFFFFFFFFFFFLL ^ key_flag_set_mask );
+  if(( error = skey->set_mask( skey )) != ak_error_ok )
+    return ak_error_message( error, __func__ , "wrong secret key masking" );
+  if(( error = skey->set_icode( skey )) != ak_error_ok )
+    return ak_error_message( error, __func__ , "wrong calculation of integrity code" );
+  if( bkey->schedule_keys != NULL ) {
+    if(( error = bkey->schedule_keys( skey )) != ak_error_ok )
+      return ak_error_message( error, __func__, "incorrect execution of key scheduling procedure" );
+  }
+
+  skey->resource.value.type = key_using_resource;
+  skey->resource.value.counter = params->section;
+ return ak_error_ok;
+}
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! \details Функция вычисляет новое значение секретного ключа в соответствии с соотношениями
     из раздела 4.1, см. Р 1323565.1.017—2018.
@@ -24,11 +115,8 @@
 /* ----------------------------------------------------------------------------------------------- */
  int ak_bckey_next_acpkm_key( ak_bckey bkey )
 {
-  ssize_t counter = 0;
   int error = ak_error_ok;
-  ak_uint8 new_key[32], acpkm[32] = {
-     0x9f, 0x9e, 0x9d, 0x9c, 0x9b, 0x9a, 0x99, 0x98, 0x97, 0x96, 0x95, 0x94, 0x93, 0x92, 0x91, 0x90,
-     0x8f, 0x8e, 0x8d, 0x8c, 0x8b, 0x8a, 0x89, 0x88, 0x87, 0x86, 0x85, 0x84, 0x83, 0x82, 0x81, 0x80 };
+  struct acpkm_params params;
 
  /* проверки */
   if( bkey == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
@@ -39,33 +127,9 @@
   if( bkey->key.check_icode( &bkey->key ) != ak_true )
     return ak_error_message( ak_error_wrong_key_icode,
                                         __func__, "incorrect integrity code of secret key value" );
- /* выработка нового значения */
-   switch( bkey->bsize ) {
-      case  8: /* шифр с длиной блока 64 бита */
-         bkey->encrypt( &bkey->key, acpkm, new_key );
-         bkey->encrypt( &bkey->key, acpkm +8, new_key +8 );
-         bkey->encrypt( &bkey->key, acpkm +16, new_key +16 );
-         bkey->encrypt( &bkey->key, acpkm +24, new_key +24 );
-         counter = ak_libakrypt_get_option_by_name( "acpkm_section_magma_block_count" );
-         break;
-      case 16: /* шифр с длиной блока 128 бит */
-         bkey->encrypt( &bkey->key, acpkm, new_key );
-         bkey->encrypt( &bkey->key, acpkm +16, new_key +16 );
-         counter = ak_libakrypt_get_option_by_name( "acpkm_section_kuznechik_block_count" );
-         break;
-      default: return ak_error_message( ak_error_wrong_block_cipher,
-                                           __func__ , "incorrect block size of block cipher key" );
-   }
-
- /* присваиваем ключу значение */
-  if(( error = ak_bckey_set_key( bkey, new_key, bkey->key.key_size )) != ak_error_ok )
-    ak_error_message( error, __func__ , "can't replace key by new using acpkm" );
-   else {
-           bkey->key.resource.value.type = key_using_resource;
-           bkey->key.resource.value.counter = counter;
-        }
-  ak_ptr_wipe( new_key, sizeof( new_key ), &bkey->key.generator );
- return error;
+  if(( error = ak_bckey_acpkm_params( bkey, &params )) != ak_error_ok ) return error;
+
+ return ak_bckey_acpkm_key_step( bkey, &params );
 }
 
 /* ----------------------------------------------------------------------------------------------- */
@@ -146,13 +210,16 @@
 {
   struct bckey nkey;
   int error = ak_error_ok;
-  ssize_t j = 0, sections = 0, tail = 0, seclen = 0, maxseclen = 0, mcount = 0;
+  struct acpkm_params params;
+  ssize_t j = 0, sections = 0, tail = 0, seclen = 0, mcount = 0;
   ak_uint64 yaout[2], *inptr = (ak_uint64 *)in, *outptr = (ak_uint64 *)out, ctr[2] = { 0, 0 };
 
  /* выполняем проверку размера входных данных */
   if( section_size%bkey->bsize != 0 )
     return ak_error_message( ak_error_wrong_block_cipher_length,
                                __func__ , "the length of section is not divided by block length" );
+  if( bkey->key.key_size != 32 ) return ak_error_message_fmt( ak_error_wrong_length, __func__,
+              "using block cipher key with unexpected length %u", (unsigned int) bkey->key.key_size );
  /* проверяем целостность ключа */
   if( bkey->key.check_icode( &bkey->key ) != ak_true )
     return ak_error_message( ak_error_wrong_key_icode, __func__,
@@ -166,28 +233,19 @@
 
  /* получаем максимально возможную длину секции, количество сообщений на одном ключе,
                                                              а также устанавливаем синхропосылку */
-  switch( bkey->bsize ) {
-    case 8:
-       maxseclen = ak_libakrypt_get_option_by_name( "acpkm_section_magma_block_count" );
-       mcount = ak_libakrypt_get_option_by_name( "magma_cipher_resource" )/maxseclen;
-       #ifdef AK_LITTLE_ENDIAN
-         ctr[0] = ((ak_uint64 *)iv)[0] << 32;
-       #else
-         ctr[0] = ((ak_uint32 *)iv)[0];
-       #endif
-      break;
-
-    case 16:
-       maxseclen = ak_libakrypt_get_option_by_name( "acpkm_section_kuznechik_block_count" );
-       mcount = ak_libakrypt_get_option_by_name( "kuznechik_cipher_resource" )/maxseclen;
-       ctr[1] = ((ak_uint64 *) iv)[0];
-      break;
-    default: return ak_error_message( ak_error_wrong_block_cipher,
-                                           __func__ , "incorrect block size of block cipher key" );
-  }
+  if(( error = ak_bckey_acpkm_params( bkey, &params )) != ak_error_ok ) return error;
+  mcount = params.resource/params.section;
+  if( bkey->bsize == 8 ) {
+   #ifdef AK_LITTLE_ENDIAN
+    ctr[0] = ((ak_uint64 *)iv)[0] << 32;
+   #else
+    ctr[0] = ((ak_uint32 *)iv)[0];
+   #endif
+  } else ctr[1] = ((ak_uint64 *) iv)[0];
+
  /* проверяем, что пользователь определил длину секции не очень большим значением */
   seclen = ( ssize_t )( section_size/bkey->bsize );
-  if( seclen > maxseclen ) return ak_error_message( ak_error_wrong_length, __func__,
+  if( seclen > params.section ) return ak_error_message( ak_error_wrong_length, __func__,
                                                                  "section has very large length" );
  /* проверяем ресурс ключа перед использованием */
   if( bkey->key.resource.value.type != key_using_resource ) { /* мы пришли сюда в первый раз */
@@ -205,7 +263,7 @@
   if(( error = ak_bckey_create_and_set_bckey( &nkey, bkey )) != ak_error_ok )
     return ak_error_message( error, __func__, "incorrect key duplication" );
  /* и меняем ресурс для производного ключа */
-  nkey.key.resource.value.counter = maxseclen;
+  nkey.key.resource.value.counter = params.section;
 
  /* дальнейшие криптографические действия применяются к новому экземпляру ключа */
   sections = ( ssize_t )( size/section_size );
@@ -218,8 +276,10 @@
          default: ak_error_message( ak_error_wrong_block_cipher,
                                            __func__ , "incorrect block size of block cipher key" );
        }
-      /* вычисляем следующий ключ */
-       if(( error = ak_bckey_next_acpkm_key( &nkey )) != ak_error_ok ) {
+      /* вычисляем следующий ключ, только если он будет использован;
+         параметры режима уже считаны, поэтому опции повторно не используются */
+       if(( sections == 1 ) && ( tail == 0 )) break;
+       if(( error = ak_bckey_acpkm_key_step( &nkey, &params )) != ak_error_ok ) {
          ak_error_message_fmt( error, __func__, "incorrect key generation after %u sections",
                                                                          (unsigned int) sections );
          goto labex;
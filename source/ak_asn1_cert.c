@@ -1973,11 +1973,18 @@
   memcpy( vptr.subject->opts.signature, bs.value,
                                           ak_min( bs.len, sizeof( vptr.subject->opts.signature )));
 
- /* 3.3.3  - только сейчас проверяем подпись под данными */
+ /* 3.3.3  - только сейчас проверяем подпись под данными;
+    таблицы предвычислений для ключа эмитента совместно используются всеми сертификатами,
+    подписанными этим ключом */
+  if( ak_libakrypt_get_option_by_name( "verifykey_cache_size" ) > 0 )
+    ak_verifykey_precompute( &vptr.issuer->vkey );
   if( ak_verifykey_verify_ptr( &vptr.issuer->vkey, buffer, size, bs.value ) != ak_true ) {
      ak_error_message( error = ak_error_not_equal_data, __func__, "digital signature isn't valid" );
      goto lab1;
   }
+ /* 3.4 - подготавливаем открытый ключ сертификата к проверке подписей */
+  if( ak_libakrypt_get_option_by_name( "verifykey_cache_size" ) > 0 )
+    ak_verifykey_precompute( &vptr.subject->vkey );
 
  /* 4. если открытый ключ проверки подписи был создан в ходе работы функции, его надо удалить */
   lab1:
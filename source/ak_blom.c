@@ -5,6 +5,13 @@
 /* ----------------------------------------------------------------------------------------------- */
  #include <libakrypt-internal.h>
 
+#ifdef AK_HAVE_STDLIB_H
+ #include <stdlib.h>
+#endif
+#ifdef AK_HAVE_PTHREAD_H
+ #include <pthread.h>
+#endif
+
 /* ----------------------------------------------------------------------------------------------- */
 /** \addtogroup skey-blom-doc Реализация схемы Блома распределения ключевой информации
  *  @{
@@ -58,9 +65,15 @@
   \f\[ Kab = f_a\left( \texttt{Streebog}_n(IDb) \right). \f\]
 
   Создание ключа абонента \f$ Ka \f$ выполняется с помощью функции ak_blomkey_create_abonent_key().
+  Ключи для массива абонентов могут быть выработаны (и экспортированы в файлы) с использованием
+  нескольких потоков с помощью функции ak_blomkey_create_abonent_keys().
 
   Создание ключа парной связи \f$ Kab \f$ - с помощью функции ak_blomkey_create_pairwise_key_as_ptr().
 
+  Для абонентов, повторно вырабатывающих ключи парной связи с одними и теми же абонентами,
+  с ключом абонента может быть связан кэш ключей парной связи ограниченного размера,
+  см. функцию ak_blomkey_cache_create().
+
   Удаление созданных ключей выполняется с помощью функции ak_blomkey_destroy().
 
   Экспорт и импорт абонентских ключей и мастер-ключа из файловых контейнеров осуществляется
@@ -70,9 +83,13 @@
   - ak_blomkey_import_from_file_with_password().
 
   Отметим, что неприводимые многочлены, используемые для реализации элементарных операций
-  в конечном поле \f$ GF(2^n)\f$, определены в файле ak_gf2n.c                                  @} */
+  в конечном поле \f$ GF(2^n)\f$, определены в файле ak_gf2n.c. Там же реализовано
+  вычисление значений многочленов ak_gf2n_polynomial(), которое при наличии команды pclmulqdq
+  выполняет одно приведение по модулю на каждые \ref ak_gf2n_horner_block коэффициентов.         @} */
+/*! \brief Проверка целостности ключа; контрольная сумма вычисляется с помощью заданного
+    контекста хеширования (функция не изменяет контекст ключа).                                    */
 /* ----------------------------------------------------------------------------------------------- */
- static bool_t ak_blomkey_check_icode( ak_blomkey bkey )
+ static bool_t ak_blomkey_check_icode( ak_blomkey bkey, ak_hash hctx )
 {
   ak_uint8 value[32];
 
@@ -87,7 +104,7 @@
 
  /* вычисляем контрольную сумму и сравниваем */
   memset( value, 0, sizeof( value ));
-  ak_hash_ptr( &bkey->ctx, bkey->data,
+  ak_hash_ptr( hctx, bkey->data,
                     bkey->type == blom_matrix_key ? (bkey->size)*(bkey->size)*bkey->count :
                                                              (bkey->size)*bkey->count, value, 32 );
   if( ak_ptr_is_equal( value, bkey->icode, 32 ) == ak_false ) {
@@ -129,6 +146,7 @@
   bkey->type = blom_matrix_key;
   bkey->count = count;
   bkey->size = size;
+  bkey->cache = NULL;
   if(( bkey->data = malloc( memsize + 16 )) == NULL ) /* 16 это размер имитовставки */
     return ak_error_message( ak_error_out_of_memory, __func__, "incorrect memory allocation" );
 
@@ -158,6 +176,53 @@
  return error;
 }
 
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция инициализирует контекст ключа абонента и вычисляет степени хэш-кода
+    его идентификатора; ключевые данные заполняются нулями.
+
+    Целостность мастер-ключа функцией не проверяется.                                              */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_blomkey_create_abonent_context( ak_blomkey bkey, ak_blomkey matrix,
+                                   ak_pointer id, const size_t idsize, ak_gf2n_powers powers )
+{
+  ak_uint8 value[64];
+  size_t memsize = 0;
+  int error = ak_error_ok;
+
+  if( bkey == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                           "using null pointer to abonent's key" );
+  if(( id == NULL ) || ( !idsize )) return ak_error_message( ak_error_undefined_value, __func__,
+                                                          "using undefined abonent's identifier" );
+  memset( bkey, 0, sizeof( struct blomkey ));
+  bkey->count = matrix->count;
+  bkey->size = matrix->size;
+  bkey->type = blom_abonent_key;
+
+ /* создаем контекст хеш-функции */
+  if(( error = ak_hash_create_oid( &bkey->ctx, matrix->ctx.oid )) != ak_error_ok )
+    return ak_error_message( error, __func__, "incorrect creation of hash function context" );
+ /* формируем хэш от идентификатора */
+  if(( error = ak_hash_ptr( &bkey->ctx, id, idsize, value, bkey->count )) != ak_error_ok ) {
+    ak_blomkey_destroy( bkey );
+    return ak_error_message( error, __func__, "incorrect evauation of initial hash value" );
+  }
+
+ /* формируем ключевые данные */
+  if(( bkey->data = malloc( ( memsize = bkey->size*matrix->count ) + 16 )) == NULL ) {
+    ak_blomkey_destroy( bkey );
+    return ak_error_message( ak_error_out_of_memory, __func__, "incorrect memory allocation" );
+  }
+  memset( bkey->data, 0, memsize + 16 );
+
+ /* степени хэш-кода вычисляются один раз для всех строк матрицы */
+  if(( error = ak_gf2n_powers_create( powers, value, bkey->count )) != ak_error_ok ) {
+    ak_blomkey_destroy( bkey );
+    return ak_error_message( error, __func__, "incorrect evaluation of hash value powers" );
+  }
+  memset( value, 0, sizeof( value ));
+ return error;
+}
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! Вырабатываемый ключ предназначается для конкретного абонента и
     однозначно зависит от его идентификатора и мастер-ключа.
@@ -171,10 +236,8 @@
  int ak_blomkey_create_abonent_key( ak_blomkey bkey, ak_blomkey matrix,
                                                                ak_pointer id, const size_t idsize )
 {
-  ak_uint8 value[64];
-  size_t memsize = 0;
-  ak_int32 column = 0;
-  ak_uint32 i, row = 0;
+  ak_uint32 row = 0;
+  struct gf2n_powers powers;
   int error = ak_error_ok;
 
   if( bkey == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
@@ -185,42 +248,561 @@
                                                    __func__, "incorrect type of blom secret key" );
   if(( id == NULL ) || ( !idsize )) return ak_error_message( ak_error_undefined_value, __func__,
                                                           "using undefined abonent's identifier" );
-  if( !ak_blomkey_check_icode( matrix ))
+  if( !ak_blomkey_check_icode( matrix, &matrix->ctx ))
     return ak_error_message( ak_error_get_value(), __func__, "using wrong blom master key" );
 
-  memset( bkey, 0, sizeof( struct blomkey ));
-  bkey->count = matrix->count;
-  bkey->size = matrix->size;
-  bkey->type = blom_abonent_key;
+  if(( error = ak_blomkey_create_abonent_context( bkey, matrix,
+                                                       id, idsize, &powers )) != ak_error_ok )
+    return ak_error_message( error, __func__, "incorrect creation of abonent's key context" );
 
- /* создаем контекст хеш-функции */
-  if(( error = ak_hash_create_oid( &bkey->ctx, matrix->ctx.oid )) != ak_error_ok )
-    return ak_error_message( error, __func__, "incorrect creation of hash function context" );
- /* формируем хэш от идентификатора */
-  if(( error = ak_hash_ptr( &bkey->ctx, id, idsize, value, bkey->count )) != ak_error_ok )
-    return ak_error_message( error, __func__, "incorrect evauation of initial hash value" );
+  for( row = 0; row < bkey->size; row++ ) /* значения многочленов, заданных строками матрицы */
+     ak_gf2n_polynomial( bkey->data + row*bkey->count,
+                  ak_blomkey_get_element_by_index( matrix, row, 0 ), bkey->size, &powers );
+  ak_gf2n_powers_destroy( &powers );
 
- /* формируем ключевые данные */
-  if(( bkey->data = malloc( ( memsize = bkey->size*matrix->count ) + 16 )) == NULL )
-    return ak_error_message( ak_error_out_of_memory, __func__, "incorrect memory allocation" );
+  if(( error = ak_hash_ptr( &bkey->ctx, bkey->data, bkey->size*bkey->count,
+                                    bkey->icode, 32 )) != ak_error_ok ) ak_blomkey_destroy( bkey );
+ return error;
+}
 
-  memset( bkey->data, 0, memsize + 16 );
-  for( row = 0; row < bkey->size; row++ ) { /* схема Горнера для вычисления значений многочлена */
-     ak_uint8 *sum = bkey->data + row*bkey->count;
-     memset( sum, 0, bkey->count );
-     for( column = bkey->size - 1; column >= 0; column-- ) {
-        ak_uint8 *key = ak_blomkey_get_element_by_index( matrix, row, column );
-        if( bkey->count == ak_galois256_size ) ak_gf256_mul( sum, sum, value );
-         else ak_gf512_mul( sum, sum, value );
-        for( i = 0; i < ( bkey->count >> 3 ); i++ ) ((ak_uint64 *)sum)[i] ^= ((ak_uint64 *)key)[i];
+/* ----------------------------------------------------------------------------------------------- */
+/*                              пакетная выработка ключей абонентов                                */
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Количество ключей абонентов, вырабатываемых за один проход по мастер-ключу. */
+ #define ak_blomkey_batch_size  (8)
+
+/*! \brief Общие данные потоков, вырабатывающих массив ключей абонентов. */
+ typedef struct blomkey_batch_pool {
+  /*! \brief Мастер-ключ, целостность которого проверена до запуска потоков. */
+   ak_blomkey matrix;
+  /*! \brief Массив вырабатываемых ключей. */
+   ak_blomkey_batch_item items;
+  /*! \brief Количество ключей. */
+   size_t count;
+  /*! \brief Индекс первого ключа, еще не переданного ни одному потоку. */
+   size_t next;
+  /*! \brief Код первой из возникших ошибок. */
+   int error;
+ #ifdef AK_HAVE_PTHREAD_H
+  /*! \brief Мьютекс, защищающий индекс следующего ключа и код ошибки. */
+   pthread_mutex_t mutex;
+ #endif
+ } *ak_blomkey_batch_pool;
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция сохраняет код ошибки, возникшей при выработке ключа абонента. */
+ static void ak_blomkey_batch_pool_set_error( ak_blomkey_batch_pool pool,
+                                                      ak_blomkey_batch_item item, const int error )
+{
+  item->error = error;
+ #ifdef AK_HAVE_PTHREAD_H
+  pthread_mutex_lock( &pool->mutex );
+ #endif
+  if( pool->error == ak_error_ok ) pool->error = error;
+ #ifdef AK_HAVE_PTHREAD_H
+  pthread_mutex_unlock( &pool->mutex );
+ #endif
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция потока, вырабатывающего ключи абонентов группами по
+    \ref ak_blomkey_batch_size штук.
+
+    Для всех ключей группы значения многочленов вычисляются построчно, поэтому каждая строка
+    мастер-ключа считывается из памяти один раз на группу, а не один раз на каждый ключ.
+    После выработки ключи группы экспортируются в файлы и, если контекст ключа не был
+    указан пользователем, уничтожаются.                                                            */
+/* ----------------------------------------------------------------------------------------------- */
+ static void *ak_blomkey_batch_pool_worker( void *ptr )
+{
+  ak_blomkey_batch_pool pool = ptr;
+  ak_blomkey keys[ak_blomkey_batch_size];
+  struct blomkey temporary[ak_blomkey_batch_size];
+  struct gf2n_powers powers[ak_blomkey_batch_size];
+  ak_blomkey_batch_item group[ak_blomkey_batch_size];
+
+  for( ;; ) {
+     int error = ak_error_ok;
+     size_t idx = 0, end = 0, i = 0, n = 0;
+     ak_uint32 row = 0;
+
+    #ifdef AK_HAVE_PTHREAD_H
+     pthread_mutex_lock( &pool->mutex );
+    #endif
+     idx = pool->next;
+     pool->next = end = ak_min( idx +ak_blomkey_batch_size, pool->count );
+    #ifdef AK_HAVE_PTHREAD_H
+     pthread_mutex_unlock( &pool->mutex );
+    #endif
+     if( idx >= pool->count ) break;
+
+    /* создаем контексты ключей группы */
+     for( n = 0; idx < end; idx++ ) {
+        ak_blomkey_batch_item item = pool->items +idx;
+
+        item->error = ak_error_ok;
+        if(( item->key == NULL ) && ( item->filename == NULL )) {
+          ak_blomkey_batch_pool_set_error( pool, item, ak_error_message( ak_error_null_pointer,
+                                    __func__, "using null pointers to abonent's key and file" ));
+          continue;
+        }
+        keys[n] = ( item->key != NULL ) ? item->key : temporary +n;
+        if(( error = ak_blomkey_create_abonent_context( keys[n], pool->matrix,
+                                           item->id, item->idsize, powers +n )) != ak_error_ok ) {
+          ak_blomkey_batch_pool_set_error( pool, item, error );
+          continue;
+        }
+        group[n++] = item;
+     }
+
+    /* вычисляем ключи построчно */
+     for( row = 0; row < pool->matrix->size; row++ ) {
+        ak_uint8 *coef = ak_blomkey_get_element_by_index( pool->matrix, row, 0 );
+        for( i = 0; i < n; i++ )
+           ak_gf2n_polynomial( keys[i]->data + row*keys[i]->count,
+                                                      coef, pool->matrix->size, powers +i );
+     }
+
+    /* завершаем формирование ключей и экспортируем их */
+     for( i = 0; i < n; i++ ) {
+        ak_blomkey_batch_item item = group[i];
+
+        ak_gf2n_powers_destroy( powers +i );
+        if(( error = ak_hash_ptr( &keys[i]->ctx, keys[i]->data, keys[i]->size*keys[i]->count,
+                                                     keys[i]->icode, 32 )) != ak_error_ok ) {
+          ak_blomkey_batch_pool_set_error( pool, item, error );
+          ak_blomkey_destroy( keys[i] );
+          continue;
+        }
+        if(( item->filename != NULL ) &&
+           (( error = ak_blomkey_export_to_file_with_password( keys[i], item->password,
+                   item->pass_size, item->filename, item->fsize )) != ak_error_ok )) {
+          ak_blomkey_batch_pool_set_error( pool, item, error );
+          if( item->key != NULL ) ak_blomkey_destroy( keys[i] );
+        }
+        if( item->key == NULL ) ak_blomkey_destroy( keys[i] );
      }
   }
 
-  if(( error = ak_hash_ptr( &bkey->ctx, bkey->data, memsize,
-                                    bkey->icode, 32 )) != ak_error_ok ) ak_blomkey_destroy( bkey );
+ return NULL;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция вырабатывает ключи для `count` абонентов, идентификаторы которых заданы
+    в массиве `items`, и, при необходимости, экспортирует их в файлы, защищенные паролем.
+    Результаты совпадают с последовательным вызовом функций ak_blomkey_create_abonent_key() и
+    ak_blomkey_export_to_file_with_password() для каждого элемента массива.
+
+    Для каждого элемента массива:
+    - если поле `key` отлично от `NULL`, то выработанный ключ помещается в указанный контекст,
+      который должен быть впоследствии уничтожен функцией ak_blomkey_destroy();
+    - если поле `filename` отлично от `NULL`, то ключ экспортируется в файл с использованием
+      пароля `password` (смысл полей `filename` и `fsize` совпадает с параметрами функции
+      ak_blomkey_export_to_file_with_password());
+    - если поле `key` равно `NULL`, то ключ существует только во время экспорта и уничтожается
+      сразу после сохранения в файл, что позволяет обрабатывать большие массивы абонентов
+      без хранения всех ключей в памяти;
+    - код ошибки, возникшей при выработке или экспорте ключа, помещается в поле `error`;
+      при возникновении ошибки контекст `key` не содержит ключа.
+
+    Целостность мастер-ключа проверяется один раз до начала вычислений.
+    Ключи вырабатываются группами по \ref ak_blomkey_batch_size штук, для которых каждая строка
+    мастер-ключа считывается из памяти однократно; группы распределяются между потоками.
+
+    \param matrix указатель на контекст мастер-ключа
+    \param items массив вырабатываемых ключей абонентов
+    \param count количество элементов массива
+    \param threads Количество потоков; если значение равно нулю, то используется
+    количество доступных процессоров (для сборки без поддержки pthread значение игнорируется).
+    \return В случае успеха функция возвращает ноль (ak_error_ok),
+    в противном случае возвращается код первой из возникших ошибок.                                */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_blomkey_create_abonent_keys( ak_blomkey matrix, ak_blomkey_batch_item items,
+                                                            const size_t count, size_t threads )
+{
+  struct blomkey_batch_pool pool;
+
+  if( matrix == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                         "using null pointer to blom master key" );
+  if( matrix->type != blom_matrix_key ) return ak_error_message( ak_error_wrong_key_type,
+                                                   __func__, "incorrect type of blom secret key" );
+  if( items == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                       "using null pointer to abonent's array" );
+  if( !count ) return ak_error_message( ak_error_zero_length, __func__,
+                                                               "using zero count of abonents" );
+  if( !ak_blomkey_check_icode( matrix, &matrix->ctx ))
+    return ak_error_message( ak_error_get_value(), __func__, "using wrong blom master key" );
+
+  pool.matrix = matrix;
+  pool.items = items;
+  pool.count = count;
+  pool.next = 0;
+  pool.error = ak_error_ok;
+
+  if( threads == 0 ) threads = ak_libakrypt_cpu_count();
+  threads = ak_min( threads, ( count +ak_blomkey_batch_size -1 )/ak_blomkey_batch_size );
+
+ #ifdef AK_HAVE_PTHREAD_H
+  pthread_mutex_init( &pool.mutex, NULL );
+ #endif
+  ak_thread_pool_run( ak_blomkey_batch_pool_worker, &pool, threads );
+ #ifdef AK_HAVE_PTHREAD_H
+  pthread_mutex_destroy( &pool.mutex );
+ #endif
+
+ return pool.error;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*                                кэш ключей парной связи                                          */
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Максимальное количество ключей парной связи, хранимых в кэше. */
+ #define ak_blomkey_cache_max  (1048576)
+
+/*! \brief Ключ парной связи, хранимый в кэше. */
+ typedef struct blomkey_cache_entry {
+  /*! \brief хэш-код идентификатора абонента */
+   ak_uint8 id[64];
+  /*! \brief маскированное значение ключа парной связи (первые 64 октета) и маска */
+   ak_uint8 key[128];
+  /*! \brief номер предыдущего ключа в порядке вытеснения, увеличенный на единицу,
+      или ноль для первого ключа */
+   size_t prev;
+  /*! \brief номер следующего ключа в порядке вытеснения, увеличенный на единицу,
+      или ноль для последнего ключа */
+   size_t next;
+ } *ak_blomkey_cache_entry;
+
+/*! \brief Кэш ключей парной связи, связанный с ключом абонента. */
+ typedef struct blomkey_cache {
+  /*! \brief массив ключей парной связи */
+   ak_blomkey_cache_entry entries;
+  /*! \brief максимальное количество ключей */
+   size_t capacity;
+  /*! \brief текущее количество ключей */
+   size_t count;
+  /*! \brief хэш-таблица с открытой адресацией: номер ключа, увеличенный на единицу,
+      или ноль для свободной ячейки */
+   size_t *index;
+  /*! \brief маска номера ячейки хэш-таблицы (размер таблицы равен степени двойки) */
+   size_t mask;
+  /*! \brief правило вытеснения ключей */
+   blom_cache_t policy;
+  /*! \brief номер первого вытесняемого ключа, увеличенный на единицу (ноль для пустого кэша) */
+   size_t head;
+  /*! \brief номер последнего вытесняемого ключа, увеличенный на единицу */
+   size_t tail;
+  /*! \brief количество успешных обращений */
+   size_t hits;
+  /*! \brief количество неуспешных обращений */
+   size_t misses;
+  /*! \brief генератор масок и значений для очистки памяти */
+   struct random generator;
+ #ifdef AK_HAVE_PTHREAD_H
+  /*! \brief мьютекс, защищающий кэш при одновременном обращении из нескольких потоков */
+   pthread_mutex_t mutex;
+ #endif
+ } *ak_blomkey_cache;
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Номер ячейки хэш-таблицы, с которой начинается поиск ключа
+    (хэш-код идентификатора равномерно распределен, поэтому используются его первые октеты). */
+/* ----------------------------------------------------------------------------------------------- */
+ static size_t ak_blomkey_cache_home( ak_blomkey_cache cache, const ak_uint8 *id )
+{
+  ak_uint64 value = 0;
+  memcpy( &value, id, sizeof( value ));
+ return ( size_t )value&cache->mask;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Поиск ячейки хэш-таблицы, содержащей ключ с заданным хэш-кодом идентификатора.
+    \return Номер ячейки или номер свободной ячейки, в которую ключ может быть помещен.           */
+/* ----------------------------------------------------------------------------------------------- */
+ static size_t ak_blomkey_cache_slot( ak_blomkey_cache cache, const ak_uint8 *id,
+                                                                             const size_t count )
+{
+  size_t slot = ak_blomkey_cache_home( cache, id );
+
+  while( cache->index[slot] != 0 ) {
+    if( memcmp( cache->entries[cache->index[slot]-1].id, id, count ) == 0 ) break;
+    slot = ( slot +1 )&cache->mask;
+  }
+ return slot;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Исключение ключа с номером `idx` из списка, задающего порядок вытеснения ключей. */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_blomkey_cache_unlink( ak_blomkey_cache cache, const size_t idx )
+{
+  ak_blomkey_cache_entry entry = cache->entries +idx;
+
+  if( entry->prev ) cache->entries[entry->prev-1].next = entry->next;
+    else cache->head = entry->next;
+  if( entry->next ) cache->entries[entry->next-1].prev = entry->prev;
+    else cache->tail = entry->prev;
+  entry->prev = entry->next = 0;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Помещение ключа с номером `idx` в конец списка, задающего порядок вытеснения ключей. */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_blomkey_cache_append( ak_blomkey_cache cache, const size_t idx )
+{
+  ak_blomkey_cache_entry entry = cache->entries +idx;
+
+  entry->prev = cache->tail;
+  entry->next = 0;
+  if( cache->tail ) cache->entries[cache->tail-1].next = idx +1;
+    else cache->head = idx +1;
+  cache->tail = idx +1;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Удаление ключа из кэша с очисткой занимаемой им памяти. */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_blomkey_cache_remove( ak_blomkey_cache cache, size_t slot, const size_t count )
+{
+  size_t next = slot, home = 0, idx = cache->index[slot] -1, last = cache->count -1;
+
+  ak_blomkey_cache_unlink( cache, idx );
+  ak_ptr_wipe( cache->entries +idx, sizeof( struct blomkey_cache_entry ), &cache->generator );
+
+ /* последний элемент массива переносится на место удаленного,
+    ссылки соседних с ним элементов списка исправляются */
+  if( idx != last ) {
+    ak_blomkey_cache_entry entry = cache->entries +idx;
+    size_t moved = ak_blomkey_cache_slot( cache, cache->entries[last].id, count );
+
+    memcpy( entry, cache->entries +last, sizeof( struct blomkey_cache_entry ));
+    ak_ptr_wipe( cache->entries +last, sizeof( struct blomkey_cache_entry ), &cache->generator );
+    if( entry->prev ) cache->entries[entry->prev-1].next = idx +1;
+      else cache->head = idx +1;
+    if( entry->next ) cache->entries[entry->next-1].prev = idx +1;
+      else cache->tail = idx +1;
+    cache->index[moved] = idx +1;
+  }
+  cache->count--;
+
+ /* освобождаем ячейку и сдвигаем следующие за ней элементы цепочки */
+  cache->index[slot] = 0;
+  for( ;; ) {
+     next = ( next +1 )&cache->mask;
+     if( cache->index[next] == 0 ) break;
+     home = ak_blomkey_cache_home( cache, cache->entries[cache->index[next]-1].id );
+     if((( next > slot ) && (( home <= slot ) || ( home > next ))) ||
+        (( next < slot ) && (( home <= slot ) && ( home > next )))) {
+       cache->index[slot] = cache->index[next];
+       cache->index[next] = 0;
+       slot = next;
+     }
+  }
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Поиск ключа парной связи в кэше; найденный ключ снимается с маски и маскируется
+    заново. \return Функция возвращает истину, если ключ найден.                                  */
+/* ----------------------------------------------------------------------------------------------- */
+ static bool_t ak_blomkey_cache_find( ak_blomkey bkey, const ak_uint8 *id, ak_uint8 *key )
+{
+  size_t i = 0, slot = 0;
+  ak_uint8 mask[64];
+  bool_t result = ak_false;
+  ak_blomkey_cache cache = bkey->cache;
+
+ #ifdef AK_HAVE_PTHREAD_H
+  pthread_mutex_lock( &cache->mutex );
+ #endif
+  slot = ak_blomkey_cache_slot( cache, id, bkey->count );
+  if( cache->index[slot] != 0 ) {
+    ak_blomkey_cache_entry entry = cache->entries +cache->index[slot] -1;
+
+    ak_random_ptr( &cache->generator, mask, bkey->count );
+    for( i = 0; i < bkey->count; i++ ) {
+       key[i] = entry->key[i]^entry->key[64+i];
+       entry->key[i] ^= entry->key[64+i]^mask[i];
+       entry->key[64+i] = mask[i];
+    }
+    if( cache->policy == blom_cache_lru ) {
+      ak_blomkey_cache_unlink( cache, cache->index[slot] -1 );
+      ak_blomkey_cache_append( cache, cache->index[slot] -1 );
+    }
+    cache->hits++;
+    result = ak_true;
+  }
+   else cache->misses++;
+ #ifdef AK_HAVE_PTHREAD_H
+  pthread_mutex_unlock( &cache->mutex );
+ #endif
+
+  memset( mask, 0, sizeof( mask ));
+ return result;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Помещение ключа парной связи в кэш с вытеснением ключа в соответствии
+    с правилом вытеснения. */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_blomkey_cache_insert( ak_blomkey bkey, const ak_uint8 *id, const ak_uint8 *key )
+{
+  size_t i = 0, slot = 0;
+  ak_blomkey_cache_entry entry = NULL;
+  ak_blomkey_cache cache = bkey->cache;
+
+ #ifdef AK_HAVE_PTHREAD_H
+  pthread_mutex_lock( &cache->mutex );
+ #endif
+ /* ключ мог быть помещен в кэш другим потоком */
+  if( cache->index[ak_blomkey_cache_slot( cache, id, bkey->count )] != 0 ) goto labex;
+
+ /* вытесняем ключ, находящийся в начале списка */
+  if( cache->count == cache->capacity )
+    ak_blomkey_cache_remove( cache, ak_blomkey_cache_slot( cache,
+                                   cache->entries[cache->head-1].id, bkey->count ), bkey->count );
+
+  slot = ak_blomkey_cache_slot( cache, id, bkey->count );
+  entry = cache->entries +cache->count;
+  memcpy( entry->id, id, bkey->count );
+  ak_random_ptr( &cache->generator, entry->key +64, bkey->count );
+  for( i = 0; i < bkey->count; i++ ) entry->key[i] = key[i]^entry->key[64+i];
+  ak_blomkey_cache_append( cache, cache->count );
+  cache->index[slot] = ++cache->count;
+
+  labex:
+ #ifdef AK_HAVE_PTHREAD_H
+  pthread_mutex_unlock( &cache->mutex );
+ #endif
+  return;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция связывает с ключом абонента кэш, в котором сохраняются выработанные ранее ключи
+    парной связи. При повторной выработке ключа парной связи с тем же абонентом функция
+    ak_blomkey_create_pairwise_key_as_ptr() (а также ak_blomkey_new_pairwise_key())
+    находит ключ в кэше по хэш-коду идентификатора абонента и не выполняет проверку
+    целостности ключа абонента и вычисление значения многочлена.
+
+    Ключи парной связи хранятся в кэше в маскированном виде; маска изменяется при каждом
+    обращении к ключу. Память, занимаемая вытесняемыми ключами, очищается.
+    Доступ к кэшу из нескольких потоков синхронизируется.
+
+    Если кэш уже был создан, то он уничтожается и создается заново.
+
+    \param bkey указатель на контекст ключа абонента
+    \param capacity максимальное количество ключей парной связи, хранимых в кэше
+    \param policy правило вытеснения ключей при заполнении кэша
+    \return Функция возвращает \ref ak_error_ok (ноль) в случае успеха,
+    в противном случае возвращается код ошибки.                                                    */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_blomkey_cache_create( ak_blomkey bkey, const size_t capacity, const blom_cache_t policy )
+{
+  size_t size = 2;
+  int error = ak_error_ok;
+  ak_blomkey_cache cache = NULL;
+
+  if( bkey == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                           "using null pointer to abonent's key" );
+  if( bkey->type != blom_abonent_key ) return ak_error_message( ak_error_wrong_key_type,
+                                                   __func__, "incorrect type of blom secret key" );
+  if( !capacity ) return ak_error_message( ak_error_zero_length, __func__,
+                                                                "using zero capacity of cache" );
+  if( capacity > ak_blomkey_cache_max ) return ak_error_message( ak_error_wrong_length,
+                                                   __func__, "using very huge capacity of cache" );
+  if(( policy != blom_cache_lru ) && ( policy != blom_cache_fifo ))
+    return ak_error_message( ak_error_undefined_value, __func__, "using unsupported cache policy" );
+  if( bkey->cache != NULL ) ak_blomkey_cache_destroy( bkey );
+
+ /* размер хэш-таблицы не менее чем вдвое превосходит количество ключей */
+  while( size < 2*capacity ) size <<= 1;
+  if(( cache = calloc( 1, sizeof( struct blomkey_cache ))) == NULL )
+    return ak_error_message( ak_error_out_of_memory, __func__, "incorrect memory allocation" );
+  if((( cache->entries = calloc( capacity, sizeof( struct blomkey_cache_entry ))) == NULL ) ||
+     (( cache->index = calloc( size, sizeof( size_t ))) == NULL )) {
+    ak_error_message( error = ak_error_out_of_memory, __func__, "incorrect memory allocation" );
+    goto labex;
+  }
+  if(( error = ak_random_create_lcg( &cache->generator )) != ak_error_ok ) {
+    ak_error_message( error, __func__, "wrong creation of random generator" );
+    goto labex;
+  }
+  cache->capacity = capacity;
+  cache->mask = size -1;
+  cache->policy = policy;
+ #ifdef AK_HAVE_PTHREAD_H
+  pthread_mutex_init( &cache->mutex, NULL );
+ #endif
+  bkey->cache = cache;
+ return ak_error_ok;
+
+  labex:
+   if( cache->index != NULL ) free( cache->index );
+   if( cache->entries != NULL ) free( cache->entries );
+   free( cache );
  return error;
 }
 
+/* ----------------------------------------------------------------------------------------------- */
+/*! \param bkey указатель на контекст ключа абонента
+    \param count указатель на переменную, в которую помещается количество ключей в кэше
+    \param hits указатель на переменную, в которую помещается количество обращений к кэшу,
+    при которых ключ был найден
+    \param misses указатель на переменную, в которую помещается количество обращений к кэшу,
+    при которых ключ не был найден
+    (любой из указателей `count`, `hits` и `misses` может быть равен `NULL`).
+    \return Функция возвращает \ref ak_error_ok (ноль) в случае успеха,
+    в противном случае возвращается код ошибки.                                                    */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_blomkey_cache_get_stat( ak_blomkey bkey, size_t *count, size_t *hits, size_t *misses )
+{
+  ak_blomkey_cache cache = NULL;
+
+  if( bkey == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                           "using null pointer to abonent's key" );
+  if(( cache = bkey->cache ) == NULL ) return ak_error_message( ak_error_null_pointer,
+                                                  __func__, "using abonent's key without cache" );
+ #ifdef AK_HAVE_PTHREAD_H
+  pthread_mutex_lock( &cache->mutex );
+ #endif
+  if( count != NULL ) *count = cache->count;
+  if( hits != NULL ) *hits = cache->hits;
+  if( misses != NULL ) *misses = cache->misses;
+ #ifdef AK_HAVE_PTHREAD_H
+  pthread_mutex_unlock( &cache->mutex );
+ #endif
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция очищает память, занимаемую хранящимися в кэше ключами парной связи, и уничтожает кэш.
+    Функция вызывается автоматически при уничтожении ключа абонента.
+
+    \param bkey указатель на контекст ключа абонента
+    \return Функция возвращает \ref ak_error_ok (ноль) в случае успеха,
+    в противном случае возвращается код ошибки.                                                    */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_blomkey_cache_destroy( ak_blomkey bkey )
+{
+  ak_blomkey_cache cache = NULL;
+
+  if( bkey == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                           "using null pointer to abonent's key" );
+  if(( cache = bkey->cache ) == NULL ) return ak_error_ok;
+
+  ak_ptr_wipe( cache->entries,
+                  cache->capacity*sizeof( struct blomkey_cache_entry ), &cache->generator );
+  ak_random_destroy( &cache->generator );
+ #ifdef AK_HAVE_PTHREAD_H
+  pthread_mutex_destroy( &cache->mutex );
+ #endif
+  free( cache->index );
+  free( cache->entries );
+  free( cache );
+  bkey->cache = NULL;
+
+ return ak_error_ok;
+}
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! Функция вырабатывает общий для двух абонентов секретный вектор и
     помещает его в контекст секретного ключа парной связи с заданным oid
@@ -294,15 +876,20 @@
     \param key указатель на область памяти, в которую помещается ключ парной связи
     \param keysize размер доступной области памяти (в октетах); данное значение должно быть
      не менее, чем размер ключа парной связи (см. поле `bkey->count`)
+
+    Если с ключом абонента связан кэш (см. ak_blomkey_cache_create()), то ключ парной связи
+    сначала ищется в кэше, а вычисленный ключ помещается в кэш.
+    Функция не изменяет контекст ключа абонента и может вызываться для одного ключа
+    одновременно из нескольких потоков.
     \return Функция возвращает \ref ak_error_ok (ноль) в случае успеха,
     в противном случае возвращается код ошибки.                                                    */
 /* ----------------------------------------------------------------------------------------------- */
  int ak_blomkey_create_pairwise_key_as_ptr( ak_blomkey bkey,
                                ak_pointer id, const size_t idsize, ak_pointer key, size_t keysize )
 {
-  ak_uint32 i = 0;
-  ak_int32 row = 0;
   ak_uint8 value[64];
+  struct hash ctx;
+  struct gf2n_powers powers;
   int error = ak_error_ok;
 
   if( bkey == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
@@ -315,21 +902,33 @@
                                                             "using null pointer to pairwise key" );
   if( keysize < bkey->count ) return ak_error_message( ak_error_null_pointer, __func__,
                                            "insufficient memory size for storing a pairwise key" );
-  if( !ak_blomkey_check_icode( bkey ))
-    return ak_error_message( ak_error_get_value(), __func__, "using wrong blom master key" );
 
- /* формируем хэш от идентификатора */
-  if(( error = ak_hash_ptr( &bkey->ctx, id, idsize, value, bkey->count )) != ak_error_ok )
-    return ak_error_message( error, __func__, "incorrect evauation of initial hash value" );
+ /* формируем хэш от идентификатора; контекст хеширования ключа абонента не используется,
+    поскольку функция может вызываться одновременно из нескольких потоков */
+  if(( error = ak_hash_create_oid( &ctx, bkey->ctx.oid )) != ak_error_ok )
+    return ak_error_message( error, __func__, "incorrect creation of hash function context" );
+  if(( error = ak_hash_ptr( &ctx, id, idsize, value, bkey->count )) != ak_error_ok ) {
+    ak_error_message( error, __func__, "incorrect evauation of initial hash value" );
+    goto labex;
+  }
 
-  memset( key, 0, bkey->count );
-  for( row = bkey->size - 1; row >= 0; row-- ) {
-     ak_uint8 *element = ak_blomkey_get_element_by_index( bkey, row, 0 );
-     if( bkey->count == ak_galois256_size ) ak_gf256_mul( key, key, value );
-       else ak_gf512_mul( key, key, value );
-     for( i = 0; i < ( bkey->count >> 3 ); i++ ) ((ak_uint64 *)key)[i] ^= ((ak_uint64 *)element)[i];
+ /* ключ, найденный в кэше, был выработан ранее из ключа с проверенной целостностью */
+  if(( bkey->cache != NULL ) && ak_blomkey_cache_find( bkey, value, key )) goto labex;
+  if( !ak_blomkey_check_icode( bkey, &ctx )) {
+    ak_error_message( error = ak_error_get_value(), __func__, "using wrong blom master key" );
+    goto labex;
+  }
+
+  if(( error = ak_gf2n_powers_create( &powers, value, bkey->count )) != ak_error_ok ) {
+    ak_error_message( error, __func__, "incorrect evaluation of hash value powers" );
+    goto labex;
   }
+  ak_gf2n_polynomial( key, bkey->data, bkey->size, &powers );
+  ak_gf2n_powers_destroy( &powers );
+  if( bkey->cache != NULL ) ak_blomkey_cache_insert( bkey, value, key );
 
+  labex:
+   ak_hash_destroy( &ctx );
  return error;
 }
 
@@ -371,6 +970,7 @@
   struct random generator;
   if( bkey == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
                                                        "destroying null pointer to blom context" );
+  ak_blomkey_cache_destroy( bkey );
   ak_hash_destroy( &bkey->ctx );
   if( bkey->data != NULL ) {
     ak_random_create_lcg( &generator );
@@ -400,7 +1000,10 @@
 
     Вектор IV формируется следующим образом:
 
-    - первые 8 октетов - значение синхропосылки для режима гаммирования,
+    - первые 8 октетов - значение синхропосылки для режима гаммирования, вырабатываемое
+      генератором, связанным с вызывающим потоком (см. ak_random_thread_local()); это значение
+      также используется в качестве соли pbkdf2 и для формирования имени файла, поэтому
+      функция может одновременно вызываться из нескольких потоков,
     - два октета - значение числа итераций в алгоритме pbkdf2,
     - один октет - тип ключа (bkey->type),
     - один октет - размер элемента поля (bkey->count),
@@ -427,7 +1030,7 @@
 {
   struct file fs;
   int error = ak_error_ok;
-  struct random generator;
+  ak_random generator = NULL;
   size_t memsize, iter = ak_libakrypt_get_option_by_name( "pbkdf2_iteration_count" );
   struct bckey ekey, ikey;
   size_t i, j, blocks, lblocks, ltail;
@@ -442,9 +1045,11 @@
     - один октет - размер элемента поля (bkey->count)
     - четыре октета - размерность матрицы (bkey->size) */
 
-  if(( error = ak_random_create_lcg( &generator )) != ak_error_ok )
-    return ak_error_message( error, __func__, "incorrect creation of random number generator");
-  ak_random_ptr( &generator, iv, sizeof( iv ));
+  if(( generator = ak_random_thread_local()) == NULL )
+    return ak_error_message( ak_error_get_value(), __func__,
+                                                  "incorrect access to thread random generator" );
+  if(( error = ak_random_ptr( generator, iv, 8 )) != ak_error_ok )
+    return ak_error_message( error, __func__, "incorrect generation of initial vector" );
   iv[8]  = (iter >> 8)&0xFF;
   iv[9]  = iter&0xFF; /* помещаем число итераций в big-endian формате */
   iv[10] = (ak_uint8) bkey->type;    /* сохраняем тип ключа */
@@ -453,7 +1058,6 @@
   iv[13] = ( bkey->size >> 16)&0xFF;
   iv[14] = ( bkey->size >>  8)&0xFF;
   iv[15] = bkey->size&0xFF;
-  ak_random_destroy( &generator );
 
  /* вычисляем размер ключевых данных */
   if( bkey->type == blom_matrix_key ) memsize = (bkey->size)*(bkey->size)*(bkey->count);
@@ -446,6 +446,42 @@
  return ak_error_ok;
 }
 
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Контекст, передаваемый функции обработки фрагментов файла. */
+ struct cmac_file_ctx {
+  /*! \brief Ключ алгоритма блочного шифрования. */
+   ak_bckey key;
+  /*! \brief Область памяти для результата. */
+   ak_pointer out;
+  /*! \brief Размер области памяти для результата. */
+   size_t out_size;
+ };
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция обработки очередного фрагмента файла.
+    \details Последний блок последнего фрагмента всегда передается в функцию
+    ak_bckey_cmac_finalize(), поскольку она не может принимать данные нулевой длины.               */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_bckey_cmac_file_chunk( ak_const_pointer data,
+                                                const size_t len, bool_t last, ak_pointer ptr )
+{
+  size_t qcnt = 0, tail = 0;
+  struct cmac_file_ctx *fctx = ptr;
+  ak_bckey key = fctx->key;
+
+  if( !last ) return ak_bckey_cmac_update( key, ( ak_pointer )data, len );
+ /* для файла нулевой длины результатом будет хеш от вектора нулевой длины,
+                                 см. замечания к реализации ak_bckey_cmac() */
+  if( !len ) return ak_bckey_cmac( key, NULL, 0, fctx->out, fctx->out_size );
+
+  qcnt = len / key->bsize;
+  tail = len - qcnt*key->bsize;
+  if( tail == 0 ) { qcnt--; tail = key->bsize; }
+  if( qcnt ) ak_bckey_cmac_update( key, ( ak_pointer )data, qcnt*key->bsize );
+ return ak_bckey_cmac_finalize( key,
+                             ( ak_uint8 *)data + qcnt*key->bsize, tail, fctx->out, fctx->out_size );
+}
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! \note Реализация данной функции не использует методы класса \ref mac, поскольку
     функция ak_bckey_cmac_finalize() не может принимать данные нелевой длины.
@@ -461,60 +497,27 @@
 /* ----------------------------------------------------------------------------------------------- */
  int ak_bckey_cmac_file( ak_bckey key, const char *filename, ak_pointer out, const size_t out_size )
 {
-  struct file file;
   int error = ak_error_ok;
-  size_t block_size = 4096; /* оптимальная длина блока для Windows, по-прежнему, не ясна */
-  ak_int64 len = 0, readlen = 0;
-  ak_uint8 *localbuffer = NULL; /* место для локального считывания информации */
+  struct cmac_file_ctx fctx;
 
  /* выполняем необходимые проверки */
   if( key == NULL ) return ak_error_message( ak_error_null_pointer, __func__ ,
                                                 "use a null pointer to block cipher key context" );
   if( filename == NULL ) return ak_error_message( ak_error_null_pointer, __func__ ,
                                                                 "use a null pointer to filename" );
-  if(( error = ak_file_open_to_read( &file, filename )) != ak_error_ok )
-    return ak_error_message_fmt( error, __func__, "incorrect access to file %s (%s)",
-                                                                      filename, strerror( errno ));
- /* для файла нулевой длины результатом будет хеш от вектора нулевой длины,
-                                 см. замечания к реализации ak_bckey_cmac() */
-  if( !file.size ) {
-    ak_file_close( &file );
-    return ak_bckey_cmac( key, NULL, 0, out, out_size );
-  }
- /* готовим область для хранения данных */
-  block_size = ak_max( ( size_t )file.blksize, 512 );
- /* здесь мы выделяем локальный буффер для считывания/обработки данных */
-  if(( localbuffer = ( ak_uint8 * ) ak_aligned_malloc( block_size )) == NULL ) {
-    ak_file_close( &file );
-    return ak_error_message( ak_error_out_of_memory, __func__ ,
-                                                      "memory allocation error for local buffer" );
-  }
-
- /* теперь обрабатываем файл с данными */
+ /* теперь обрабатываем файл с данными; длина фрагментов кратна размеру страницы памяти,
+    а значит и длине блока алгоритма шифрования */
   ak_bckey_cmac_clean( key );
-  read_label:
-   readlen += ( len = ( size_t ) ak_file_read( &file, localbuffer, block_size ));
-   if( readlen == file.size ) { /* считан последний большой блок */
-     size_t qcnt = len / key->bsize,
-            tail = len - qcnt*key->bsize;
-     if( tail == 0 ) {
-       if( qcnt > 0 ) { qcnt--; tail = key->bsize; }
-         else {
-           error = ak_error_message( ak_error_read_data, __func__,
-                                                           "unexpected length of input data");
-           goto labex;
-         }
-     }
-     if( qcnt ) ak_bckey_cmac_update( key, localbuffer, qcnt*key->bsize );
-     error = ak_bckey_cmac_finalize(key, localbuffer + qcnt*key->bsize, tail, out, out_size );
-   }
-    else {
-           ak_bckey_cmac_update( key, localbuffer, len );
-           goto read_label;
-         }
-  labex:
-   if( localbuffer != NULL ) ak_aligned_free( localbuffer );
-   ak_file_close( &file );
+  fctx.key = key;
+  fctx.out = out;
+  fctx.out_size = out_size;
+  if(( error = ak_file_read_ahead( filename,
+              ( size_t ) ak_libakrypt_get_option_by_name( "file_read_chunk_size" ),
+              ( size_t ) ak_libakrypt_get_option_by_name( "file_read_buffers_count" ),
+              ( file_read_mode_t ) ak_libakrypt_get_option_by_name( "file_read_mode" ),
+                                               ak_bckey_cmac_file_chunk, &fctx )) != ak_error_ok )
+    ak_error_message_fmt( error, __func__, "incorrect processing of file %s", filename );
+
  return error;
 }
 
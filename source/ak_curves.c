@@ -4,7 +4,7 @@
 /*  Файл ak_curves.с                                                                               */
 /*  - содержит реализацию функций для работы с эллиптическими кривыми.                             */
 /* ----------------------------------------------------------------------------------------------- */
- #include <libakrypt.h>
+ #include <libakrypt-internal.h>
 
 /* ----------------------------------------------------------------------------------------------- */
 #ifdef AK_HAVE_STRING_H
@@ -15,6 +15,12 @@
 #ifdef AK_HAVE_STRINGS_H
  #include <strings.h>
 #endif
+#ifdef AK_HAVE_STDLIB_H
+ #include <stdlib.h>
+#endif
+#ifdef AK_HAVE_PTHREAD_H
+ #include <pthread.h>
+#endif
 
 /* ----------------------------------------------------------------------------------------------- */
 /*! Функция вычисляет величину \f$\Delta \equiv -16(4a^3 + 27b^2) \pmod{p} \f$, зависящую
@@ -102,6 +108,83 @@
    else return ak_error_curve_order_parameters;
 }
 
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Проверка константы \f$ \mu = \lfloor 2^{128\cdot size}/m \rfloor \f$, используемой
+    в редукции Барретта.
+
+    Проверка выполняется без деления: константа корректна тогда и только тогда, когда
+    \f$ 0 \leq 2^{128\cdot size} - \mu m < m \f$.
+
+    @return Функция возвращает \ref ak_true, если константа корректна.                            */
+/* ----------------------------------------------------------------------------------------------- */
+ static bool_t ak_mpzn_barrett_is_ok( ak_uint64 *mu, ak_uint64 *m, const size_t size )
+{
+  size_t i = 0;
+  ak_mpznmax me = ak_mpznmax_zero, t, d, e = ak_mpznmax_zero;
+
+  memcpy( me, m, size*sizeof( ak_uint64 ));
+  ak_mpzn_mul( t, mu, me, size +1 );
+ /* d = 2^{128*size} - mu*m не должно быть отрицательным */
+  e[2*size] = 1;
+  if( ak_mpzn_sub( d, e, t, 2*size +2 )) return ak_false;
+  for( i = size; i < 2*size +2; i++ ) if( d[i] ) return ak_false;
+ return ( ak_mpzn_cmp( d, m, size ) < 0 );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Проверка параметров эквивалентной скрученной кривой Эдвардса.
+
+    Проверяются соотношения \f$ 4s \equiv 1 - d \f$, \f$ 6t \equiv 1 + d \f$,
+    \f$ a \equiv s^2 - 3t^2 \f$ и \f$ b \equiv t(2t^2 - s^2) \pmod{p} \f$, связывающие
+    коэффициенты кривой в форме Вейерштрасса и кривой Эдвардса, а также то, что \f$ d \f$
+    не является квадратичным вычетом (условие полноты формул сложения).
+
+    @return Функция возвращает \ref ak_true, если параметры корректны.                            */
+/* ----------------------------------------------------------------------------------------------- */
+ static bool_t ak_wcurve_edwards_is_ok( ak_wcurve ec )
+{
+  size_t i = 0;
+  ak_mpznmax one = ak_mpznmax_one, u, v, w;
+  struct ecurve *ed = ec->edwards;
+
+  ak_mpzn_mul_montgomery( one, one, ec->r2, ec->p, ec->n, ec->size );
+ /* 4s = 1 - d */
+  ak_mpzn_lshift_montgomery( u, ed->s, ec->p, ec->size );
+  ak_mpzn_lshift_montgomery( u, u, ec->p, ec->size );
+  ak_mpzn_sub( v, ec->p, ed->d, ec->size );
+  ak_mpzn_add_montgomery( v, v, one, ec->p, ec->size );
+  if( ak_mpzn_cmp( u, v, ec->size ) != 0 ) return ak_false;
+ /* 6t = 1 + d */
+  ak_mpzn_lshift_montgomery( u, ed->t, ec->p, ec->size );
+  ak_mpzn_add_montgomery( u, u, ed->t, ec->p, ec->size );
+  ak_mpzn_lshift_montgomery( u, u, ec->p, ec->size );
+  ak_mpzn_add_montgomery( v, one, ed->d, ec->p, ec->size );
+  if( ak_mpzn_cmp( u, v, ec->size ) != 0 ) return ak_false;
+ /* a = s^2 - 3t^2 */
+  ak_mpzn_mul_montgomery( v, ed->s, ed->s, ec->p, ec->n, ec->size );
+  ak_mpzn_mul_montgomery( w, ed->t, ed->t, ec->p, ec->n, ec->size );
+  ak_mpzn_lshift_montgomery( u, w, ec->p, ec->size );
+  ak_mpzn_add_montgomery( u, u, w, ec->p, ec->size );
+  ak_mpzn_sub( u, ec->p, u, ec->size );
+  ak_mpzn_add_montgomery( u, u, v, ec->p, ec->size );
+  if( ak_mpzn_cmp( u, ec->a, ec->size ) != 0 ) return ak_false;
+ /* b = t(2t^2 - s^2) */
+  ak_mpzn_lshift_montgomery( u, w, ec->p, ec->size );
+  ak_mpzn_sub( v, ec->p, v, ec->size );
+  ak_mpzn_add_montgomery( u, u, v, ec->p, ec->size );
+  ak_mpzn_mul_montgomery( u, u, ed->t, ec->p, ec->n, ec->size );
+  if( ak_mpzn_cmp( u, ec->b, ec->size ) != 0 ) return ak_false;
+ /* d^{(p-1)/2} = -1 */
+  ak_mpzn_set( w, ec->p, ec->size );
+  for( i = 0; i < ec->size-1; i++ ) w[i] = ( w[i] >> 1 ) | ( w[i+1] << 63 );
+  w[ec->size-1] >>= 1;
+  ak_mpzn_modpow_montgomery( u, ed->d, w, ec->p, ec->n, ec->size );
+  ak_mpzn_sub( v, ec->p, one, ec->size );
+  if( ak_mpzn_cmp( u, v, ec->size ) != 0 ) return ak_false;
+
+ return ak_true;
+}
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! Функция принимает на вход контекст эллиптической кривой, заданной в короткой форме Вейерштрасса,
     и выполняет следующие математические проверки
@@ -154,6 +237,23 @@
   if(( error = ak_wcurve_discriminant_is_ok( ec )) != ak_error_ok )
     return ak_error_message( ak_error_curve_discriminant, __func__ ,
                                        "using elliptic curve parameters with zero discriminant" );
+ /* проверяем, что вид кривой соответствует коэффициенту a,
+    поскольку от него зависят формулы удвоения точек */
+  ak_mpzn_set_ui( temp, ec->size, 3 );
+  ak_mpzn_mul_montgomery( temp, temp, ec->r2, ec->p, ec->n, ec->size );
+  ak_mpzn_sub( temp, ec->p, temp, ec->size );
+  if(( ak_mpzn_cmp( temp, ec->a, ec->size ) == 0 ) != ( ec->variant == wcurve_a_minus_three ))
+    return ak_error_message( ak_error_curve_order_parameters, __func__ ,
+                                   "elliptic curve variant does not match the coefficient a" );
+ /* проверяем константы редукции Барретта по модулям p и q */
+  if( !ak_mpzn_barrett_is_ok( ec->mu, ec->p, ec->size ) ||
+      !ak_mpzn_barrett_is_ok( ec->muq, ec->q, ec->size ))
+    return ak_error_message( ak_error_curve_order_parameters, __func__ ,
+                                         "elliptic curve has wrong Barrett reduction constants" );
+ /* проверяем параметры эквивалентной кривой Эдвардса */
+  if(( ec->edwards != NULL ) && ( ak_wcurve_edwards_is_ok( ec ) != ak_true ))
+    return ak_error_message( ak_error_curve_order_parameters, __func__ ,
+                                     "elliptic curve has wrong twisted Edwards parameters" );
  /* теперь проверяем принадлежность точки кривой */
   if(( error = ak_wpoint_set( &wp, ec )) != ak_error_ok )
     return ak_error_message( error, __func__, "incorect asiigning a temporary point" );
@@ -416,8 +516,38 @@
 }
 
 /* ----------------------------------------------------------------------------------------------- */
-/*! Точка эллиптической кривой \f$ P = (x:y:z) \f$ заменяется значением \f$ 2P  = (x_3:y_3:z_3)\f$,
-    то есть складывается сама с собой (удваивается).
+/*! \brief Завершение удвоения точки по известному значению \f$ w = aZ^2 + 3X^2 \f$.
+
+    Функция вычисляет координаты точки \f$ 2P \f$ по формулам dbl-2007-bl, общим
+    для всех видов кривых.                                                                         */
+/* ----------------------------------------------------------------------------------------------- */
+ static inline void ak_wpoint_double_finish( ak_wpoint wp, ak_uint64 *u3, ak_wcurve ec )
+{
+ ak_mpznmax u1, u2, u4, u5, u6, u7;
+
+ ak_mpzn_mul_montgomery( u4, wp->y, wp->z, ec->p, ec->n, ec->size );
+ ak_mpzn_lshift_montgomery( u4, u4, ec->p, ec->size );   // u4 = 2yz
+ ak_mpzn_mul_montgomery( u5, wp->y, u4, ec->p, ec->n, ec->size ); // u5 = 2y^2z
+ ak_mpzn_lshift_montgomery( u6, u5, ec->p, ec->size ); // u6 = 2u5
+ ak_mpzn_mul_montgomery( u7, u6, wp->x, ec->p, ec->n, ec->size ); // u7 = 8xy^2z
+ ak_mpzn_lshift_montgomery( u1, u7, ec->p, ec->size );
+ ak_mpzn_sub( u1, ec->p, u1, ec->size );
+ ak_mpzn_mul_montgomery( u2, u3, u3, ec->p, ec->n, ec->size );
+ ak_mpzn_add_montgomery( u2, u2, u1, ec->p, ec->size );
+ ak_mpzn_mul_montgomery( wp->x, u2, u4, ec->p, ec->n, ec->size );
+ ak_mpzn_mul_montgomery( u6, u6, u5, ec->p, ec->n, ec->size );
+ ak_mpzn_sub( u6, ec->p, u6, ec->size );
+ ak_mpzn_sub( u2, ec->p, u2, ec->size );
+ ak_mpzn_add_montgomery( u2, u2, u7, ec->p, ec->size );
+ ak_mpzn_mul_montgomery( wp->y, u2, u3, ec->p, ec->n, ec->size );
+ ak_mpzn_add_montgomery( wp->y, wp->y, u6, ec->p, ec->size );
+ ak_mpzn_mul_montgomery( wp->z, u4, u4, ec->p, ec->n, ec->size );
+ ak_mpzn_mul_montgomery( wp->z, wp->z, u4, ec->p, ec->n, ec->size );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Удвоение точки кривой с произвольным коэффициентом \f$ a \f$ (формулы dbl-2007-bl).
+
     При вычислениях используются соотношения, основанные на результатах работы
     D.Bernstein, T.Lange, <a href="http://eprint.iacr.org/2007/286">Faster addition and doubling
      on elliptic curves</a>, 2007.
@@ -436,14 +566,11 @@
       X3 = h*s
       Y3 = w*(B-h)-2*RR
       Z3 = sss
-    \endcode
-
-    @param wp удваиваемая точка \f$ P \f$ эллиптической кривой.
-    @param ec эллиптическая кривая, которой принадлежит точка \f$P\f$.                             */
+    \endcode                                                                                       */
 /* ----------------------------------------------------------------------------------------------- */
- inline void ak_wpoint_double( ak_wpoint wp, ak_wcurve ec )
+ static void ak_wpoint_double_generic( ak_wpoint wp, ak_wcurve ec )
 {
- ak_mpznmax u1, u2, u3, u4, u5, u6, u7;
+ ak_mpznmax u1, u2, u3, u4;
 
  if( ak_mpzn_cmp_ui( wp->z, ec->size, 0 ) == ak_true ) return;
  if( ak_mpzn_cmp_ui( wp->y, ec->size, 0 ) == ak_true ) {
@@ -457,24 +584,49 @@
  ak_mpzn_add_montgomery( u4, u4, u1, ec->p, ec->size );
  ak_mpzn_mul_montgomery( u3, u2, ec->a, ec->p, ec->n, ec->size );
  ak_mpzn_add_montgomery( u3, u3, u4, ec->p, ec->size );  // u3 = az^2 + 3x^2
- ak_mpzn_mul_montgomery( u4, wp->y, wp->z, ec->p, ec->n, ec->size );
- ak_mpzn_lshift_montgomery( u4, u4, ec->p, ec->size );   // u4 = 2yz
- ak_mpzn_mul_montgomery( u5, wp->y, u4, ec->p, ec->n, ec->size ); // u5 = 2y^2z
- ak_mpzn_lshift_montgomery( u6, u5, ec->p, ec->size ); // u6 = 2u5
- ak_mpzn_mul_montgomery( u7, u6, wp->x, ec->p, ec->n, ec->size ); // u7 = 8xy^2z
- ak_mpzn_lshift_montgomery( u1, u7, ec->p, ec->size );
- ak_mpzn_sub( u1, ec->p, u1, ec->size );
- ak_mpzn_mul_montgomery( u2, u3, u3, ec->p, ec->n, ec->size );
- ak_mpzn_add_montgomery( u2, u2, u1, ec->p, ec->size );
- ak_mpzn_mul_montgomery( wp->x, u2, u4, ec->p, ec->n, ec->size );
- ak_mpzn_mul_montgomery( u6, u6, u5, ec->p, ec->n, ec->size );
- ak_mpzn_sub( u6, ec->p, u6, ec->size );
- ak_mpzn_sub( u2, ec->p, u2, ec->size );
- ak_mpzn_add_montgomery( u2, u2, u7, ec->p, ec->size );
- ak_mpzn_mul_montgomery( wp->y, u2, u3, ec->p, ec->n, ec->size );
- ak_mpzn_add_montgomery( wp->y, wp->y, u6, ec->p, ec->size );
- ak_mpzn_mul_montgomery( wp->z, u4, u4, ec->p, ec->n, ec->size );
- ak_mpzn_mul_montgomery( wp->z, wp->z, u4, ec->p, ec->n, ec->size );
+ ak_wpoint_double_finish( wp, u3, ec );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Удвоение точки кривой с коэффициентом \f$ a \equiv -3 \pmod{p} \f$.
+
+    Для таких кривых \f$ w = 3(X^2 - Z^2) = 3(X-Z)(X+Z) \f$, что позволяет заменить два
+    возведения в квадрат и умножение на коэффициент \f$ a \f$ одним умножением;
+    остальные вычисления совпадают с формулами dbl-2007-bl.                                        */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_wpoint_double_a_minus_three( ak_wpoint wp, ak_wcurve ec )
+{
+ ak_mpznmax u1, u2, u3;
+
+ if( ak_mpzn_cmp_ui( wp->z, ec->size, 0 ) == ak_true ) return;
+ if( ak_mpzn_cmp_ui( wp->y, ec->size, 0 ) == ak_true ) {
+   ak_wpoint_set_as_unit( wp, ec );
+   return;
+ }
+ ak_mpzn_sub( u1, ec->p, wp->z, ec->size );
+ ak_mpzn_add_montgomery( u1, u1, wp->x, ec->p, ec->size ); // u1 = x - z
+ ak_mpzn_add_montgomery( u2, wp->x, wp->z, ec->p, ec->size ); // u2 = x + z
+ ak_mpzn_mul_montgomery( u1, u1, u2, ec->p, ec->n, ec->size );
+ ak_mpzn_lshift_montgomery( u3, u1, ec->p, ec->size );
+ ak_mpzn_add_montgomery( u3, u3, u1, ec->p, ec->size );  // u3 = 3(x^2 - z^2)
+ ak_wpoint_double_finish( wp, u3, ec );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Точка эллиптической кривой \f$ P = (x:y:z) \f$ заменяется значением \f$ 2P  = (x_3:y_3:z_3)\f$,
+    то есть складывается сама с собой (удваивается).
+
+    Используемые формулы выбираются в зависимости от вида кривой, заданного полем
+    wcurve::variant: для кривых с коэффициентом \f$ a \equiv -3 \pmod{p} \f$ вычисляется
+    на два умножения меньше, чем в общем случае.
+
+    @param wp удваиваемая точка \f$ P \f$ эллиптической кривой.
+    @param ec эллиптическая кривая, которой принадлежит точка \f$P\f$.                             */
+/* ----------------------------------------------------------------------------------------------- */
+ inline void ak_wpoint_double( ak_wpoint wp, ak_wcurve ec )
+{
+  if( ec->variant == wcurve_a_minus_three ) ak_wpoint_double_a_minus_three( wp, ec );
+   else ak_wpoint_double_generic( wp, ec );
 }
 
 /* ----------------------------------------------------------------------------------------------- */
@@ -571,29 +723,394 @@
 /* ----------------------------------------------------------------------------------------------- */
  void ak_wpoint_reduce( ak_wpoint wp, ak_wcurve ec )
 {
- ak_mpznmax u, one = ak_mpznmax_one;
+ ak_mpznmax u;
  if( ak_mpzn_cmp_ui( wp->z, ec->size, 0 ) == ak_true ) {
    ak_wpoint_set_as_unit( wp, ec );
    return;
  }
 
- ak_mpzn_set_ui( u, ec->size, 2 );
- ak_mpzn_sub( u, ec->p, u, ec->size );
- ak_mpzn_modpow_montgomery( u, wp->z, u, ec->p, ec->n, ec->size ); // u <- z^{p-2} (mod p)
- ak_mpzn_mul_montgomery( u, u, one, ec->p, ec->n, ec->size );
+ ak_mpzn_inverse( u, wp->z, ec->p, ec->size ); // u <- z^{-1} (mod p)
+ ak_mpzn_mul_montgomery( u, u, ec->r2, ec->p, ec->n, ec->size );
 
  ak_mpzn_mul_montgomery( wp->x, wp->x, u, ec->p, ec->n, ec->size );
  ak_mpzn_mul_montgomery( wp->y, wp->y, u, ec->p, ec->n, ec->size );
  ak_mpzn_set_ui( wp->z, ec->size, 1 );
 }
 
+/* ----------------------------------------------------------------------------------------------- */
+/*             реализация операций с точками скрученной кривой Эдвардса в расширенных координатах  */
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Точка скрученной кривой Эдвардса в расширенных проективных координатах.
+
+    Точка \f$ (u, v) \f$ кривой \f$ u^2 + v^2 = 1 + du^2v^2 \f$ представляется вектором
+    \f$ (X:Y:Z:T) \f$, где \f$ u = X/Z \f$, \f$ v = Y/Z \f$ и \f$ T = XY/Z \f$, см. работу
+    H.Hisil, K.Wong, G.Carter, E.Dawson, <a href="http://eprint.iacr.org/2008/522">Twisted
+    Edwards curves revisited</a>, 2008. Поскольку \f$ d \f$ не является квадратичным вычетом,
+    формулы сложения полны и не содержат исключительных случаев. Координаты хранятся
+    в представлении Монтгомери.                                                                    */
+/* ----------------------------------------------------------------------------------------------- */
+ typedef struct epoint {
+  /*! \brief X-координата точки */
+   ak_uint64 x[ak_mpzn512_size];
+  /*! \brief Y-координата точки */
+   ak_uint64 y[ak_mpzn512_size];
+  /*! \brief Z-координата точки */
+   ak_uint64 z[ak_mpzn512_size];
+  /*! \brief T-координата точки */
+   ak_uint64 t[ak_mpzn512_size];
+ } *ak_epoint;
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Вычисление разности \f$ z \equiv x - y \pmod{p} \f$ для вычетов \f$ 0 \leq x,y < p \f$. */
+/* ----------------------------------------------------------------------------------------------- */
+ static inline void ak_mpzn_sub_modulo( ak_uint64 *z, ak_uint64 *x, ak_uint64 *y, ak_wcurve ec )
+{
+  ak_mpznmax t;
+
+  ak_mpzn_sub( t, ec->p, y, ec->size );
+  ak_mpzn_add_montgomery( z, x, t, ec->p, ec->size );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Присвоение точке кривой Эдвардса значения нейтрального элемента \f$ (0:1:1:0) \f$. */
+/* ----------------------------------------------------------------------------------------------- */
+ static inline void ak_epoint_set_as_unit( ak_epoint ep, ak_wcurve ec )
+{
+  ak_mpzn_set_ui( ep->x, ec->size, 0 );
+  ak_mpzn_set_ui( ep->y, ec->size, 1 );
+  ak_mpzn_set_ui( ep->z, ec->size, 1 );
+  ak_mpzn_set_ui( ep->t, ec->size, 0 );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Переход от точки \f$ (x:y:z) \f$ кривой в форме Вейерштрасса к точке кривой Эдвардса.
+
+    Для \f$ A = x - tz \f$ и \f$ B_{\pm} = A \pm sz \f$ точка кривой Эдвардса
+    имеет координаты \f$ (AB_{+} : B_{-}y : yB_{+} : AB_{-}) \f$. Бесконечно удаленная точка
+    переходит в нейтральный элемент \f$ (0:1:1:0) \f$, точка второго порядка \f$ (t:0:1) \f$ -
+    в точку \f$ (0:-1:1:0) \f$.                                                                    */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_epoint_set_wpoint( ak_epoint ep, ak_wpoint wp, ak_wcurve ec )
+{
+  ak_mpznmax a, bm, bp, t;
+
+  if( ak_mpzn_cmp_ui( wp->z, ec->size, 0 ) == ak_true ) {
+    ak_epoint_set_as_unit( ep, ec );
+    return;
+  }
+  if( ak_mpzn_cmp_ui( wp->y, ec->size, 0 ) == ak_true ) {
+    ak_epoint_set_as_unit( ep, ec );
+    ak_mpzn_sub( ep->y, ec->p, ep->y, ec->size );
+    return;
+  }
+  ak_mpzn_mul_montgomery( t, ec->edwards->t, wp->z, ec->p, ec->n, ec->size );
+  ak_mpzn_sub_modulo( a, wp->x, t, ec );                    // a = x - tz
+  ak_mpzn_mul_montgomery( t, ec->edwards->s, wp->z, ec->p, ec->n, ec->size );
+  ak_mpzn_add_montgomery( bp, a, t, ec->p, ec->size );      // bp = a + sz
+  ak_mpzn_sub_modulo( bm, a, t, ec );                       // bm = a - sz
+
+  ak_mpzn_mul_montgomery( ep->x, a, bp, ec->p, ec->n, ec->size );
+  ak_mpzn_mul_montgomery( ep->t, a, bm, ec->p, ec->n, ec->size );
+  ak_mpzn_mul_montgomery( ep->z, wp->y, bp, ec->p, ec->n, ec->size );
+  ak_mpzn_mul_montgomery( ep->y, wp->y, bm, ec->p, ec->n, ec->size );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Переход от точки \f$ (X:Y:Z:T) \f$ кривой Эдвардса к точке кривой в форме Вейерштрасса.
+
+    Точка кривой в форме Вейерштрасса имеет координаты
+    \f$ ((s(Z+Y) + t(Z-Y))X : s(Z+Y)Z : (Z-Y)X) \f$; точки с \f$ X = 0 \f$ обрабатываются
+    отдельно.                                                                                      */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_epoint_to_wpoint( ak_wpoint wp, ak_epoint ep, ak_wcurve ec )
+{
+  ak_mpznmax a, b, c;
+
+  if( ak_mpzn_cmp_ui( ep->x, ec->size, 0 ) == ak_true ) {
+    if( ak_mpzn_cmp( ep->y, ep->z, ec->size ) == 0 ) ak_wpoint_set_as_unit( wp, ec );
+     else { /* точка второго порядка (t:0:1) */
+       ak_mpzn_set_ui( c, ec->size, 1 );
+       ak_mpzn_mul_montgomery( wp->x, ec->edwards->t, c, ec->p, ec->n, ec->size );
+       ak_mpzn_set_ui( wp->y, ec->size, 0 );
+       ak_mpzn_set_ui( wp->z, ec->size, 1 );
+     }
+    return;
+  }
+  ak_mpzn_add_montgomery( c, ep->z, ep->y, ec->p, ec->size );
+  ak_mpzn_mul_montgomery( a, ec->edwards->s, c, ec->p, ec->n, ec->size );   // a = s(z + y)
+  ak_mpzn_sub_modulo( c, ep->z, ep->y, ec );                               // c = z - y
+  ak_mpzn_mul_montgomery( b, ec->edwards->t, c, ec->p, ec->n, ec->size );   // b = t(z - y)
+  ak_mpzn_add_montgomery( b, b, a, ec->p, ec->size );
+
+  ak_mpzn_mul_montgomery( wp->x, b, ep->x, ec->p, ec->n, ec->size );
+  ak_mpzn_mul_montgomery( wp->y, a, ep->z, ec->p, ec->n, ec->size );
+  ak_mpzn_mul_montgomery( wp->z, c, ep->x, ec->p, ec->n, ec->size );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Удвоение точки кривой Эдвардса (формулы dbl-2008-hwcd, 4 возведения в квадрат
+    и 4 умножения).
+    \code
+      A = X^2
+      B = Y^2
+      C = 2*Z^2
+      E = (X+Y)^2-A-B
+      G = A+B
+      F = G-C
+      H = A-B
+      X3 = E*F
+      Y3 = G*H
+      T3 = E*H
+      Z3 = F*G
+    \endcode                                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_epoint_double( ak_epoint ep, ak_wcurve ec )
+{
+  ak_mpznmax a, b, c, e, f, g, h;
+
+  ak_mpzn_sqr_montgomery( a, ep->x, ec->p, ec->n, ec->size );
+  ak_mpzn_sqr_montgomery( b, ep->y, ec->p, ec->n, ec->size );
+  ak_mpzn_sqr_montgomery( c, ep->z, ec->p, ec->n, ec->size );
+  ak_mpzn_lshift_montgomery( c, c, ec->p, ec->size );
+  ak_mpzn_add_montgomery( e, ep->x, ep->y, ec->p, ec->size );
+  ak_mpzn_sqr_montgomery( e, e, ec->p, ec->n, ec->size );
+  ak_mpzn_add_montgomery( g, a, b, ec->p, ec->size );
+  ak_mpzn_sub_modulo( e, e, g, ec );
+  ak_mpzn_sub_modulo( f, g, c, ec );
+  ak_mpzn_sub_modulo( h, a, b, ec );
+
+  ak_mpzn_mul_montgomery( ep->x, e, f, ec->p, ec->n, ec->size );
+  ak_mpzn_mul_montgomery( ep->y, g, h, ec->p, ec->n, ec->size );
+  ak_mpzn_mul_montgomery( ep->t, e, h, ec->p, ec->n, ec->size );
+  ak_mpzn_mul_montgomery( ep->z, f, g, ec->p, ec->n, ec->size );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Завершение сложения точек кривой Эдвардса: по известным значениям
+    \f$ A = X_1X_2 \f$, \f$ B = Y_1Y_2 \f$, \f$ C = dT_1T_2 \f$, \f$ D = Z_1Z_2 \f$ и
+    \f$ E = (X_1+Y_1)(X_2+Y_2) \f$ вычисляются координаты суммы.                                   */
+/* ----------------------------------------------------------------------------------------------- */
+ static inline void ak_epoint_add_finish( ak_epoint ep, ak_uint64 *a, ak_uint64 *b,
+                                   ak_uint64 *c, ak_uint64 *d, ak_uint64 *e, ak_wcurve ec )
+{
+  ak_mpznmax f, g, h;
+
+  ak_mpzn_add_montgomery( g, a, b, ec->p, ec->size );
+  ak_mpzn_sub_modulo( e, e, g, ec );                          // e = (x1+y1)(x2+y2) - a - b
+  ak_mpzn_sub_modulo( f, d, c, ec );
+  ak_mpzn_add_montgomery( g, d, c, ec->p, ec->size );
+  ak_mpzn_sub_modulo( h, b, a, ec );
+
+  ak_mpzn_mul_montgomery( ep->x, e, f, ec->p, ec->n, ec->size );
+  ak_mpzn_mul_montgomery( ep->y, g, h, ec->p, ec->n, ec->size );
+  ak_mpzn_mul_montgomery( ep->t, e, h, ec->p, ec->n, ec->size );
+  ak_mpzn_mul_montgomery( ep->z, f, g, ec->p, ec->n, ec->size );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Сложение точек кривой Эдвардса (формулы add-2008-hwcd, 10 умножений);
+    результат помещается в первую точку.
+    \code
+      A = X1*X2
+      B = Y1*Y2
+      C = T1*d*T2
+      D = Z1*Z2
+      E = (X1+Y1)*(X2+Y2)-A-B
+      F = D-C
+      G = D+C
+      H = B-A
+      X3 = E*F
+      Y3 = G*H
+      T3 = E*H
+      Z3 = F*G
+    \endcode                                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_epoint_add( ak_epoint ep1, ak_epoint ep2, ak_wcurve ec )
+{
+  ak_mpznmax a, b, c, d, e, f;
+
+  ak_mpzn_mul_montgomery( a, ep1->x, ep2->x, ec->p, ec->n, ec->size );
+  ak_mpzn_mul_montgomery( b, ep1->y, ep2->y, ec->p, ec->n, ec->size );
+  ak_mpzn_mul_montgomery( c, ep1->t, ep2->t, ec->p, ec->n, ec->size );
+  ak_mpzn_mul_montgomery( c, c, ec->edwards->d, ec->p, ec->n, ec->size );
+  ak_mpzn_mul_montgomery( d, ep1->z, ep2->z, ec->p, ec->n, ec->size );
+  ak_mpzn_add_montgomery( e, ep1->x, ep1->y, ec->p, ec->size );
+  ak_mpzn_add_montgomery( f, ep2->x, ep2->y, ec->p, ec->size );
+  ak_mpzn_mul_montgomery( e, e, f, ec->p, ec->n, ec->size );
+  ak_epoint_add_finish( ep1, a, b, c, d, e, ec );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Сложение точки кривой Эдвардса с точкой таблицы, заданной в аффинных координатах
+    вектором \f$ (v, u, duv) \f$ в представлении Монтгомери (8 умножений).                       */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_epoint_add_mixed( ak_epoint ep, ak_uint64 *pt, ak_wcurve ec )
+{
+  ak_mpznmax a, b, c, e, f;
+  ak_uint64 *v = pt, *u = pt +ec->size, *duv = pt +2*ec->size;
+
+  ak_mpzn_mul_montgomery( a, ep->x, u, ec->p, ec->n, ec->size );
+  ak_mpzn_mul_montgomery( b, ep->y, v, ec->p, ec->n, ec->size );
+  ak_mpzn_mul_montgomery( c, ep->t, duv, ec->p, ec->n, ec->size );
+  ak_mpzn_add_montgomery( e, ep->x, ep->y, ec->p, ec->size );
+  ak_mpzn_add_montgomery( f, u, v, ec->p, ec->size );
+  ak_mpzn_mul_montgomery( e, e, f, ec->p, ec->n, ec->size );
+  ak_mpzn_set( f, ep->z, ec->size );
+  ak_epoint_add_finish( ep, a, b, c, f, e, ec );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Присвоение точке кривой Эдвардса значения точки таблицы \f$ (v, u, duv) \f$. */
+/* ----------------------------------------------------------------------------------------------- */
+ static inline void ak_epoint_set_affine( ak_epoint ep, ak_uint64 *pt, ak_uint64 *one,
+                                                                                  ak_wcurve ec )
+{
+  ak_mpzn_set( ep->y, pt, ec->size );
+  ak_mpzn_set( ep->x, pt +ec->size, ec->size );
+  ak_mpzn_set( ep->z, one, ec->size );
+  ak_mpzn_mul_montgomery( ep->t, ep->x, ep->y, ec->p, ec->n, ec->size );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*                  вычисление кратной точки методом окна с нечетными цифрами                      */
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Ширина окна, используемого функцией ak_wpoint_pow(). */
+ #define ak_wpoint_pow_width      (5)
+/*! \brief Количество нечетных кратных \f$ P, 3P, \ldots, 31P \f$, вычисляемых функцией ak_wpoint_pow(). */
+ #define ak_wpoint_pow_points    (16)
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция возвращает \f$ w+1 \f$ бит числа \f$ k \f$, начиная с бита с номером pos
+    (биты, выходящие за пределы числа, считаются равными нулю).                                    */
+/* ----------------------------------------------------------------------------------------------- */
+ static inline ak_uint64 ak_mpzn_get_window( ak_uint64 *k, const size_t size, const size_t pos )
+{
+  ak_uint64 v = 0;
+  const size_t word = pos >> 6, offset = pos&0x3f;
+
+  if( word < size ) v = k[word] >> offset;
+  if(( offset > 63 - ak_wpoint_pow_width ) && ( word +1 < size )) v |= k[word+1] << ( 64 - offset );
+ return v&(( 1 << ( ak_wpoint_pow_width +1 )) -1 );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Замена вычета \f$ x \f$ на \f$ -x \pmod{p} \f$ при ненулевом значении neg (без ветвлений). */
+/* ----------------------------------------------------------------------------------------------- */
+ static inline void ak_mpzn_negate_modulo( ak_uint64 *x, ak_uint64 neg, ak_wcurve ec )
+{
+  size_t l = 0;
+  ak_mpznmax t, zero = ak_mpznmax_zero;
+  ak_uint64 mask = ( ak_uint64 )0 - neg;
+
+  ak_mpzn_sub_modulo( t, zero, x, ec );
+  for( l = 0; l < ec->size; l++ ) x[l] = ( x[l]&( ~mask )) | ( t[l]&mask );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Копирование в pt элемента массива table, состоящего из count элементов по words слов,
+    с номером idx; просматриваются все элементы массива, время работы не зависит от idx.          */
+/* ----------------------------------------------------------------------------------------------- */
+ static inline void ak_wpoint_pow_select( ak_uint64 *pt, ak_uint64 *table, const size_t count,
+                                                            const size_t words, ak_uint64 idx )
+{
+  size_t j = 0, l = 0;
+  ak_uint64 mask = 0;
+
+  memset( pt, 0, words*sizeof( ak_uint64 ));
+  for( j = 0; j < count; j++, table += words ) {
+    /* mask = 0xff..ff, если j = idx, и 0 в противном случае */
+     mask = ( ak_uint64 )0 - ((( ak_uint64 )( j^idx ) - 1 ) >> 63 );
+     for( l = 0; l < words; l++ ) pt[l] |= table[l] & mask;
+  }
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция вычисляет цифру с номером i представления
+    \f$ k' = \sum_{i=0}^{n-1} d_i 2^{wi} \f$ нечетного числа \f$ k' = k \,|\, 1 \f$ с нечетными
+    цифрами \f$ d_i \in \{ \pm 1, \pm 3, \ldots, \pm (2^w -1) \} \f$ (старшая цифра положительна)
+    и возвращает номер \f$ (|d_i| -1)/2 \f$ точки в таблице нечетных кратных;
+    в переменную neg помещается единица, если \f$ d_i < 0 \f$.
+
+    Поскольку \f$ d_i = m_i - 2^w \f$, где \f$ m_i \f$ - число, образованное битами
+    \f$ wi, \ldots, wi+w \f$ числа \f$ k' \f$ с младшим битом, равным единице, цифры
+    вычисляются независимо друг от друга и без ветвлений.                                          */
+/* ----------------------------------------------------------------------------------------------- */
+ static inline ak_uint64 ak_mpzn_get_digit( ak_uint64 *neg, ak_uint64 *k, const size_t size,
+                                                          const size_t i, const size_t windows )
+{
+  const ak_uint64 low = ( 1 << ak_wpoint_pow_width ) -1;
+  ak_uint64 m = ak_mpzn_get_window( k, size, i*ak_wpoint_pow_width ) | 1;
+
+  if( i == windows -1 ) { *neg = 0; return m >> 1; } /* старшая цифра равна m */
+  *neg = (( m >> ak_wpoint_pow_width )&1 )^1;
+ return (( m&low )^( low&( 0 - *neg ))) >> 1;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Вычисление кратной точки методом окна в расширенных координатах кривой Эдвардса;
+    используется функцией ak_wpoint_pow() для кривых, имеющих форму Эдвардса.                     */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_epoint_pow( ak_wpoint wq, ak_wpoint wp, ak_uint64 *k, size_t size, ak_wcurve ec )
+{
+  size_t i = 0, j = 0, l = 0;
+  struct epoint R, S, table[ ak_wpoint_pow_points ];
+  ak_uint64 idx = 0, neg = 0, mask = 0, *r = ( ak_uint64 * )&R, *s = ( ak_uint64 * )&S;
+  const size_t windows = ( 64*size + ak_wpoint_pow_width -1 )/ak_wpoint_pow_width,
+               words = sizeof( struct epoint )/sizeof( ak_uint64 );
+
+ /* вычисляем нечетные кратные P, 3P, ..., 31P */
+  memset( table, 0, sizeof( table ));
+  ak_epoint_set_wpoint( table, wp, ec );
+  memcpy( &S, table, sizeof( struct epoint ));
+  ak_epoint_double( &S, ec );
+  for( j = 1; j < ak_wpoint_pow_points; j++ ) {
+     memcpy( table +j, table +j -1, sizeof( struct epoint ));
+     ak_epoint_add( table +j, &S, ec );
+  }
+
+ /* основной цикл: w удвоений и одно сложение на каждую цифру */
+  for( i = windows; i > 0; i-- ) {
+     idx = ak_mpzn_get_digit( &neg, k, size, i-1, windows );
+     ak_wpoint_pow_select( s, ( ak_uint64 * )table, ak_wpoint_pow_points, words, idx );
+     ak_mpzn_negate_modulo( S.x, neg, ec );
+     ak_mpzn_negate_modulo( S.t, neg, ec );
+     if( i == windows ) memcpy( &R, &S, sizeof( struct epoint ));
+      else {
+        for( j = 0; j < ak_wpoint_pow_width; j++ ) ak_epoint_double( &R, ec );
+        ak_epoint_add( &R, &S, ec );
+      }
+  }
+
+ /* для четного k вычитаем из [k+1]P точку P (без ветвлений) */
+  memcpy( &S, table, sizeof( struct epoint ));
+  ak_mpzn_negate_modulo( S.x, 1, ec );
+  ak_mpzn_negate_modulo( S.t, 1, ec );
+  ak_epoint_add( &S, &R, ec );
+  mask = ( ak_uint64 )0 - (( k[0]&1 )^1 );
+  for( l = 0; l < words; l++ ) r[l] = ( r[l]&( ~mask )) | ( s[l]&mask );
+  ak_epoint_to_wpoint( wq, &R, ec );
+
+  memset( &R, 0, sizeof( struct epoint ));
+  memset( &S, 0, sizeof( struct epoint ));
+  memset( table, 0, sizeof( table ));
+}
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! Для заданной точки \f$ P = (x:y:z) \f$ и заданного целого числа (вычета) \f$ k \f$
     функция вычисляет кратную точку \f$ Q \f$, удовлетворяющую
     равенству \f$  Q = [k]P = \underbrace{P+ \cdots + P}_{k}\f$.
 
-    При вычислении используется метод `лесенки Монтгомери`, выравнивающий время работы алгоритма
-    вне зависимости от вида числа \f$ k \f$.
+    При вычислении используется метод окна ширины \f$ w = 5 \f$ с нечетными цифрами:
+    вычисляются точки \f$ P, 3P, \ldots, 31P \f$, нечетное число \f$ k' = k \,|\, 1 \f$
+    представляется в виде \f$ k' = \sum d_i 32^i \f$ с цифрами
+    \f$ d_i \in \{ \pm 1, \pm 3, \ldots, \pm 31 \} \f$, после чего на каждую цифру выполняется
+    пять удвоений и одно сложение (вместо одного сложения на каждый бит в методе лесенки
+    Монтгомери). Если \f$ k \f$ четно, то из полученной точки \f$ [k+1]P \f$ вычитается
+    точка \f$ P \f$, а результат выбирается без ветвлений. Количество операций с точками
+    и последовательность обращений к памяти (при выборе точки просматривается вся таблица)
+    не зависят от значения \f$ k \f$. Для кривых, имеющих форму Эдвардса (см. wcurve::edwards),
+    вычисления выполняются в расширенных координатах эквивалентной кривой Эдвардса
+    с использованием полных формул сложения.
 
     \b Для \b информации:
      \li Функция не приводит результирующую точку \f$ Q \f$ к аффинной форме.
@@ -609,25 +1126,756 @@
 /* ----------------------------------------------------------------------------------------------- */
  void ak_wpoint_pow( ak_wpoint wq, ak_wpoint wp, ak_uint64 *k, size_t size, ak_wcurve ec )
 {
-  ak_uint64 uk = 0;
-  long long int i, j;
-  struct wpoint Q, R; /* две точки из лесенки Монтгомери */
-
- /* начальные значения для переменных */
-  ak_wpoint_set_as_unit( &Q, ec );
-  ak_wpoint_set_wpoint( &R, wp, ec );
-
- /* полный цикл по всем(!) битам числа k */
-  for( i = size-1; i >= 0; i-- ) {
-     uk = k[i];
-     for( j = 0; j < 64; j++ ) {
-       if( uk&0x8000000000000000LL ) { ak_wpoint_add( &Q, &R, ec ); ak_wpoint_double( &R, ec ); }
-        else { ak_wpoint_add( &R, &Q, ec ); ak_wpoint_double( &Q, ec ); }
-       uk <<= 1;
+  size_t i = 0, j = 0, l = 0;
+  struct wpoint R, S, table[ ak_wpoint_pow_points ];
+  ak_uint64 idx = 0, neg = 0, mask = 0, *r = ( ak_uint64 * )&R, *s = ( ak_uint64 * )&S;
+  const size_t windows = ( 64*size + ak_wpoint_pow_width -1 )/ak_wpoint_pow_width,
+               words = sizeof( struct wpoint )/sizeof( ak_uint64 );
+ /* формулы удвоения выбираются один раз, в зависимости от вида кривой */
+  void ( *twice )( ak_wpoint, ak_wcurve ) = ( ec->variant == wcurve_a_minus_three ) ?
+                                      ak_wpoint_double_a_minus_three : ak_wpoint_double_generic;
+
+  if(( windows == 0 ) || ( ak_mpzn_cmp_ui( wp->z, ec->size, 0 ) == ak_true )) {
+    ak_wpoint_set_as_unit( wq, ec );
+    return;
+  }
+  if( ec->edwards != NULL ) {
+    ak_epoint_pow( wq, wp, k, size, ec );
+    return;
+  }
+
+ /* вычисляем нечетные кратные P, 3P, ..., 31P */
+  memset( table, 0, sizeof( table ));
+  ak_wpoint_set_wpoint( table, wp, ec );
+  ak_wpoint_set_wpoint( &S, wp, ec );
+  twice( &S, ec );
+  for( j = 1; j < ak_wpoint_pow_points; j++ ) {
+     ak_wpoint_set_wpoint( table +j, table +j -1, ec );
+     ak_wpoint_add( table +j, &S, ec );
+  }
+
+ /* основной цикл: w удвоений и одно сложение на каждую цифру */
+  for( i = windows; i > 0; i-- ) {
+     idx = ak_mpzn_get_digit( &neg, k, size, i-1, windows );
+     ak_wpoint_pow_select( s, ( ak_uint64 * )table, ak_wpoint_pow_points, words, idx );
+     ak_mpzn_negate_modulo( S.y, neg, ec );
+     if( i == windows ) ak_wpoint_set_wpoint( &R, &S, ec );
+      else {
+        for( j = 0; j < ak_wpoint_pow_width; j++ ) twice( &R, ec );
+        ak_wpoint_add( &R, &S, ec );
+      }
+  }
+
+ /* для четного k вычитаем из [k+1]P точку P (без ветвлений) */
+  ak_wpoint_set_wpoint( &S, table, ec );
+  ak_mpzn_negate_modulo( S.y, 1, ec );
+  ak_wpoint_add( &S, &R, ec );
+  mask = ( ak_uint64 )0 - (( k[0]&1 )^1 );
+  for( l = 0; l < words; l++ ) r[l] = ( r[l]&( ~mask )) | ( s[l]&mask );
+  ak_wpoint_set_wpoint( wq, &R, ec );
+
+  memset( &R, 0, sizeof( struct wpoint ));
+  memset( &S, 0, sizeof( struct wpoint ));
+  memset( table, 0, sizeof( table ));
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Для массива точек \f$ P_1, \ldots, P_n \f$ функция вычисляет их аффинные представления,
+    аналогично функции ak_wpoint_reduce(). Для вычисления обратных элементов используется
+    прием Монтгомери: вычисляется только один обратный элемент (произведения всех
+    \f$ z \f$-координат), а остальные получаются из него с помощью трех умножений на каждую точку.
+
+    @param wp Массив точек кривой, которые приводятся к аффинной форме
+    @param count Количество точек в массиве
+    @param ec Эллиптическая кривая, которой принадлежат точки
+    @return В случае успеха функция возвращает \ref ak_error_ok. В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_wpoint_reduce_many( ak_wpoint wp, const size_t count, ak_wcurve ec )
+{
+  size_t i = 0;
+  ak_uint64 *prod = NULL, *z = NULL;
+  ak_mpznmax u, t, rone, one = ak_mpznmax_one;
+
+  if( wp == NULL ) return ak_error_message( ak_error_null_pointer, __func__ ,
+                                                   "using null pointer to elliptic curve point" );
+  if( ec == NULL ) return ak_error_message( ak_error_null_pointer, __func__ ,
+                                                         "using null pointer to elliptic curve" );
+  if( count == 0 ) return ak_error_ok;
+  if( count == 1 ) {
+    ak_wpoint_reduce( wp, ec );
+    return ak_error_ok;
+  }
+  if(( prod = malloc( count*ec->size*sizeof( ak_uint64 ))) == NULL )
+    return ak_error_message( ak_error_out_of_memory, __func__, "incorrect memory allocation" );
+
+ /* единица в представлении Монтгомери, заменяющая z-координату бесконечно удаленных точек */
+  ak_mpzn_mul_montgomery( rone, one, ec->r2, ec->p, ec->n, ec->size );
+
+ /* накапливаем произведения z-координат */
+  ak_mpzn_set( u, rone, ec->size );
+  for( i = 0; i < count; i++ ) {
+     z = ak_mpzn_cmp_ui( wp[i].z, ec->size, 0 ) ? rone : wp[i].z;
+     ak_mpzn_mul_montgomery( u, u, z, ec->p, ec->n, ec->size );
+     ak_mpzn_set( prod +i*ec->size, u, ec->size );
+  }
+
+ /* вычисляем единственный обратный элемент u <- (z_1 \cdots z_n)^{-1} (mod p) */
+  ak_mpzn_inverse_montgomery( u, u, ec->p, ec->n, ec->r2, ec->size );
+
+ /* проходим массив в обратном порядке, получая обратные элементы для каждой точки */
+  for( i = count; i > 0; i-- ) {
+     ak_wpoint w = wp +i -1;
+     bool_t infinity = ak_mpzn_cmp_ui( w->z, ec->size, 0 );
+
+     if( i > 1 ) ak_mpzn_mul_montgomery( t, u, prod +( i-2 )*ec->size, ec->p, ec->n, ec->size );
+      else ak_mpzn_set( t, u, ec->size );
+     if( infinity ) {
+       ak_wpoint_set_as_unit( w, ec );
+       continue;
+     }
+     ak_mpzn_mul_montgomery( u, u, w->z, ec->p, ec->n, ec->size );
+     ak_mpzn_mul_montgomery( t, t, one, ec->p, ec->n, ec->size );
+     ak_mpzn_mul_montgomery( w->x, w->x, t, ec->p, ec->n, ec->size );
+     ak_mpzn_mul_montgomery( w->y, w->y, t, ec->p, ec->n, ec->size );
+     ak_mpzn_set_ui( w->z, ec->size, 1 );
+  }
+
+  memset( prod, 0, count*ec->size*sizeof( ak_uint64 ));
+  free( prod );
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*                      вычисление кратных точек для образующей точки кривой                       */
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Ширина окна, используемого при вычислении кратных точек для образующей точки. */
+ #define ak_wcurve_table_width     (4)
+/*! \brief Количество точек в одном окне таблицы. */
+ #define ak_wcurve_table_points    (8)
+/*! \brief Максимальное количество кривых, для которых хранятся таблицы. */
+ #define ak_wcurve_tables_count   (16)
+/*! \brief Количество слов, занимаемых в таблицах одной точкой: аффинные координаты \f$ (x, y) \f$
+    для кривых в форме Вейерштрасса и \f$ (v, u, duv) \f$ для кривых, имеющих форму Эдвардса. */
+ #define ak_wcurve_point_words( ec ) ((( ec )->edwards == NULL ? 2 : 3 )*( ec )->size )
+
+/*! \brief Таблица кратных образующей точки эллиптической кривой.
+
+    Для каждого окна \f$ i = 0, \ldots, n-1 \f$ хранятся аффинные координаты точек
+    \f$ (2j+1)16^iP \f$, \f$ j = 0, \ldots, 7 \f$, в представлении Монтгомери
+    (для кривых, имеющих форму Эдвардса, - координаты \f$ (v, u, duv) \f$ точек кривой Эдвардса). */
+ typedef struct wcurve_table {
+  /*! \brief кривая, для которой вычислена таблица */
+   ak_wcurve wc;
+  /*! \brief количество окон */
+   size_t windows;
+  /*! \brief единица в представлении Монтгомери (z-координата всех точек таблицы) */
+   ak_mpzn512 one;
+  /*! \brief координаты точек */
+   ak_uint64 *data;
+ } *ak_wcurve_table;
+
+/*! \brief Таблицы для всех кривых, использовавшихся в процессе работы. */
+ static struct wcurve_table ak_wcurve_tables[ ak_wcurve_tables_count ];
+/*! \brief Количество вычисленных таблиц. */
+ static size_t ak_wcurve_tables_used = 0;
+#ifdef AK_HAVE_PTHREAD_H
+/*! \brief Мьютекс, защищающий массив таблиц. */
+ static pthread_mutex_t ak_wcurve_tables_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Сложение точки в проективных координатах с точкой, заданной аффинными координатами
+    в представлении Монтгомери (z-координата второй точки считается равной единице).
+
+    Используются формулы add-1998-cmo-2, из которых исключены умножения на \f$ z_2 \f$.
+    \code
+      u = Y2*Z1-Y1
+      v = X2*Z1-X1
+      R = v^2*X1
+      A = u^2*Z1-v^3-2*R
+      X3 = v*A
+      Y3 = u*(R-A)-v^3*Y1
+      Z3 = v^3*Z1
+    \endcode
+
+    @param wp Точка \f$ P \f$, в которую помещается результат операции сложения
+    @param x2 x-координата второго слагаемого
+    @param y2 y-координата второго слагаемого
+    @param one Единица в представлении Монтгомери
+    @param ec Эллиптическая кривая                                                                 */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_wpoint_add_mixed( ak_wpoint wp, ak_uint64 *x2, ak_uint64 *y2,
+                                                                  ak_uint64 *one, ak_wcurve ec )
+{
+  ak_mpznmax u, v, t, r, a, vvv;
+
+  if( ak_mpzn_cmp_ui( wp->z, ec->size, 0 ) == ak_true ) {
+    ak_mpzn_set( wp->x, x2, ec->size );
+    ak_mpzn_set( wp->y, y2, ec->size );
+    ak_mpzn_set( wp->z, one, ec->size );
+    return;
+  }
+
+  ak_mpzn_mul_montgomery( u, y2, wp->z, ec->p, ec->n, ec->size );
+  ak_mpzn_sub( t, ec->p, wp->y, ec->size );
+  ak_mpzn_add_montgomery( u, u, t, ec->p, ec->size );      // u = y2z1 - y1
+  ak_mpzn_mul_montgomery( v, x2, wp->z, ec->p, ec->n, ec->size );
+  ak_mpzn_sub( t, ec->p, wp->x, ec->size );
+  ak_mpzn_add_montgomery( v, v, t, ec->p, ec->size );      // v = x2z1 - x1
+
+ /* случай совпадения x-координат точек */
+  if( ak_mpzn_cmp_ui( v, ec->size, 0 ) == ak_true ) {
+    if( ak_mpzn_cmp_ui( u, ec->size, 0 ) == ak_true ) ak_wpoint_double( wp, ec );
+     else ak_wpoint_set_as_unit( wp, ec );
+    return;
+  }
+
+  ak_mpzn_mul_montgomery( t, v, v, ec->p, ec->n, ec->size );          // t = v^2
+  ak_mpzn_mul_montgomery( vvv, t, v, ec->p, ec->n, ec->size );        // vvv = v^3
+  ak_mpzn_mul_montgomery( r, t, wp->x, ec->p, ec->n, ec->size );      // r = v^2x1
+  ak_mpzn_mul_montgomery( a, u, u, ec->p, ec->n, ec->size );
+  ak_mpzn_mul_montgomery( a, a, wp->z, ec->p, ec->n, ec->size );      // a = u^2z1
+  ak_mpzn_sub( t, ec->p, vvv, ec->size );
+  ak_mpzn_add_montgomery( a, a, t, ec->p, ec->size );
+  ak_mpzn_lshift_montgomery( t, r, ec->p, ec->size );
+  ak_mpzn_sub( t, ec->p, t, ec->size );
+  ak_mpzn_add_montgomery( a, a, t, ec->p, ec->size );      // a = u^2z1 - v^3 - 2r
+
+  ak_mpzn_mul_montgomery( wp->x, v, a, ec->p, ec->n, ec->size );
+  ak_mpzn_mul_montgomery( wp->z, vvv, wp->z, ec->p, ec->n, ec->size );
+  ak_mpzn_mul_montgomery( vvv, vvv, wp->y, ec->p, ec->n, ec->size );
+  ak_mpzn_sub( t, ec->p, a, ec->size );
+  ak_mpzn_add_montgomery( r, r, t, ec->p, ec->size );
+  ak_mpzn_mul_montgomery( wp->y, u, r, ec->p, ec->n, ec->size );
+  ak_mpzn_sub( t, ec->p, vvv, ec->size );
+  ak_mpzn_add_montgomery( wp->y, wp->y, t, ec->p, ec->size ); // y3 = u(r - a) - v^3y1
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Приведение массива точек к аффинной форме и запись их координат в таблицу
+    в представлении Монтгомери.
+
+    Для кривых в форме Вейерштрасса записываются координаты \f$ (x, y) \f$,
+    для кривых, имеющих форму Эдвардса, - координаты \f$ (v, u, duv) \f$ эквивалентных точек
+    кривой Эдвардса. Исходный массив точек изменяется.                                             */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_wpoint_table_store( ak_uint64 *data, ak_wpoint points, const size_t count,
+                                                                                  ak_wcurve ec )
+{
+  size_t i = 0;
+  struct epoint ep;
+  int error = ak_error_ok;
+  const size_t words = ak_wcurve_point_words( ec );
+
+ /* переходим к проективным координатам (v:u:z) кривой Эдвардса */
+  if( ec->edwards != NULL )
+    for( i = 0; i < count; i++ ) {
+       ak_epoint_set_wpoint( &ep, points +i, ec );
+       ak_mpzn_set( points[i].x, ep.y, ec->size );
+       ak_mpzn_set( points[i].y, ep.x, ec->size );
+       ak_mpzn_set( points[i].z, ep.z, ec->size );
+    }
+  if(( error = ak_wpoint_reduce_many( points, count, ec )) != ak_error_ok )
+    return ak_error_message( error, __func__, "incorrect reducing of precomputed points" );
+
+  for( i = 0; i < count; i++, data += words ) {
+     ak_mpzn_mul_montgomery( data, points[i].x, ec->r2, ec->p, ec->n, ec->size );
+     ak_mpzn_mul_montgomery( data +ec->size, points[i].y, ec->r2, ec->p, ec->n, ec->size );
+     if( ec->edwards != NULL ) {
+       ak_mpzn_mul_montgomery( data +2*ec->size, data, data +ec->size, ec->p, ec->n, ec->size );
+       ak_mpzn_mul_montgomery( data +2*ec->size,
+                                  data +2*ec->size, ec->edwards->d, ec->p, ec->n, ec->size );
      }
   }
- /* копируем полученный результат */
-  ak_wpoint_set_wpoint( wq, &Q, ec );
+ return error;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Вычисление таблицы кратных образующей точки эллиптической кривой. */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_wcurve_table_create( ak_wcurve_table tb, ak_wcurve ec )
+{
+  size_t i = 0, j = 0, idx = 0, count = 0;
+  int error = ak_error_ok;
+  struct wpoint base, twice;
+  ak_wpoint points = NULL;
+  ak_uint64 one[ak_mpzn512_size] = ak_mpzn512_one;
+
+  tb->windows = 16*ec->size +1; /* k < 2q, то есть k содержит не более 64*size +1 бит */
+  count = tb->windows*ak_wcurve_table_points;
+  if(( points = malloc( count*sizeof( struct wpoint ))) == NULL )
+    return ak_error_message( ak_error_out_of_memory, __func__, "incorrect memory allocation" );
+  if(( tb->data = malloc( count*ak_wcurve_point_words( ec )*sizeof( ak_uint64 ))) == NULL ) {
+    free( points );
+    return ak_error_message( ak_error_out_of_memory, __func__, "incorrect memory allocation" );
+  }
+
+ /* вычисляем точки (2j+1)16^iP в проективных координатах */
+  ak_wpoint_set( &base, ec );
+  for( i = 0; i < tb->windows; i++ ) {
+     ak_wpoint_set_wpoint( &twice, &base, ec );
+     ak_wpoint_double( &twice, ec );
+     ak_wpoint_set_wpoint( points +idx, &base, ec );
+     for( j = 1; j < ak_wcurve_table_points; j++, idx++ ) {
+        ak_wpoint_set_wpoint( points +idx +1, points +idx, ec );
+        ak_wpoint_add( points +idx +1, &twice, ec );
+     }
+     idx++;
+     for( j = 0; j < ak_wcurve_table_width; j++ ) ak_wpoint_double( &base, ec );
+  }
+
+ /* приводим точки к аффинной форме и переводим координаты в представление Монтгомери */
+  if(( error = ak_wpoint_table_store( tb->data, points, count, ec )) != ak_error_ok ) {
+    ak_error_message( error, __func__, "incorrect storing of precomputed points" );
+    free( tb->data ); tb->data = NULL;
+  } else {
+      ak_mpzn_mul_montgomery( tb->one, one, ec->r2, ec->p, ec->n, ec->size );
+      tb->wc = ec;
+    }
+  free( points );
+
+ return error;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция возвращает таблицу кратных образующей точки для заданной кривой,
+    вычисляя ее при первом обращении. Если таблица не может быть вычислена, возвращается NULL.     */
+/* ----------------------------------------------------------------------------------------------- */
+ static ak_wcurve_table ak_wcurve_table_get( ak_wcurve ec )
+{
+  size_t i = 0;
+  ak_wcurve_table tb = NULL;
+
+#ifdef AK_HAVE_PTHREAD_H
+  pthread_mutex_lock( &ak_wcurve_tables_mutex );
+#endif
+  for( i = 0; i < ak_wcurve_tables_used; i++ )
+     if( ak_wcurve_tables[i].wc == ec ) { tb = ak_wcurve_tables +i; break; }
+
+  if(( tb == NULL ) && ( ak_wcurve_tables_used < ak_wcurve_tables_count )) {
+    tb = ak_wcurve_tables +ak_wcurve_tables_used;
+    memset( tb, 0, sizeof( struct wcurve_table ));
+    if( ak_wcurve_table_create( tb, ec ) == ak_error_ok ) ak_wcurve_tables_used++;
+     else tb = NULL;
+  }
+#ifdef AK_HAVE_PTHREAD_H
+  pthread_mutex_unlock( &ak_wcurve_tables_mutex );
+#endif
+
+ return tb;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция удаляет все вычисленные таблицы кратных точек. */
+/* ----------------------------------------------------------------------------------------------- */
+ void ak_wcurve_tables_destroy( void )
+{
+  size_t i = 0;
+
+#ifdef AK_HAVE_PTHREAD_H
+  pthread_mutex_lock( &ak_wcurve_tables_mutex );
+#endif
+  for( i = 0; i < ak_wcurve_tables_used; i++ ) {
+     free( ak_wcurve_tables[i].data );
+     memset( ak_wcurve_tables +i, 0, sizeof( struct wcurve_table ));
+  }
+  ak_wcurve_tables_used = 0;
+#ifdef AK_HAVE_PTHREAD_H
+  pthread_mutex_unlock( &ak_wcurve_tables_mutex );
+#endif
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Замена точки таблицы на противоположную при ненулевом значении neg (без ветвлений).
+
+    У противоположной точки изменяют знак все координаты, кроме первой:
+    \f$ y \f$ для кривой в форме Вейерштрасса, \f$ u \f$ и \f$ duv \f$ для кривой Эдвардса.     */
+/* ----------------------------------------------------------------------------------------------- */
+ static inline void ak_wcurve_point_negate( ak_uint64 *pt, ak_uint64 neg, ak_wcurve ec )
+{
+  size_t l = 0;
+  ak_mpzn512 t;
+  ak_uint64 *y = NULL, mask = ( ak_uint64 )0 - neg;
+
+  for( y = pt +ec->size; y < pt +ak_wcurve_point_words( ec ); y += ec->size ) {
+     ak_mpzn_sub( t, ec->p, y, ec->size );
+     for( l = 0; l < ec->size; l++ ) y[l] = ( y[l]&( ~mask )) | ( t[l]&mask );
+  }
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Выбор точки из строки таблицы, не зависящий по времени от номера точки;
+    при ненулевом значении neg выбранная точка заменяется на противоположную.                      */
+/* ----------------------------------------------------------------------------------------------- */
+ static inline void ak_wcurve_table_select( ak_uint64 *pt, ak_uint64 *row,
+                                             ak_uint64 idx, ak_uint64 neg, ak_wcurve ec )
+{
+  size_t j = 0, l = 0;
+  ak_uint64 mask = 0;
+  const size_t words = ak_wcurve_point_words( ec );
+
+  memset( pt, 0, words*sizeof( ak_uint64 ));
+  for( j = 0; j < ak_wcurve_table_points; j++, row += words ) {
+    /* mask = 0xff..ff, если j = idx, и 0 в противном случае */
+     mask = ( ak_uint64 )0 - ((( ak_uint64 )( j^idx ) - 1 ) >> 63 );
+     for( l = 0; l < words; l++ ) pt[l] |= row[l] & mask;
+  }
+  ak_wcurve_point_negate( pt, neg, ec );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция вычисляет кратную точку \f$ Q = [k]P \f$, где \f$ P \f$ образующая точка кривой,
+    содержащаяся в ее параметрах. В отличие от функции ak_wpoint_pow(), удвоения точек
+    не выполняются: при первом обращении для кривой вычисляется и сохраняется таблица
+    точек \f$ (2j+1)16^iP \f$, после чего кратная точка вычисляется как сумма \f$ 16\cdot size +1 \f$
+    точек таблицы (65 сложений для 256-ти битных кривых и 129 для 512-ти битных).
+
+    Для этого нечетное число \f$ k' \f$ (равное \f$ k \f$, если \f$ k \f$ нечетно, и \f$ k+q \f$
+    в противном случае; поскольку \f$ [q]P = \mathcal O \f$, то \f$ [k']P = [k]P\f$)
+    представляется в виде \f$ k' = \sum d_i 16^i \f$ с нечетными цифрами
+    \f$ d_i \in \{ \pm 1, \pm 3, \ldots, \pm 15 \} \f$. Количество сложений, а также
+    последовательность обращений к памяти при выборе точек таблицы (просматриваются все точки
+    строки) не зависят от значения \f$ k \f$.
+
+    Для кривых, имеющих форму Эдвардса, сумма точек таблицы накапливается в расширенных
+    координатах эквивалентной кривой Эдвардса.
+
+    Если таблица не может быть вычислена, используется функция ak_wpoint_pow().
+
+    \b Для \b информации:
+     \li Функция не приводит результирующую точку \f$ Q \f$ к аффинной форме.
+     \li Значение \f$ k \f$ должно удовлетворять неравенству \f$ 0 \leq k < q \f$.
+
+    @param wq Точка \f$ Q \f$, в которую помещается результат.
+    @param k Степень кратности, вычет по модулю \f$ q \f$ размером `ec->size` слов.
+    @param ec Эллиптическая кривая, на которой происходят вычисления                               */
+/* ----------------------------------------------------------------------------------------------- */
+ void ak_wpoint_pow_base( ak_wpoint wq, ak_uint64 *k, ak_wcurve ec )
+{
+  size_t i = 0, l = 0;
+  struct epoint ep;
+  ak_mpznmax kk, t;
+  ak_uint64 pt[3*ak_mpzn512_size];
+  ak_uint64 mask = 0, m = 0, neg = 0, *row = NULL;
+  ak_wcurve_table tb = ak_wcurve_table_get( ec );
+
+  if( tb == NULL ) {
+    ak_wpoint_pow( wq, &ec->point, k, ec->size, ec );
+    return;
+  }
+
+ /* вычисляем нечетное k' (без ветвлений) */
+  t[ec->size] = ak_mpzn_add( t, k, ec->q, ec->size );
+  mask = ( k[0]&1 ) - 1;
+  for( l = 0; l < ec->size; l++ ) kk[l] = ( k[l]&( ~mask )) | ( t[l]&mask );
+  kk[ec->size] = t[ec->size]&mask;
+
+ /* суммируем точки таблицы */
+  for( i = 0, row = tb->data; i < tb->windows;
+                                  i++, row += ak_wcurve_table_points*ak_wcurve_point_words( ec )) {
+     if( i < tb->windows -1 ) {
+       m = kk[0]&0x1f;                 /* d = m - 16 */
+       neg = (( m >> 4 )&1 )^1;       /* d < 0 */
+       m = (( m&0xf )^( 0xf&( 0 - neg ))) >> 1;
+      /* k <- (k >> 4) | 1 */
+       for( l = 0; l < ec->size; l++ ) kk[l] = ( kk[l] >> 4 ) | ( kk[l+1] << 60 );
+       kk[ec->size] >>= 4;
+       kk[0] |= 1;
+     } else { m = 0; neg = 0; } /* старшая цифра всегда равна 1 */
+
+     ak_wcurve_table_select( pt, row, m, neg, ec );
+     if( ec->edwards != NULL ) {
+       if( i == 0 ) ak_epoint_set_affine( &ep, pt, tb->one, ec );
+        else ak_epoint_add_mixed( &ep, pt, ec );
+     } else {
+         if( i == 0 ) {
+           ak_mpzn_set( wq->x, pt, ec->size );
+           ak_mpzn_set( wq->y, pt +ec->size, ec->size );
+           ak_mpzn_set( wq->z, tb->one, ec->size );
+         } else ak_wpoint_add_mixed( wq, pt, pt +ec->size, tb->one, ec );
+       }
+  }
+  if( ec->edwards != NULL ) ak_epoint_to_wpoint( wq, &ep, ec );
+
+  memset( kk, 0, sizeof( kk ));
+  memset( t, 0, sizeof( t ));
+  memset( pt, 0, sizeof( pt ));
+  memset( &ep, 0, sizeof( struct epoint ));
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*                      одновременное вычисление суммы двух кратных точек                          */
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Ширина окна wNAF представления, используемого при вычислении суммы кратных точек. */
+ #define ak_wpoint_naf_width      (5)
+/*! \brief Максимальная длина wNAF представления вычета. */
+ #define ak_wpoint_naf_length     ( 64*ak_mpzn512_size +2 )
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Вычисление wNAF представления вычета \f$ k = \sum_i d_i2^i \f$, в котором
+    ненулевые цифры \f$ d_i \f$ нечетны, \f$ |d_i| < 2^{w-1} \f$, и среди любых \f$ w \f$
+    подряд идущих цифр не более одной отлично от нуля.
+
+    \note Время работы функции зависит от значения \f$ k \f$, поэтому она используется только
+    для открытых данных.
+
+    @return Функция возвращает количество цифр представления.                                      */
+/* ----------------------------------------------------------------------------------------------- */
+ static size_t ak_mpzn_to_naf( ak_int8 *naf, ak_uint64 *k, const size_t size, const size_t w )
+{
+  size_t i = 0, l = 0, len = 0;
+  ak_mpznmax t;
+  ak_uint64 top = (( ak_uint64 )1 ) << w, mask = top -1;
+
+  ak_mpzn_set( t, k, size );
+  t[size] = 0;
+  while( !ak_mpzn_cmp_ui( t, size +1, 0 )) {
+    ak_int64 d = 0;
+    if( t[0]&1 ) {
+      d = ( ak_int64 )( t[0]&mask );
+      if( d >= ( ak_int64 )( top >> 1 )) d -= ( ak_int64 )top;
+     /* t <- t - d, при этом младшие w бит обнуляются */
+      if( d > 0 ) t[0] -= ( ak_uint64 )d;
+       else {
+         ak_uint64 c = ( ak_uint64 )( -d );
+         for( l = 0; l <= size && c; l++ ) { t[l] += c; c = ( t[l] < c ); }
+       }
+    }
+    naf[i++] = ( ak_int8 )d;
+    if( d != 0 ) len = i;
+    for( l = 0; l < size; l++ ) t[l] = ( t[l] >> 1 ) | ( t[l+1] << 63 );
+    t[size] >>= 1;
+  }
+
+ return len;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Вычисление нечетных кратных \f$ [2j+1]P \f$, \f$ j = 0, \ldots, count-1 \f$, заданной
+    точки в аффинных координатах, записанных в представлении Монтгомери
+    (формат записи определяется функцией ak_wpoint_table_store()).                                 */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_wpoint_odd_multiples( ak_uint64 *data, ak_wpoint wp, const size_t count,
+                                                                                  ak_wcurve ec )
+{
+  size_t j = 0;
+  int error = ak_error_ok;
+  struct wpoint twice, *points = NULL;
+
+  if(( points = malloc( count*sizeof( struct wpoint ))) == NULL )
+    return ak_error_message( ak_error_out_of_memory, __func__,
+                                                    "incorrect memory allocation for points" );
+  ak_wpoint_set_wpoint( points, wp, ec );
+  ak_wpoint_set_wpoint( &twice, wp, ec );
+  ak_wpoint_double( &twice, ec );
+  for( j = 1; j < count; j++ ) {
+     ak_wpoint_set_wpoint( points +j, points +j -1, ec );
+     ak_wpoint_add( points +j, &twice, ec );
+  }
+  if(( error = ak_wpoint_table_store( data, points, count, ec )) != ak_error_ok )
+    ak_error_message( error, __func__, "incorrect storing of precomputed points" );
+
+  free( points );
+ return error;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Прибавление к точке \f$ R \f$ (или к точке \f$ E \f$ кривой Эдвардса, если кривая
+    имеет форму Эдвардса) точки таблицы нечетных кратных, соответствующей
+    ненулевой цифре wNAF представления.                                                            */
+/* ----------------------------------------------------------------------------------------------- */
+ static inline void ak_wpoint_add_naf_digit( ak_wpoint wr, ak_epoint er, ak_uint64 *data,
+                                                      ak_int8 d, ak_uint64 *one, ak_wcurve ec )
+{
+  ak_uint64 pt[3*ak_mpzn512_size];
+  const size_t words = ak_wcurve_point_words( ec );
+
+ /* выбираем (|d|-1)/2 -ю точку таблицы */
+  memcpy( pt, data +(( d > 0 ? d : -d ) -1 )/2*words, words*sizeof( ak_uint64 ));
+  ak_wcurve_point_negate( pt, d < 0, ec );
+  if( ec->edwards != NULL ) ak_epoint_add_mixed( er, pt, ec );
+   else ak_wpoint_add_mixed( wr, pt, pt +ec->size, one, ec );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Вычисление точки \f$ R = [k_1]P + [k_2]Q \f$ по таблице нечетных кратных образующей
+    точки \f$ P \f$ и таблице нечетных кратных точки \f$ Q \f$, вычисленной для окна ширины
+    `width`.                                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_wpoint_pow_pair_naf( ak_wpoint wr, ak_uint64 *k1, ak_wcurve_table tb,
+                             ak_uint64 *k2, ak_uint64 *qdata, const size_t width, ak_wcurve ec )
+{
+  size_t i = 0, len1 = 0, len2 = 0;
+  struct epoint er;
+  ak_int8 naf1[ ak_wpoint_naf_length ], naf2[ ak_wpoint_naf_length ];
+
+  len1 = ak_mpzn_to_naf( naf1, k1, ec->size, ak_wpoint_naf_width );
+  len2 = ak_mpzn_to_naf( naf2, k2, ec->size, width );
+
+ /* основной цикл: одно удвоение на каждый разряд */
+  ak_wpoint_set_as_unit( wr, ec );
+  ak_epoint_set_as_unit( &er, ec );
+  for( i = ak_max( len1, len2 ); i > 0; i-- ) {
+     if( ec->edwards != NULL ) ak_epoint_double( &er, ec );
+      else ak_wpoint_double( wr, ec );
+     if(( i <= len1 ) && ( naf1[i-1] != 0 ))
+       ak_wpoint_add_naf_digit( wr, &er, tb->data, naf1[i-1], tb->one, ec );
+     if(( i <= len2 ) && ( naf2[i-1] != 0 ))
+       ak_wpoint_add_naf_digit( wr, &er, qdata, naf2[i-1], tb->one, ec );
+  }
+  if( ec->edwards != NULL ) ak_epoint_to_wpoint( wr, &er, ec );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Вычисление точки \f$ R = [k_1]P + [k_2]Q \f$ с помощью двух независимых вычислений
+    кратных точек; используется, если таблицы предвычислений не могут быть созданы.              */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_wpoint_pow_pair_ladder( ak_wpoint wr, ak_uint64 *k1, ak_wpoint wq,
+                                                                  ak_uint64 *k2, ak_wcurve ec )
+{
+  struct wpoint tp;
+
+  ak_wpoint_pow( wr, &ec->point, k1, ec->size, ec );
+  ak_wpoint_pow( &tp, wq, k2, ec->size, ec );
+  ak_wpoint_add( wr, &tp, ec );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция вычисляет точку \f$ R = [k_1]P + [k_2]Q \f$, где \f$ P \f$ образующая точка кривой,
+    а \f$ Q \f$ произвольная точка кривой (например, открытый ключ электронной подписи).
+
+    Используется метод Штрауса (Шамира) с wNAF представлениями степеней: обе кратные точки
+    вычисляются в одном цикле, использующем общую последовательность удвоений, а количество
+    сложений уменьшается за счет wNAF представлений с шириной окна 5 (примерно одно сложение на
+    шесть разрядов для каждой степени). Нечетные кратные образующей точки берутся из таблицы,
+    используемой функцией ak_wpoint_pow_base(); нечетные кратные точки \f$ Q \f$ вычисляются
+    при каждом вызове функции. Если точка \f$ Q \f$ используется многократно, то нечетные
+    кратные следует вычислить заранее с помощью функции ak_wpoint_table_create() и
+    использовать функцию ak_wpoint_pow_pair_table().
+
+    \warning Время работы функции зависит от значений \f$ k_1 \f$ и \f$ k_2 \f$, поэтому функция
+    предназначена только для работы с открытыми данными, например, при проверке
+    электронной подписи.
+
+    \b Для \b информации:
+     \li Функция не приводит результирующую точку \f$ R \f$ к аффинной форме.
+
+    @param wr Точка \f$ R \f$, в которую помещается результат.
+    @param k1 Степень кратности образующей точки, вычет размером `ec->size` слов.
+    @param wq Точка \f$ Q \f$.
+    @param k2 Степень кратности точки \f$ Q \f$, вычет размером `ec->size` слов.
+    @param ec Эллиптическая кривая, на которой происходят вычисления                               */
+/* ----------------------------------------------------------------------------------------------- */
+ void ak_wpoint_pow_pair( ak_wpoint wr, ak_uint64 *k1, ak_wpoint wq, ak_uint64 *k2, ak_wcurve ec )
+{
+  ak_uint64 qdata[ 3*ak_mpzn512_size*( 1 << ( ak_wpoint_naf_width -2 ))];
+  ak_wcurve_table tb = ak_wcurve_table_get( ec );
+
+  if(( tb == NULL ) || ( ak_wpoint_odd_multiples( qdata, wq,
+                               1 << ( ak_wpoint_naf_width -2 ), ec ) != ak_error_ok )) {
+    ak_wpoint_pow_pair_ladder( wr, k1, wq, k2, ec );
+    return;
+  }
+  ak_wpoint_pow_pair_naf( wr, k1, tb, k2, qdata, ak_wpoint_naf_width, ec );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция вычисляет нечетные кратные \f$ [1]Q, [3]Q, \ldots, [2^{w-1}-1]Q \f$ заданной точки
+    и сохраняет их в аффинных координатах. Вычисленная таблица используется функцией
+    ak_wpoint_pow_pair_table() и позволяет не вычислять кратные точки \f$ Q \f$ при каждом
+    вычислении суммы кратных точек. Увеличение ширины окна \f$ w \f$ уменьшает количество
+    сложений точек, но требует вычисления и хранения \f$ 2^{w-2} \f$ точек.
+
+    @param wt Контекст таблицы
+    @param wq Точка \f$ Q \f$
+    @param width Ширина окна \f$ w \f$, допустимы значения от 2 до 8.
+    @param ec Эллиптическая кривая, которой принадлежит точка.
+
+    @return В случае успеха функция возвращает \ref ak_error_ok. В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_wpoint_table_create( ak_wpoint_table wt, ak_wpoint wq, const size_t width, ak_wcurve ec )
+{
+  int error = ak_error_ok;
+  size_t count = 0;
+
+  if( wt == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                          "using null pointer to table context" );
+  if( wq == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                        "using null pointer to elliptic point" );
+  if( ec == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                        "using null pointer to elliptic curve" );
+  if(( width < 2 ) || ( width > 8 )) return ak_error_message( ak_error_wrong_length, __func__,
+                                                                "using unsupported window width" );
+  memset( wt, 0, sizeof( struct wpoint_table ));
+  count = (( size_t )1 ) << ( width -2 );
+  if(( wt->data = malloc( count*ak_wcurve_point_words( ec )*sizeof( ak_uint64 ))) == NULL )
+    return ak_error_message( ak_error_out_of_memory, __func__,
+                                                   "incorrect memory allocation for table data" );
+  if(( error = ak_wpoint_odd_multiples( wt->data, wq, count, ec )) != ak_error_ok ) {
+    free( wt->data );
+    wt->data = NULL;
+    return ak_error_message( error, __func__, "incorrect creation of odd multiples" );
+  }
+
+  ak_wpoint_set_wpoint( &wt->point, wq, ec );
+  ak_wpoint_reduce( &wt->point, ec );
+  wt->width = width;
+  wt->wc = ec;
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! @param wt Контекст таблицы
+    @return В случае успеха функция возвращает \ref ak_error_ok. В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_wpoint_table_destroy( ak_wpoint_table wt )
+{
+  if( wt == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                          "using null pointer to table context" );
+  if( wt->data != NULL ) free( wt->data );
+  memset( wt, 0, sizeof( struct wpoint_table ));
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция аналогична функции ak_wpoint_pow_pair(), однако нечетные кратные точки \f$ Q \f$
+    не вычисляются, а берутся из заранее созданной таблицы.
+
+    \warning Время работы функции зависит от значений \f$ k_1 \f$ и \f$ k_2 \f$, поэтому функция
+    предназначена только для работы с открытыми данными.
+
+    @param wr Точка \f$ R \f$, в которую помещается результат.
+    @param k1 Степень кратности образующей точки, вычет размером `ec->size` слов.
+    @param wt Таблица нечетных кратных точки \f$ Q \f$, созданная для кривой `ec`.
+    @param k2 Степень кратности точки \f$ Q \f$, вычет размером `ec->size` слов.
+    @param ec Эллиптическая кривая, на которой происходят вычисления
+
+    @return В случае успеха функция возвращает \ref ak_error_ok. Если таблица не создана
+    или создана для другой эллиптической кривой, то возвращается код ошибки, а значение
+    точки \f$ R \f$ не изменяется.                                                                */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_wpoint_pow_pair_table( ak_wpoint wr, ak_uint64 *k1, ak_wpoint_table wt,
+                                                                  ak_uint64 *k2, ak_wcurve ec )
+{
+  ak_wcurve_table tb = NULL;
+
+  if(( wr == NULL ) || ( k1 == NULL ) || ( k2 == NULL ))
+    return ak_error_message( ak_error_null_pointer, __func__,
+                                                "using null pointer to point or multiplier" );
+  if( ec == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                        "using null pointer to elliptic curve" );
+  if(( wt == NULL ) || ( wt->data == NULL )) return ak_error_message( ak_error_null_pointer,
+                                                 __func__, "using undefined table of multiples" );
+  if( wt->wc != ec ) return ak_error_message( ak_error_curve_not_equal, __func__,
+                                              "using table created for another elliptic curve" );
+
+  if(( tb = ak_wcurve_table_get( ec )) == NULL )
+    ak_wpoint_pow_pair_ladder( wr, k1, &wt->point, k2, ec );
+   else ak_wpoint_pow_pair_naf( wr, k1, tb, k2, wt->data, wt->width, ec );
+ return ak_error_ok;
 }
 
 /* ----------------------------------------------------------------------------------------------- */
@@ -24,6 +24,9 @@
 #ifdef AK_HAVE_FNMATCH_H
  #include <fnmatch.h>
 #endif
+#ifdef AK_HAVE_PTHREAD_H
+ #include <pthread.h>
+#endif
 
 /* ----------------------------------------------------------------------------------------------- */
 /*! \param filename Имя, для которого проводится проверка
@@ -445,6 +448,336 @@
  #endif
 }
 
+/* ----------------------------------------------------------------------------------------------- */
+                        /* Последовательное чтение файлов с опережением */
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция считывает из файла ровно size октетов (или меньше, если достигнут конец файла).
+    \details В отличие от ak_file_read() функция повторяет чтение при частичном заполнении буфера.
+    @return Количество считанных октетов, либо -1 в случае ошибки.                                 */
+/* ----------------------------------------------------------------------------------------------- */
+ static ssize_t ak_file_read_full( ak_file file, ak_uint8 *buffer, size_t size )
+{
+  size_t done = 0;
+
+  while( done < size ) {
+    ssize_t len = ak_file_read( file, buffer +done, size -done );
+    if( len < 0 ) {
+     #ifdef EINTR
+      if( errno == EINTR ) continue;
+     #endif
+      return -1;
+    }
+    if( len == 0 ) break;
+    done += ( size_t )len;
+  }
+ return ( ssize_t )done;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Последовательное чтение файла с подсказками ядру о порядке доступа к данным.            */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_file_read_ahead_plain( ak_file file, size_t chunk, size_t buffers,
+                                                  ak_function_file_chunk *function, ak_pointer ptr )
+{
+  ak_uint8 *buffer = NULL;
+  ak_int64 offset = 0;
+  int error = ak_error_ok;
+
+  if(( buffer = ak_aligned_malloc( chunk )) == NULL )
+    return ak_error_message( ak_error_out_of_memory, __func__, "incorrect memory allocation" );
+
+ #if defined( POSIX_FADV_SEQUENTIAL ) && !defined( AK_HAVE_WINDOWS_H )
+  posix_fadvise( file->fd, 0, 0, POSIX_FADV_SEQUENTIAL );
+ #else
+  (void)buffers;
+ #endif
+
+  while( offset < file->size ) {
+    ssize_t len = 0;
+   #if defined( POSIX_FADV_WILLNEED ) && !defined( AK_HAVE_WINDOWS_H )
+   /* просим ядро загрузить в кэш следующие фрагменты, пока мы обрабатываем текущий */
+    if( offset +( ak_int64 )chunk < file->size )
+      posix_fadvise( file->fd, offset +( ak_int64 )chunk,
+                                          ( off_t )( chunk*( buffers -1 )), POSIX_FADV_WILLNEED );
+   #endif
+    if(( len = ak_file_read_full( file, buffer, chunk )) <= 0 ) {
+      error = ak_error_message( ak_error_read_data, __func__, "unexpected end of file" );
+      break;
+    }
+    offset += len;
+    if(( error = function( buffer, ( size_t )len,
+                                 ( offset >= file->size ? ak_true : ak_false ), ptr )) != ak_error_ok )
+      break;
+  }
+
+  ak_aligned_free( buffer );
+ return error;
+}
+
+#ifdef AK_HAVE_SYSMMAN_H
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Обработка файла, отображенного в память, с подсказками madvise.
+    \return В случае, если отобразить файл не удалось, возвращается \ref ak_error_mmap_file.     */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_file_read_ahead_mmap( ak_file file, size_t chunk, size_t buffers,
+                                                  ak_function_file_chunk *function, ak_pointer ptr )
+{
+  ak_uint8 *data = NULL;
+  ak_int64 offset = 0;
+  int error = ak_error_ok;
+
+  if(( data = ak_file_mmap( file, NULL, ( size_t )file->size,
+                                                PROT_READ, MAP_PRIVATE, 0 )) == MAP_FAILED ) {
+    file->addr = NULL;
+    return ak_error_mmap_file;
+  }
+ #ifdef MADV_SEQUENTIAL
+  madvise( data, ( size_t )file->size, MADV_SEQUENTIAL );
+ #endif
+
+  while( offset < file->size ) {
+    size_t len = ( size_t )ak_min(( ak_int64 )chunk, file->size - offset );
+   #ifdef MADV_WILLNEED
+    if( offset +( ak_int64 )len < file->size )
+      madvise( data +offset +len, ( size_t ) ak_min(( ak_int64 )( chunk*( buffers -1 )),
+                                                file->size -offset -( ak_int64 )len ), MADV_WILLNEED );
+   #endif
+    if(( error = function( data +offset, len,
+                 ( offset +( ak_int64 )len >= file->size ? ak_true : ak_false ), ptr )) != ak_error_ok )
+      break;
+   #ifdef MADV_DONTNEED
+   /* обработанные страницы больше не нужны */
+    madvise( data +offset, len, MADV_DONTNEED );
+   #endif
+    offset += len;
+  }
+
+  ak_file_unmap( file );
+  file->addr = NULL;
+ return error;
+}
+#endif
+
+#ifdef AK_HAVE_PTHREAD_H
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Контекст чтения файла отдельным потоком в кольцо буферов. */
+ typedef struct file_ring {
+  /*! \brief Читаемый файл. */
+   ak_file file;
+  /*! \brief Массив буферов. */
+   ak_uint8 *buffers[8];
+  /*! \brief Длины данных, помещенных в буферы. */
+   size_t lengths[8];
+  /*! \brief Количество буферов в кольце. */
+   size_t count;
+  /*! \brief Размер одного буфера. */
+   size_t chunk;
+  /*! \brief Общее количество заполненных буферов. */
+   size_t produced;
+  /*! \brief Общее количество обработанных буферов. */
+   size_t consumed;
+  /*! \brief Флаг досрочного завершения чтения. */
+   bool_t stop;
+  /*! \brief Код ошибки, возникшей при чтении. */
+   int error;
+  /*! \brief Мьютекс, защищающий поля структуры. */
+   pthread_mutex_t mutex;
+  /*! \brief Условие появления заполненного буфера. */
+   pthread_cond_t ready;
+  /*! \brief Условие освобождения буфера. */
+   pthread_cond_t free;
+ } *ak_file_ring;
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция потока, последовательно заполняющего буферы кольца данными из файла. */
+/* ----------------------------------------------------------------------------------------------- */
+ static void *ak_file_ring_reader( void *arg )
+{
+  ak_file_ring ring = arg;
+  ak_int64 offset = 0;
+
+  while( offset < ring->file->size ) {
+    ssize_t len = 0;
+    size_t idx = 0;
+
+    pthread_mutex_lock( &ring->mutex );
+    while(( ring->produced - ring->consumed >= ring->count ) && !ring->stop )
+      pthread_cond_wait( &ring->free, &ring->mutex );
+    if( ring->stop ) { pthread_mutex_unlock( &ring->mutex ); break; }
+    idx = ring->produced%ring->count;
+    pthread_mutex_unlock( &ring->mutex );
+
+   /* чтение выполняется без блокировки: буфер idx не используется потребителем */
+    len = ak_file_read_full( ring->file, ring->buffers[idx], ring->chunk );
+
+    pthread_mutex_lock( &ring->mutex );
+    if( len <= 0 ) {
+      ring->error = ak_error_read_data;
+      ring->stop = ak_true;
+    } else {
+        ring->lengths[idx] = ( size_t )len;
+        ring->produced++;
+        offset += len;
+      }
+    pthread_cond_signal( &ring->ready );
+    pthread_mutex_unlock( &ring->mutex );
+    if( len <= 0 ) break;
+  }
+ return NULL;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Чтение файла отдельным потоком: чтение очередного фрагмента совмещается
+    с обработкой предыдущего.                                                                      */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_file_read_ahead_thread( ak_file file, size_t chunk, size_t buffers,
+                                                  ak_function_file_chunk *function, ak_pointer ptr )
+{
+  size_t i = 0;
+  pthread_t reader;
+  ak_int64 offset = 0;
+  int error = ak_error_ok;
+  struct file_ring ring;
+
+  memset( &ring, 0, sizeof( struct file_ring ));
+  ring.file = file;
+  ring.chunk = chunk;
+  ring.count = ak_max( 2, ak_min( buffers, 8 ));
+  for( i = 0; i < ring.count; i++ ) {
+     if(( ring.buffers[i] = ak_aligned_malloc( chunk )) == NULL ) {
+       error = ak_error_message( ak_error_out_of_memory, __func__, "incorrect memory allocation" );
+       goto labex;
+     }
+  }
+  pthread_mutex_init( &ring.mutex, NULL );
+  pthread_cond_init( &ring.ready, NULL );
+  pthread_cond_init( &ring.free, NULL );
+
+  if( pthread_create( &reader, NULL, ak_file_ring_reader, &ring ) != 0 ) {
+   /* поток создать не удалось, читаем файл без него */
+    error = ak_file_read_ahead_plain( file, chunk, buffers, function, ptr );
+    goto labex2;
+  }
+
+  while( offset < file->size ) {
+    size_t idx = 0, len = 0;
+
+    pthread_mutex_lock( &ring.mutex );
+    while(( ring.produced == ring.consumed ) && !ring.stop )
+      pthread_cond_wait( &ring.ready, &ring.mutex );
+    if( ring.produced == ring.consumed ) { /* поток завершился с ошибкой */
+      error = ring.error;
+      pthread_mutex_unlock( &ring.mutex );
+      ak_error_message( error, __func__, "unexpected end of file" );
+      break;
+    }
+    idx = ring.consumed%ring.count;
+    len = ring.lengths[idx];
+    pthread_mutex_unlock( &ring.mutex );
+
+    offset += len;
+    error = function( ring.buffers[idx], len, ( offset >= file->size ? ak_true : ak_false ), ptr );
+
+    pthread_mutex_lock( &ring.mutex );
+    ring.consumed++;
+    if( error != ak_error_ok ) ring.stop = ak_true;
+    pthread_cond_signal( &ring.free );
+    pthread_mutex_unlock( &ring.mutex );
+    if( error != ak_error_ok ) break;
+  }
+  pthread_join( reader, NULL );
+
+  labex2:
+   pthread_cond_destroy( &ring.free );
+   pthread_cond_destroy( &ring.ready );
+   pthread_mutex_destroy( &ring.mutex );
+  labex:
+   for( i = 0; i < ring.count; i++ ) if( ring.buffers[i] ) ak_aligned_free( ring.buffers[i] );
+ return error;
+}
+#endif
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция открывает файл на чтение и последовательно передает его содержимое функции `function`
+    фрагментами длины `chunk_size` октетов; длина последнего фрагмента может быть меньше.
+    Для последнего фрагмента функция `function` вызывается со значением флага `ak_true`;
+    для файла нулевой длины функция `function` вызывается один раз с пустыми данными.
+
+    Чтение данных производится с опережением: пока обрабатывается очередной фрагмент,
+    следующие фрагменты уже загружаются с диска. Способ опережающего чтения определяется
+    параметром `mode`; при значении \ref file_read_auto используется чтение отдельным потоком
+    (если библиотека собрана с поддержкой pthread), иначе - отображение файла в память.
+    Если выбранный способ недоступен, используется последовательное чтение с подсказками ядру.
+
+    @param filename Имя файла.
+    @param chunk_size Размер фрагмента в октетах; округляется вверх до размера страницы памяти.
+    Если значение равно нулю, используется фрагмент длиной один мегабайт.
+    @param buffers Количество одновременно загружаемых фрагментов (от 2 до 8).
+    @param mode Способ опережающего чтения.
+    @param function Функция обработки фрагментов. Если функция возвращает значение,
+    отличное от \ref ak_error_ok, чтение прекращается и это значение возвращается.
+    @param ptr Указатель на данные, передаваемые функции `function`.
+    @return В случае успеха возвращается \ref ak_error_ok, в противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_file_read_ahead( const char *filename, size_t chunk_size, size_t buffers,
+                          file_read_mode_t mode, ak_function_file_chunk *function, ak_pointer ptr )
+{
+  struct file file;
+  size_t page = 4096;
+  int error = ak_error_ok;
+
+  if( filename == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                                  "using null pointer to filename" );
+  if( function == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                        "using null pointer to chunk function" );
+ /* округляем размер фрагмента до целого числа страниц */
+ #if defined( _SC_PAGESIZE ) && !defined( AK_HAVE_WINDOWS_H )
+  if( sysconf( _SC_PAGESIZE ) > 0 ) page = ( size_t )sysconf( _SC_PAGESIZE );
+ #endif
+  if( chunk_size == 0 ) chunk_size = 1048576;
+  chunk_size = page*(( chunk_size +page -1 )/page );
+  buffers = ak_max( 2, ak_min( buffers, 8 ));
+
+  if(( error = ak_file_open_to_read( &file, filename )) != ak_error_ok )
+    return ak_error_message_fmt( error, __func__, "incorrect access to file %s", filename );
+  file.addr = NULL;
+  file.mmaped_size = 0;
+
+  if( file.size == 0 ) {
+    error = function( "", 0, ak_true, ptr );
+    goto labex;
+  }
+  if( mode == file_read_auto ) {
+   #ifdef AK_HAVE_PTHREAD_H
+    mode = file_read_thread;
+   #else
+    mode = file_read_mmap;
+   #endif
+  }
+
+  switch( mode ) {
+   #ifdef AK_HAVE_PTHREAD_H
+    case file_read_thread:
+      error = ak_file_read_ahead_thread( &file, chunk_size, buffers, function, ptr );
+      goto labex;
+   #endif
+   #ifdef AK_HAVE_SYSMMAN_H
+    case file_read_mmap:
+      if(( error = ak_file_read_ahead_mmap( &file, chunk_size, buffers, function, ptr ))
+                                                                          != ak_error_mmap_file )
+        goto labex;
+   /* если отобразить файл не удалось, читаем его последовательно */
+      ak_error_set_value( ak_error_ok );
+   #endif
+    default:
+      error = ak_file_read_ahead_plain( &file, chunk_size, buffers, function, ptr );
+  }
+
+  labex: ak_file_close( &file );
+ return error;
+}
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! Функция обрабатывает только префикс файла.
     В случае появления внутри строки символов вида .. их обработка не производится.
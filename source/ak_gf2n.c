@@ -5,11 +5,18 @@
 /*  Файл ak_gf2n.c                                                                                 */
 /*  - содержит реализацию функций умножения элементов конечных полей характеристики 2.             */
 /* ----------------------------------------------------------------------------------------------- */
- #include <libakrypt.h>
+ #include <libakrypt-internal.h>
 
 /* ----------------------------------------------------------------------------------------------- */
 #ifdef AK_HAVE_BUILTIN_CLMULEPI64
  #include <wmmintrin.h>
+ /* код, использующий команду pclmulqdq, компилируется без флагов -mpclmul и -march,
+    а вызывается только после проверки возможностей процессора */
+ #if defined( __GNUC__ ) && !defined( __PCLMUL__ )
+  #define ak_target_pclmul __attribute__(( target( "pclmul,sse2" )))
+ #else
+  #define ak_target_pclmul
+ #endif
 #endif
 #ifdef _MSC_VER
  #include <stdlib.h>
@@ -288,7 +295,7 @@
     \f$ f(x) = x^{64} + x^4 + x^3 + x + 1 \in \mathbb F_2[x]\f$. Для умножения используется
     реализация с помощью команды PCLMULQDQ.                                                        */
 /* ----------------------------------------------------------------------------------------------- */
- void ak_gf64_mul_pcmulqdq( ak_pointer z, ak_pointer x, ak_pointer y )
+ ak_target_pclmul void ak_gf64_mul_pcmulqdq( ak_pointer z, ak_pointer x, ak_pointer y )
 {
 #ifdef _MSC_VER
 	 __m128i gm, xm, ym, cm, cx;
@@ -328,7 +335,7 @@
     \f$ f(x) = x^{128} + x^7 + x^2 + x + 1 \in \mathbb F_2[x]\f$. Для умножения используется
     реализация с помощью команды PCLMULQDQ.                                                        */
 /* ----------------------------------------------------------------------------------------------- */
- void ak_gf128_mul_pcmulqdq( ak_pointer z, ak_pointer a, ak_pointer b )
+ ak_target_pclmul void ak_gf128_mul_pcmulqdq( ak_pointer z, ak_pointer a, ak_pointer b )
 {
 #ifdef _MSC_VER
 	 __m128i am, bm, cm, dm, em, fm;
@@ -380,7 +387,7 @@
     \f$ f(x) = x^{256} + x^10 + x^5 + x^2 + 1 \in \mathbb F_2[x]\f$. Для умножения используется
     реализация с помощью команды PCLMULQDQ.                                                        */
 /* ----------------------------------------------------------------------------------------------- */
- void ak_gf256_mul_pcmulqdq( ak_pointer z, ak_pointer a, ak_pointer b )
+ ak_target_pclmul void ak_gf256_mul_pcmulqdq( ak_pointer z, ak_pointer a, ak_pointer b )
 {
 #ifdef _MSC_VER
      __m128i a1a0, a3a2, b1b0, b3b2;
@@ -497,7 +504,7 @@
     реализация с помощью команды PCLMULQDQ.
     \todo может быть имеет смысл разбить на 2 ifdef, а середину сделать общей?                     */
 /* ----------------------------------------------------------------------------------------------- */
-void ak_gf512_mul_pcmulqdq( ak_pointer z, ak_pointer a, ak_pointer b )
+ ak_target_pclmul void ak_gf512_mul_pcmulqdq( ak_pointer z, ak_pointer a, ak_pointer b )
 {
 #ifdef _MSC_VER
      __m128i a1a0, a3a2, a5a4, a7a6, b1b0, b3b2, b5b4, b7b6;
@@ -787,6 +794,240 @@ void ak_gf512_mul_pcmulqdq( ak_pointer z, ak_pointer a, ak_pointer b )
 
 #endif
 
+/* ----------------------------------------------------------------------------------------------- */
+/*                 реализации умножения, выбираемые во время инициализации библиотеки             */
+/* ----------------------------------------------------------------------------------------------- */
+ ak_function_gf_mul *ak_gf64_mul = ak_gf64_mul_uint64;
+ ak_function_gf_mul *ak_gf128_mul = ak_gf128_mul_uint64;
+ ak_function_gf_mul *ak_gf256_mul = ak_gf256_mul_uint64;
+ ak_function_gf_mul *ak_gf512_mul = ak_gf512_mul_uint64;
+
+#ifdef AK_HAVE_BUILTIN_CLMULEPI64
+/*! \brief Признак использования вычисления значений многочленов с отложенным приведением. */
+ static bool_t ak_gf2n_polynomial_aggregated = ak_false;
+#endif
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция не проверяет, поддерживается ли команда pclmulqdq процессором; проверка
+    выполняется функцией ak_libakrypt_set_kernel().
+
+    @param pclmul Истинное значение устанавливает реализации, использующие команду pclmulqdq,
+    ложное - универсальные реализации.
+    @return Функция возвращает \ref ak_true, если установлена запрошенная реализация.              */
+/* ----------------------------------------------------------------------------------------------- */
+ bool_t ak_gf2n_set_kernel( bool_t pclmul )
+{
+#ifdef AK_HAVE_BUILTIN_CLMULEPI64
+  if( pclmul ) {
+    ak_gf64_mul = ak_gf64_mul_pcmulqdq;
+    ak_gf128_mul = ak_gf128_mul_pcmulqdq;
+    ak_gf256_mul = ak_gf256_mul_pcmulqdq;
+    ak_gf512_mul = ak_gf512_mul_pcmulqdq;
+    ak_gf2n_polynomial_aggregated = ak_true;
+    return ak_true;
+  }
+  ak_gf2n_polynomial_aggregated = ak_false;
+#endif
+  ak_gf64_mul = ak_gf64_mul_uint64;
+  ak_gf128_mul = ak_gf128_mul_uint64;
+  ak_gf256_mul = ak_gf256_mul_uint64;
+  ak_gf512_mul = ak_gf512_mul_uint64;
+ return !pclmul;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*                     вычисление значений многочленов над полями GF(2^256) и GF(2^512)           */
+/* ----------------------------------------------------------------------------------------------- */
+#ifdef AK_HAVE_BUILTIN_CLMULEPI64
+/*! Функция приводит по модулю многочлена \f$ f(x) = x^{256} + x^{10} + x^5 + x^2 + 1 \f$
+    произведение двух элементов поля, представленное восемью 64-х битными словами.                 */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_gf256_reduce( ak_uint64 *z, ak_uint64 *r )
+{
+  int i = 0;
+
+  for( i = 7; i > 3; i-- ) {
+     r[i-3] ^= ( r[i] >> 54 ) ^ ( r[i] >> 59 ) ^ ( r[i] >> 62 );
+     r[i-4] ^= ( r[i] << 10 ) ^ ( r[i] << 5 ) ^ ( r[i] << 2 ) ^ r[i];
+  }
+  z[0] = r[0]; z[1] = r[1]; z[2] = r[2]; z[3] = r[3];
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция приводит по модулю многочлена \f$ f(x) = x^{512} + x^8 + x^5 + x^2 + 1 \f$
+    произведение двух элементов поля, представленное шестнадцатью 64-х битными словами.            */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_gf512_reduce( ak_uint64 *z, ak_uint64 *r )
+{
+  int i = 0;
+
+  for( i = 15; i > 7; i-- ) {
+     r[i-7] ^= ( r[i] >> 56 ) ^ ( r[i] >> 59 ) ^ ( r[i] >> 62 );
+     r[i-8] ^= ( r[i] << 8 ) ^ ( r[i] << 5 ) ^ ( r[i] << 2 ) ^ r[i];
+  }
+  for( i = 0; i < 8; i++ ) z[i] = r[i];
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция вычисляет сумму `n` произведений \f$ a_k\cdot b_k \f$ элементов поля, состоящих
+    из `w` 64-х битных слов, без приведения по модулю; результат (2w слов) прибавляется
+    к значению `r`. Произведения не зависят друг от друга, что позволяет процессору выполнять
+    команды pclmulqdq одновременно.
+
+    Произведения с четными и нечетными смещениями накапливаются в разных 128-ми битных
+    регистрах и объединяются только один раз, перед записью результата.                           */
+/* ----------------------------------------------------------------------------------------------- */
+ static ak_target_pclmul void ak_gf2n_clmul_sum_pcmulqdq( ak_uint64 *r,
+                               ak_uint64 **a, ak_uint64 **b, const size_t n, const size_t w )
+{
+  size_t i = 0, j = 0, k = 0;
+  ak_uint64 even[16], odd[16];
+  __m128i se[8], so[8];
+
+  for( i = 0; i < 8; i++ ) se[i] = so[i] = _mm_setzero_si128();
+  for( k = 0; k < n; k++ ) {
+     for( j = 0; j < w; j += 2 ) {
+        __m128i bj = _mm_loadu_si128(( const __m128i *)( b[k] +j ));
+        for( i = 0; i < w; i += 2 ) {
+           size_t t = ( i+j ) >> 1;
+           __m128i ai = _mm_loadu_si128(( const __m128i *)( a[k] +i ));
+          /* слагаемые со смещениями i+j и i+j+2 слов */
+           se[t] = _mm_xor_si128( se[t], _mm_clmulepi64_si128( ai, bj, 0x00 ));
+           se[t+1] = _mm_xor_si128( se[t+1], _mm_clmulepi64_si128( ai, bj, 0x11 ));
+          /* слагаемые со смещением i+j+1 слов */
+           so[t] = _mm_xor_si128( so[t], _mm_xor_si128(
+                   _mm_clmulepi64_si128( ai, bj, 0x01 ), _mm_clmulepi64_si128( ai, bj, 0x10 )));
+        }
+     }
+  }
+
+  for( i = 0; i < 8; i++ ) {
+     _mm_storeu_si128(( __m128i *)( even +2*i ), se[i] );
+     _mm_storeu_si128(( __m128i *)( odd +2*i ), so[i] );
+  }
+  r[0] ^= even[0];
+  for( i = 1; i < 2*w; i++ ) r[i] ^= even[i]^odd[i-1];
+  memset( even, 0, sizeof( even ));
+  memset( odd, 0, sizeof( odd ));
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция реализует агрегированную схему Горнера: коэффициенты многочлена обрабатываются
+    блоками по \ref ak_gf2n_horner_block элементов, и для каждого блока вычисляется значение
+
+    \f[ s \cdot x^{K} + a_{t} + a_{t+1}x + \ldots + a_{t+K-1}x^{K-1}, \f]
+
+    в котором все произведения суммируются без приведения, а приведение по модулю
+    выполняется один раз на блок.                                                                  */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_gf2n_polynomial_pcmulqdq( ak_uint64 *z, ak_uint8 *coef,
+                                                       const size_t count, ak_gf2n_powers powers )
+{
+  ak_uint64 r[16], *a[ak_gf2n_horner_block], *b[ak_gf2n_horner_block];
+  size_t i = 0, n = 0, w = powers->count >> 3, start = count;
+
+  memset( z, 0, powers->count );
+  while( start > 0 ) {
+     size_t length = start%ak_gf2n_horner_block;
+     if( !length ) length = ak_gf2n_horner_block;
+     start -= length;
+
+     memset( r, 0, sizeof( r ));
+    /* свободный член блока прибавляется без умножения */
+     for( i = 0; i < w; i++ ) r[i] = (( ak_uint64 *)( coef +start*powers->count ))[i];
+     for( i = 1, n = 0; i < length; i++, n++ ) {
+        a[n] = ( ak_uint64 *)( coef +( start +i )*powers->count );
+        b[n] = powers->x[i-1];
+     }
+    /* накопленное значение умножается на x^K (первый обрабатываемый блок может быть неполным,
+       но для него накопленное значение равно нулю) */
+     if( start +length < count ) { a[n] = z; b[n] = powers->x[ak_gf2n_horner_block -1]; n++; }
+     ak_gf2n_clmul_sum_pcmulqdq( r, a, b, n, w );
+
+     if( w == 4 ) ak_gf256_reduce( z, r );
+      else ak_gf512_reduce( z, r );
+  }
+  memset( r, 0, sizeof( r ));
+}
+#endif
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция вычисляет степени \f$ x, x^2, \ldots, x^K \f$ элемента конечного поля,
+    где \f$ K \f$ = \ref ak_gf2n_horner_block, и сохраняет их для последующего вычисления значений
+    многочленов в точке \f$ x \f$ с помощью функции ak_gf2n_polynomial().
+
+    @param powers Контекст, в который помещаются вычисленные степени
+    @param x Элемент конечного поля
+    @param count Размер элемента поля в октетах; допустимыми значениями являются
+    \ref ak_galois256_size и \ref ak_galois512_size.
+    @return Функция возвращает \ref ak_error_ok (ноль) в случае успеха,
+    в противном случае возвращается код ошибки.                                                    */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_gf2n_powers_create( ak_gf2n_powers powers, ak_pointer x, const size_t count )
+{
+  size_t i = 0;
+
+  if( powers == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                          "using null pointer to powers context" );
+  if(( count != ak_galois256_size ) && ( count != ak_galois512_size ))
+    return ak_error_message_fmt( ak_error_undefined_value, __func__,
+                                                     "unsupported galois field size: %u", count );
+  memset( powers, 0, sizeof( struct gf2n_powers ));
+  powers->count = count;
+  memcpy( powers->x[0], x, count );
+  for( i = 1; i < ak_gf2n_horner_block; i++ ) {
+     if( count == ak_galois256_size ) ak_gf256_mul( powers->x[i], powers->x[i-1], x );
+       else ak_gf512_mul( powers->x[i], powers->x[i-1], x );
+  }
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! @param powers Контекст степеней элемента конечного поля
+    @return Функция возвращает \ref ak_error_ok (ноль).                                            */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_gf2n_powers_destroy( ak_gf2n_powers powers )
+{
+  if( powers == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                          "using null pointer to powers context" );
+  memset( powers, 0, sizeof( struct gf2n_powers ));
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция вычисляет значение \f$ z = a_0 + a_1x + \ldots + a_{count-1}x^{count-1} \f$
+    многочлена над полем \f$ GF(2^{256}) \f$ или \f$ GF(2^{512}) \f$, коэффициенты которого
+    последовательно расположены в памяти, начиная с младшего.
+
+    Если для умножения используется команда pclmulqdq, то применяется агрегированная схема Горнера
+    с однократным приведением по модулю на каждые \ref ak_gf2n_horner_block коэффициентов;
+    в противном случае используется обычная схема Горнера.
+
+    @param z Область памяти, в которую помещается результат (powers->count октетов)
+    @param coef Указатель на коэффициенты многочлена
+    @param count Количество коэффициентов
+    @param powers Степени элемента \f$ x \f$, вычисленные функцией ak_gf2n_powers_create().       */
+/* ----------------------------------------------------------------------------------------------- */
+ void ak_gf2n_polynomial( ak_pointer z, ak_pointer coef, const size_t count,
+                                                                          ak_gf2n_powers powers )
+{
+  size_t i = 0, j = 0, w = powers->count >> 3;
+
+#ifdef AK_HAVE_BUILTIN_CLMULEPI64
+  if( ak_gf2n_polynomial_aggregated ) {
+    ak_gf2n_polynomial_pcmulqdq( z, coef, count, powers );
+    return;
+  }
+#endif
+  memset( z, 0, powers->count );
+  for( i = count; i > 0; i-- ) {
+     ak_uint64 *element = ( ak_uint64 *)(( ak_uint8 *)coef +( i-1 )*powers->count );
+     if( w == 4 ) ak_gf256_mul( z, z, powers->x[0] );
+       else ak_gf512_mul( z, z, powers->x[0] );
+     for( j = 0; j < w; j++ ) (( ak_uint64 *)z)[j] ^= element[j];
+  }
+}
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! \brief Тестирование операции умножения в поле \f$ \mathbb F_{2^{64}}\f$. */
  static bool_t ak_gf64_multiplication_test( void )
@@ -841,6 +1082,8 @@ void ak_gf512_mul_pcmulqdq( ak_pointer z, ak_pointer a, ak_pointer b )
   }
 
 #ifdef AK_HAVE_BUILTIN_CLMULEPI64
+ /* вторая реализация сравнивается с первой, только если процессор поддерживает pclmulqdq */
+ if( !ak_libakrypt_cpu_has( ak_cpu_feature_pclmul )) return ak_true;
  if( ak_log_get_level() >= ak_log_maximum )
    ak_error_message( ak_error_ok, __func__, "comparison between two implementations included");
 
@@ -930,6 +1173,8 @@ void ak_gf512_mul_pcmulqdq( ak_pointer z, ak_pointer a, ak_pointer b )
  if( !ak_ptr_is_equal_with_log( result, m8, 16 )) goto lexit;
 
 #ifdef AK_HAVE_BUILTIN_CLMULEPI64
+ /* вторая реализация сравнивается с первой, только если процессор поддерживает pclmulqdq */
+ if( !ak_libakrypt_cpu_has( ak_cpu_feature_pclmul )) return ak_true;
  if( ak_log_get_level() >= ak_log_maximum )
    ak_error_message( ak_error_ok, __func__, "comparison between two implementations included");
 
@@ -1004,6 +1249,8 @@ void ak_gf512_mul_pcmulqdq( ak_pointer z, ak_pointer a, ak_pointer b )
   }
 
 #ifdef AK_HAVE_BUILTIN_CLMULEPI64
+ /* вторая реализация сравнивается с первой, только если процессор поддерживает pclmulqdq */
+ if( !ak_libakrypt_cpu_has( ak_cpu_feature_pclmul )) return ak_true;
  if( ak_log_get_level() >= ak_log_maximum )
    ak_error_message( ak_error_ok, __func__, "comparison between two implementations included");
 
@@ -1088,6 +1335,8 @@ void ak_gf512_mul_pcmulqdq( ak_pointer z, ak_pointer a, ak_pointer b )
   }
 
 #ifdef AK_HAVE_BUILTIN_CLMULEPI64
+ /* вторая реализация сравнивается с первой, только если процессор поддерживает pclmulqdq */
+ if( !ak_libakrypt_cpu_has( ak_cpu_feature_pclmul )) return ak_true;
  if( ak_log_get_level() >= ak_log_maximum )
    ak_error_message( ak_error_ok, __func__, "comparison between two implementations included");
 
@@ -1145,7 +1394,7 @@ void ak_gf512_mul_pcmulqdq( ak_pointer z, ak_pointer a, ak_pointer b )
    ak_error_message( ak_error_ok, __func__ , "testing the Galois fileds arithmetic started");
 
 #ifdef AK_HAVE_BUILTIN_CLMULEPI64
- if( audit >= ak_log_maximum )
+ if(( audit >= ak_log_maximum ) && ( ak_gf128_mul == ak_gf128_mul_pcmulqdq ))
    ak_error_message( ak_error_ok, __func__ ,
                                       "using pcmulqdq for multiplication in finite Galois fields");
 #endif
@@ -0,0 +1,541 @@
+/* ----------------------------------------------------------------------------------------------- */
+/*  Copyright (c) 2023 by Axel Kenzo, axelkenzo@mail.ru                                            */
+/*                                                                                                 */
+/*  Файл ak_icode.с                                                                                */
+/*  - содержит реализацию функций контроля целостности каталогов                                   */
+/* ----------------------------------------------------------------------------------------------- */
+ #include <libakrypt-internal.h>
+
+/* ----------------------------------------------------------------------------------------------- */
+#ifdef AK_HAVE_STDLIB_H
+ #include <stdlib.h>
+#else
+ #error Library cannot be compiled without stdlib.h header
+#endif
+#ifdef AK_HAVE_SYSSTAT_H
+ #include <sys/stat.h>
+#endif
+#ifdef AK_HAVE_PTHREAD_H
+ #include <pthread.h>
+#endif
+
+/* ----------------------------------------------------------------------------------------------- */
+/** \addtogroup icode-doc Контроль целостности каталогов
+ @{
+   Индекс контроля целостности содержит для каждого файла каталога его размер, время последней
+   модификации, номер индексного дескриптора и хеш-код содержимого.
+   Функция ak_icode_index_scan() обходит каталог, вычисляет хеш-коды только для тех файлов,
+   метаданные которых изменились с момента предыдущей проверки, и распределяет вычисления
+   между несколькими потоками. Индекс сохраняется в файл компактного двоичного формата
+   функцией ak_icode_index_save() и считывается функцией ak_icode_index_create_from_file().
+
+   Формат файла индекса (все целые числа записываются в порядке little-endian):
+    - сигнатура `akicode1` (8 октетов),
+    - длина идентификатора функции хеширования (1 октет) и сам идентификатор,
+    - длина хеш-кода (1 октет), количество записей (8 октетов),
+    - для каждой записи: длина имени (4 октета), имя файла, размер, время модификации и
+      номер индексного дескриптора (по 8 октетов), хеш-код.                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ static const char ak_icode_index_magic[8] = { 'a', 'k', 'i', 'c', 'o', 'd', 'e', '1' };
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Элемент списка найденных при обходе каталога файлов. */
+ typedef struct icode_entry {
+  /*! \brief Метаданные и хеш-код файла. */
+   struct icode_record rec;
+  /*! \brief Запись индекса, соответствующая файлу до начала проверки. */
+   ak_icode_record old;
+  /*! \brief Флаг необходимости вычисления хеш-кода. */
+   bool_t need;
+  /*! \brief Код ошибки, возникшей при вычислении хеш-кода. */
+   int error;
+ } *ak_icode_entry;
+
+/*! \brief Список файлов, найденных при обходе каталога. */
+ typedef struct icode_list {
+  /*! \brief Массив элементов. */
+   struct icode_entry *entries;
+  /*! \brief Количество элементов. */
+   size_t count;
+  /*! \brief Количество элементов, под которое выделена память. */
+   size_t size;
+ } *ak_icode_list;
+
+/*! \brief Общие данные потоков, вычисляющих хеш-коды. */
+ typedef struct icode_pool {
+  /*! \brief Список файлов. */
+   ak_icode_list list;
+  /*! \brief Идентификатор функции хеширования. */
+   ak_oid oid;
+  /*! \brief Длина хеш-кода. */
+   size_t tag_size;
+  /*! \brief Индекс следующего обрабатываемого элемента списка. */
+   size_t next;
+ #ifdef AK_HAVE_PTHREAD_H
+  /*! \brief Мьютекс, защищающий индекс следующего элемента. */
+   pthread_mutex_t mutex;
+ #endif
+ } *ak_icode_pool;
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Сравнение записей по имени файла (используется в qsort и bsearch). */
+ static int ak_icode_record_compare( const void *a, const void *b )
+{
+  return strcmp((( const struct icode_record *)a)->name, (( const struct icode_record *)b)->name );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция, получающая метаданные файла. */
+ static int ak_icode_record_set_stat( ak_icode_record rec, const char *filename )
+{
+  struct stat st;
+
+  if( stat( filename, &st ) != 0 ) return ak_error_access_file;
+  rec->size = ( ak_uint64 ) st.st_size;
+  rec->inode = ( ak_uint64 ) st.st_ino;
+ #ifdef __linux__
+  rec->mtime = ( ak_int64 ) st.st_mtim.tv_sec*1000000000 + ( ak_int64 ) st.st_mtim.tv_nsec;
+ #else
+  rec->mtime = ( ak_int64 ) st.st_mtime;
+ #endif
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция, добавляющая найденный файл в список. */
+ static int ak_icode_list_add( const tchar *filename, ak_pointer ptr )
+{
+  size_t len = 0;
+  ak_icode_list list = ptr;
+  ak_icode_entry entry = NULL;
+
+  if( list->count == list->size ) {
+    size_t size = ak_max( 64, list->size << 1 );
+    ak_icode_entry entries = realloc( list->entries, size*sizeof( struct icode_entry ));
+    if( entries == NULL ) return ak_error_message( ak_error_out_of_memory, __func__,
+                                                                 "incorrect memory allocation" );
+    list->entries = entries;
+    list->size = size;
+  }
+  entry = list->entries + list->count;
+  memset( entry, 0, sizeof( struct icode_entry ));
+ /* если метаданные получить не удалось, ошибка будет обнаружена при вычислении хеш-кода */
+  ak_icode_record_set_stat( &entry->rec, filename );
+  len = strlen( filename );
+  if(( entry->rec.name = malloc( len +1 )) == NULL )
+    return ak_error_message( ak_error_out_of_memory, __func__, "incorrect memory allocation" );
+  memcpy( entry->rec.name, filename, len +1 );
+  list->count++;
+
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция потока, последовательно вычисляющего хеш-коды файлов списка. */
+ static void *ak_icode_pool_worker( void *ptr )
+{
+  struct hash ctx;
+  ak_icode_pool pool = ptr;
+
+  if( ak_hash_create_oid( &ctx, pool->oid ) != ak_error_ok ) return NULL;
+  for( ;; ) {
+     size_t idx = 0;
+     ak_icode_entry entry = NULL;
+
+    #ifdef AK_HAVE_PTHREAD_H
+     pthread_mutex_lock( &pool->mutex );
+    #endif
+     idx = pool->next;
+     while(( idx < pool->list->count ) && !pool->list->entries[idx].need ) idx++;
+     pool->next = idx +1;
+    #ifdef AK_HAVE_PTHREAD_H
+     pthread_mutex_unlock( &pool->mutex );
+    #endif
+     if( idx >= pool->list->count ) break;
+
+     entry = pool->list->entries +idx;
+     entry->error = ak_hash_file( &ctx, entry->rec.name, entry->rec.tag, pool->tag_size );
+  }
+  ak_hash_destroy( &ctx );
+
+ return NULL;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Вычисление хеш-кодов для всех отмеченных файлов списка с помощью пула потоков. */
+ static void ak_icode_pool_run( ak_icode_pool pool, size_t threads )
+{
+ #ifdef AK_HAVE_PTHREAD_H
+  pthread_mutex_init( &pool->mutex, NULL );
+ #endif
+  ak_thread_pool_run( ak_icode_pool_worker, pool, threads );
+ #ifdef AK_HAVE_PTHREAD_H
+  pthread_mutex_destroy( &pool->mutex );
+ #endif
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Освобождение памяти, занимаемой массивом записей. */
+ static void ak_icode_records_free( struct icode_record *records, size_t count )
+{
+  size_t i = 0;
+  if( records == NULL ) return;
+  for( i = 0; i < count; i++ ) if( records[i].name ) free( records[i].name );
+  free( records );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! @param idx Контекст индекса контроля целостности.
+    @param oid Идентификатор бесключевой функции хеширования.
+    @return В случае успеха возвращается \ref ak_error_ok, в противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_icode_index_create( ak_icode_index idx, ak_oid oid )
+{
+  struct hash ctx;
+  int error = ak_error_ok;
+
+  if( idx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                              "using null pointer to icode index" );
+  if( oid == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                            "using null pointer to hash oid" );
+  if(( oid->engine != hash_function ) || ( oid->mode != algorithm ))
+    return ak_error_message( ak_error_oid_engine, __func__ , "using oid with wrong engine" );
+
+  if(( error = ak_hash_create_oid( &ctx, oid )) != ak_error_ok )
+    return ak_error_message( error, __func__ , "incorrect creation of hash function context" );
+  memset( idx, 0, sizeof( struct icode_index ));
+  idx->oid = oid;
+  idx->tag_size = ak_hash_get_tag_size( &ctx );
+  ak_hash_destroy( &ctx );
+
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_icode_index_destroy( ak_icode_index idx )
+{
+  if( idx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                              "using null pointer to icode index" );
+  ak_icode_records_free( idx->records, idx->count );
+  memset( idx, 0, sizeof( struct icode_index ));
+
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! @param idx Контекст индекса контроля целостности.
+    @param filename Полное имя файла.
+    @return Указатель на запись или NULL, если запись для файла в индексе отсутствует.             */
+/* ----------------------------------------------------------------------------------------------- */
+ ak_icode_record ak_icode_index_find( ak_icode_index idx, const char *filename )
+{
+  struct icode_record key;
+
+  if(( idx == NULL ) || ( filename == NULL ) || ( idx->count == 0 )) return NULL;
+  key.name = ( char * )filename;
+ return bsearch( &key, idx->records, idx->count,
+                                          sizeof( struct icode_record ), ak_icode_record_compare );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_icode_put_uint( ak_uint8 *out, ak_uint64 value, size_t len )
+{
+  size_t i = 0;
+  for( i = 0; i < len; i++ ) { out[i] = ( ak_uint8 )( value&0xff ); value >>= 8; }
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+ static ak_uint64 ak_icode_get_uint( const ak_uint8 *in, size_t len )
+{
+  ak_uint64 value = 0;
+  while( len-- > 0 ) value = ( value << 8 )^in[len];
+ return value;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! @param idx Контекст индекса контроля целостности.
+    @param filename Имя файла, в который сохраняется индекс.
+    @return В случае успеха возвращается \ref ak_error_ok, в противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_icode_index_save( ak_icode_index idx, const char *filename )
+{
+  size_t i = 0;
+  struct file fp;
+  ak_uint8 buffer[128];
+  int error = ak_error_ok;
+  const char *id = NULL;
+
+  if( idx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                              "using null pointer to icode index" );
+  if( filename == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                                 "using null pointer to filename" );
+  if(( error = ak_file_create_to_write( &fp, filename )) != ak_error_ok )
+    return ak_error_message_fmt( error, __func__, "incorrect creation of file %s", filename );
+
+  id = idx->oid->id[0];
+  memcpy( buffer, ak_icode_index_magic, 8 );
+  buffer[8] = ( ak_uint8 ) strlen( id );
+  if( ak_file_write( &fp, buffer, 9 ) != 9 ) goto labwrite;
+  if( ak_file_write( &fp, id, buffer[8] ) != buffer[8] ) goto labwrite;
+  buffer[0] = ( ak_uint8 ) idx->tag_size;
+  ak_icode_put_uint( buffer +1, idx->count, 8 );
+  if( ak_file_write( &fp, buffer, 9 ) != 9 ) goto labwrite;
+
+  for( i = 0; i < idx->count; i++ ) {
+     ak_icode_record rec = idx->records +i;
+     ak_uint32 len = ( ak_uint32 ) strlen( rec->name );
+
+     ak_icode_put_uint( buffer, len, 4 );
+     if( ak_file_write( &fp, buffer, 4 ) != 4 ) goto labwrite;
+     if( ak_file_write( &fp, rec->name, len ) != ( ssize_t )len ) goto labwrite;
+     ak_icode_put_uint( buffer, rec->size, 8 );
+     ak_icode_put_uint( buffer +8, ( ak_uint64 )rec->mtime, 8 );
+     ak_icode_put_uint( buffer +16, rec->inode, 8 );
+     memcpy( buffer +24, rec->tag, idx->tag_size );
+     if( ak_file_write( &fp, buffer, 24 +idx->tag_size ) != ( ssize_t )( 24 +idx->tag_size ))
+       goto labwrite;
+  }
+  ak_file_close( &fp );
+ return ak_error_ok;
+
+  labwrite:
+   ak_file_close( &fp );
+ return ak_error_message_fmt( ak_error_write_data, __func__,
+                                                "incorrect writing of icode index to %s", filename );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! @param idx Контекст индекса контроля целостности.
+    @param filename Имя файла, из которого считывается индекс.
+    @return В случае успеха возвращается \ref ak_error_ok, в противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_icode_index_create_from_file( ak_icode_index idx, const char *filename )
+{
+  struct file fp;
+  char id[256];
+  ak_oid oid = NULL;
+  ak_uint64 count = 0;
+  ak_uint8 *data = NULL, *ptr = NULL, *end = NULL;
+  size_t i = 0, done = 0, size = 0;
+  int error = ak_error_ok;
+
+  if( idx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                              "using null pointer to icode index" );
+  if( filename == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                                 "using null pointer to filename" );
+  memset( idx, 0, sizeof( struct icode_index ));
+  if(( error = ak_file_open_to_read( &fp, filename )) != ak_error_ok )
+    return ak_error_message_fmt( error, __func__, "incorrect access to file %s", filename );
+  if(( fp.size < 19 ) || (( data = malloc( size = ( size_t ) fp.size )) == NULL )) {
+    ak_file_close( &fp );
+    return ak_error_message_fmt( ak_error_read_data, __func__,
+                                                     "incorrect size of icode index %s", filename );
+  }
+  while( done < size ) {
+    ssize_t len = ak_file_read( &fp, data +done, size -done );
+    if( len <= 0 ) break;
+    done += ( size_t )len;
+  }
+  ak_file_close( &fp );
+  if( done != size ) {
+    error = ak_error_message_fmt( ak_error_read_data, __func__,
+                                                       "incorrect reading of file %s", filename );
+    goto labex;
+  }
+
+ /* проверяем заголовок */
+  ptr = data; end = data +done;
+  if( memcmp( ptr, ak_icode_index_magic, 8 ) != 0 ) goto labformat;
+  ptr += 8;
+  if( ptr +1 +ptr[0] +9 > end ) goto labformat;
+  memcpy( id, ptr +1, ptr[0] ); id[ptr[0]] = 0;
+  ptr += 1 +ptr[0];
+  if(( oid = ak_oid_find_by_id( id )) == NULL ) goto labformat;
+  if(( error = ak_icode_index_create( idx, oid )) != ak_error_ok ) goto labex;
+  if( ptr[0] != idx->tag_size ) goto labformat;
+  count = ak_icode_get_uint( ptr +1, 8 );
+  ptr += 9;
+  if( count > ( ak_uint64 )( end -ptr )/( 28 +idx->tag_size )) goto labformat;
+
+  if( count && (( idx->records = calloc(( size_t )count, sizeof( struct icode_record ))) == NULL )) {
+    error = ak_error_message( ak_error_out_of_memory, __func__, "incorrect memory allocation" );
+    goto labex;
+  }
+  for( i = 0; i < ( size_t )count; i++ ) {
+     ak_icode_record rec = idx->records +i;
+     size_t len = 0;
+
+     if( ptr +4 > end ) goto labformat;
+     len = ( size_t ) ak_icode_get_uint( ptr, 4 );
+     ptr += 4;
+     if(( size_t )( end -ptr ) < len +24 +idx->tag_size ) goto labformat;
+     if(( rec->name = malloc( len +1 )) == NULL ) {
+       error = ak_error_message( ak_error_out_of_memory, __func__, "incorrect memory allocation" );
+       goto labex;
+     }
+     memcpy( rec->name, ptr, len ); rec->name[len] = 0;
+     ptr += len;
+     rec->size = ak_icode_get_uint( ptr, 8 );
+     rec->mtime = ( ak_int64 ) ak_icode_get_uint( ptr +8, 8 );
+     rec->inode = ak_icode_get_uint( ptr +16, 8 );
+     memcpy( rec->tag, ptr +24, idx->tag_size );
+     ptr += 24 +idx->tag_size;
+     idx->count++;
+     if(( i > 0 ) && ( ak_icode_record_compare( rec -1, rec ) >= 0 )) goto labformat;
+  }
+  free( data );
+ return ak_error_ok;
+
+  labformat:
+   error = ak_error_message_fmt( ak_error_invalid_value, __func__,
+                                                   "file %s has wrong icode index format", filename );
+  labex:
+   if( data ) free( data );
+   if( idx->oid != NULL ) ak_icode_index_destroy( idx );
+ return error;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция обходит каталог `root` и для каждого файла, имя которого удовлетворяет маске `mask`,
+    сравнивает его метаданные (размер, время последней модификации и номер индексного
+    дескриптора) с записью индекса. Если метаданные совпадают, хеш-код повторно не вычисляется;
+    иначе хеш-код вычисляется заново и сравнивается с хранящимся в индексе.
+    Вычисление хеш-кодов выполняется пулом из `threads` потоков (при сборке библиотеки
+    с поддержкой pthread).
+
+    После завершения работы индекс содержит записи только для найденных файлов, с новыми
+    метаданными и хеш-кодами. Если сохранять индекс не требуется (например, при проверке
+    целостности эталонного индекса), изменения индекса можно проигнорировать.
+
+    @param idx Контекст индекса контроля целостности.
+    @param root Имя каталога.
+    @param mask Маска имен файлов, например, "*".
+    @param tree Флаг рекурсивного обхода вложенных каталогов.
+    @param threads Количество потоков; если значение равно нулю, то используется количество
+    доступных процессоров.
+    @param force Флаг принудительного вычисления хеш-кодов для всех файлов.
+    @param result Указатель на структуру, в которую помещается статистика (может быть NULL).
+    @param report Функция, вызываемая для каждого нового, измененного, удаленного или
+    недоступного файла (может быть NULL).
+    @param ptr Указатель на данные, передаваемые функции `report`.
+    @return В случае успеха возвращается \ref ak_error_ok. Если целостность хотя бы одного
+    файла нарушена, возвращается \ref ak_error_not_equal_data. В случае ошибки
+    возвращается ее код.                                                                           */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_icode_index_scan( ak_icode_index idx, const char *root, const char *mask, bool_t tree,
+                          size_t threads, bool_t force, ak_icode_stat result,
+                                                  ak_function_icode_report *report, ak_pointer ptr )
+{
+  size_t i = 0, count = 0;
+  int error = ak_error_ok;
+  struct icode_list list;
+  struct icode_pool pool;
+  struct icode_stat st;
+  struct icode_record *records = NULL;
+
+  if( idx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                              "using null pointer to icode index" );
+  if( root == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                           "using null pointer to directory name" );
+  if( mask == NULL ) mask = "*";
+  memset( &st, 0, sizeof( struct icode_stat ));
+  memset( &list, 0, sizeof( struct icode_list ));
+
+ /* формируем упорядоченный список файлов */
+  if(( error = ak_file_find( root, mask, ak_icode_list_add, &list, tree )) != ak_error_ok ) {
+   /* файлы из недоступных каталогов будут учтены как удаленные */
+    ak_error_message_fmt( error, __func__, "incorrect search of files in %s", root );
+    if( error == ak_error_out_of_memory ) goto labex;
+  }
+  if( list.count )
+    qsort( list.entries, list.count, sizeof( struct icode_entry ), ak_icode_record_compare );
+
+ /* отмечаем файлы, для которых требуется вычисление хеш-кода */
+  for( i = 0; i < list.count; i++ ) {
+     ak_icode_entry entry = list.entries +i;
+     if(( entry->old = ak_icode_index_find( idx, entry->rec.name )) != NULL ) {
+       if( !force && ( entry->old->size == entry->rec.size ) &&
+           ( entry->old->mtime == entry->rec.mtime ) && ( entry->old->inode == entry->rec.inode )) {
+         memcpy( entry->rec.tag, entry->old->tag, idx->tag_size );
+         st.skipped++;
+         continue;
+       }
+     }
+     entry->need = ak_true;
+     entry->error = ak_error_not_ready;
+     st.hashed++;
+  }
+  st.total = list.count;
+
+ /* вычисляем хеш-коды */
+  if( st.hashed ) {
+    pool.list = &list;
+    pool.oid = idx->oid;
+    pool.tag_size = idx->tag_size;
+    pool.next = 0;
+    ak_icode_pool_run( &pool, ak_min( threads, st.hashed ));
+  }
+
+ /* формируем новый массив записей и сообщаем об изменениях */
+  if( list.count && (( records = calloc( list.count, sizeof( struct icode_record ))) == NULL )) {
+    error = ak_error_message( ak_error_out_of_memory, __func__, "incorrect memory allocation" );
+    goto labex;
+  }
+  for( i = 0; i < list.count; i++ ) {
+     ak_icode_entry entry = list.entries +i;
+     if( entry->need ) {
+       if( entry->error != ak_error_ok ) {
+         st.failed++;
+         if( report ) report( entry->rec.name, icode_failed, ptr );
+        /* для недоступного файла сохраняем прежнюю запись */
+         if( entry->old ) {
+           free( entry->rec.name );
+           entry->rec = *entry->old;
+           entry->old->name = NULL;
+         } else { free( entry->rec.name ); entry->rec.name = NULL; continue; }
+       } else {
+          if( entry->old == NULL ) {
+            st.added++;
+            if( report ) report( entry->rec.name, icode_added, ptr );
+          } else
+             if( memcmp( entry->old->tag, entry->rec.tag, idx->tag_size ) != 0 ) {
+               st.changed++;
+               if( report ) report( entry->rec.name, icode_changed, ptr );
+             }
+         }
+     }
+     records[count++] = entry->rec;
+     entry->rec.name = NULL;
+  }
+  for( i = 0; i < idx->count; i++ ) {
+     struct icode_record *rec = idx->records +i;
+     if( rec->name == NULL ) continue; /* запись перенесена в новый массив */
+     if(( count == 0 ) || ( bsearch( rec, records, count,
+                                sizeof( struct icode_record ), ak_icode_record_compare ) == NULL )) {
+       st.removed++;
+       if( report ) report( rec->name, icode_removed, ptr );
+     }
+  }
+
+ /* заменяем массив записей индекса */
+  ak_icode_records_free( idx->records, idx->count );
+  idx->records = records;
+  idx->count = count;
+  if( st.changed || st.removed || st.failed ) error = ak_error_not_equal_data;
+
+  labex:
+   for( i = 0; i < list.count; i++ ) if( list.entries[i].rec.name ) free( list.entries[i].rec.name );
+   if( list.entries ) free( list.entries );
+   if( result != NULL ) *result = st;
+
+ return error;
+}
+
+/** @} */
+
+/* ----------------------------------------------------------------------------------------------- */
+/*                                                                                     ak_icode.c  */
+/* ----------------------------------------------------------------------------------------------- */
@@ -17,6 +17,9 @@
 #else
  #error Library cannot be compiled without string.h header
 #endif
+#ifdef AK_HAVE_PTHREAD_H
+ #include <pthread.h>
+#endif
 
 /* ----------------------------------------------------------------------------------------------- */
              /* Реализация функций генерации ключей согласно Р 50.1.113-2016 */
@@ -72,6 +75,38 @@
   return error;
 }
 
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция проверяет, что контекст секретного ключа может использоваться в качестве
+    исходного ключа алгоритма KDF256.
+    \param master Контекст секретного ключа
+    \return В случае успеха функция возвращает \ref ak_error_ok (ноль).
+    В противном случае возвращается код ошибки.                                                    */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_skey_derive_kdf256_check_master( ak_skey master )
+{
+   /* проверяем, что мастер-ключ установлен */
+    if( master->oid->mode != algorithm )
+      return ak_error_message( ak_error_oid_mode, __func__,
+                                   "using the master key which is not a cryptographic algorithm" );
+    switch( master->oid->engine ) {
+      case block_cipher:
+      case hmac_function:
+        break;
+      default: return ak_error_message_fmt( ak_error_oid_engine, __func__,
+                                            "using the master key with unsupported engine (%s)",
+                                              ak_libakrypt_get_engine_name( master->oid->engine ));
+    }
+
+    if(( master->flags&key_flag_set_key ) == 0 )
+      return ak_error_message( ak_error_key_value, __func__,
+                                                     "using the master key with undefined value" );
+   /* целостность ключа */
+    if( master->check_icode( master ) != ak_true )
+      return ak_error_message( ak_error_wrong_key_icode,
+                                              __func__, "incorrect integrity code of master key" );
+  return ak_error_ok;
+}
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! Для генерации ключа используется алгоритм, названный в рекомендациях KDF_GOSTR3411_2012_256.
     Вырабатываемый ключ `K` имеет длину 256 бит и определяется равенством
@@ -115,26 +150,8 @@
     if(( label_size == 0 ) && ( seed_size == 0 ))
       return ak_error_message( ak_error_null_pointer, __func__,
                                                 "using zero length for both input data pointers" );
-   /* проверяем, что мастер-ключ установлен */
-    if( master->oid->mode != algorithm )
-      return ak_error_message( ak_error_oid_mode, __func__,
-                                   "using the master key which is not a cryptographic algorithm" );
-    switch( master->oid->engine ) {
-      case block_cipher:
-      case hmac_function:
-        break;
-      default: return ak_error_message_fmt( ak_error_oid_engine, __func__,
-                                            "using the master key with unsupported engine (%s)",
-                                              ak_libakrypt_get_engine_name( master->oid->engine ));
-    }
-
-    if(( master->flags&key_flag_set_key ) == 0 )
-      return ak_error_message( ak_error_key_value, __func__,
-                                                     "using the master key with undefined value" );
-   /* целостность ключа */
-    if( master->check_icode( master ) != ak_true )
-      return ak_error_message( ak_error_wrong_key_icode,
-                                              __func__, "incorrect integrity code of master key" );
+    if(( error = ak_skey_derive_kdf256_check_master( master )) != ak_error_ok )
+      return ak_error_message( error, __func__, "using incorrect master key" );
 
   /* только теперь вызываем функцию генерации производного ключа */
     master->unmask( master );
@@ -217,6 +234,196 @@
  return handle;
 }
 
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Выработка нескольких производных ключей KDF256 от одного исходного ключа.
+
+    Функция однократно вычисляет состояния функции хеширования Стрибог256 после обработки
+    блоков `Kin xor ipad` и `Kin xor opad`, после чего для каждого производного ключа
+    копирует эти состояния и обрабатывает только данные, зависящие от метки и
+    инициализирующего значения. Выработанный ключ помещается либо в область памяти `outs[i]`,
+    либо, если `outs` равен NULL, присваивается созданному ранее контексту ключа `keys[i]`.    */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_skey_derive_kdf256_multi_internal( ak_skey master, ak_uint8 **labels,
+                        const size_t *label_sizes, ak_uint8 **seeds, const size_t *seed_sizes,
+                                         ak_uint8 **outs, ak_pointer *keys, const size_t count )
+{
+  size_t i = 0;
+  struct hash hctx;
+  int error = ak_error_ok;
+  ak_uint8 cv[2] = { 0x01, 0x00 }, pad[64], key[64], out[32];
+  struct streebog istate, ostate; /* состояния после обработки ipad и opad */
+  const size_t key_size = master->key_size;
+
+  if(( error = ak_hash_create_streebog256( &hctx )) != ak_error_ok )
+    return ak_error_message( error, __func__, "incorrect creation of hash function context" );
+
+ /* формируем значение ключа алгоритма hmac (длинный ключ заменяется его хеш-кодом) */
+  memset( key, 0, sizeof( key ));
+  master->unmask( master );
+  if( key_size > sizeof( key ))
+    error = ak_hash_ptr( &hctx, master->key, key_size, key, 32 );
+   else memcpy( key, master->key, key_size );
+  master->set_mask( master );
+  if( error != ak_error_ok ) {
+    ak_error_message( error, __func__, "incorrect hashing of master key" );
+    goto labex;
+  }
+
+ /* вычисляем начальные состояния внутренней и внешней функций хеширования */
+  for( i = 0; i < sizeof( pad ); i++ ) pad[i] = key[i]^0x36;
+  ak_hash_clean( &hctx );
+  ak_hash_update( &hctx, pad, sizeof( pad ));
+  memcpy( &istate, &hctx.data.sctx, sizeof( struct streebog ));
+
+  for( i = 0; i < sizeof( pad ); i++ ) pad[i] = key[i]^0x5C;
+  ak_hash_clean( &hctx );
+  ak_hash_update( &hctx, pad, sizeof( pad ));
+  memcpy( &ostate, &hctx.data.sctx, sizeof( struct streebog ));
+
+ /* основной цикл выработки производных ключей */
+  for( i = 0; i < count; i++ ) {
+     ak_uint8 *label = labels ? labels[i] : NULL, *seed = seeds ? seeds[i] : NULL;
+     size_t label_size = label_sizes ? label_sizes[i] : 0, seed_size = seed_sizes ? seed_sizes[i] : 0;
+     ak_uint8 *ptr = outs ? outs[i] : out;
+
+     if( ptr == NULL ) {
+       ak_error_message_fmt( error = ak_error_null_pointer, __func__,
+                                    "using null pointer to output buffer (index: %u)", (unsigned int)i );
+       goto labex;
+     }
+    /* внутренняя функция хеширования */
+     ak_hash_clean( &hctx );
+     memcpy( &hctx.data.sctx, &istate, sizeof( struct streebog ));
+     ak_hash_update( &hctx, cv, 1 );
+     if(( label != NULL ) && ( label_size != 0 )) ak_hash_update( &hctx, label, label_size );
+     ak_hash_update( &hctx, cv+1, 1 );
+     if(( seed != NULL ) && ( seed_size != 0 )) ak_hash_update( &hctx, seed, seed_size );
+     if(( error = ak_hash_finalize( &hctx, cv, 2, pad, 32 )) != ak_error_ok ) break;
+
+    /* внешняя функция хеширования */
+     ak_hash_clean( &hctx );
+     memcpy( &hctx.data.sctx, &ostate, sizeof( struct streebog ));
+     if(( error = ak_hash_finalize( &hctx, pad, 32, ptr, 32 )) != ak_error_ok ) break;
+
+    /* присваиваем значение контексту секретного ключа */
+     if( outs == NULL ) {
+       ak_skey skey = keys[i];
+       if(( skey == NULL ) || ( skey->oid == NULL ) || ( skey->oid->func.first.set_key == NULL )) {
+         ak_error_message_fmt( error = ak_error_undefined_function, __func__,
+                  "using secret key context with undefined key assigning mechanism (index: %u)",
+                                                                                  (unsigned int)i );
+         goto labex;
+       }
+       if(( error = skey->oid->func.first.set_key( skey, out, 32 )) != ak_error_ok ) {
+         ak_error_message_fmt( error, __func__,
+                            "incorrect assigning a derivative key value (index: %u)", (unsigned int)i );
+         goto labex;
+       }
+     }
+  }
+  if( error != ak_error_ok )
+    ak_error_message( error, __func__, "wrong creation of a derivative value of a secret key" );
+
+ /* очищаем память */
+  labex:
+   ak_ptr_wipe( key, sizeof( key ), &master->generator );
+   ak_ptr_wipe( pad, sizeof( pad ), &master->generator );
+   ak_ptr_wipe( out, sizeof( out ), &master->generator );
+   ak_ptr_wipe( &istate, sizeof( struct streebog ), &master->generator );
+   ak_ptr_wipe( &ostate, sizeof( struct streebog ), &master->generator );
+   ak_ptr_wipe( &hctx.data.sctx, sizeof( struct streebog ), &master->generator );
+   ak_hash_destroy( &hctx );
+
+ return error;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция вырабатывает `count` производных ключей по алгоритму KDF_GOSTR3411_2012_256
+    от одного исходного ключа
+
+    \code
+      K[i] = KDF256( Kin, label[i], seed[i] )
+    \endcode
+
+    Результат совпадает с `count` последовательными вызовами функции
+    ak_skey_derive_kdf256_from_skey(), однако ключ `Kin` снимается с маски, а состояния
+    функции хеширования после обработки блоков `Kin xor ipad` и `Kin xor opad` вычисляются
+    только один раз. Это сокращает время выработки ключей, например, в протоколах выработки
+    общего ключа, в которых от одного ключа вырабатывается несколько производных.
+
+    \param master_key Указатель на корректно созданный ранее контекст секретного ключа `Kin`
+    (блочного шифра или алгоритма hmac).
+    \param labels Массив из `count` указателей на метки; может принимать значение NULL.
+    \param label_sizes Массив длин меток (в октетах); может принимать значение NULL.
+    \param seeds Массив из `count` указателей на инициализирующие значения;
+    может принимать значение NULL.
+    \param seed_sizes Массив длин инициализирующих значений (в октетах);
+    может принимать значение NULL.
+    \param outs Массив из `count` указателей на области памяти, в которые помещаются
+    выработанные значения (для каждого значения должно быть выделено 32 октета).
+    \param count Количество вырабатываемых ключей.
+
+    \return В случае возникновения ошибки функция возвращает ее код. В случае успеха
+    возвращается \ref ak_error_ok (ноль).                                                          */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_skey_derive_kdf256_multi( ak_pointer master_key, ak_uint8 **labels,
+                        const size_t *label_sizes, ak_uint8 **seeds, const size_t *seed_sizes,
+                                                            ak_uint8 **outs, const size_t count )
+{
+  int error = ak_error_ok;
+
+  if( master_key == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                              "using null pointer to master key" );
+  if( outs == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                   "using null pointer to array of output buffers" );
+  if( !count ) return ak_error_message( ak_error_zero_length, __func__,
+                                                            "using zero count of derivative keys" );
+  if(( error = ak_skey_derive_kdf256_check_master( master_key )) != ak_error_ok )
+    return ak_error_message( error, __func__, "using incorrect master key" );
+
+ return ak_skey_derive_kdf256_multi_internal( master_key,
+                                      labels, label_sizes, seeds, seed_sizes, outs, NULL, count );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция аналогична функции ak_skey_derive_kdf256_multi(), однако выработанные значения
+    не возвращаются, а сразу присваиваются созданным ранее контекстам секретных ключей
+    (например, контекстам \ref bckey или \ref hmac) с помощью функции присвоения ключа,
+    определенной в идентификаторе каждого ключа. Тем самым исключается создание новых объектов
+    функцией ak_oid_new_object(), выполняемое в ak_skey_new_derive_kdf256_from_skey().
+
+    \param master_key Указатель на корректно созданный ранее контекст секретного ключа `Kin`.
+    \param labels Массив из `count` указателей на метки; может принимать значение NULL.
+    \param label_sizes Массив длин меток (в октетах); может принимать значение NULL.
+    \param seeds Массив из `count` указателей на инициализирующие значения;
+    может принимать значение NULL.
+    \param seed_sizes Массив длин инициализирующих значений (в октетах);
+    может принимать значение NULL.
+    \param keys Массив из `count` указателей на созданные ранее контексты секретных ключей.
+    \param count Количество вырабатываемых ключей.
+
+    \return В случае возникновения ошибки функция возвращает ее код. В случае успеха
+    возвращается \ref ak_error_ok (ноль).                                                          */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_skey_derive_kdf256_multi_to_skey( ak_pointer master_key, ak_uint8 **labels,
+                        const size_t *label_sizes, ak_uint8 **seeds, const size_t *seed_sizes,
+                                                            ak_pointer *keys, const size_t count )
+{
+  int error = ak_error_ok;
+
+  if( master_key == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                              "using null pointer to master key" );
+  if( keys == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                               "using null pointer to array of secret key contexts" );
+  if( !count ) return ak_error_message( ak_error_zero_length, __func__,
+                                                            "using zero count of derivative keys" );
+  if(( error = ak_skey_derive_kdf256_check_master( master_key )) != ak_error_ok )
+    return ak_error_message( error, __func__, "using incorrect master key" );
+
+ return ak_skey_derive_kdf256_multi_internal( master_key,
+                                      labels, label_sizes, seeds, seed_sizes, NULL, keys, count );
+}
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! @return В случае успеха, функция возвращает истину. В случае возникновения ошибки,
  *  возвращается ложь. Код ошибки может быть получен с помощью вызова функции ak_error_get_value() */
@@ -234,10 +441,16 @@
      0x01, 0x31, 0x37, 0x01, 0x0a, 0x83, 0x75, 0x4f, 0xd0, 0xaf, 0x6d, 0x7c, 0xd4, 0x92, 0x2e, 0xd9
     };
 
-    ak_uint8 out[32];
+    ak_uint8 out[32], outs[3][32];
     int error = ak_error_ok;
     ak_uint8 static_label[4] = { 0x26, 0xbd, 0xb8, 0x78 };
     ak_uint8 static_seed[8] = { 0xaf, 0x21, 0x43, 0x41, 0x45, 0x65, 0x63, 0x78 };
+    ak_uint8 *labels[3] = { static_label, static_seed, NULL };
+    ak_uint8 *seeds[3] = { static_seed, static_label, static_seed };
+    ak_uint8 *optr[3] = { outs[0], outs[1], outs[2] };
+    size_t i = 0, label_sizes[3] = { 4, 8, 0 }, seed_sizes[3] = { 8, 4, 8 };
+    ak_pointer hptr = NULL;
+    struct hmac hk;
 
    /* структура временного ключа */
     struct bckey sk;
@@ -275,9 +488,56 @@
         if( ak_log_get_level() >= ak_log_maximum ) ak_error_message( ak_error_ok, __func__ ,
                        "the test for kdf-gostr3411-2012-256 function from R 50.1.113-2016 is Ok" );
      }
+    if( error != ak_error_ok ) goto exlab;
+
+   /* вырабатываем несколько ключей одновременно и сравниваем с последовательной выработкой */
+    memset( outs, 0, sizeof( outs ));
+    if(( error = ak_skey_derive_kdf256_multi( &sk, labels, label_sizes,
+                                           seeds, seed_sizes, optr, 3 )) != ak_error_ok ) {
+      ak_error_message( error, __func__, "incorrect generation of several secret key values");
+      goto exlab;
+    }
+    for( i = 0; i < 3; i++ ) {
+       if(( error = ak_skey_derive_kdf256_from_skey( &sk, labels[i], label_sizes[i],
+                                      seeds[i], seed_sizes[i], out, sizeof( out ))) != ak_error_ok ) {
+         ak_error_message( error, __func__, "incorrect generation of a new secret key value");
+         goto exlab;
+       }
+       if( !ak_ptr_is_equal_with_log( out, outs[i], sizeof( out ))) {
+         ak_error_message( error = ak_error_not_equal_data, __func__,
+                             "the value of kdf_gostr3411_2012_256 function for several keys is wrong");
+         goto exlab;
+       }
+    }
+
+   /* вырабатываем ключ непосредственно в контекст алгоритма hmac */
+    if(( error = ak_hmac_create_streebog256( &hk )) != ak_error_ok ) {
+      ak_error_message( error, __func__, "incorrect creation of hmac context");
+      goto exlab;
+    }
+    hptr = &hk;
+    if(( error = ak_skey_derive_kdf256_multi_to_skey( &sk, labels, label_sizes,
+                                          seeds, seed_sizes, &hptr, 1 )) != ak_error_ok ) {
+      ak_error_message( error, __func__, "incorrect assigning of derivative secret key value");
+      ak_hmac_destroy( &hk );
+      goto exlab;
+    }
+    memset( outs, 0, sizeof( outs ));
+    ak_hmac_ptr( &hk, static_seed, sizeof( static_seed ), outs[0], 32 );
+    ak_hmac_destroy( &hk );
+    if(( error = ak_hmac_create_streebog256( &hk )) == ak_error_ok ) {
+      ak_hmac_set_key( &hk, static_output_key, sizeof( static_output_key ));
+      ak_hmac_ptr( &hk, static_seed, sizeof( static_seed ), outs[1], 32 );
+      ak_hmac_destroy( &hk );
+    }
+    if( !ak_ptr_is_equal_with_log( outs[0], outs[1], 32 )) {
+      ak_error_message( error = ak_error_not_equal_data, __func__,
+                                "the value of kdf_gostr3411_2012_256 function for hmac key is wrong");
+    }
 
     exlab:
       ak_ptr_wipe( out, 32, &sk.key.generator );
+      ak_ptr_wipe( outs, sizeof( outs ), &sk.key.generator );
       ak_bckey_destroy( &sk );
 
  return ( error == ak_error_ok ) ? ak_true : ak_false;
@@ -781,14 +1041,265 @@
  return handle;
 }
 
+/* ----------------------------------------------------------------------------------------------- */
+                  /* Реализация алгоритма TLSTREE с кэшированием промежуточных ключей */
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция накладывает на ключ, хранящийся в первой половине буфера, новую маску.
+ *  \details Если маска уже была наложена, она заменяется новой, при этом ключ в открытом виде
+ *  в памяти не появляется. */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_tlstree_cache_remask( ak_tlstree_cache cache, ak_uint8 *key )
+{
+    size_t i = 0;
+    ak_uint8 newmask[32];
+    int error = ak_error_ok;
+
+    if(( error = ak_random_ptr( &cache->generator, newmask, 32 )) != ak_error_ok )
+      return ak_error_message( error, __func__, "wrong generation a random mask for key buffer" );
+    for( i = 0; i < 32; i++ ) {
+       key[i] ^= newmask[i];
+       key[32+i] ^= newmask[i];
+    }
+    ak_ptr_wipe( newmask, 32, &cache->generator );
+ return error;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция вырабатывает значение KDF256( key, label, Str8( index )), где ключ key
+ *  хранится в маскированном виде, и помещает результат в элемент кэша (также в маскированном виде). */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_tlstree_cache_derive( ak_tlstree_cache cache, ak_uint8 *key,
+                                   const char *label, ak_uint64 index, ak_tlstree_cache_entry entry )
+{
+    size_t i = 0;
+    ak_uint8 plain[32];
+    int error = ak_error_ok;
+    ak_uint64 seed = index;
+
+  #ifdef AK_LITTLE_ENDIAN
+    seed = bswap_64( index );
+  #endif
+    for( i = 0; i < 32; i++ ) plain[i] = key[i]^key[32+i];
+    error = ak_skey_derive_kdf256( plain, 32, (ak_uint8 *) label, 6,
+                                                         (ak_uint8 *) &seed, 8, entry->key, 32 );
+    ak_ptr_wipe( plain, 32, &cache->generator );
+    if( error != ak_error_ok ) return error;
+
+   /* маскируем выработанное значение: начальная маска нулевая */
+    memset( entry->key +32, 0, 32 );
+    entry->index = index;
+ return ak_tlstree_cache_remask( cache, entry->key );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция ищет в кэше элемент для заданного индекса. */
+/* ----------------------------------------------------------------------------------------------- */
+ static ak_tlstree_cache_entry ak_tlstree_cache_lookup( ak_tlstree_cache_entry table,
+                                                                 size_t count, ak_uint64 index )
+{
+    size_t i = 0;
+    for( i = 0; i < count; i++ ) if( table[i].index == index ) return table +i;
+ return NULL;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция помещает выработанный ключ в кэш: в свободный элемент или на место элемента,
+ *  который дольше всех не использовался. */
+/* ----------------------------------------------------------------------------------------------- */
+ static ak_tlstree_cache_entry ak_tlstree_cache_insert( ak_tlstree_cache cache,
+                         ak_tlstree_cache_entry table, size_t *count, ak_tlstree_cache_entry entry )
+{
+    size_t i = 0, lru = 0;
+    ak_tlstree_cache_entry slot = NULL;
+
+    if( *count < ak_tlstree_cache_size ) slot = table +( (*count)++ );
+     else {
+       for( i = 1; i < *count; i++ ) if( table[i].stamp < table[lru].stamp ) lru = i;
+       slot = table +lru;
+     }
+    memcpy( slot, entry, sizeof( struct tlstree_cache_entry ));
+    ak_ptr_wipe( entry, sizeof( struct tlstree_cache_entry ), &cache->generator );
+ return slot;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция создает контекст, позволяющий вырабатывать производные ключи алгоритма TLSTREE
+ *  для произвольной последовательности номеров (например, при получении пакетов
+ *  в произвольном порядке). Промежуточные ключи первого и второго уровней сохраняются
+ *  в кэше ограниченного размера \ref ak_tlstree_cache_size; при его переполнении вытесняется ключ,
+ *  который дольше всех не использовался. Если оба промежуточных ключа для номера находятся в кэше,
+ *  выработка производного ключа требует однократного вызова функции KDF256.
+ *
+ *  Исходный ключ и все промежуточные ключи хранятся в памяти в маскированном виде,
+ *  маска сменяется после каждого использования ключа.
+ *
+ *  \param cache Контекст алгоритма TLSTREE с кэшированием.
+ *  \param master_key Указатель на область памяти, содержащую исходный ключ.
+ *  \param master_key_size Размер исходного ключа в байтах.
+ *  \param tlstree Набор констант, являющийся параметром алгоритма.
+ *  \return В случае возникновения ошибки функция возвращает ее код. В случае успеха
+ *  возвращается \ref ak_error_ok (ноль).                                                          */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_tlstree_cache_create( ak_tlstree_cache cache, ak_uint8 *master_key,
+                                                 const size_t master_key_size, tlstree_t tlstree )
+{
+    int error = ak_error_ok;
+
+    if( cache == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                           "using null-pointer to tlstree cache" );
+    if( master_key == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                               "using null-pointer to master key");
+    if( !master_key_size ) return ak_error_message( ak_error_zero_length, __func__,
+                                                              "using master key with zero length");
+    memset( cache, 0, sizeof( struct tlstree_cache ));
+    if(( error = ak_random_create_lcg( &cache->generator )) != ak_error_ok )
+      return ak_error_message( error, __func__, "incorrect creation of random generator context" );
+    cache->state = tlstree;
+    memcpy( cache->master, master_key, ak_min( 32, master_key_size ));
+    if(( error = ak_tlstree_cache_remask( cache, cache->master )) != ak_error_ok ) {
+      ak_tlstree_cache_destroy( cache );
+      return ak_error_message( error, __func__, "incorrect masking of master key" );
+    }
+
+ return error;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \param cache Контекст алгоритма TLSTREE с кэшированием.
+ *  \param master_key Указатель на корректно созданный ранее контекст секретного ключа `Kin`
+ *  (ключ блочного шифра или ключ выработки hmac).
+ *  \param tlstree Набор констант, являющийся параметром алгоритма.
+ *  \return В случае возникновения ошибки функция возвращает ее код. В случае успеха
+ *  возвращается \ref ak_error_ok (ноль).                                                          */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_tlstree_cache_create_from_skey( ak_tlstree_cache cache,
+                                                         ak_pointer master_key, tlstree_t tlstree )
+{
+    int error = ak_error_ok;
+    ak_skey master = ( ak_skey ) master_key;
+
+    if( master_key == NULL )  return ak_error_message( ak_error_null_pointer, __func__,
+                                                              "using null pointer to master key" );
+    if( master->oid->mode != algorithm )
+      return ak_error_message( ak_error_oid_mode, __func__,
+                                   "using the master key which is not a cryptographic algorithm" );
+    switch( master->oid->engine ) {
+      case block_cipher:
+      case hmac_function:
+        break;
+      default: return ak_error_message_fmt( ak_error_oid_engine, __func__,
+                                            "using the master key with unsupported engine (%s)",
+                                              ak_libakrypt_get_engine_name( master->oid->engine ));
+    }
+    if(( master->flags&key_flag_set_key ) == 0 )
+      return ak_error_message( ak_error_key_value, __func__,
+                                                     "using the master key with undefined value" );
+    if( master->check_icode( master ) != ak_true )
+      return ak_error_message( ak_error_wrong_key_icode,
+                                              __func__, "incorrect integrity code of master key" );
+    master->unmask( master );
+    error = ak_tlstree_cache_create( cache, master->key, master->key_size, tlstree );
+    master->set_mask( master );
+
+    if( error != ak_error_ok )
+      ak_error_message( error, __func__, "incorrect creation of tlstree cache" );
+ return error;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция вырабатывает значение `K = TLSTREE( Kin, index )` для произвольного номера ключа,
+ *  используя (и пополняя) кэш промежуточных ключей первого и второго уровней.
+ *
+ *  \param cache Контекст алгоритма TLSTREE с кэшированием.
+ *  \param index Порядковый номер вырабатываемого ключа.
+ *  \param out Указатель на область памяти, в которую помещается выработанное значение
+ *  (память в размере 32 октета должна быть выделена заранее).
+ *  \param size Размер выделенной памяти.
+ *  \return В случае возникновения ошибки функция возвращает ее код. В случае успеха
+ *  возвращается \ref ak_error_ok (ноль).                                                          */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_tlstree_cache_get_key( ak_tlstree_cache cache, ak_uint64 index,
+                                                                 ak_uint8 *out, const size_t size )
+{
+    int error = ak_error_ok;
+    struct tlstree_cache_entry temp, level3;
+    ak_tlstree_cache_entry k1 = NULL, k2 = NULL;
+    ak_uint64 ind1 = 0, ind2 = 0, ind3 = 0;
+
+    if( cache == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                           "using null-pointer to tlstree cache" );
+    if( out == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                            "using null-pointer to output buffer");
+    if( !size ) return ak_error_message( ak_error_zero_length, __func__,
+                                                           "using output buffer with zero length");
+    ind1 = index&tlstree_constant_values[cache->state].c1;
+    ind2 = index&tlstree_constant_values[cache->state].c2;
+    ind3 = index&tlstree_constant_values[cache->state].c3;
+    cache->clock++;
+
+   /* промежуточный ключ второго уровня однозначно определяет и ключ первого уровня */
+    if(( k2 = ak_tlstree_cache_lookup( cache->level2, cache->count2, ind2 )) == NULL ) {
+      if(( k1 = ak_tlstree_cache_lookup( cache->level1, cache->count1, ind1 )) == NULL ) {
+        if(( error = ak_tlstree_cache_derive( cache, cache->master,
+                                                      "level1", ind1, &temp )) != ak_error_ok )
+          return ak_error_message( error, __func__, "incorrect creation of temporary K1 value" );
+        ak_tlstree_cache_remask( cache, cache->master );
+        k1 = ak_tlstree_cache_insert( cache, cache->level1, &cache->count1, &temp );
+      }
+      k1->stamp = cache->clock;
+      if(( error = ak_tlstree_cache_derive( cache, k1->key,
+                                                      "level2", ind2, &temp )) != ak_error_ok )
+        return ak_error_message( error, __func__, "incorrect creation of temporary K2 value" );
+      ak_tlstree_cache_remask( cache, k1->key );
+      k2 = ak_tlstree_cache_insert( cache, cache->level2, &cache->count2, &temp );
+    } else cache->hits++;
+    k2->stamp = cache->clock;
+
+   /* третий уровень вычисляется всегда */
+    if(( error = ak_tlstree_cache_derive( cache, k2->key,
+                                                     "level3", ind3, &level3 )) != ak_error_ok )
+      return ak_error_message( error, __func__, "incorrect creation of temporary K3 value" );
+    ak_tlstree_cache_remask( cache, k2->key );
+    for( ind1 = 0; ind1 < ak_min( size, 32 ); ind1++ )
+       out[ind1] = level3.key[ind1]^level3.key[32+ind1];
+    ak_ptr_wipe( &level3, sizeof( struct tlstree_cache_entry ), &cache->generator );
+
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \param cache Контекст алгоритма TLSTREE с кэшированием.
+ *  \return В случае возникновения ошибки возвращается ее код. В случае успеха функция
+ *  возвращает ноль `ak_error_ok` (ноль).                                                          */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_tlstree_cache_destroy( ak_tlstree_cache cache )
+{
+    int error = ak_error_ok;
+
+    if( cache == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                           "destroying null-pointer to tlstree cache" );
+    if(( error = ak_ptr_wipe( cache->master, sizeof( cache->master ),
+                                                          &cache->generator )) != ak_error_ok )
+      ak_error_message( error, __func__, "incorrect wipe of master key" );
+    ak_ptr_wipe( cache->level1, sizeof( cache->level1 ), &cache->generator );
+    ak_ptr_wipe( cache->level2, sizeof( cache->level2 ), &cache->generator );
+    ak_random_destroy( &cache->generator );
+    memset( cache, 0, sizeof( struct tlstree_cache ));
+
+ return error;
+}
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! @return В случае успеха, функция возвращает истину. В случае возникновения ошибки,
  *  возвращается ложь. Код ошибки может быть получен с помощью вызова функции ak_error_get_value() */
 /* ----------------------------------------------------------------------------------------------- */
  bool_t ak_libakrypt_test_tlstree( void )
 {
+   size_t idx = 0;
+   ak_uint64 index = 0;
    int error = ak_error_ok;
    struct tlstree_state ctx;
+   struct tlstree_cache cache;
 
   /* множество исходных ключей */
    ak_uint8 inkey611[32] = {
@@ -835,7 +1346,7 @@
    };
 
   /* массив для хранения выработанных ключей */
-   ak_uint8 out[32];
+   ak_uint8 out[32], out2[32];
 
   /* первый пример */
    if(( error = ak_skey_derive_tlstree( inkey611, 32, 5,
@@ -969,9 +1480,39 @@
      ak_tlstree_state_destroy( &ctx );
      if( error != ak_error_ok ) return ak_false;
 
+  /* восьмой пример - выработка ключей в произвольном порядке с использованием кэша
+   * промежуточных ключей и сравнение с непосредственным вычислением */
+   if(( error = ak_tlstree_cache_create( &cache, inkey634, 32,
+                                                 tlstree_with_libakrypt_4096 )) != ak_error_ok ) {
+     ak_error_message( error, __func__, "incorrect creation of tlstree cache");
+     return ak_false;
+   }
+   for( idx = 0; idx < 512; idx++ ) {
+     /* номера ключей выбираются из нескольких удаленных друг от друга диапазонов */
+      index = (( idx*2654435761U )%8192 ) + (( idx&3 ) << 20 );
+      if(( error = ak_tlstree_cache_get_key( &cache, index, out, 32 )) != ak_error_ok ) {
+        ak_error_message( error, __func__, "incorrect creation of tlstree cached key");
+        break;
+      }
+      if(( error = ak_skey_derive_tlstree( inkey634, 32, index,
+                                        tlstree_with_libakrypt_4096, out2, 32 )) != ak_error_ok ) {
+        ak_error_message( error, __func__, "incorrect creation of tlstree derive key");
+        break;
+      }
+      if( !ak_ptr_is_equal_with_log( out, out2, 32 )) {
+        ak_error_message_fmt( error = ak_error_not_equal_data, __func__,
+                          "wrong value of cached derivative secret key, index: %d", (int) index );
+        break;
+      }
+   }
+   ak_tlstree_cache_destroy( &cache );
+   if( error != ak_error_ok ) return ak_false;
+
 
    if( ak_log_get_level() >= ak_log_maximum ) ak_error_message( ak_error_ok, __func__ ,
                   "4200 tests for comparison of different realizations of tlstree funcion is Ok" );
+   if( ak_log_get_level() >= ak_log_maximum ) ak_error_message( ak_error_ok, __func__ ,
+                                 "512 tests for random access to tlstree cached keys is Ok" );
   return ak_true;
 }
 
@@ -1295,6 +1836,7 @@
   ak_uint64 index = 0;
   size_t i, count, tail;
   ak_uint8 *ptr = buffer;
+  int error = ak_error_ok;
   ak_function_finalize *mac = NULL;
 
   if( state == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
@@ -1326,7 +1868,9 @@
   for( i = 0; i < count; i++ ) {
     state->number++;
     ak_uint64_to_ptr( state->number, ( state->ivbuffer +state->block_size ));
-    mac( &state->key.bkey, state->ivbuffer, state->state_size, state->ivbuffer, state->block_size );
+    if(( error = mac( &state->key.bkey, state->ivbuffer,
+                 state->state_size, state->ivbuffer, state->block_size )) != ak_error_ok )
+      return ak_error_message( error, __func__, "incorrect generation of key information" );
     memcpy( ptr, state->ivbuffer, state->block_size );
     ptr += state->block_size;
   }
@@ -1334,13 +1878,124 @@
   if( tail ) {
     state->number++;
     ak_uint64_to_ptr( state->number, ( state->ivbuffer +state->block_size ));
-    mac( &state->key.bkey, state->ivbuffer, state->state_size, state->ivbuffer, state->block_size );
+    if(( error = mac( &state->key.bkey, state->ivbuffer,
+                 state->state_size, state->ivbuffer, state->block_size )) != ak_error_ok )
+      return ak_error_message( error, __func__, "incorrect generation of key information" );
     memcpy( ptr, state->ivbuffer, tail );
   }
 
  return ak_error_ok;
 }
 
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Общие данные потоков, вырабатывающих ключевую информацию для массива контекстов. */
+ typedef struct kdf_state_pool {
+  /*! \brief Массив контекстов выработки ключевой информации. */
+   ak_kdf_state states;
+  /*! \brief Количество контекстов. */
+   size_t count;
+  /*! \brief Область памяти для выработанной ключевой информации. */
+   ak_uint8 *out;
+  /*! \brief Размер ключевой информации, вырабатываемой каждым контекстом. */
+   size_t size;
+  /*! \brief Индекс следующего обрабатываемого контекста. */
+   size_t next;
+  /*! \brief Код первой из возникших ошибок. */
+   int error;
+ #ifdef AK_HAVE_PTHREAD_H
+  /*! \brief Мьютекс, защищающий индекс следующего контекста и код ошибки. */
+   pthread_mutex_t mutex;
+ #endif
+ } *ak_kdf_state_pool;
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция потока, последовательно обрабатывающего контексты массива. */
+ static void *ak_kdf_state_pool_worker( void *ptr )
+{
+  ak_kdf_state_pool pool = ptr;
+
+  for( ;; ) {
+     size_t idx = 0;
+     int error = ak_error_ok;
+
+    #ifdef AK_HAVE_PTHREAD_H
+     pthread_mutex_lock( &pool->mutex );
+    #endif
+     idx = pool->next++;
+    #ifdef AK_HAVE_PTHREAD_H
+     pthread_mutex_unlock( &pool->mutex );
+    #endif
+     if( idx >= pool->count ) break;
+
+     if(( error = ak_kdf_state_next( pool->states +idx,
+                                       pool->out +idx*pool->size, pool->size )) != ak_error_ok ) {
+      #ifdef AK_HAVE_PTHREAD_H
+       pthread_mutex_lock( &pool->mutex );
+      #endif
+       if( pool->error == ak_error_ok ) pool->error = error;
+      #ifdef AK_HAVE_PTHREAD_H
+       pthread_mutex_unlock( &pool->mutex );
+      #endif
+     }
+  }
+
+ return NULL;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция вырабатывает очередной фрагмент ключевой информации длины `size` октетов для
+    каждого из `count` независимых контекстов, расположенных в памяти последовательно,
+    например, для каждого абонента из таблицы абонентов.
+    Результат, выработанный контекстом с номером `i`, помещается в область памяти
+    `out + i*size`. Результат совпадает с последовательным вызовом функции ak_kdf_state_next()
+    для каждого контекста.
+
+    Поскольку в алгоритме, описанном в Р 1323565.1.022-2018, каждый следующий блок ключевой
+    информации зависит от предыдущего, вычисления для одного контекста выполняются
+    последовательно; распараллеливание производится между различными контекстами.
+
+    \param states Указатель на массив контекстов
+    \param count Количество контекстов в массиве
+    \param out Область памяти, куда помещается выработанная ключевая информация;
+    размер области должен быть не менее `count*size` октетов
+    \param size Размер ключевой информации, вырабатываемой каждым контекстом (в октетах)
+    \param threads Количество потоков; если значение равно нулю, то используется
+    количество доступных процессоров (для сборки без поддержки pthread значение игнорируется).
+    \return В случае успеха функция возвращает ноль (ak_error_ok),
+    в противном случае возвращается код первой из возникших ошибок.                                */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_kdf_state_next_many( ak_kdf_state states, const size_t count,
+                                          ak_pointer out, const size_t size, size_t threads )
+{
+  struct kdf_state_pool pool;
+
+  if( states == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                          "using null pointer to states array" );
+  if( out == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                              "using null pointer to key buffer" );
+  if( !count || !size ) return ak_error_message( ak_error_zero_length, __func__,
+                                                     "using zero count of states or key length" );
+  pool.states = states;
+  pool.count = count;
+  pool.out = out;
+  pool.size = size;
+  pool.next = 0;
+  pool.error = ak_error_ok;
+
+  if( threads == 0 ) threads = ak_libakrypt_cpu_count();
+  if( threads > count ) threads = count;
+
+ #ifdef AK_HAVE_PTHREAD_H
+  pthread_mutex_init( &pool.mutex, NULL );
+ #endif
+  ak_thread_pool_run( ak_kdf_state_pool_worker, &pool, threads );
+ #ifdef AK_HAVE_PTHREAD_H
+  pthread_mutex_destroy( &pool.mutex );
+ #endif
+
+ return pool.error;
+}
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! \param state Контекст, содержащий текущее состояние алгоритма выработки производной 
     ключевой информации
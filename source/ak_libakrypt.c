@@ -4,6 +4,12 @@
 /*  Файл ak_libakrypt.с                                                                            */
 /*  - содержит реализацию функций инициализации и тестирования библиотеки.                         */
 /* ----------------------------------------------------------------------------------------------- */
+#ifdef AK_HAVE_STDLIB_H
+ #include <stdlib.h>
+#endif
+#ifdef AK_HAVE_UNISTD_H
+ #include <unistd.h>
+#endif
 #ifdef AK_HAVE_PTHREAD_H
  #include <pthread.h>
 #endif
@@ -13,6 +19,13 @@
 #ifdef AK_HAVE_WINDOWS_H
  #include <windows.h>
 #endif
+#if defined( _MSC_VER ) && ( defined( _M_X64 ) || defined( _M_IX86 ))
+ #include <intrin.h>
+ #define LIBAKRYPT_HAVE_CPUID
+#elif defined( __GNUC__ ) && ( defined( __x86_64__ ) || defined( __i386__ ))
+ #include <cpuid.h>
+ #define LIBAKRYPT_HAVE_CPUID
+#endif
 
 /* ----------------------------------------------------------------------------------------------- */
  #include <libakrypt-internal.h>
@@ -87,7 +100,12 @@
   #endif
   #ifdef AK_HAVE_BUILTIN_CLMULEPI64
    if( ak_log_get_level() > ak_log_standard ) {
-     ak_error_message( ak_error_ok, __func__ , "library applies clmulepi64 instruction" );
+     ak_error_message( ak_error_ok, __func__ , "library contains code for clmulepi64 instruction" );
+   }
+  #endif
+  #ifdef AK_HAVE_BUILTIN_MULX_ADX
+   if( ak_log_get_level() > ak_log_standard ) {
+     ak_error_message( ak_error_ok, __func__ , "library contains code for mulx and adx instructions" );
    }
   #endif
   #ifdef AK_HAVE_BUILTIN_MULQ_GCC
@@ -109,6 +127,235 @@
  return ak_true;
 }
 
+/* ----------------------------------------------------------------------------------------------- */
+/*                      выбор реализаций вычислительных ядер во время выполнения                   */
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Наборы команд, поддерживаемые процессором (отрицательное значение до первой проверки). */
+ static ak_int64 ak_cpu_features = -1;
+
+/*! \brief Вычислительные ядра, реализация которых выбирается во время выполнения. */
+ static struct cpu_kernel {
+ /*! \brief Имя ядра. */
+  const char *name;
+ /*! \brief Имя реализации, использующей специальные команды процессора. */
+  const char *accelerated;
+ /*! \brief Наборы команд, необходимые для ускоренной реализации. */
+  ak_uint32 features;
+ /*! \brief Функция, устанавливающая ускоренную (ak_true) или универсальную (ak_false) реализацию. */
+  bool_t ( *set )( bool_t );
+ /*! \brief Признак использования ускоренной реализации. */
+  bool_t current;
+} ak_cpu_kernels[] = {
+  { "gf2n", "pclmul", ak_cpu_feature_pclmul, ak_gf2n_set_kernel, ak_false },
+  { "montgomery", "mulx-adx", ak_cpu_feature_bmi2_adx, ak_mpzn_set_montgomery_kernel, ak_false },
+  { NULL, NULL, 0, NULL, ak_false }
+};
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Определение наборов команд процессора с помощью инструкции cpuid.
+
+    Проверяются бит 1 регистра ecx (pclmulqdq) и бит 26 регистра edx (sse2) функции 1,
+    а также биты 8 (bmi2) и 19 (adx) регистра ebx функции 7.                                      */
+/* ----------------------------------------------------------------------------------------------- */
+ static ak_uint32 ak_libakrypt_cpu_probe( void )
+{
+  ak_uint32 features = 0;
+#ifdef LIBAKRYPT_HAVE_CPUID
+  ak_uint32 max = 0, ecx1 = 0, edx1 = 0, ebx7 = 0;
+ #ifdef _MSC_VER
+  int regs[4];
+
+  __cpuid( regs, 0 ); max = ( ak_uint32 )regs[0];
+  if( max >= 1 ) { __cpuid( regs, 1 ); ecx1 = ( ak_uint32 )regs[2]; edx1 = ( ak_uint32 )regs[3]; }
+  if( max >= 7 ) { __cpuidex( regs, 7, 0 ); ebx7 = ( ak_uint32 )regs[1]; }
+ #else
+  unsigned int a = 0, b = 0, c = 0, d = 0;
+
+  max = __get_cpuid_max( 0, NULL );
+  if( max >= 1 ) { __cpuid( 1, a, b, c, d ); ecx1 = c; edx1 = d; }
+  if( max >= 7 ) { __cpuid_count( 7, 0, a, b, c, d ); ebx7 = b; }
+ #endif
+  if(( ecx1&0x2 ) && ( edx1&0x4000000 )) features |= ak_cpu_feature_pclmul;
+  if(( ebx7&0x100 ) && ( ebx7&0x80000 )) features |= ak_cpu_feature_bmi2_adx;
+#endif
+ return features;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Проверка выполняется один раз, при первом вызове функции; результат сохраняется.
+
+    @param features Битовая маска наборов команд, например, \ref ak_cpu_feature_pclmul.
+    @return Функция возвращает \ref ak_true, если процессор поддерживает все заданные наборы.      */
+/* ----------------------------------------------------------------------------------------------- */
+ bool_t ak_libakrypt_cpu_has( const ak_uint32 features )
+{
+  if( ak_cpu_features < 0 ) ak_cpu_features = ak_libakrypt_cpu_probe();
+ return (( ak_cpu_features&features ) == features );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+ static struct cpu_kernel *ak_libakrypt_find_kernel( const char *name )
+{
+  struct cpu_kernel *kernel = ak_cpu_kernels;
+
+  if( name == NULL ) {
+    ak_error_message( ak_error_null_pointer, __func__, "using null pointer to kernel name" );
+    return NULL;
+  }
+  while( kernel->name != NULL ) {
+    if( strncmp( kernel->name, name, strlen( kernel->name ) +1 ) == 0 ) return kernel;
+    kernel++;
+  }
+  ak_error_message_fmt( ak_error_wrong_option, __func__, "using unknown kernel name %s", name );
+ return NULL;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Библиотека выбирает реализации следующих вычислительных ядер:
+     - `gf2n` -- умножение в конечных полях \f$ \mathbb F_{2^{64}}\f$, \f$ \mathbb F_{2^{128}}\f$,
+       \f$ \mathbb F_{2^{256}}\f$ и \f$ \mathbb F_{2^{512}}\f$; реализации `generic` и `pclmul`;
+     - `montgomery` -- умножение вычетов длины 256 и 512 бит в представлении Монтгомери;
+       реализации `generic` и `mulx-adx`.
+
+    @param name Имя вычислительного ядра.
+    @return Функция возвращает имя используемой реализации. В случае ошибки возвращается NULL,
+    а код ошибки может быть получен с помощью вызова функции ak_error_get_value().                 */
+/* ----------------------------------------------------------------------------------------------- */
+ const char *ak_libakrypt_get_kernel( const char *name )
+{
+  struct cpu_kernel *kernel = ak_libakrypt_find_kernel( name );
+
+  if( kernel == NULL ) return NULL;
+ return kernel->current ? kernel->accelerated : "generic";
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция позволяет принудительно выбрать универсальную реализацию вычислительного ядра
+    (значение `generic`), ускоренную реализацию (например, `pclmul`), либо вернуть выбор,
+    выполняемый при инициализации библиотеки (значение `auto`). Ускоренная реализация
+    устанавливается только в случае, если она скомпилирована и поддерживается процессором.
+
+    Функция изменяет глобальные указатели на функции и должна вызываться до начала
+    использования криптографических механизмов в нескольких потоках.
+
+    @param name Имя вычислительного ядра (см. ak_libakrypt_get_kernel()).
+    @param implementation Имя реализации.
+    @return В случае успеха функция возвращает \ref ak_error_ok. В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_libakrypt_set_kernel( const char *name, const char *implementation )
+{
+  bool_t accelerated = ak_false;
+  struct cpu_kernel *kernel = ak_libakrypt_find_kernel( name );
+
+  if( kernel == NULL ) return ak_error_get_value();
+  if( implementation == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                     "using null pointer to implementation name" );
+  if( strncmp( implementation, "auto", 5 ) == 0 ) {
+    accelerated = ak_libakrypt_cpu_has( kernel->features );
+    if( accelerated && !kernel->set( ak_true )) accelerated = ak_false;
+    if( !accelerated ) kernel->set( ak_false );
+    kernel->current = accelerated;
+    return ak_error_ok;
+  }
+  if( strncmp( implementation, "generic", 8 ) == 0 ) {
+    kernel->set( ak_false );
+    kernel->current = ak_false;
+    return ak_error_ok;
+  }
+  if( strncmp( implementation, kernel->accelerated, strlen( kernel->accelerated ) +1 ) != 0 )
+    return ak_error_message_fmt( ak_error_invalid_value, __func__,
+                                "using unknown implementation %s for %s kernel", implementation, name );
+  if( !ak_libakrypt_cpu_has( kernel->features ))
+    return ak_error_message_fmt( ak_error_invalid_value, __func__,
+                                 "%s implementation is not supported by processor", implementation );
+  if( !kernel->set( ak_true )) {
+    kernel->set( ak_false );
+    return ak_error_message_fmt( ak_error_invalid_value, __func__,
+                                  "%s implementation is not compiled into library", implementation );
+  }
+  kernel->current = ak_true;
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция выбирает для каждого вычислительного ядра наиболее быструю реализацию,
+    поддерживаемую процессором, и выводит в журнал информацию о сделанном выборе.
+
+    @return В случае успеха функция возвращает \ref ak_error_ok.                                   */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_libakrypt_dispatch_kernels( void )
+{
+  int error = ak_error_ok;
+  char message[128];
+  size_t len = 0;
+  struct cpu_kernel *kernel = ak_cpu_kernels;
+
+  memset( message, 0, sizeof( message ));
+  while( kernel->name != NULL ) {
+    if(( error = ak_libakrypt_set_kernel( kernel->name, "auto" )) != ak_error_ok )
+      return ak_error_message_fmt( error, __func__, "incorrect selection of %s kernel", kernel->name );
+    ak_snprintf( message +len, sizeof( message ) -len, "%s%s: %s", len ? ", " : "",
+                                          kernel->name, ak_libakrypt_get_kernel( kernel->name ));
+    len = strlen( message );
+    kernel++;
+  }
+  if( ak_log_get_level() >= ak_log_standard )
+    ak_error_message_fmt( ak_error_ok, __func__, "cpu kernels (%s)", message );
+
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! @return Функция возвращает количество доступных процессоров (ядер). Если количество
+    не может быть определено, возвращается единица.                                                */
+/* ----------------------------------------------------------------------------------------------- */
+ size_t ak_libakrypt_cpu_count( void )
+{
+#if defined( AK_HAVE_UNISTD_H ) && defined( _SC_NPROCESSORS_ONLN )
+  long cpus = sysconf( _SC_NPROCESSORS_ONLN );
+  return cpus > 0 ? ( size_t )cpus : 1;
+#else
+  return 1;
+#endif
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция запускает `threads` - 1 дополнительных потоков, выполняющих функцию `worker`
+    с аргументом `arg`, выполняет эту же функцию в вызывающем потоке и ожидает завершения
+    всех запущенных потоков. Функция `worker` должна самостоятельно распределять работу
+    между потоками (как правило, извлекая задания из общей очереди, защищенной мьютексом).
+
+    Если потоки не могут быть созданы или библиотека собрана без поддержки pthread, то
+    функция `worker` выполняется один раз в вызывающем потоке.
+
+    @param worker Функция, выполняемая каждым потоком.
+    @param arg Аргумент, передаваемый функции `worker`.
+    @param threads Количество потоков, включая вызывающий; нулевое значение означает,
+    что количество потоков равно количеству процессоров (см. ak_libakrypt_cpu_count()).           */
+/* ----------------------------------------------------------------------------------------------- */
+ void ak_thread_pool_run( ak_function_thread *worker, ak_pointer arg, size_t threads )
+{
+#ifdef AK_HAVE_PTHREAD_H
+  size_t i = 0, created = 0;
+  pthread_t *workers = NULL;
+
+  if( threads == 0 ) threads = ak_libakrypt_cpu_count();
+  if(( threads > 1 ) && (( workers = malloc( threads*sizeof( pthread_t ))) != NULL )) {
+    for( i = 1; i < threads; i++ )
+       if( pthread_create( workers +created, NULL, worker, arg ) == 0 ) created++;
+   /* текущий поток также участвует в вычислениях */
+    worker( arg );
+    for( i = 0; i < created; i++ ) pthread_join( workers[i], NULL );
+    free( workers );
+    return;
+  }
+#else
+  (void)threads;
+#endif
+  worker( arg );
+}
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! \param flag булева переменная; истинное значение устанавливает режим совместимости,
     ложное -- снимает.
@@ -385,6 +632,12 @@
      return ak_false;
    }
 
+ /* выбираем реализации вычислительных ядер в соответствии с возможностями процессора */
+   if(( error = ak_libakrypt_dispatch_kernels()) != ak_error_ok ) {
+     ak_error_message( error, __func__ , "incorrect selection of processor specific code" );
+     return ak_false;
+   }
+
  /* инициализируем константные таблицы для алгоритма Кузнечик */
    if(( error = ak_bckey_kuznechik_init_gost_tables()) != ak_error_ok ) {
     ak_error_message( error, __func__, "initialization of context manager is wrong" );
@@ -435,6 +688,10 @@
   if( error != ak_error_ok )
     ak_error_message( error, __func__ , "before destroing library holds an error(s)" );
 
+  ak_random_thread_local_destroy();
+  ak_verifykey_tables_destroy();
+  ak_wcurve_tables_destroy();
+
 #ifdef AK_HAVE_WINDOWS_H
   #ifdef LIBAKRYPT_NETWORK
     if( WSACleanup() != 0 )
@@ -186,6 +186,28 @@
  return error;
 }
 
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Контекст, передаваемый функции обработки фрагментов файла. */
+ struct mac_file_ctx {
+  /*! \brief Контекст итерационного сжатия. */
+   ak_mac mctx;
+  /*! \brief Область памяти для результата. */
+   ak_pointer out;
+  /*! \brief Размер области памяти для результата. */
+   size_t out_size;
+ };
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция обработки очередного фрагмента файла. */
+ static int ak_mac_file_chunk( ak_const_pointer data, const size_t size, bool_t last, ak_pointer ptr )
+{
+  struct mac_file_ctx *fctx = ptr;
+
+  if( last ) return ak_mac_finalize( fctx->mctx, ( ak_pointer )data, size,
+                                                                   fctx->out, fctx->out_size );
+ return ak_mac_update( fctx->mctx, ( ak_pointer )data, size );
+}
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! Функция вычисляет результат сжимающего отображения для заданного файла и помещает
     его в область памяти, на которую указывает out.
@@ -202,11 +224,8 @@
 /* ----------------------------------------------------------------------------------------------- */
  int ak_mac_file( ak_mac mctx, const char* filename, ak_pointer out, const size_t out_size )
 {
-  size_t len = 0;
-  struct file file;
   int error = ak_error_ok;
-  size_t block_size = 4096; /* оптимальная длина блока для Windows пока не ясна */
-  ak_uint8 *localbuffer = NULL; /* место для локального считывания информации */
+  struct mac_file_ctx fctx;
 
  /* выполняем необходимые проверки */
   if( mctx == NULL ) return ak_error_message( ak_error_null_pointer, __func__ ,
@@ -216,40 +235,19 @@
   if(( error = ak_mac_clean( mctx )) != ak_error_ok )
     return ak_error_message( error, __func__, "incorrect cleaning a mac context");
 
-  if(( error = ak_file_open_to_read( &file, filename )) != ak_error_ok )
-    return ak_error_message_fmt( error, __func__, "incorrect access to file %s", filename );
+ /* теперь обрабатываем файл с данными, последний фрагмент передается в функцию finalize */
+  fctx.mctx = mctx;
+  fctx.out = out;
+  fctx.out_size = out_size;
+  if(( error = ak_file_read_ahead( filename,
+              ( size_t ) ak_libakrypt_get_option_by_name( "file_read_chunk_size" ),
+              ( size_t ) ak_libakrypt_get_option_by_name( "file_read_buffers_count" ),
+              ( file_read_mode_t ) ak_libakrypt_get_option_by_name( "file_read_mode" ),
+                                                 ak_mac_file_chunk, &fctx )) != ak_error_ok )
+    ak_error_message_fmt( error, __func__, "incorrect processing of file %s", filename );
 
- /* для файла нулевой длины результатом будет хеш от нулевого вектора */
-  if( !file.size ) {
-    ak_file_close( &file );
-    return ak_mac_finalize( mctx, "", 0, out, out_size );
-  }
-
- /* готовим область для хранения данных */
-  block_size = ak_max( ( size_t )file.blksize, mctx->bsize );
- /* здесь мы выделяем локальный буффер для считывания/обработки данных */
-  if(( localbuffer = ( ak_uint8 * ) ak_aligned_malloc( block_size )) == NULL ) {
-    ak_file_close( &file );
-    return ak_error_message( ak_error_out_of_memory, __func__ ,
-                                                      "memory allocation error for local buffer" );
-  }
- /* теперь обрабатываем файл с данными */
-  read_label: len = ( size_t ) ak_file_read( &file, localbuffer, block_size );
-  if( len == block_size ) {
-    ak_mac_update( mctx, localbuffer, block_size ); /* добавляем считанные данные */
-    goto read_label;
-  } else {
-           size_t qcnt = len / mctx->bsize,
-                  tail = len - qcnt*mctx->bsize;
-           if( qcnt ) ak_mac_update( mctx, localbuffer, qcnt*mctx->bsize );
-           error = ak_mac_finalize( mctx,
-                                             localbuffer + qcnt*mctx->bsize, tail, out, out_size );
-         }
  /* очищаем за собой данные, содержащиеся в контексте */
   ak_mac_clean( mctx );
- /* закрываем данные */
-  ak_file_close( &file );
-  ak_aligned_free( localbuffer );
  return error;
 }
 
@@ -4,7 +4,7 @@
 /*  Файл ak_mpzn.c                                                                                 */
 /*  - содержит реализации функций для вычислений с большими целыми числами                         */
 /* ----------------------------------------------------------------------------------------------- */
- #include <libakrypt.h>
+ #include <libakrypt-internal.h>
 
 /* ----------------------------------------------------------------------------------------------- */
 /** \addtogroup math-doc Математические функции
@@ -599,17 +599,67 @@
 }
 
 /* ----------------------------------------------------------------------------------------------- */
-/*! Для вычета \f$ x = \sum_{n=0}^{s-1} a_n\cdot \left( 2^{64} \right)^n \f$ в начале вычисляется
-    последовательность \f$ r_0 = 0\f$, \f$r_1 = 2^{64} \pmod{p}\f$, \f$r_n = r_1r_{n-1} \pmod{p}\f$.
-    После это возвращается результат \f$  \sum_{n=0}^{s-1} \big( a_n*r_n \pmod{p} \big) \pmod{p}\f$.
+/*! Функция вычисляет вычет \f$ r \f$, удовлетворяющий сравнению \f$ r \equiv u \pmod{p}\f$,
+    для произвольного вычета \f$ u \f$ двойной длины, т.е. \f$ 0 \leq u < 2^{128\cdot size}\f$.
+    Используется редукция Барретта (алгоритм 14.42 из книги A. Menezes, P. van Oorschot,
+    S. Vanstone Handbook of Applied Cryptography) с заранее вычисленной константой
+    \f$ \mu = \lfloor 2^{128\cdot size}/p \rfloor \f$, которая для модулей \f$ p \f$ и \f$ q \f$
+    эллиптических кривых хранится в полях `mu` и `muq` структуры \ref wcurve.
+
+    Последовательность выполняемых операций не зависит от значения вычета \f$ u \f$:
+    завершающие вычитания модуля выполняются всегда, а их результат выбирается с помощью маски.
+
+    @param r Результат применения операции вычисления остатка от деления (size слов)
+    @param u Вычет, значение которого приводится по модулю (2*size слов)
+    @param p Модуль, по которому выполняется приведение; старшее слово модуля должно быть
+    отлично от нуля
+    @param mu Константа \f$ \mu \f$ (size+1 слов)
+    @param size Размер модуля в словах. Данная переменная должна
+    принимать значения \ref ak_mpzn256_size или \ref ak_mpzn512_size.                              */
+/* ----------------------------------------------------------------------------------------------- */
+ void ak_mpzn_rem_barrett( ak_uint64 *r, ak_uint64 *u, ak_uint64 *p,
+                                                                ak_uint64 *mu, const size_t size )
+{
+  size_t i = 0, j = 0;
+  ak_uint64 mask = 0;
+  ak_mpznmax q = ak_mpznmax_zero, t = ak_mpznmax_zero,
+             pe = ak_mpznmax_zero, s = ak_mpznmax_zero;
+
+ /* q = ( floor( u/b^{size-1} )*mu )/b^{size+1} */
+  ak_mpzn_mul( q, u +size -1, mu, size +1 );
+ /* t = ( q*p ) mod b^{size+1} */
+  for( i = 0; i < size; i++ ) pe[i] = p[i];
+  ak_mpzn_mul( t, q +size +1, pe, size +1 );
+ /* s = ( u - t ) mod b^{size+1}, при этом 0 <= s < 3p */
+  ak_mpzn_sub( s, u, t, size +1 );
+
+ /* не более двух вычитаний модуля, результат которых выбирается по маске */
+  for( j = 0; j < 2; j++ ) {
+     mask = ak_mpzn_sub( t, s, pe, size +1 ) -1;
+     for( i = 0; i <= size; i++ ) s[i] ^= ( s[i]^t[i] )&mask;
+  }
+  memcpy( r, s, size*sizeof( ak_uint64 ));
 
-   \note Реализован простейший алгоритм и, как показывают тесты, он раз в 10
-   проигрывает по скорости реализации из GMP. В качестве упражнения можно попробовать реализовать
-   этот же алгоритм, но с использованием арифметики Монтгомери. По предварительным расчетам,
-   это может дать ускорение в два раза.
+  memset( q, 0, sizeof( q ));
+  memset( t, 0, sizeof( t ));
+  memset( s, 0, sizeof( s ));
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Остаток вычисляется по схеме Горнера, начиная со старших слов вычета, без использования
+    операции деления на каждом шаге. Для этого вычет \f$ x \f$ и модуль \f$ p \f$ умножаются
+    на \f$ 2^s \f$ так, чтобы старший бит 64-х битного слова \f$ d = 2^sp \f$ был равен единице
+    (поскольку \f$ p < 2^{32} \f$, то \f$ 32 \leq s < 64\f$), и вычисляется обратная величина
+    \f$ v = \lfloor (2^{128}-1)/d \rfloor - 2^{64}\f$. Для \f$ d = 2^{32}p' \f$ она равна
+    \f$ \lfloor (2^{96}-1)/p' \rfloor - 2^{64}\f$ и находится с помощью двух делений
+    64-х битных слов на \f$ p' \f$. После этого каждое слово вычета приводится по модулю
+    \f$ d \f$ двумя умножениями (алгоритм деления двух слов на одно из работы
+    N. Möller, T. Granlund Improved division by invariant integers,
+    IEEE Transactions on Computers, 60(2):165-175, 2011).
+    Поскольку \f$ 2^sx \pmod{2^sp} = 2^s(x \pmod{p})\f$, искомый остаток получается сдвигом.
 
     @param x Вычет, который приводится по модулю
-    @param size Размер вычета в словах (значение константы ak_mpzn256_size или ak_mpzn512_size )
+    @param size Размер вычета в словах
     @param p Одноразрядное число, по модулю которого приводится вычет `x`.
     В случае, если делитель `p` равен нулю, то возвращается -1. Код ошибки может
     быть получен с помощью вызова функции ak_error_get_value().
@@ -618,25 +668,37 @@
 /* ----------------------------------------------------------------------------------------------- */
  ak_uint32 ak_mpzn_rem_uint32( ak_uint64 *x, const size_t size, ak_uint32 p )
 {
-  size_t i;
-  ak_uint64 t, r1, r = 1, sum = x[0]%p;
+  size_t i = size;
+  unsigned int shift = 32;
+  ak_uint64 d = p, v = 0, r = 0, q1 = 0, q0 = 0, u0 = 0;
 
   if( !p ) {
     ak_error_message( ak_error_invalid_value, __func__, "divide by zero" );
     return -1;
   }
-
- /* вычисляем r[i] = 2^{64i} mod (p) */
-  r1 = 9223372036854775808ull % p; r1 = ( 2*r1 )%p;
-
- /* вычисляем остаток от деления */
-  for( i = 1; i < size; i++ ) {
-    r *= r1; r %= p;
-    t = x[i]%p; t *= r; t %= p; sum += t;
+  if( !size ) return 0;
+
+ /* нормализуем модуль: d = 2^shift p, старший бит d равен единице */
+  while(( d&0x80000000LL ) == 0 ) { d <<= 1; shift++; }
+ /* v = floor( (2^96 - 1)/p' ) - 2^64, где p' = d >> 32 */
+  q1 = 0xffffffffffffffffLL/d;
+  q0 = (( 0xffffffffffffffffLL%d ) << 32 | 0xffffffffLL )/d;
+  v = ( q1 << 32 ) + q0;
+  d <<= 32;
+
+ /* старшее слово вычета, умноженного на 2^shift, меньше d */
+  r = x[i-1] >> ( 64 - shift );
+  while( i-- > 0 ) {
+    u0 = ( x[i] << shift )|( i > 0 ? x[i-1] >> ( 64 - shift ) : 0 );
+   /* (q1, q0) = v*r + (r+1, u0) */
+    umul_ppmm( q1, q0, v, r );
+    q0 += u0;
+    q1 += r +1 +( q0 < u0 );
+    r = u0 - q1*d;
+    if( r > q0 ) r += d;
+    if( r >= d ) r -= d;
   }
-  /* приведение после суммирования дает корректный результат только для небольших значений size
-     в произвольном случае здесь возникнет ошибка переполнения */
- return sum%p;
+ return ( ak_uint32 )( r >> shift );
 }
 
 /* ----------------------------------------------------------------------------------------------- */
@@ -720,23 +782,225 @@
 }
 
 /* ----------------------------------------------------------------------------------------------- */
-/*! Функция умножает два вычета x и y в представлении Монтгомери, после чего приводит полученное
-    произведение по модулю p, то есть для \f$ x \equiv x_0r \pmod{p} \f$ и
-    \f$ y \equiv y_0r \pmod{p} \f$ функция вычисляет значение,
-    удовлетворяющее сравнению \f$ z \equiv x_0y_0r \pmod{p}\f$.
-    Результат помещается в переменную z. Указатель на z может совпадать с одним из указателей на
-    перемножаемые вычеты.
+/*                  умножение вычетов фиксированной длины в представлении Монтгомери               */
+/* ----------------------------------------------------------------------------------------------- */
+#ifdef __SIZEOF_INT128__
+ #define AK_HAVE_UINT128
+/*! \brief Двойное машинное слово: беззнаковое 128-ми битное целое (расширение gcc и clang). */
+ __extension__ typedef unsigned __int128 ak_dword;
+#endif
 
-    @param z Указатель на вычет, в который помещается результат
-    @param x Левый аргумент опреации сложения
-    @param y Правый аргумент операции сложения
-    @param p Модуль, по которому производятся вычисления
-    @param n0 Константа, используемая в вычислениях. Представляет собой младшее слово
-    числа n, удовлетворяющего равенству \f$ rs - np = 1\f$.
-    @param size Размер модуля в словах (значение константы \ref ak_mpzn256_size или
-                                                                          \ref ak_mpzn512_size).   */
 /* ----------------------------------------------------------------------------------------------- */
- inline void ak_mpzn_mul_montgomery( ak_uint64 *z, ak_uint64 *x, ak_uint64 *y,
+/*! \brief Вычитание модуля из результата умножения Монтгомери.
+
+    Функция принимает значение \f$ t < 2p \f$, заданное `size` младшими словами массива `t` и
+    старшим словом `top`, и помещает в `z` величину \f$ t - p \f$ или \f$ t \f$.                  */
+/* ----------------------------------------------------------------------------------------------- */
+ static inline void ak_mpzn_montgomery_final( ak_uint64 *z, ak_uint64 *t, ak_uint64 top,
+                                                                ak_uint64 *p, const size_t size )
+{
+  size_t i = 0;
+  ak_uint64 av = 0, bv = 0, cy = 0, s[ ak_mpzn512_size ];
+
+  for( i = 0; i < size; i++ ) {
+     av = t[i];
+     bv = av - cy;
+     cy = bv > av;
+     av = bv - p[i];
+     cy += av > bv;
+     s[i] = av;
+  }
+  if( cy != top ) memcpy( z, t, size*sizeof( ak_uint64 ));
+   else memcpy( z, s, size*sizeof( ak_uint64 ));
+}
+
+#ifdef AK_HAVE_UINT128
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Умножение Монтгомери с чередованием умножения и приведения (метод CIOS).
+
+    Функция вызывается только для постоянных значений `size`, что позволяет компилятору
+    полностью развернуть циклы.                                                                    */
+/* ----------------------------------------------------------------------------------------------- */
+ static inline void ak_mpzn_mul_montgomery_cios( ak_uint64 *z, ak_uint64 *x, ak_uint64 *y,
+                                               ak_uint64 *p, ak_uint64 n0, const size_t size )
+{
+  size_t i = 0, j = 0;
+  ak_dword uv;
+  ak_uint64 c = 0, m = 0, t[ ak_mpzn512_size +2 ];
+
+  for( j = 0; j <= size; j++ ) t[j] = 0;
+  for( i = 0; i < size; i++ ) {
+    /* t <- t + x_i*y */
+     for( j = 0, c = 0; j < size; j++ ) {
+        uv = ( ak_dword )x[i]*y[j] + t[j] + c;
+        t[j] = ( ak_uint64 )uv;
+        c = ( ak_uint64 )( uv >> 64 );
+     }
+     uv = ( ak_dword )t[size] + c;
+     t[size] = ( ak_uint64 )uv;
+     t[size+1] = ( ak_uint64 )( uv >> 64 );
+
+    /* t <- ( t + m*p )/2^64 */
+     m = t[0]*n0;
+     uv = ( ak_dword )m*p[0] + t[0];
+     c = ( ak_uint64 )( uv >> 64 );
+     for( j = 1; j < size; j++ ) {
+        uv = ( ak_dword )m*p[j] + t[j] + c;
+        t[j-1] = ( ak_uint64 )uv;
+        c = ( ak_uint64 )( uv >> 64 );
+     }
+     uv = ( ak_dword )t[size] + c;
+     t[size-1] = ( ak_uint64 )uv;
+     t[size] = t[size+1] + ( ak_uint64 )( uv >> 64 );
+  }
+  ak_mpzn_montgomery_final( z, t, t[size], p, size );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Возведение в квадрат в представлении Монтгомери (метод SOS).
+
+    Произведения \f$ x_ix_j \f$ при \f$ i \neq j \f$ вычисляются один раз и удваиваются,
+    что сокращает количество умножений слов примерно на четверть по сравнению с умножением.
+    Функция используется только для восьмисловных вычетов: для четырехсловных вычетов
+    дополнительные проходы по массиву обходятся дороже сэкономленных умножений.                    */
+/* ----------------------------------------------------------------------------------------------- */
+ static inline void ak_mpzn_sqr_montgomery_sos( ak_uint64 *z, ak_uint64 *x,
+                                               ak_uint64 *p, ak_uint64 n0, const size_t size )
+{
+  size_t i = 0, j = 0;
+  ak_dword uv;
+  ak_uint64 c = 0, m = 0, hi = 0, t[ 2*ak_mpzn512_size ];
+
+  for( j = 0; j < 2*size; j++ ) t[j] = 0;
+ /* попарные произведения */
+  for( i = 0; i < size -1; i++ ) {
+     for( j = i+1, c = 0; j < size; j++ ) {
+        uv = ( ak_dword )x[i]*x[j] + t[i+j] + c;
+        t[i+j] = ( ak_uint64 )uv;
+        c = ( ak_uint64 )( uv >> 64 );
+     }
+     t[i+size] = c;
+  }
+ /* удвоение и прибавление квадратов */
+  t[2*size-1] = t[2*size-2] >> 63;
+  for( j = 2*size-2; j > 0; j-- ) t[j] = ( t[j] << 1 )|( t[j-1] >> 63 );
+  t[0] <<= 1;
+  for( i = 0, c = 0; i < size; i++ ) {
+     uv = ( ak_dword )x[i]*x[i] + t[2*i] + c;
+     t[2*i] = ( ak_uint64 )uv;
+     uv = ( ak_dword )t[2*i+1] + ( ak_uint64 )( uv >> 64 );
+     t[2*i+1] = ( ak_uint64 )uv;
+     c = ( ak_uint64 )( uv >> 64 );
+  }
+ /* приведение, перенос в старшее слово откладывается до следующего шага */
+  for( i = 0, hi = 0; i < size; i++ ) {
+     m = t[i]*n0;
+     for( j = 0, c = 0; j < size; j++ ) {
+        uv = ( ak_dword )m*p[j] + t[i+j] + c;
+        t[i+j] = ( ak_uint64 )uv;
+        c = ( ak_uint64 )( uv >> 64 );
+     }
+     uv = ( ak_dword )t[i+size] + c + hi;
+     t[i+size] = ( ak_uint64 )uv;
+     hi = ( ak_uint64 )( uv >> 64 );
+  }
+  ak_mpzn_montgomery_final( z, t +size, hi, p, size );
+}
+#endif
+
+#ifdef AK_HAVE_BUILTIN_MULX_ADX
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Шаг вычисления \f$ t \leftarrow t + a\cdot b \f$ с использованием команд mulx, adcx и adox.
+
+    Команды adcx и adox используют разные флаги переноса, что позволяет одновременно складывать
+    младшие и старшие половины произведений слов.                                                 */
+/* ----------------------------------------------------------------------------------------------- */
+ #define ak_mulx_step( cur, next, tcur, tnext, boff ) \
+   "movq " tnext "(%[t]), %%" next "\n\t"              \
+   "mulxq " boff "(%[b]), %%r8, %%r9\n\t"              \
+   "adcxq %%r8, %%" cur "\n\t"                         \
+   "adoxq %%r9, %%" next "\n\t"                        \
+   "movq %%" cur ", " tcur "(%[t])\n\t"
+
+/*! \brief Завершение вычисления \f$ t \leftarrow t + a\cdot b \f$: перенос в два старших слова. */
+ #define ak_mulx_tail( next, tnext, ttop ) \
+   "movq " ttop "(%[t]), %%r9\n\t"         \
+   "adcxq %%rcx, %%" next "\n\t"           \
+   "adoxq %%rcx, %%r9\n\t"                 \
+   "adcxq %%rcx, %%r9\n\t"                 \
+   "movq %%" next ", " tnext "(%[t])\n\t"  \
+   "movq %%r9, " ttop "(%[t])\n\t"
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Вычисление \f$ t \leftarrow t + a\cdot b \f$ для четырехсловного вычета b. */
+/* ----------------------------------------------------------------------------------------------- */
+ static inline void ak_mpzn_muladd4_adx( ak_uint64 *t, ak_uint64 a, ak_uint64 *b )
+{
+  __asm__ volatile (
+    "xorl %%ecx, %%ecx\n\t"
+    "movq 0(%[t]), %%r10\n\t"
+    ak_mulx_step( "r10", "r11", "0", "8", "0" )
+    ak_mulx_step( "r11", "r10", "8", "16", "8" )
+    ak_mulx_step( "r10", "r11", "16", "24", "16" )
+    ak_mulx_step( "r11", "r10", "24", "32", "24" )
+    ak_mulx_tail( "r10", "32", "40" )
+    :
+    : [t] "r" (t), [b] "r" (b), "d" (a)
+    : "rcx", "r8", "r9", "r10", "r11", "cc", "memory" );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Вычисление \f$ t \leftarrow t + a\cdot b \f$ для восьмисловного вычета b. */
+/* ----------------------------------------------------------------------------------------------- */
+ static inline void ak_mpzn_muladd8_adx( ak_uint64 *t, ak_uint64 a, ak_uint64 *b )
+{
+  __asm__ volatile (
+    "xorl %%ecx, %%ecx\n\t"
+    "movq 0(%[t]), %%r10\n\t"
+    ak_mulx_step( "r10", "r11", "0", "8", "0" )
+    ak_mulx_step( "r11", "r10", "8", "16", "8" )
+    ak_mulx_step( "r10", "r11", "16", "24", "16" )
+    ak_mulx_step( "r11", "r10", "24", "32", "24" )
+    ak_mulx_step( "r10", "r11", "32", "40", "32" )
+    ak_mulx_step( "r11", "r10", "40", "48", "40" )
+    ak_mulx_step( "r10", "r11", "48", "56", "48" )
+    ak_mulx_step( "r11", "r10", "56", "64", "56" )
+    ak_mulx_tail( "r10", "64", "72" )
+    :
+    : [t] "r" (t), [b] "r" (b), "d" (a)
+    : "rcx", "r8", "r9", "r10", "r11", "cc", "memory" );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Умножение Монтгомери с использованием команд mulx, adcx и adox.
+
+    На i-м шаге к окну `t + i` прибавляются произведения \f$ x_iy \f$ и \f$ mp \f$, после чего
+    младшее слово окна обращается в ноль; результат находится в старших словах массива.           */
+/* ----------------------------------------------------------------------------------------------- */
+ static inline void ak_mpzn_mul_montgomery_adx( ak_uint64 *z, ak_uint64 *x, ak_uint64 *y,
+                                               ak_uint64 *p, ak_uint64 n0, const size_t size )
+{
+  size_t i = 0;
+  ak_uint64 t[ 2*ak_mpzn512_size +2 ];
+
+  memset( t, 0, ( 2*size +2 )*sizeof( ak_uint64 ));
+  for( i = 0; i < size; i++ ) {
+     if( size == ak_mpzn256_size ) {
+       ak_mpzn_muladd4_adx( t +i, x[i], y );
+       ak_mpzn_muladd4_adx( t +i, t[i]*n0, p );
+     } else {
+       ak_mpzn_muladd8_adx( t +i, x[i], y );
+       ak_mpzn_muladd8_adx( t +i, t[i]*n0, p );
+     }
+  }
+  ak_mpzn_montgomery_final( z, t +size, t[2*size], p, size );
+}
+#endif
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Умножение Монтгомери для вычетов произвольной длины. */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_mpzn_mul_montgomery_common( ak_uint64 *z, ak_uint64 *x, ak_uint64 *y,
                                                ak_uint64 *p, ak_uint64 n0, const size_t size )
 {
   size_t i = 0, j = 0, ij = 0;
@@ -795,6 +1059,123 @@
   if( cy != t[2*size] ) memcpy( z, t+size, size*sizeof( ak_uint64 ));
 }
 
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Умножение Монтгомери для вычетов длины 256 и 512 бит без использования
+    специальных команд процессора; при совпадении множителей длины 512 бит выполняется
+    возведение в квадрат.                                                                          */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_mpzn_mul_montgomery_fixed( ak_uint64 *z, ak_uint64 *x, ak_uint64 *y,
+                                               ak_uint64 *p, ak_uint64 n0, const size_t size )
+{
+#ifdef AK_HAVE_UINT128
+  if( size == ak_mpzn256_size ) {
+    ak_mpzn_mul_montgomery_cios( z, x, y, p, n0, ak_mpzn256_size );
+    return;
+  }
+  if( x == y ) ak_mpzn_sqr_montgomery_sos( z, x, p, n0, ak_mpzn512_size );
+   else ak_mpzn_mul_montgomery_cios( z, x, y, p, n0, ak_mpzn512_size );
+#else
+  ak_mpzn_mul_montgomery_common( z, x, y, p, n0, size );
+#endif
+}
+
+#ifdef AK_HAVE_BUILTIN_MULX_ADX
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Умножение Монтгомери для вычетов длины 256 и 512 бит с использованием
+    команд mulx, adcx и adox.                                                                      */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_mpzn_mul_montgomery_mulx( ak_uint64 *z, ak_uint64 *x, ak_uint64 *y,
+                                               ak_uint64 *p, ak_uint64 n0, const size_t size )
+{
+  ak_mpzn_mul_montgomery_adx( z, x, y, p, n0, size );
+}
+#endif
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция умножения вычетов в представлении Монтгомери. */
+ typedef void ( ak_function_mpzn_mul_montgomery )( ak_uint64 * , ak_uint64 * , ak_uint64 * ,
+                                                          ak_uint64 * , ak_uint64 , const size_t );
+/*! \brief Реализация умножения Монтгомери для вычетов длины 256 и 512 бит,
+    выбираемая при инициализации библиотеки. */
+ static ak_function_mpzn_mul_montgomery *ak_mpzn_mul_montgomery_kernel =
+                                                                     ak_mpzn_mul_montgomery_fixed;
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция не проверяет, поддерживаются ли команды mulx, adcx и adox процессором; проверка
+    выполняется функцией ak_libakrypt_set_kernel().
+
+    @param adx Истинное значение устанавливает реализацию, использующую команды mulx, adcx и adox,
+    ложное - реализацию, использующую 128-ми битные целые числа.
+    @return Функция возвращает \ref ak_true, если установлена запрошенная реализация.              */
+/* ----------------------------------------------------------------------------------------------- */
+ bool_t ak_mpzn_set_montgomery_kernel( bool_t adx )
+{
+#ifdef AK_HAVE_BUILTIN_MULX_ADX
+  if( adx ) {
+    ak_mpzn_mul_montgomery_kernel = ak_mpzn_mul_montgomery_mulx;
+    return ak_true;
+  }
+#endif
+  ak_mpzn_mul_montgomery_kernel = ak_mpzn_mul_montgomery_fixed;
+ return !adx;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция умножает два вычета x и y в представлении Монтгомери, после чего приводит полученное
+    произведение по модулю p, то есть для \f$ x \equiv x_0r \pmod{p} \f$ и
+    \f$ y \equiv y_0r \pmod{p} \f$ функция вычисляет значение,
+    удовлетворяющее сравнению \f$ z \equiv x_0y_0r \pmod{p}\f$.
+    Результат помещается в переменную z. Указатель на z может совпадать с одним из указателей на
+    перемножаемые вычеты.
+
+    @param z Указатель на вычет, в который помещается результат
+    @param x Левый аргумент опреации сложения
+    @param y Правый аргумент операции сложения
+    @param p Модуль, по которому производятся вычисления
+    @param n0 Константа, используемая в вычислениях. Представляет собой младшее слово
+    числа n, удовлетворяющего равенству \f$ rs - np = 1\f$.
+    Для вычетов длины \ref ak_mpzn256_size и \ref ak_mpzn512_size используются реализации
+    с развернутыми циклами: на процессорах, поддерживающих команды mulx, adcx и adox,
+    используется ассемблерная реализация, в остальных случаях - реализация, использующая
+    128-ми битные целые числа; выбор выполняется при инициализации библиотеки
+    (см. ak_libakrypt_set_kernel()). Для остальных длин используется универсальная реализация.
+
+    @param size Размер модуля в словах (значение константы \ref ak_mpzn256_size или
+                                                                          \ref ak_mpzn512_size).   */
+/* ----------------------------------------------------------------------------------------------- */
+ inline void ak_mpzn_mul_montgomery( ak_uint64 *z, ak_uint64 *x, ak_uint64 *y,
+                                               ak_uint64 *p, ak_uint64 n0, const size_t size )
+{
+  if(( size == ak_mpzn256_size ) || ( size == ak_mpzn512_size ))
+    ak_mpzn_mul_montgomery_kernel( z, x, y, p, n0, size );
+   else ak_mpzn_mul_montgomery_common( z, x, y, p, n0, size );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция возводит в квадрат вычет x в представлении Монтгомери, то есть для
+    \f$ x \equiv x_0r \pmod{p} \f$ вычисляет значение, удовлетворяющее сравнению
+    \f$ z \equiv x_0^2r \pmod{p}\f$. Функция эквивалентна вызову
+    `ak_mpzn_mul_montgomery( z, x, x, p, n0, size )`.
+
+    Отдельный алгоритм возведения в квадрат используется только для вычетов длины
+    \ref ak_mpzn512_size в реализации, использующей 128-ми битные целые числа. Для вычетов длины
+    \ref ak_mpzn256_size, а также в реализации, использующей команды mulx, adcx и adox,
+    выполняется умножение: время вычисления определяется цепочкой приведения, длина которой
+    у квадрата та же, что и у произведения, поэтому выигрыш от сокращения числа умножений
+    слов не превышает погрешности измерений.
+
+    @param z Указатель на вычет, в который помещается результат
+    @param x Вычет, возводимый в квадрат
+    @param p Модуль, по которому производятся вычисления
+    @param n0 Константа, используемая в вычислениях (см. ak_mpzn_mul_montgomery()).
+    @param size Размер модуля в словах                                                             */
+/* ----------------------------------------------------------------------------------------------- */
+ void ak_mpzn_sqr_montgomery( ak_uint64 *z, ak_uint64 *x,
+                                               ak_uint64 *p, ak_uint64 n0, const size_t size )
+{
+  ak_mpzn_mul_montgomery( z, x, x, p, n0, size );
+}
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! Для вычета \f$ x \f$, заданного в представлении Монтгомери в виде \f$ xr \f$, где \f$ r \f$
     заданная степень двойки, вычисляется вычет \f$ z \f$,
@@ -833,7 +1214,7 @@
   for( i = s; i >= 0; i-- ) {
      uk = k[i];
      for( j = 0; j < 64; j++ ) {
-        ak_mpzn_mul_montgomery( res, res, res, p, n0, size );
+        ak_mpzn_sqr_montgomery( res, res, p, n0, size );
         if( uk&0x8000000000000000LL ) ak_mpzn_mul_montgomery( res, res, x, p, n0, size );
         uk <<= 1;
      }
@@ -841,6 +1222,253 @@
   memcpy( z, res, size*sizeof( ak_uint64 ));
 }
 
+/* ----------------------------------------------------------------------------------------------- */
+/*                 обращение вычетов в постоянное время (алгоритм Бернштейна-Янга)                 */
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Вычисление вычета \f$ p^{-1} \pmod{2^{64}}\f$ для нечетного \f$ p \f$ методом Ньютона. */
+ static inline ak_uint64 ak_mpzn_inverse_word( const ak_uint64 p )
+{
+  ak_uint64 inv = p; /* верны младшие три бита, поскольку p^2 = 1 (mod 8) */
+  inv *= 2 - p*inv; inv *= 2 - p*inv; inv *= 2 - p*inv;
+  inv *= 2 - p*inv; inv *= 2 - p*inv;
+ return inv;
+}
+
+#ifdef AK_HAVE_UINT128
+/*! \brief Двойное машинное слово со знаком (расширение gcc и clang). */
+ __extension__ typedef __int128 ak_sdword;
+
+/*! \brief Маска для выделения 62-х младших бит. */
+ #define ak_mpzn_mask62 ( 0xffffffffffffffffLL >> 2 )
+/*! \brief Максимальное количество 62-х битных слов в представлении вычета. */
+ #define ak_mpzn_signed62_size ( 64*ak_mpzn512_size/62 + 1 )
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Преобразование вычета в последовательность 62-х битных слов. */
+ static void ak_mpzn_to_signed62( ak_int64 *r, const ak_uint64 *x,
+                                                               const size_t size, const size_t len )
+{
+  size_t i, w, s;
+  ak_uint64 v;
+
+  for( i = 0; i < len; i++ ) {
+     w = ( 62*i ) >> 6; s = ( 62*i )&0x3f; v = 0;
+     if( w < size ) {
+       v = x[w] >> s;
+       if(( s > 2 ) && ( w+1 < size )) v |= x[w+1] << ( 64 - s );
+     }
+     r[i] = ( ak_int64 )( v&ak_mpzn_mask62 );
+  }
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Обратное преобразование неотрицательной последовательности 62-х битных слов. */
+ static void ak_mpzn_from_signed62( ak_uint64 *z, const ak_int64 *r,
+                                                               const size_t size, const size_t len )
+{
+  size_t i, l, s;
+
+  for( i = 0; i < size; i++ ) {
+     l = ( 64*i )/62; s = ( 64*i )%62;
+     z[i] = ( ak_uint64 )r[l] >> s;
+     if( l+1 < len ) z[i] |= ( ak_uint64 )r[l+1] << ( 62 - s );
+  }
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Выполнение 62-х шагов divstep над младшими словами \f$ f \f$ и \f$ g \f$.
+
+    Функция вычисляет матрицу перехода \f$ t = (u, v, q, r) \f$, умноженную на \f$ 2^{62} \f$,
+    и новое значение \f$ \eta = -\delta \f$. Все ветвления заменены вычислением масок,
+    поэтому время работы не зависит от обрабатываемых значений.                                   */
+/* ----------------------------------------------------------------------------------------------- */
+ static ak_int64 ak_mpzn_divsteps62( ak_int64 eta, const ak_uint64 f0,
+                                                               const ak_uint64 g0, ak_int64 *t )
+{
+  int i;
+  ak_uint64 u = 1, v = 0, q = 0, r = 1, f = f0, g = g0, x, y, w, mask1, mask2;
+
+  for( i = 0; i < 62; i++ ) {
+    /* mask1 соответствует условию delta > 0, mask2 - нечетности g */
+     mask1 = ( ak_uint64 )( eta >> 63 );
+     mask2 = 0 - ( g&1 );
+     x = ( f^mask1 ) - mask1;
+     y = ( u^mask1 ) - mask1;
+     w = ( v^mask1 ) - mask1;
+     g += x&mask2; q += y&mask2; r += w&mask2;
+    /* теперь mask1 - условие обмена (f, g) -> (g, (g-f)/2) */
+     mask1 &= mask2;
+     eta = ( eta^( ak_int64 )mask1 ) - 1 - ( ak_int64 )mask1;
+     f += g&mask1; u += q&mask1; v += r&mask1;
+     g >>= 1; u <<= 1; v <<= 1;
+  }
+  t[0] = ( ak_int64 )u; t[1] = ( ak_int64 )v;
+  t[2] = ( ak_int64 )q; t[3] = ( ak_int64 )r;
+ return eta;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Вычисление \f$ (f, g) \leftarrow t(f, g)/2^{62} \f$ (деление выполняется нацело). */
+ static void ak_mpzn_update_fg62( ak_int64 *f, ak_int64 *g, const ak_int64 *t, const size_t len )
+{
+  size_t i;
+  ak_sdword cf, cg;
+
+  cf = ( ak_sdword )t[0]*f[0] + ( ak_sdword )t[1]*g[0];
+  cg = ( ak_sdword )t[2]*f[0] + ( ak_sdword )t[3]*g[0];
+  cf >>= 62; cg >>= 62;
+  for( i = 1; i < len; i++ ) {
+     cf += ( ak_sdword )t[0]*f[i] + ( ak_sdword )t[1]*g[i];
+     cg += ( ak_sdword )t[2]*f[i] + ( ak_sdword )t[3]*g[i];
+     f[i-1] = ( ak_int64 )(( ak_uint64 )cf&ak_mpzn_mask62 ); cf >>= 62;
+     g[i-1] = ( ak_int64 )(( ak_uint64 )cg&ak_mpzn_mask62 ); cg >>= 62;
+  }
+  f[len-1] = ( ak_int64 )cf;
+  g[len-1] = ( ak_int64 )cg;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Вычисление \f$ (d, e) \leftarrow t(d, e)/2^{62} \pmod{p} \f$.
+
+    К произведению добавляется кратное модуля, обнуляющее младшие 62 бита, что позволяет
+    выполнить деление нацело. Значения \f$ d \f$ и \f$ e \f$ остаются в интервале
+    \f$ (-2p, p)\f$.                                                                              */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_mpzn_update_de62( ak_int64 *d, ak_int64 *e, const ak_int64 *t,
+                                   const ak_int64 *p, const ak_uint64 pinv, const size_t len )
+{
+  size_t i;
+  ak_sdword cd, ce;
+  ak_int64 md, me, sd = d[len-1] >> 63, se = e[len-1] >> 63;
+
+ /* для отрицательных d и e заранее добавляем модуль, умноженный на соответствующие коэффициенты */
+  md = ( t[0]&sd ) + ( t[1]&se );
+  me = ( t[2]&sd ) + ( t[3]&se );
+  cd = ( ak_sdword )t[0]*d[0] + ( ak_sdword )t[1]*e[0];
+  ce = ( ak_sdword )t[2]*d[0] + ( ak_sdword )t[3]*e[0];
+  md -= ( ak_int64 )(( pinv*( ak_uint64 )cd + ( ak_uint64 )md )&ak_mpzn_mask62 );
+  me -= ( ak_int64 )(( pinv*( ak_uint64 )ce + ( ak_uint64 )me )&ak_mpzn_mask62 );
+  cd += ( ak_sdword )p[0]*md;
+  ce += ( ak_sdword )p[0]*me;
+  cd >>= 62; ce >>= 62;
+  for( i = 1; i < len; i++ ) {
+     cd += ( ak_sdword )t[0]*d[i] + ( ak_sdword )t[1]*e[i] + ( ak_sdword )p[i]*md;
+     ce += ( ak_sdword )t[2]*d[i] + ( ak_sdword )t[3]*e[i] + ( ak_sdword )p[i]*me;
+     d[i-1] = ( ak_int64 )(( ak_uint64 )cd&ak_mpzn_mask62 ); cd >>= 62;
+     e[i-1] = ( ak_int64 )(( ak_uint64 )ce&ak_mpzn_mask62 ); ce >>= 62;
+  }
+  d[len-1] = ( ak_int64 )cd;
+  e[len-1] = ( ak_int64 )ce;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Приведение \f$ d \in (-2p, p)\f$, умноженного на знак \f$ f \f$, к интервалу \f$ [0, p)\f$. */
+ static void ak_mpzn_normalize62( ak_int64 *d, const ak_int64 sign,
+                                                               const ak_int64 *p, const size_t len )
+{
+  size_t i;
+  ak_int64 cond = d[len-1] >> 63, neg = sign >> 63;
+
+  for( i = 0; i < len; i++ ) d[i] = (( d[i] + ( p[i]&cond ))^neg ) - neg;
+  for( i = 0; i < len-1; i++ ) {
+     d[i+1] += d[i] >> 62;
+     d[i] &= ak_mpzn_mask62;
+  }
+  cond = d[len-1] >> 63;
+  for( i = 0; i < len; i++ ) d[i] += p[i]&cond;
+  for( i = 0; i < len-1; i++ ) {
+     d[i+1] += d[i] >> 62;
+     d[i] &= ak_mpzn_mask62;
+  }
+}
+#endif
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция вычисляет вычет \f$ z \f$, удовлетворяющий сравнению \f$ xz \equiv 1 \pmod{p} \f$.
+    Вычеты \f$ x \f$ и \f$ z \f$ задаются как обычные (не в представлении Монтгомери),
+    для \f$ x = 0 \f$ результат равен нулю.
+
+    Используется алгоритм Бернштейна-Янга (safegcd): выполняется фиксированное,
+    зависящее только от длины модуля, количество шагов divstep, объединенных в блоки по 62 шага,
+    при этом ни ветвления, ни обращения к памяти не зависят от значения \f$ x \f$.
+    Для модуля длины \f$ d \f$ бит выполняется \f$ \lfloor (49d + 80)/17 \rfloor \f$ шагов,
+    что гарантирует завершение алгоритма. По сравнению с возведением в степень \f$ p-2 \f$
+    функция работает в несколько раз быстрее.
+
+    При отсутствии 128-ми битного целого типа используется возведение в степень \f$ p-2 \f$.
+
+    @param z Вычет, в который помещается результат
+    @param x Обращаемый вычет, должен удовлетворять неравенству \f$ x < p\f$
+    @param p Нечетный простой модуль
+    @param size Размер модуля в словах (значение константы \ref ak_mpzn256_size
+    или \ref ak_mpzn512_size )                                                                     */
+/* ----------------------------------------------------------------------------------------------- */
+ void ak_mpzn_inverse( ak_uint64 *z, ak_uint64 *x, ak_uint64 *p, const size_t size )
+{
+  ak_uint64 pinv = ak_mpzn_inverse_word( p[0] );
+#ifdef AK_HAVE_UINT128
+  size_t i, count;
+  ak_int64 eta = -1, t[4], d[ak_mpzn_signed62_size], e[ak_mpzn_signed62_size],
+           f[ak_mpzn_signed62_size], g[ak_mpzn_signed62_size], m[ak_mpzn_signed62_size];
+  const size_t len = 64*size/62 + 1;
+
+  memset( d, 0, sizeof( d ));
+  memset( e, 0, sizeof( e )); e[0] = 1;
+  ak_mpzn_to_signed62( m, p, size, len );
+  ak_mpzn_to_signed62( f, p, size, len );
+  ak_mpzn_to_signed62( g, x, size, len );
+  pinv &= ak_mpzn_mask62;
+
+  count = (( 49*64*size + 80 )/17 + 61 )/62;
+  for( i = 0; i < count; i++ ) {
+     eta = ak_mpzn_divsteps62( eta, ( ak_uint64 )f[0], ( ak_uint64 )g[0], t );
+     ak_mpzn_update_de62( d, e, t, m, pinv, len );
+     ak_mpzn_update_fg62( f, g, t, len );
+  }
+ /* теперь g = 0, f = \pm 1 и d = \pm x^{-1} */
+  ak_mpzn_normalize62( d, f[len-1], m, len );
+  ak_mpzn_from_signed62( z, d, size, len );
+
+ /* обращаемые вычеты могут быть секретными (например, маски секретного ключа) */
+  memset( d, 0, sizeof( d ));
+  memset( e, 0, sizeof( e ));
+  memset( f, 0, sizeof( f ));
+  memset( g, 0, sizeof( g ));
+  memset( t, 0, sizeof( t ));
+#else
+  ak_mpznmax one = ak_mpznmax_one, pm2 = ak_mpznmax_zero;
+
+ /* x считается вычетом в представлении Монтгомери, тогда x^{p-2} = r^2/x */
+  pm2[0] = 2;
+  ak_mpzn_sub( pm2, p, pm2, size );
+  ak_mpzn_modpow_montgomery( z, x, pm2, p, 0 - pinv, size );
+  ak_mpzn_mul_montgomery( z, z, one, p, 0 - pinv, size );
+  ak_mpzn_mul_montgomery( z, z, one, p, 0 - pinv, size );
+#endif
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Для вычета \f$ x \f$, заданного в представлении Монтгомери, функция вычисляет
+    вычет \f$ z \f$, являющийся представлением Монтгомери вычета \f$ x^{-1} \pmod{p} \f$.
+    Результат совпадает с результатом возведения \f$ x \f$ в степень \f$ p-2 \f$ функцией
+    ak_mpzn_modpow_montgomery(), однако вычисляется в постоянное время функцией ak_mpzn_inverse().
+
+    @param z Вычет, в который помещается результат
+    @param x Обращаемый вычет в представлении Монтгомери
+    @param p Модуль, по которому производятся вычисления
+    @param n0 Константа, используемая в вычислениях умножения Монтгомери
+    @param r2 Константа \f$ r^2 \pmod{p} \f$
+    @param size Размер модуля в словах (значение константы \ref ak_mpzn256_size
+    или \ref ak_mpzn512_size )                                                                     */
+/* ----------------------------------------------------------------------------------------------- */
+ void ak_mpzn_inverse_montgomery( ak_uint64 *z, ak_uint64 *x, ak_uint64 *p,
+                                             ak_uint64 n0, ak_uint64 *r2, const size_t size )
+{
+  ak_mpzn_inverse( z, x, p, size );
+  ak_mpzn_mul_montgomery( z, z, r2, p, n0, size );
+  ak_mpzn_mul_montgomery( z, z, r2, p, n0, size );
+}
+
 /* ----------------------------------------------------------------------------------------------- */
 #ifdef AK_HAVE_GMP_H
 /* преобразование "туда и обратно" */
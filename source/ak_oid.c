@@ -55,6 +55,10 @@
  static const char *asn1_dev_urandom_n[] = { "dev-urandom", "/dev/urandom", NULL };
  static const char *asn1_dev_urandom_i[] = { "1.2.643.2.52.1.1.3", NULL };
 #endif
+#ifdef AK_HAVE_SYSRANDOM_H
+ static const char *asn1_getrandom_n[] =  { "getrandom", NULL };
+ static const char *asn1_getrandom_i[] =  { "1.2.643.2.52.1.1.8", NULL };
+#endif
 #ifdef _WIN32
  static const char *asn1_winrtl_n[] =       { "winrtl", NULL };
  static const char *asn1_winrtl_i[] =       { "1.2.643.2.52.1.1.4", NULL };
@@ -64,6 +68,9 @@
  static const char *asn1_hrng_i[] =     { "1.2.643.2.52.1.1.5", NULL };
  static const char *asn1_nlfsr_n[] =     { "nlfsr", NULL };
  static const char *asn1_nlfsr_i[] =     { "1.2.643.2.52.1.1.6", NULL };
+/* генератор на основе блочного шифра Кузнечик в режиме гаммирования */
+ static const char *asn1_drbg_kuznechik_n[] = { "ctr-drbg-kuznechik", NULL };
+ static const char *asn1_drbg_kuznechik_i[] = { "1.2.643.2.52.1.1.7", NULL };
 
  static const char *asn1_streebog256_n[] = { "streebog256", "md_gost12_256", NULL };
  static const char *asn1_streebog256_i[] = { "1.2.643.7.1.1.2.2", NULL };
@@ -526,6 +533,12 @@ static struct oid libakrypt_oids[] =
                               (ak_function_destroy_object *)ak_random_destroy, NULL, NULL, NULL },
                                                                 ak_object_undefined, NULL, NULL }},
 #endif
+#ifdef AK_HAVE_SYSRANDOM_H
+ { random_generator, algorithm, asn1_getrandom_i, asn1_getrandom_n, NULL,
+  {{ sizeof( struct random ), (ak_function_create_object *)ak_random_create_getrandom,
+                              (ak_function_destroy_object *)ak_random_destroy, NULL, NULL, NULL },
+                                                                ak_object_undefined, NULL, NULL }},
+#endif
 #ifdef _WIN32
  { random_generator, algorithm,asn1_winrtl_i, asn1_winrtl_n, NULL,
   {{ sizeof( struct random ), (ak_function_create_object *)ak_random_create_winrtl,
@@ -543,6 +556,11 @@ static struct oid libakrypt_oids[] =
                               (ak_function_destroy_object *)ak_random_destroy, NULL, NULL, NULL },
                                                                 ak_object_undefined, NULL, NULL }},
 
+ { random_generator, algorithm, asn1_drbg_kuznechik_i, asn1_drbg_kuznechik_n, NULL,
+  {{ sizeof( struct random ), (ak_function_create_object *)ak_random_create_ctr_kuznechik,
+                              (ak_function_destroy_object *)ak_random_destroy, NULL, NULL, NULL },
+                                                                ak_object_undefined, NULL, NULL }},
+
 /* добавляем идентификаторы алгоритмов */
  { hash_function, algorithm, asn1_streebog256_i, asn1_streebog256_n, NULL,
   {{ sizeof( struct hash ), ( ak_function_create_object *) ak_hash_create_streebog256,
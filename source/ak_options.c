@@ -50,6 +50,22 @@
      { "openssl_compability", 0, 0, 1 },
   /* флаг использования цвета при выводе сообщений библиотеки */
      { "use_color_output", 1, 0, 1 },
+  /* параметры опережающего чтения файлов при вычислении контрольных сумм:
+     длина одного фрагмента в октетах, количество одновременно загружаемых фрагментов
+     и способ чтения (0 - автоматически, 1 - последовательно, 2 - mmap, 3 - отдельным потоком) */
+     { "file_read_chunk_size", 1048576, 4096, 67108864 },
+     { "file_read_buffers_count", 3, 2, 8 },
+     { "file_read_mode", 0, 0, 3 },
+  /* параметры генератора ctr-drbg-kuznechik: размер внутреннего буфера выработанных значений
+     (в октетах) и объем данных, после выработки которого выполняется повторная инициализация
+     генератора значениями, полученными от операционной системы (0 - без повторной инициализации) */
+     { "random_ctr_buffer_size", 65536, 256, 1048576 },
+     { "random_ctr_reseed_interval", 1048576, 0, 4294967296 },
+  /* размер внутреннего буфера генератора getrandom (в октетах, 0 - без буферизации) */
+     { "random_getrandom_buffer_size", 4096, 0, 65536 },
+  /* количество таблиц предвычислений для открытых ключей проверки подписи, хранящихся в кэше
+     (0 - таблицы для импортируемых сертификатов не вычисляются) */
+     { "verifykey_cache_size", 16, 0, 64 },
      { NULL, 0, 0, 0 } /* завершающая константа, должна всегда принимать нулевые значения */
  };
 
@@ -20,12 +20,16 @@
  const struct wcurve id_tc26_gost_3410_2012_256_paramSetTest = {
   ak_mpzn256_size,
   1,
+  wcurve_a_generic, /* variant */
+  NULL, /* edwards */
   { 0xffffffffffffc983LL, 0xffffffffffffffffLL, 0xffffffffffffffffLL, 0x7fffffffffffffffLL }, /* a (в форме Монтгомери) */
   { 0x807bbfa323a3952aLL, 0x004469b4541a2542LL, 0x20391abe272c66adLL, 0x58df983a171cd5aeLL }, /* b (в форме Монтгомери) */
   { 0x0000000000000431LL, 0x0000000000000000LL, 0x0000000000000000LL, 0x8000000000000000LL }, /* p */
   { 0x0000000000464584LL, 0x0000000000000000LL, 0x0000000000000000LL, 0x0000000000000000LL }, /* r2 */
+  { 0xffffffffffffef3cLL, 0xffffffffffffffffLL, 0xffffffffffffffffLL, 0xffffffffffffffffLL, 0x0000000000000001LL }, /* mu */
   { 0xc59cfc193accf5b3LL, 0x50fe8a1892976154LL, 0x0000000000000001LL, 0x8000000000000000LL }, /* q */
   { 0xecaed44677f7f28dLL, 0x4af1f8ac73c6c555LL, 0xc0db8b05c83ad16aLL, 0x6e749e5b503b112aLL }, /* r2q */
+  { 0xe98c0f9b14cc2941LL, 0xbc05d79db5a27aacLL, 0xfffffffffffffffaLL, 0xffffffffffffffffLL, 0x0000000000000001LL }, /* muq */
   {
     { 0x0000000000000002LL, 0x0000000000000000LL, 0x0000000000000000LL, 0x0000000000000000LL }, /* px */
     { 0x2b96abbcea7e8fc8LL, 0x85c97f0a9ca26712LL, 0xbd6316030e16d19cLL, 0x08e2a8a0e65147d4LL }, /* py */
@@ -36,6 +40,20 @@
   "8000000000000000000000000000000000000000000000000000000000000431",
  };
 
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Параметры скрученной кривой Эдвардса, эквивалентной кривой paramSetA
+    из рекомендаций Р 50.1.114-2016.
+    \code
+      e = "1",
+      d = "0605F6B7C183FA81578BC39CFAD518132B9DF62897009AF7E522C32D6DC7BFFB"
+    \endcode                                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ static const struct ecurve id_tc26_gost_3410_2012_256_paramSetA_edwards = {
+  { 0x40c8687d966dd5b1LL, 0x1fb647d3f0757f77LL, 0xffda75588b970634LL, 0x845fa0e16716c1bbLL }, /* d */
+  { 0x2fcde5e09a6488c5LL, 0xf8126e0b03e2a022LL, 0x000962a9dd1a3e72LL, 0xdee817c7a63a4f91LL }, /* s */
+  { 0x8acc116a43bcf88cLL, 0x05490bf8a813953eLL, 0xaaa468e41743d65eLL, 0x6b65457ae683caf4LL }  /* t */
+ };
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! \brief Параметры 256-ти битной эллиптической кривой из рекомендаций Р 50.1.114-2016 (paramSetA). */
 /*! \code
@@ -50,12 +68,16 @@
  const struct wcurve id_tc26_gost_3410_2012_256_paramSetA = {
   ak_mpzn256_size,
   4, /* cofactor */
+  wcurve_a_generic, /* variant */
+  ( struct ecurve * ) &id_tc26_gost_3410_2012_256_paramSetA_edwards, /* edwards */
   { 0x6d0078e62fc81048LL, 0x94db4f98bfb73698LL, 0x75e9b60631449efdLL, 0xca0709cc398e1cd1LL }, /* a */
   { 0xacd1216d5cc63966LL, 0x534b728e6773c810LL, 0xfb4e95d31a5032feLL, 0xb76e3775f6a4aee7LL }, /* b */
   { 0xfffffffffffffd97LL, 0xffffffffffffffffLL, 0xffffffffffffffffLL, 0xffffffffffffffffLL }, /* p */
   { 0x000000000005cf11LL, 0x0000000000000000LL, 0x0000000000000000LL, 0x0000000000000000LL }, /* r2 */
+  { 0x0000000000000269LL, 0x0000000000000000LL, 0x0000000000000000LL, 0x0000000000000000LL, 0x0000000000000001LL }, /* mu */
   { 0xc115af556c360c67LL, 0x0fd8cddfc87b6635LL, 0x0000000000000000LL, 0x4000000000000000LL }, /* q */
   { 0x57cb446240dd1710LL, 0x7556091c4805caa4LL, 0xd0593365f9384bcdLL, 0x0fb1fbc48b0f0eb4LL }, /* r2q */
+  { 0xeea50aa93c9f3990LL, 0x0273220378499ca3LL, 0xffffffffffffffffLL, 0xffffffffffffffffLL, 0x0000000000000003LL }, /* muq */
   {
     { 0x8b2582fe742daa28LL, 0x658b9196932e02c7LL, 0x880923425712b2bbLL, 0x91e38443a5e82c0dLL }, /* px */
     { 0xaf268adb32322e5cLL, 0x5fde0b5344766740LL, 0x895786c4bb46e956LL, 0x32879423ab1a0375LL }, /* py */
@@ -80,12 +102,16 @@
  const struct wcurve id_rfc4357_gost_3410_2001_paramSetA = {
   ak_mpzn256_size,
   1,
+  wcurve_a_minus_three, /* variant */
+  NULL, /* edwards */
   { 0xfffffffffffff65cLL, 0xffffffffffffffffLL, 0xffffffffffffffffLL, 0xffffffffffffffffLL }, /* a */
   { 0x0000000000019016LL, 0x0000000000000000LL, 0x0000000000000000LL, 0x0000000000000000LL }, /* b */
   { 0xfffffffffffffd97LL, 0xffffffffffffffffLL, 0xffffffffffffffffLL, 0xffffffffffffffffLL }, /* p */
   { 0x000000000005cf11LL, 0x0000000000000000LL, 0x0000000000000000LL, 0x0000000000000000LL }, /* r2 */
+  { 0x0000000000000269LL, 0x0000000000000000LL, 0x0000000000000000LL, 0x0000000000000000LL, 0x0000000000000001LL }, /* mu */
   { 0x45841b09b761b893LL, 0x6c611070995ad100LL, 0xffffffffffffffffLL, 0xffffffffffffffffLL }, /* q */
   { 0x9ac2d7858e79a469LL, 0xfb07f8222e76dd52LL, 0xf74885d08a3714c6LL, 0x551fe9cb451179dbLL }, /* r2q */
+  { 0xba7be4f6489e476dLL, 0x939eef8f66a52effLL, 0x0000000000000000LL, 0x0000000000000000LL, 0x0000000000000001LL }, /* muq */
   {
     { 0x0000000000000001LL, 0x0000000000000000LL, 0x0000000000000000LL, 0x0000000000000000LL }, /* px */
     { 0x22acc99c9e9f1e14LL, 0x35294f2ddf23e3b1LL, 0x27df505a453f2b76LL, 0x8d91e471e0989cdaLL }, /* py */
@@ -110,12 +136,16 @@
  const struct wcurve id_rfc4357_gost_3410_2001_paramSetB = {
   ak_mpzn256_size,
   1,
+  wcurve_a_minus_three, /* variant */
+  NULL, /* edwards */
   { 0x0000000000004b96LL, 0x0000000000000000LL, 0x0000000000000000LL, 0x0000000000000000LL }, /* a */
   { 0x8dcc455aa9c5a084LL, 0x91ab42df6cf438a8LL, 0x8f8aa907eeac7d11LL, 0x3ce5d221f6285375LL }, /* b */
   { 0x0000000000000c99LL, 0x0000000000000000LL, 0x0000000000000000LL, 0x8000000000000000LL }, /* p */
   { 0x00000000027acdc4LL, 0x0000000000000000LL, 0x0000000000000000LL, 0x0000000000000000LL }, /* r2 */
+  { 0xffffffffffffcd9cLL, 0xffffffffffffffffLL, 0xffffffffffffffffLL, 0xffffffffffffffffLL, 0x0000000000000001LL }, /* mu */
   { 0xe497161bcc8a198fLL, 0x5f700cfff1a624e5LL, 0x0000000000000001LL, 0x8000000000000000LL }, /* q */
   { 0x29b721f4e6cd7823LL, 0x2a3104a7ea43e855LL, 0x4a2e7e2f6882cf10LL, 0x09d1d2c4e5082466LL }, /* r2q */
+  { 0x6da3a790cdd799d3LL, 0x823fcc0039676c68LL, 0xfffffffffffffffaLL, 0xffffffffffffffffLL, 0x0000000000000001LL }, /* muq */
   {
     { 0x0000000000000001LL, 0x0000000000000000LL, 0x0000000000000000LL, 0x0000000000000000LL }, /* px */
     { 0x744bf8d717717efcLL, 0xc545c9858d03ecfbLL, 0xb83d1c3eb2c070e5LL, 0x3fa8124359f96680LL }, /* py */
@@ -140,12 +170,16 @@
  const struct wcurve id_rfc4357_gost_3410_2001_paramSetC = {
   ak_mpzn256_size,
   1,
+  wcurve_a_minus_three, /* variant */
+  NULL, /* edwards */
   { 0x5ffcd69d0ae34c07LL, 0x0d9628a05ad19921LL, 0x5799e9d81848eb56LL, 0x0a1ce1dcc49b8526LL }, /* a */
   { 0x4be8a4e93bda2acfLL, 0x79cc0e3e90d382ddLL, 0x3ba4c8b01d9cc79bLL, 0x5cc73b5a966609e9LL }, /* b */
   { 0x7998f7b9022d759bLL, 0xcf846e86789051d3LL, 0xab1ec85e6b41c8aaLL, 0x9b9f605f5a858107LL }, /* p */
   { 0x409973b4c427fceaLL, 0x1017bb39c2d346c5LL, 0x186304212849c07bLL, 0x807a394ede097652LL }, /* r2 */
+  { 0xedc283cdd217b5a2LL, 0xbac48fc06398ae59LL, 0x405384d55f9f3b73LL, 0xa51f176161f1d734LL, 0x0000000000000001LL }, /* mu */
   { 0xf02f3a6598980bb9LL, 0x582ca3511eddfb74LL, 0xab1ec85e6b41c8aaLL, 0x9b9f605f5a858107LL }, /* q */
   { 0xe94faab66aba180eLL, 0x04fda8694afda24bLL, 0xc67e5d0ee96e8ed3LL, 0x7aa61b49a49d4759LL }, /* r2q */
+  { 0x90859e45ba119482LL, 0xfdb70c7fdaf6e4c0LL, 0x405384d55f9f3b74LL, 0xa51f176161f1d734LL, 0x0000000000000001LL }, /* muq */
   {
     { 0x0000000000000000LL, 0x0000000000000000LL, 0x0000000000000000LL, 0x0000000000000000LL }, /* px */
     { 0x366e550dfdb3bb67LL, 0x4d4dc440d4641a8fLL, 0x3cbf3783cd08c0eeLL, 0x41ece55743711a8cLL }, /* py */
@@ -179,12 +213,16 @@
  const struct wcurve id_axel_gost_3410_2012_256_paramSet_N0 = {
   ak_mpzn256_size,
   1,
+  wcurve_a_minus_three, /* variant */
+  NULL, /* edwards */
   { 0xFFFFFFFFFFF4856CLL, 0xFFFFFFFFFFFFFFFFLL, 0xFFFFFFFFFFFFFFFFLL, 0xFFFFFFFFFFFFFFFFLL }, /* a */
   { 0x5537E72FFE703FE3LL, 0xCB8A1CEFBFBC3F5BLL, 0x4EA3980725DF7C30LL, 0xF9C75C119775CB55LL }, /* b */
   { 0XFFFFFFFFFFFD215BLL, 0XFFFFFFFFFFFFFFFFLL, 0XFFFFFFFFFFFFFFFFLL, 0XFFFFFFFFFFFFFFFFLL }, /* p */
   { 0x000000083C369659LL, 0x0000000000000000LL, 0x0000000000000000LL, 0x0000000000000000LL }, /* r2 */
+  { 0x000000000002dea5LL, 0x0000000000000000LL, 0x0000000000000000LL, 0x0000000000000000LL, 0x0000000000000001LL }, /* mu */
   { 0x5DCC785B195C4EDBLL, 0x2C1B759991830C6BLL, 0xffffffffffffffffLL, 0xffffffffffffffffLL }, /* q */
   { 0x5F1888618BB22F59LL, 0xB1264EDCDEE377ACLL, 0xD5FFD504DC5F765DLL, 0xAF62882BAB696033LL }, /* r2q */
+  { 0xa23387a4e6a3b125LL, 0xd3e48a666e7cf394LL, 0x0000000000000000LL, 0x0000000000000000LL, 0x0000000000000001LL }, /* muq */
   {
     { 0x0000000000000002LL, 0x0000000000000000LL, 0x0000000000000000LL, 0x0000000000000000LL }, /* px */
     { 0x5567C9D87F68A17FLL, 0x4B9B88CA9EC7DA8CLL, 0x83B9F4FC84D08588LL, 0x011E47B6E40DC7F7LL }, /* py */
@@ -209,12 +247,16 @@
  const struct wcurve id_tc26_gost_3410_2012_512_paramSetTest = {
   ak_mpzn512_size,
   1,
+  wcurve_a_generic, /* variant */
+  NULL, /* edwards */
   { 0xd029a50f056849c5, 0xc102fa1830a665e5, 0x93678fa569b3c155, 0x61dff2a95e2108c5, 0x3500e30d3e698dd3, 0xb9cafa8506ed8887, 0xb1b73df28851b571, 0x3e261f7e31fc8188 }, /* a */
   { 0x3d869f8d06cde456, 0x22167b920ce0bfcb, 0xf7fdd636df3cc250, 0x45228319a5e6292d, 0xfd513828d9ad288d, 0xc7d45cb277e670aa, 0x04890c718bc5c744, 0x1a693f403fc50f21 }, /* b */
   { 0x1664bbf528be6373, 0x35b8336fac224dd8, 0x0458047e80e4546d, 0xf1d852741af4704a, 0xd4eb7c09b5d2d15d, 0x922b14b2ffb90f04, 0x550d267b6b2fee80, 0x4531acd1fe0023c7 }, /* p */
   { 0x001c10bc2d005b65, 0x4b907a71e647ee63, 0xe417d58d200c2aa0, 0x0815b9eb1e7dd300, 0xca0bc8af77c8690a, 0xfcd983cfb7c663d9, 0x01fde9ca99de0852, 0x1d887dcd9cd19c10 }, /* r2 */
+  { 0x9321403331168039, 0x3e0dbb26c5066545, 0x57c5263e503c0f91, 0x0a34c0232e5384ef, 0x3eb417dd79e484d5, 0x9c2db0b11022a258, 0xd8d804ff6796fd8e, 0xb3223079d17e4ac3, 0x0000000000000003 }, /* mu */
   { 0xd644aaf187e6e6df, 0xd86e25edbe23c595, 0x19905c5eecc423f1, 0xa82f2d7ecb1dbac7, 0xd4eb7c09b5d2d15d, 0x922b14b2ffb90f04, 0x550d267b6b2fee80, 0x4531acd1fe0023c7 }, /* q */
   { 0xb03174e56db6ba90, 0x561500cb39a9b66b, 0x929e0924887fab48, 0xe23c04dc39c8c930, 0x0cc44723bcc36979, 0xd70dfcccc3dd062f, 0x80bc9d923a08f9a9, 0x3057350e3201bb36 }, /* r2q */
+  { 0xbef0337c720d9890, 0x2c83ae595830d0ec, 0xde72763f8aea7871, 0xfa7ad69503fe08a9, 0x3eb417dd79e484d8, 0x9c2db0b11022a258, 0xd8d804ff6796fd8e, 0xb3223079d17e4ac3, 0x0000000000000003 }, /* muq */
   {
     { 0xb530f1b120248a9a, 0x8bc849977fac33b4, 0xc6b60aa7eee804e2, 0xfd60611262cd838d, 0x25f91093a68cd762, 0x5213b3b3d7057cc8, 0xf396bf6ebbfd7a6c, 0x24d19cc64572ee30 }, /* px */
     { 0x6dbb92cb1add371e, 0xdc1a18b91b24640b, 0xf7eb3351e1ee4e43, 0x83ab156d77f1496b, 0xf32447c259f39b2c, 0xcfbf061e91e5f2c3, 0x0d020613c857acdd, 0x2bb312a43bd2ce6e }, /* py */
@@ -239,12 +281,16 @@
  const struct wcurve id_tc26_gost_3410_2012_512_paramSetA = {
   ak_mpzn512_size,
   1,
+  wcurve_a_minus_three, /* variant */
+  NULL, /* edwards */
   { 0xfffffffffffff71c, 0xffffffffffffffff, 0xffffffffffffffff, 0xffffffffffffffff, 0xffffffffffffffff, 0xffffffffffffffff, 0xffffffffffffffff, 0xffffffffffffffff }, /* a */
   { 0x3e2a1b8106e8a17d, 0x3e694a40649ca74b, 0x7cd5ed6575cbfc5f, 0x84e4722c383c8743, 0x9527086e6e4db48e, 0x2d4b3fda85c534b6, 0x9d2dd3769d088dff, 0x57e4a0c5f647c2e3 }, /* b */
   { 0xfffffffffffffdc7, 0xffffffffffffffff, 0xffffffffffffffff, 0xffffffffffffffff, 0xffffffffffffffff, 0xffffffffffffffff, 0xffffffffffffffff, 0xffffffffffffffff }, /* p */
   { 0x000000000004f0b1, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000 }, /* r2 */
+  { 0x0000000000000239, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000001 }, /* mu */
   { 0xcacdb1411f10b275, 0x9b4b38abfad2b85d, 0x6ff22b8d4e056060, 0x27e69532f48d8911, 0xffffffffffffffff, 0xffffffffffffffff, 0xffffffffffffffff, 0xffffffffffffffff }, /* q */
   { 0x546775b92106e979, 0xb55cd33800ab10e6, 0x80b08b27e9cebbc7, 0xa06b76a2bae6fc86, 0xc7433579e382956f, 0xbab8be5dd7b1651d, 0xee028bf9d8ed3314, 0xb66ae6c00bebd6c3 }, /* r2q */
+  { 0x35324ebee0ef4d8b, 0x64b4c754052d47a2, 0x900dd472b1fa9f9f, 0xd8196acd0b7276ee, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000001 }, /* muq */
   {
     { 0x0000000000000003, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000 }, /* px */
     { 0x89a589cb5215f2a4, 0x8028fe5fc235f5b8, 0x3d75e6a50e3a41e9, 0xdf1626be4fd036e9, 0x778064fdcbefa921, 0xce5e1c93acf1abc1, 0xa61b8816e25450e6, 0x7503cfe87a836ae3 }, /* py */
@@ -269,12 +315,16 @@
  const struct wcurve id_tc26_gost_3410_2012_512_paramSetB = {
   ak_mpzn512_size,
   1,
+  wcurve_a_minus_three, /* variant */
+  NULL, /* edwards */
   { 0x000000000000029a, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000 }, /* a */
   { 0xdbe748c318a75dd6, 0xc954a7809097bfc1, 0x6553cd27e2d5a471, 0xb99b326049435cf3, 0xe9eac8a216d2c5e7, 0x260b45a102d0cc51, 0x8636181d6c5bd56d, 0x638259a12c5765bc }, /* b */
   { 0x000000000000006f, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x8000000000000000 }, /* p */
   { 0x000000000000c084, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000 }, /* r2 */
+  { 0xfffffffffffffe44, 0xffffffffffffffff, 0xffffffffffffffff, 0xffffffffffffffff, 0xffffffffffffffff, 0xffffffffffffffff, 0xffffffffffffffff, 0xffffffffffffffff, 0x0000000000000001 }, /* mu */
   { 0xc6346c54374f25bd, 0x8b996712101bea0e, 0xacfdb77bd9d40cfa, 0x49a1ec142565a545, 0x0000000000000001, 0x0000000000000000, 0x0000000000000000, 0x8000000000000000 }, /* q */
   { 0x3163da9749d3cb8b, 0x267d56905313f38b, 0xc55538cf997acac4, 0xb1532b08f1e25e5c, 0xc385980eb887a3f9, 0x9f96043308eeb401, 0xf96232d7a52b18fe, 0x21c65cda4cadccc0 }, /* r2q */
+  { 0xe72e4eaf22c36919, 0xd19a63b7bf9057c4, 0x4c09221098afcc15, 0xd9784faf6a696ae9, 0xfffffffffffffffa, 0xffffffffffffffff, 0xffffffffffffffff, 0xffffffffffffffff, 0x0000000000000001 }, /* muq */
   {
     { 0x0000000000000002, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000 }, /* px */
     { 0x7e21340780fe41bd, 0x28041055f94ceeec, 0x152cbcaaf8c03988, 0xdcb228fd1edf4a39, 0xbe6dd9e6c8ec7335, 0x3c123b697578c213, 0x2c071e3647a8940f, 0x1a8f7eda389b094c }, /* py */
@@ -285,6 +335,20 @@
   "8000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000006f",
  };
 
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Параметры скрученной кривой Эдвардса, эквивалентной кривой paramSetC
+    из рекомендаций Р 50.1.114-2016.
+    \code
+      e = "1",
+      d = "9E4F5D8C017D8D9F13A5CF3CDF5BFE4DAB402D54198E31EBDE28A0621050439CA6B39E0A515C06B304E2CE43E79E369E91A0CFC2BC2A22B4CA302DBB33EE7550"
+    \endcode                                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ static const struct ecurve id_tc26_gost_3410_2012_512_paramSetC_edwards = {
+  { 0x6515a5166d05caf7, 0xae6dc7d439a723d5, 0xdc1c74edcea76671, 0x853a44eed58ae3e5, 0xc84c79f64266472e, 0xa1a4bfeccd0cf540, 0xab899e4c73783aa1, 0xde66ec2f500fc692 }, /* d */
+  { 0xa6ba96ba64be8cb4, 0x94648e0af196370a, 0x88f8e2c48c562663, 0x5eb16ec44a9d4706, 0xcdece1826f666e34, 0x9796d004ccbcc2af, 0x551d986ce321f157, 0x486644f42bfc0e5b }, /* s */
+  { 0xe62e462e6780f788, 0x9d124bf8b44685f8, 0xfa04be27a2713bbd, 0x163460d278ec7b50, 0x76b769a90b110bdd, 0xf0461ffcccd77e35, 0x71ec450cbde95f1a, 0x2511275d3802a118 }  /* t */
+ };
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! \brief Параметры 512-ти битной эллиптической кривой из рекомендаций Р 50.1.114-2016 (paramSetC). */
 /*! \code
@@ -299,12 +363,16 @@
  const struct wcurve id_tc26_gost_3410_2012_512_paramSetC = {
   ak_mpzn512_size,
   4,
+  wcurve_a_generic, /* variant */
+  ( struct ecurve * ) &id_tc26_gost_3410_2012_512_paramSetC_edwards, /* edwards */
   { 0xd341ab3699869915, 0x3d6c9273ccebc4c1, 0x486b484c83cb0726, 0x9a8145b812d1a7b0, 0x2003251cadf8effa, 0x6b20d9f8b7db94f1, 0xdd0c19f57c9cc019, 0x408aa82ae77985ca }, /* a */
   { 0xb304002a3c03ce62, 0xcbe7bfdf359dc095, 0x57398fea29abadad, 0x3ce46aec38657034, 0xabf0edb5e37f775e, 0x63ccffc5280e7697, 0x6754d90e93579656, 0xc9b558b380cc6f00 }, /* b */
   { 0xfffffffffffffdc7, 0xffffffffffffffff, 0xffffffffffffffff, 0xffffffffffffffff, 0xffffffffffffffff, 0xffffffffffffffff, 0xffffffffffffffff, 0xffffffffffffffff }, /* p */
   { 0x000000000004f0b1, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000 }, /* r2 */
+  { 0x0000000000000239, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000001 }, /* mu */
   { 0x94623cef47f023ed, 0xc8eda9e7a769a126, 0x4c33a9ff5147502c, 0xc98cdba46506ab00, 0xffffffffffffffff, 0xffffffffffffffff, 0xffffffffffffffff, 0x3fffffffffffffff }, /* q */
   { 0xe58fa18ee6ca4eb6, 0xe79280282d956fca, 0xd016086ec2d4f903, 0x542f8f3fa490666a, 0x04f77045db49adc9, 0x314e0a57f445b20e, 0x8910352f3bea2192, 0x394c72054d8503be }, /* r2q */
+  { 0xb9dc310b80fdc132, 0x712561858965ed96, 0x3cc5600aeb8afd33, 0x673245b9af954ffb, 0x0000000000000003, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000004 }, /* muq */
   {
     { 0xc5bc7928c1950148, 0xc6fb85487eae97aa, 0xa7b9033db9ed3610, 0xa27272a7ae602bf2, 0xd385f7074cea043a, 0x2295b7a9cbaef021, 0xebe241ce593ef5de, 0xe2e31edfc23de7bd }, /* px */
     { 0xd0396e9a9addc40f, 0x04f726aa854bae07, 0xef32d85822423b63, 0xe18e2d33e3021ed2, 0x8c108c3d2090ff9b, 0x7939804d6527378b, 0xabbccff5911cb857, 0xf5ce40d95b5eb899 }, /* py */
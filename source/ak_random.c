@@ -4,7 +4,7 @@
 /*  Файл ak_random.с                                                                               */
 /*  - содержит реализацию генераторов псевдо-случайных чисел                                       */
 /* ----------------------------------------------------------------------------------------------- */
- #include <libakrypt.h>
+ #include <libakrypt-internal.h>
 
 /* ----------------------------------------------------------------------------------------------- */
 #ifdef AK_HAVE_TIME_H
@@ -19,6 +19,15 @@
 #ifdef AK_HAVE_STDLIB_H
  #include <stdlib.h>
 #endif
+#ifdef AK_HAVE_ERRNO_H
+ #include <errno.h>
+#endif
+#ifdef AK_HAVE_SYSRANDOM_H
+ #include <sys/random.h>
+#endif
+#ifdef AK_HAVE_PTHREAD_H
+ #include <pthread.h>
+#endif
 
 /* ----------------------------------------------------------------------------------------------- */
 /*! \brief Инициализация генератора псевдо-случайных чисел.
@@ -399,6 +408,240 @@
 }
 #endif
 
+/* ----------------------------------------------------------------------------------------------- */
+/*                         отслеживание копирования процесса вызовом fork()                        */
+/* ----------------------------------------------------------------------------------------------- */
+#ifdef AK_HAVE_PTHREAD_H
+/*! \brief Мьютекс, защищающий общие данные генераторов. */
+ static pthread_mutex_t ak_random_mutex = PTHREAD_MUTEX_INITIALIZER;
+/*! \brief Признак однократной регистрации обработчиков вызова fork(). */
+ static pthread_once_t ak_random_fork_once = PTHREAD_ONCE_INIT;
+/*! \brief Признак успешной регистрации обработчиков вызова fork(). */
+ static bool_t ak_random_fork_handlers = ak_false;
+/*! \brief Количество вызовов fork(), выполненных в истории данного процесса. */
+ static volatile ak_uint64 ak_random_forks = 0;
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Обработчики вызова fork(): мьютекс захватывается до копирования процесса, поэтому
+    в дочернем процессе он всегда находится в согласованном состоянии.                            */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_random_fork_prepare( void ) { pthread_mutex_lock( &ak_random_mutex ); }
+ static void ak_random_fork_parent( void ) { pthread_mutex_unlock( &ak_random_mutex ); }
+ static void ak_random_fork_child( void )
+{
+  ak_random_forks++;
+  pthread_mutex_unlock( &ak_random_mutex );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_random_fork_init( void )
+{
+  if( pthread_atfork( ak_random_fork_prepare, ak_random_fork_parent, ak_random_fork_child ) == 0 )
+    ak_random_fork_handlers = ak_true;
+}
+#endif
+
+/* ----------------------------------------------------------------------------------------------- */
+ static inline void ak_random_lock( void )
+{
+#ifdef AK_HAVE_PTHREAD_H
+  pthread_mutex_lock( &ak_random_mutex );
+#endif
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+ static inline void ak_random_unlock( void )
+{
+#ifdef AK_HAVE_PTHREAD_H
+  pthread_mutex_unlock( &ak_random_mutex );
+#endif
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Метка изменяется в дочернем процессе после вызова fork(), что позволяет обнаружить
+    копирование состояния генератора или других секретных данных, которые не должны
+    использоваться одновременно в двух процессах.
+
+    При наличии поддержки потоков метка равна количеству вызовов fork() и определяется
+    без обращения к операционной системе; в остальных случаях используется getpid().
+
+    @return Функция возвращает метку текущего процесса.                                            */
+/* ----------------------------------------------------------------------------------------------- */
+ ak_uint64 ak_random_fork_stamp( void )
+{
+#ifdef AK_HAVE_PTHREAD_H
+  pthread_once( &ak_random_fork_once, ak_random_fork_init );
+  if( ak_random_fork_handlers ) return ak_random_forks;
+#endif
+#ifdef AK_HAVE_UNISTD_H
+  return ( ak_uint64 )getpid();
+#else
+  return 0;
+#endif
+}
+
+#ifdef AK_HAVE_SYSRANDOM_H
+/* ----------------------------------------------------------------------------------------------- */
+/*                          генератор, использующий системный вызов getrandom()                    */
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Внутреннее состояние генератора getrandom. */
+ typedef struct random_system {
+  /*! \brief массив полученных от операционной системы значений */
+   ak_uint8 *buffer;
+  /*! \brief размер массива (в октетах) */
+   size_t size;
+  /*! \brief текущее количество доступных для выдачи октетов */
+   size_t capacity;
+  /*! \brief метка процесса, в котором был заполнен массив */
+   ak_uint64 stamp;
+ } *ak_random_system;
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Получение заданного количества октетов с помощью системного вызова getrandom().
+    Вызов повторяется, если он был прерван сигналом или вернул меньше запрошенного.                */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_random_getrandom_fill( ak_uint8 *out, const size_t size )
+{
+  size_t done = 0;
+
+  while( done < size ) {
+    ssize_t result = getrandom( out +done, size -done, 0 );
+    if( result < 0 ) {
+     #ifdef AK_HAVE_ERRNO_H
+      if( errno == EINTR ) continue;
+     #endif
+      return ak_error_read_data;
+    }
+    done += ( size_t )result;
+  }
+
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Выработка случайных данных.
+
+    Запросы, объем которых меньше размера внутреннего буфера, обслуживаются из буфера;
+    выданные октеты буфера сразу же обнуляются. Запросы большего объема, а также все запросы
+    при нулевом размере буфера, передаются операционной системе напрямую.
+    Если после заполнения буфера был выполнен вызов fork(), его содержимое уничтожается.
+
+    @param rnd контекст генератора
+    @param ptr указатель на область памяти, куда помещаются случайные данные
+    @param size размер данных (в байтах)
+    @return В случае успеха, функция возвращает \ref ak_error_ok. В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_random_getrandom_random( ak_random rnd, const ak_pointer ptr, const ssize_t size )
+{
+  ak_uint8 *outbuf = ptr, *from = NULL;
+  size_t cursize = ( size_t )size, len = 0;
+  ak_random_system ctx = NULL;
+
+  if( rnd == NULL ) return ak_error_message( ak_error_null_pointer, __func__ ,
+                                                     "use a null pointer to a random generator" );
+  if( ptr == NULL ) return ak_error_message( ak_error_null_pointer, __func__ ,
+                                                                   "use a null pointer to data" );
+  if( size <= 0 ) return ak_error_message( ak_error_zero_length, __func__ ,
+                                                                 "use a data with wrong length" );
+  if(( ctx = (ak_random_system) rnd->data.ctx ) == NULL )
+   return ak_error_message( ak_error_undefined_value, __func__, "using non initialized context" );
+
+ /* буфер был скопирован в дочерний процесс */
+  if(( ctx->capacity > 0 ) && ( ctx->stamp != ak_random_fork_stamp())) {
+    memset( ctx->buffer, 0, ctx->size );
+    ctx->capacity = 0;
+  }
+
+  while( cursize > 0 ) {
+     if( ctx->capacity == 0 ) {
+      /* большой объем данных запрашивается у операционной системы напрямую */
+       if( cursize >= ctx->size ) {
+         if( ak_random_getrandom_fill( outbuf, cursize ) != ak_error_ok )
+           return ak_error_message( ak_error_read_data, __func__ ,
+                                                          "wrong reading data from getrandom()" );
+         break;
+       }
+       if( ak_random_getrandom_fill( ctx->buffer, ctx->size ) != ak_error_ok )
+         return ak_error_message( ak_error_read_data, __func__ ,
+                                                          "wrong reading data from getrandom()" );
+       ctx->capacity = ctx->size;
+       ctx->stamp = ak_random_fork_stamp();
+     }
+     len = ak_min( cursize, ctx->capacity );
+     from = ctx->buffer + ( ctx->size - ctx->capacity );
+     memcpy( outbuf, from, len );
+     memset( from, 0, len );
+     ctx->capacity -= len;
+     cursize -= len;
+     outbuf += len;
+  }
+
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Освобождение внутреннего состояния генератора getrandom. */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_random_getrandom_free( ak_random rnd )
+{
+  ak_random_system ctx = NULL;
+  if( rnd == NULL ) return ak_error_message( ak_error_null_pointer, __func__ ,
+                                                     "use a null pointer to a random generator" );
+  if(( ctx = (ak_random_system) rnd->data.ctx ) != NULL ) {
+    if( ctx->buffer != NULL ) {
+      memset( ctx->buffer, 0, ctx->size );
+      free( ctx->buffer );
+    }
+    memset( ctx, 0, sizeof( struct random_system ));
+    free( ctx );
+    rnd->data.ctx = NULL;
+  }
+
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Генератор получает случайные значения от операционной системы с помощью системного
+    вызова getrandom(). В отличие от генератора dev-urandom, он не использует файловый дескриптор
+    (и, следовательно, работает при отсутствии каталога /dev, например, в chroot окружении),
+    а запросы небольшого объема обслуживает из внутреннего буфера, размер которого
+    определяется опцией `random_getrandom_buffer_size`. Тем самым, системный вызов выполняется
+    однократно для серии небольших запросов.
+
+    @param rnd контекст создаваемого генератора
+    @return В случае успеха, функция возвращает \ref ak_error_ok. В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_random_create_getrandom( ak_random rnd )
+{
+  int error = ak_error_ok;
+  ak_random_system ctx = NULL;
+  ak_int64 size = ak_libakrypt_get_option_by_name( "random_getrandom_buffer_size" );
+
+  if(( error = ak_random_create( rnd )) != ak_error_ok )
+    return ak_error_message( error, __func__ , "wrong initialization of random generator" );
+
+  if(( rnd->data.ctx = ctx = calloc( 1, sizeof( struct random_system ))) == NULL ) {
+    ak_random_destroy( rnd );
+    return ak_error_message( ak_error_out_of_memory, __func__, "incorrect memory allocation" );
+  }
+  ctx->size = size > 0 ? ( size_t )size : 0;
+  if(( ctx->size > 0 ) && (( ctx->buffer = calloc( 1, ctx->size )) == NULL )) {
+    free( ctx ); rnd->data.ctx = NULL;
+    ak_random_destroy( rnd );
+    return ak_error_message( ak_error_out_of_memory, __func__, "incorrect memory allocation" );
+  }
+
+  rnd->oid = ak_oid_find_by_name( "getrandom" );
+  rnd->next = NULL;
+  rnd->randomize_ptr = NULL;
+  rnd->random = ak_random_getrandom_random;
+  rnd->free = ak_random_getrandom_free;
+
+ return error;
+}
+#endif
 
 /* ----------------------------------------------------------------------------------------------- */
 /*                                 реализация класса rng_winrtl                                    */
@@ -895,6 +1138,630 @@
  return error;
 }
 
+/* ----------------------------------------------------------------------------------------------- */
+/*                            реализация класса ctr-drbg-kuznechik                                 */
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Класс для хранения внутренних состояний генератора ctr-drbg-kuznechik */
+ typedef struct random_ctr {
+  /*! \brief ключ блочного шифра Кузнечик */
+   struct bckey key;
+  /*! \brief текущее значение счетчика */
+   ak_uint64 counter[2];
+  /*! \brief массив выработанных значений */
+   ak_uint8 *buffer;
+  /*! \brief размер массива выработанных значений (в октетах) */
+   size_t size;
+  /*! \brief текущее количество доступных для выдачи октетов */
+   size_t capacity;
+  /*! \brief объем данных, выработанных с момента последней инициализации (в октетах) */
+   ak_uint64 generated;
+  /*! \brief объем данных, после выработки которого выполняется повторная инициализация */
+   ak_uint64 interval;
+  /*! \brief общий объем выданных генератором данных (в октетах) */
+   ak_uint64 served;
+  /*! \brief количество повторных инициализаций значениями операционной системы */
+   ak_uint64 reseeds;
+ } *ak_random_ctr;
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция получает от операционной системы случайные значения для инициализации генератора.
+    Используется системный вызов getrandom(), при его отсутствии - системный генератор
+    (/dev/urandom или crypto-провайдер Windows). Если ни один из источников недоступен,
+    возвращается ошибка: предсказуемые значения (например, вырабатываемые функцией
+    ak_random_value()) не могут использоваться для инициализации генератора.                      */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_random_ctr_entropy( ak_uint8 *out, const size_t size )
+{
+  struct random generator;
+#ifdef AK_HAVE_SYSRANDOM_H
+  if( ak_random_getrandom_fill( out, size ) == ak_error_ok ) return ak_error_ok;
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+  if( ak_random_create_urandom( &generator ) == ak_error_ok ) {
+#elif defined(_WIN32)
+  if( ak_random_create_winrtl( &generator ) == ak_error_ok ) {
+#else
+  if( ak_false ) {
+#endif
+    int error = ak_random_ptr( &generator, out, ( ssize_t )size );
+    ak_random_destroy( &generator );
+    if( error == ak_error_ok ) return ak_error_ok;
+  }
+
+ return ak_error_message( ak_error_read_data, __func__,
+                                        "operating system does not provide random values" );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Увеличение 128-ми битного счетчика на единицу. */
+ static inline void ak_random_ctr_increment( ak_uint64 *counter )
+{
+  if(( ++counter[0] ) == 0 ) counter[1]++;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция обновления ключа и счетчика генератора.
+
+    Вырабатываются три очередных блока гаммы, которые (после сложения с дополнительными данными,
+    если они заданы) используются в качестве нового значения ключа (32 октета) и
+    счетчика (16 октетов). Тем самым, после выработки очередного фрагмента данных,
+    предыдущие выходные значения не могут быть восстановлены по текущему состоянию генератора.
+
+    @param ctx внутреннее состояние генератора
+    @param data дополнительные данные длины 48 октетов (может принимать значение NULL)
+    @return В случае успеха, функция возвращает \ref ak_error_ok. В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_random_ctr_update( ak_random_ctr ctx, const ak_uint8 *data )
+{
+  size_t i = 0;
+  int error = ak_error_ok;
+  ak_uint8 temp[48];
+
+  for( i = 0; i < sizeof( temp ); i += 16 ) {
+     ak_random_ctr_increment( ctx->counter );
+     ctx->key.encrypt( &ctx->key.key, ctx->counter, temp +i );
+  }
+  if( data != NULL ) for( i = 0; i < sizeof( temp ); i++ ) temp[i] ^= data[i];
+
+  if(( error = ak_bckey_set_key( &ctx->key, temp, 32 )) != ak_error_ok )
+    ak_error_message( error, __func__, "incorrect assigning of new secret key value" );
+  memcpy( ctx->counter, temp +32, 16 );
+  ak_ptr_wipe( temp, sizeof( temp ), &ctx->key.key.generator );
+
+ return error;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Инициализация внутреннего состояния генератора заданными 48 октетами.
+    Ключ и счетчик обнуляются, после чего выполняется их обновление с использованием
+    заданных данных.                                                                               */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_random_ctr_instantiate( ak_random_ctr ctx, const ak_uint8 *seed )
+{
+  int error = ak_error_ok;
+  ak_uint8 zero[32];
+
+  memset( zero, 0, sizeof( zero ));
+  if(( error = ak_bckey_set_key( &ctx->key, zero, sizeof( zero ))) != ak_error_ok )
+    return ak_error_message( error, __func__, "incorrect assigning of initial secret key value" );
+  ctx->counter[0] = ctx->counter[1] = 0;
+  if(( error = ak_random_ctr_update( ctx, seed )) != ak_error_ok )
+    return ak_error_message( error, __func__, "incorrect update of internal state" );
+
+ /* выработанные ранее данные более не используются */
+  ak_ptr_wipe( ctx->buffer, ctx->size, &ctx->key.key.generator );
+  ctx->capacity = 0;
+  ctx->generated = 0;
+
+ return error;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Повторная инициализация генератора значениями, полученными от операционной системы.
+    Полученные значения добавляются к текущему состоянию генератора.                               */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_random_ctr_reseed( ak_random_ctr ctx )
+{
+  int error = ak_error_ok;
+  ak_uint8 seed[48];
+
+  memset( seed, 0, sizeof( seed ));
+  if(( error = ak_random_ctr_entropy( seed, sizeof( seed ))) == ak_error_ok )
+    error = ak_random_ctr_update( ctx, seed );
+  ak_ptr_wipe( seed, sizeof( seed ), &ctx->key.key.generator );
+  if( error != ak_error_ok ) return ak_error_message( error, __func__, "incorrect reseeding" );
+  ctx->generated = 0;
+  ctx->reseeds++;
+
+ return error;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция вырабатывает новый фрагмент выходных значений генератора.
+
+    При необходимости, перед выработкой, генератор повторно инициализируется значениями,
+    полученными от операционной системы. После выработки фрагмента ключ и счетчик обновляются.
+
+    @param rnd контекст генератора псевдослучайных чисел
+    @return В случае успеха, функция возвращает \ref ak_error_ok. В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_random_ctr_next( ak_random rnd )
+{
+  size_t i = 0;
+  int error = ak_error_ok;
+  ak_random_ctr ctx = NULL;
+
+  if( rnd == NULL ) return ak_error_message( ak_error_null_pointer, __func__ ,
+                                                     "use a null pointer to a random generator" );
+  if(( ctx = (ak_random_ctr) rnd->data.ctx ) == NULL )
+   return ak_error_message( ak_error_undefined_value, __func__, "using non initialized context" );
+
+ /* повторная инициализация генератора */
+  if(( ctx->interval > 0 ) && ( ctx->generated >= ctx->interval )) {
+    if(( error = ak_random_ctr_reseed( ctx )) != ak_error_ok ) return error;
+  }
+
+ /* вырабатываем фрагмент гаммы */
+  for( i = 0; i < ctx->size; i += 16 ) {
+     ak_random_ctr_increment( ctx->counter );
+     ctx->key.encrypt( &ctx->key.key, ctx->counter, ctx->buffer +i );
+  }
+  ctx->capacity = ctx->size;
+  ctx->generated += ctx->size;
+
+ return ak_random_ctr_update( ctx, NULL );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Инициализация генератора заданным значением.
+
+    Внутреннее состояние генератора вычисляется как хеш-код Стрибог512 от заданных данных,
+    поэтому последовательность выходных значений полностью определяется ими
+    (если повторная инициализация значениями операционной системы отключена опцией
+    `random_ctr_reseed_interval`).
+
+    @param rnd контекст генератора псевдослучайных чисел
+    @param ptr указатель на данные, которыми инициализируется генератор
+    @param size размер данных (в байтах)
+    @return В случае успеха, функция возвращает \ref ak_error_ok. В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_random_ctr_randomize_ptr( ak_random rnd, const ak_pointer ptr, const ssize_t size )
+{
+  struct hash hctx;
+  ak_uint8 seed[64];
+  int error = ak_error_ok;
+  ak_random_ctr ctx = NULL;
+
+  if( rnd == NULL ) return ak_error_message( ak_error_null_pointer, __func__ ,
+                                                     "use a null pointer to a random generator" );
+  if(( ctx = (ak_random_ctr) rnd->data.ctx ) == NULL )
+   return ak_error_message( ak_error_undefined_value, __func__, "using non initialized context" );
+
+  if(( error = ak_hash_create_streebog512( &hctx )) != ak_error_ok )
+    return ak_error_message( error, __func__ , "incorrect creation of hash function context" );
+  if(( error = ak_hash_ptr( &hctx, ptr, ( size_t )size, seed, sizeof( seed ))) != ak_error_ok )
+    ak_error_message( error, __func__, "incorrect hashing of input data" );
+   else error = ak_random_ctr_instantiate( ctx, seed );
+  ak_hash_destroy( &hctx );
+  ak_ptr_wipe( seed, sizeof( seed ), &ctx->key.key.generator );
+
+ return error;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Выработка псевдо-случайных данных.
+
+    Данные выдаются из внутреннего буфера; выданные октеты буфера сразу же обнуляются.
+
+    @param rnd контекст генератора псевдослучайных чисел
+    @param ptr указатель на область памяти, куда помещаются случайные данные
+    @param size размер данных (в байтах)
+    @return В случае успеха, функция возвращает \ref ak_error_ok. В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_random_ctr_random( ak_random rnd, const ak_pointer ptr, const ssize_t size )
+{
+  int error = ak_error_ok;
+  size_t cursize = ( size_t )size, len = 0;
+  ak_uint8 *outbuf = ptr, *from = NULL;
+  ak_random_ctr ctx = NULL;
+
+  if( rnd == NULL ) return ak_error_message( ak_error_null_pointer, __func__ ,
+                                                     "use a null pointer to a random generator" );
+  if(( ctx = (ak_random_ctr) rnd->data.ctx ) == NULL )
+   return ak_error_message( ak_error_undefined_value, __func__, "using non initialized context" );
+
+  while( cursize > 0 ) {
+     if( ctx->capacity == 0 ) {
+       if(( error = rnd->next( rnd )) != ak_error_ok )
+         return ak_error_message( error, __func__, "incorrect generation of internal buffer" );
+     }
+     len = ak_min( cursize, ctx->capacity );
+     from = ctx->buffer + ( ctx->size - ctx->capacity );
+     memcpy( outbuf, from, len );
+     memset( from, 0, len );
+     ctx->capacity -= len;
+     ctx->served += len;
+     cursize -= len;
+     outbuf += len;
+  }
+
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Освобождение внутреннего состояния генератора. */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_random_ctr_free( ak_random rnd )
+{
+  ak_random_ctr ctx = NULL;
+  if( rnd == NULL ) return ak_error_message( ak_error_null_pointer, __func__ ,
+                                                     "use a null pointer to a random generator" );
+  if(( ctx = (ak_random_ctr) rnd->data.ctx ) != NULL ) {
+    if( ctx->buffer != NULL ) {
+      memset( ctx->buffer, 0, ctx->size );
+      free( ctx->buffer );
+    }
+    ak_bckey_destroy( &ctx->key );
+    memset( ctx, 0, sizeof( struct random_ctr ));
+    free( ctx );
+    rnd->data.ctx = NULL;
+  }
+
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Генератор вырабатывает последовательность псевдо-случайных значений, зашифровывая значения
+    128-ми битного счетчика на ключе блочного шифра Кузнечик, аналогично генератору CTR_DRBG
+    из NIST SP 800-90A. Выходные значения вырабатываются фрагментами, длина которых
+    определяется опцией `random_ctr_buffer_size`; после выработки каждого фрагмента
+    ключ и счетчик генератора заменяются новыми значениями.
+
+    При создании генератор инициализируется значениями, полученными от операционной
+    системы (функция getrandom()); повторная инициализация выполняется после выработки
+    количества октетов, определяемого опцией `random_ctr_reseed_interval`. Если операционная
+    система не предоставляет случайных значений, то создание генератора, как и выработка
+    данных после исчерпания интервала повторной инициализации, завершается ошибкой.
+
+    @param rnd контекст генератора псевдослучайных чисел
+    @return В случае успеха, функция возвращает \ref ak_error_ok. В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_random_create_ctr_kuznechik( ak_random rnd )
+{
+  ak_uint8 seed[48];
+  int error = ak_error_ok;
+  ak_random_ctr ctx = NULL;
+  ak_int64 size = ak_libakrypt_get_option_by_name( "random_ctr_buffer_size" ),
+           interval = ak_libakrypt_get_option_by_name( "random_ctr_reseed_interval" );
+
+  if(( error = ak_random_create( rnd )) != ak_error_ok )
+    return ak_error_message( error, __func__ , "wrong initialization of random generator" );
+
+ /* выделяем память под внутренний контекст генератора */
+  if(( rnd->data.ctx = ctx = calloc( 1, sizeof( struct random_ctr ))) == NULL ) {
+    ak_random_destroy( rnd );
+    return ak_error_message( ak_error_out_of_memory, __func__, "incorrect memory allocation" );
+  }
+  if( size < 256 ) size = 65536;
+  ctx->size = (( size_t )size ) &( ~( size_t )15 );
+  ctx->interval = interval > 0 ? ( ak_uint64 )interval : 0;
+  if(( ctx->buffer = calloc( 1, ctx->size )) == NULL ) {
+    free( ctx ); rnd->data.ctx = NULL;
+    ak_random_destroy( rnd );
+    return ak_error_message( ak_error_out_of_memory, __func__, "incorrect memory allocation" );
+  }
+  if(( error = ak_bckey_create_kuznechik( &ctx->key )) != ak_error_ok ) {
+    free( ctx->buffer ); free( ctx ); rnd->data.ctx = NULL;
+    ak_random_destroy( rnd );
+    return ak_error_message( error, __func__ , "incorrect creation of block cipher key" );
+  }
+
+ /* устанавливаем обработчики событий */
+  rnd->oid = ak_oid_find_by_name( "ctr-drbg-kuznechik" );
+  rnd->next = ak_random_ctr_next;
+  rnd->randomize_ptr = ak_random_ctr_randomize_ptr;
+  rnd->random = ak_random_ctr_random;
+  rnd->free = ak_random_ctr_free;
+
+ /* инициализируем начальное состояние значениями операционной системы */
+  memset( seed, 0, sizeof( seed ));
+  if(( error = ak_random_ctr_entropy( seed, sizeof( seed ))) == ak_error_ok )
+    error = ak_random_ctr_instantiate( ctx, seed );
+  ak_ptr_wipe( seed, sizeof( seed ), &ctx->key.key.generator );
+  if( error != ak_error_ok ) {
+    ak_error_message( error, __func__, "incorrect initialization of internal state" );
+    ak_random_destroy( rnd );
+  }
+
+ return error;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*                     генераторы псевдо-случайных чисел, связанные с потоками                     */
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Генератор, связанный с потоком выполнения. */
+ typedef struct random_thread {
+  /*! \brief генератор ctr-drbg-kuznechik (должен быть первым полем структуры) */
+   struct random generator;
+  /*! \brief метка процесса, в котором генератор был инициализирован */
+   ak_uint64 stamp;
+  /*! \brief объем выданных данных, уже учтенный в общей статистике */
+   ak_uint64 served;
+  /*! \brief количество повторных инициализаций, уже учтенное в общей статистике */
+   ak_uint64 reseeds;
+ } *ak_random_thread;
+
+/*! \brief Общая статистика использования генераторов. */
+ static struct random_thread_stat ak_random_thread_totals = { 0, 0, 0, 0, 0 };
+/*! \brief Интервал повторной инициализации генераторов (отрицательное значение означает,
+    что используется значение опции `random_ctr_reseed_interval`). */
+ static volatile ak_int64 ak_random_thread_interval = -1;
+
+#ifdef AK_HAVE_PTHREAD_H
+/*! \brief Ключ, по которому поток получает доступ к своему генератору. */
+ static pthread_key_t ak_random_thread_key;
+/*! \brief Признак однократного создания ключа. */
+ static pthread_once_t ak_random_thread_once = PTHREAD_ONCE_INIT;
+/*! \brief Код ошибки, возникшей при создании ключа. */
+ static int ak_random_thread_key_error = ak_error_ok;
+#else
+/*! \brief Единственный генератор (при отсутствии поддержки потоков). */
+ static ak_random_thread ak_random_thread_single = NULL;
+#endif
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Перенос накопленных генератором значений в общую статистику. */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_random_thread_flush( ak_random_thread th )
+{
+  ak_random_ctr ctx = ( ak_random_ctr ) th->generator.data.ctx;
+
+  ak_random_lock();
+  ak_random_thread_totals.served += ctx->served - th->served;
+  ak_random_thread_totals.reseeds += ctx->reseeds - th->reseeds;
+  ak_random_unlock();
+  th->served = ctx->served;
+  th->reseeds = ctx->reseeds;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Повторная инициализация генератора, состояние которого было скопировано
+    в дочерний процесс вызовом fork().
+
+    Проверка выполняется при каждой выработке данных, поэтому указатель на генератор,
+    полученный до вызова fork(), может использоваться и в дочернем процессе: ранее выработанные,
+    но не выданные данные уничтожаются, а генератор инициализируется значениями
+    операционной системы.                                                                          */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_random_thread_check_fork( ak_random_thread th )
+{
+  int error = ak_error_ok;
+  ak_uint64 stamp = ak_random_fork_stamp();
+  ak_random_ctr ctx = ( ak_random_ctr ) th->generator.data.ctx;
+
+  if( th->stamp == stamp ) return ak_error_ok;
+  if( ctx == NULL )
+   return ak_error_message( ak_error_undefined_value, __func__, "using non initialized context" );
+
+  ak_ptr_wipe( ctx->buffer, ctx->size, &ctx->key.key.generator );
+  ctx->capacity = 0;
+  if(( error = ak_random_ctr_reseed( ctx )) != ak_error_ok )
+    return ak_error_message( error, __func__, "incorrect reseeding after fork" );
+  th->stamp = stamp;
+  ak_random_lock();
+  ak_random_thread_totals.forks++;
+  ak_random_unlock();
+
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Выработка нового фрагмента данных с одновременным обновлением общей статистики. */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_random_thread_next( ak_random rnd )
+{
+  int error = ak_error_ok;
+
+  if( rnd == NULL ) return ak_error_message( ak_error_null_pointer, __func__ ,
+                                                     "use a null pointer to a random generator" );
+  if(( error = ak_random_thread_check_fork(( ak_random_thread ) rnd )) != ak_error_ok )
+    return error;
+  ak_random_thread_flush(( ak_random_thread ) rnd );
+ return ak_random_ctr_next( rnd );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Выработка псевдо-случайных данных с проверкой вызова fork(). */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_random_thread_random( ak_random rnd, const ak_pointer ptr, const ssize_t size )
+{
+  int error = ak_error_ok;
+
+  if( rnd == NULL ) return ak_error_message( ak_error_null_pointer, __func__ ,
+                                                     "use a null pointer to a random generator" );
+  if(( error = ak_random_thread_check_fork(( ak_random_thread ) rnd )) != ak_error_ok )
+    return error;
+ return ak_random_ctr_random( rnd, ptr, size );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Уничтожение генератора, связанного с потоком. */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_random_thread_free( void *ptr )
+{
+  ak_random_thread th = ( ak_random_thread ) ptr;
+  if( th == NULL ) return;
+
+  ak_random_thread_flush( th );
+  ak_random_lock();
+  ak_random_thread_totals.generators--;
+  ak_random_unlock();
+  ak_random_destroy( &th->generator );
+  free( th );
+}
+
+#ifdef AK_HAVE_PTHREAD_H
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Однократное создание ключа, по которому потоки получают доступ к генераторам. */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_random_thread_init( void )
+{
+  if( pthread_key_create( &ak_random_thread_key, ak_random_thread_free ) != 0 )
+    ak_random_thread_key_error = ak_error_undefined_value;
+}
+#endif
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция возвращает генератор ctr-drbg-kuznechik, принадлежащий вызывающему потоку.
+    Генератор создается при первом обращении из потока и уничтожается автоматически
+    при завершении потока (генератор основного потока уничтожается функцией ak_libakrypt_destroy()).
+    Поскольку генератор используется только одним потоком, обращение к нему не требует
+    синхронизации.
+
+    Если после создания генератора был выполнен вызов fork(), то при первой выработке данных
+    в дочернем процессе генератор повторно инициализируется значениями операционной системы,
+    а ранее выработанные, но не выданные данные уничтожаются. Тем самым родительский и дочерний
+    процессы не получают одинаковых последовательностей, в том числе в случае, когда указатель
+    на генератор был получен до вызова fork().
+
+    Интервал повторной инициализации является общим для всех генераторов и задается
+    функцией ak_random_thread_local_set_reseed_interval().
+
+    \note Возвращаемый генератор не должен уничтожаться с помощью ak_random_destroy(),
+    а указатель на него не должен передаваться другим потокам.
+
+    @return Указатель на генератор. В случае возникновения ошибки возвращается NULL,
+    а код ошибки может быть получен с помощью функции ak_error_get_value().                        */
+/* ----------------------------------------------------------------------------------------------- */
+ ak_random ak_random_thread_local( void )
+{
+  int error = ak_error_ok;
+  ak_random_ctr ctx = NULL;
+  ak_random_thread th = NULL;
+  ak_int64 interval = ak_random_thread_interval;
+
+#ifdef AK_HAVE_PTHREAD_H
+  pthread_once( &ak_random_thread_once, ak_random_thread_init );
+  if( ak_random_thread_key_error != ak_error_ok ) {
+    ak_error_message( ak_random_thread_key_error, __func__,
+                                                   "incorrect creation of thread specific key" );
+    return NULL;
+  }
+  th = ( ak_random_thread ) pthread_getspecific( ak_random_thread_key );
+#else
+  th = ak_random_thread_single;
+#endif
+
+ /* создаем генератор при первом обращении */
+  if( th == NULL ) {
+    if(( th = calloc( 1, sizeof( struct random_thread ))) == NULL ) {
+      ak_error_message( ak_error_out_of_memory, __func__, "incorrect memory allocation" );
+      return NULL;
+    }
+    if(( error = ak_random_create_ctr_kuznechik( &th->generator )) != ak_error_ok ) {
+      ak_error_message( error, __func__, "incorrect creation of random generator" );
+      free( th );
+      return NULL;
+    }
+    th->generator.next = ak_random_thread_next;
+    th->generator.random = ak_random_thread_random;
+    th->stamp = ak_random_fork_stamp();
+   #ifdef AK_HAVE_PTHREAD_H
+    if( pthread_setspecific( ak_random_thread_key, th ) != 0 ) {
+      ak_error_message( ak_error_undefined_value, __func__,
+                                                  "incorrect binding of generator to thread" );
+      ak_random_destroy( &th->generator );
+      free( th );
+      return NULL;
+    }
+   #else
+    ak_random_thread_single = th;
+   #endif
+    ak_random_lock();
+    ak_random_thread_totals.generators++;
+    ak_random_thread_totals.created++;
+    ak_random_unlock();
+  }
+  ctx = ( ak_random_ctr ) th->generator.data.ctx;
+
+ /* применяем общий интервал повторной инициализации */
+  if( interval >= 0 ) ctx->interval = ( ak_uint64 )interval;
+
+ return &th->generator;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Установленное значение применяется ко всем генераторам, возвращаемым функцией
+    ak_random_thread_local(), при очередном обращении к ним.
+
+    @param interval объем данных (в октетах), после выработки которого генератор повторно
+    инициализируется значениями операционной системы; нулевое значение отключает
+    повторную инициализацию.
+    @return Функция возвращает \ref ak_error_ok.                                                   */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_random_thread_local_set_reseed_interval( const ak_uint64 interval )
+{
+  ak_random_thread_interval = ( ak_int64 )ak_min( interval, ( ak_uint64 )0x7fffffffffffffffLL );
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Значения, накопленные генератором вызывающего потока, учитываются полностью;
+    значения остальных генераторов учитываются при выработке ими очередного фрагмента
+    данных и при завершении потоков.
+
+    @param stat указатель на структуру, в которую помещается статистика
+    @return В случае успеха, функция возвращает \ref ak_error_ok. В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_random_thread_local_get_stat( ak_random_thread_stat stat )
+{
+  ak_random_thread th = NULL;
+
+  if( stat == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                            "using null pointer to statistics" );
+#ifdef AK_HAVE_PTHREAD_H
+  pthread_once( &ak_random_thread_once, ak_random_thread_init );
+  if( ak_random_thread_key_error == ak_error_ok )
+    th = ( ak_random_thread ) pthread_getspecific( ak_random_thread_key );
+#else
+  th = ak_random_thread_single;
+#endif
+  if( th != NULL ) ak_random_thread_flush( th );
+
+  ak_random_lock();
+  *stat = ak_random_thread_totals;
+  ak_random_unlock();
+
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция уничтожает генератор, связанный с вызывающим потоком (если он был создан). */
+/* ----------------------------------------------------------------------------------------------- */
+ void ak_random_thread_local_destroy( void )
+{
+#ifdef AK_HAVE_PTHREAD_H
+  ak_random_thread th = NULL;
+
+  pthread_once( &ak_random_thread_once, ak_random_thread_init );
+  if( ak_random_thread_key_error != ak_error_ok ) return;
+  if(( th = ( ak_random_thread ) pthread_getspecific( ak_random_thread_key )) != NULL ) {
+    pthread_setspecific( ak_random_thread_key, NULL );
+    ak_random_thread_free( th );
+  }
+#else
+  ak_random_thread_free( ak_random_thread_single );
+  ak_random_thread_single = NULL;
+#endif
+}
+
 /* ----------------------------------------------------------------------------------------------- */
 /*                                                                                    ak_random.c  */
 /* ----------------------------------------------------------------------------------------------- */
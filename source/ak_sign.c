@@ -9,6 +9,28 @@
 #ifdef AK_HAVE_TIME_H
  #include <time.h>
 #endif
+#ifdef AK_HAVE_STDLIB_H
+ #include <stdlib.h>
+#endif
+#ifdef AK_HAVE_PTHREAD_H
+ #include <pthread.h>
+#endif
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Приведение вычета \f$ x \f$ по модулю порядка \f$ q \f$ подгруппы точек кривой.
+
+    Вычет дополняется нулями до двойной длины и приводится с помощью редукции Барретта,
+    время выполнения которой не зависит от значения \f$ x \f$; используется для секретных
+    значений и хеш-кодов, интерпретируемых как вычеты.                                            */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_wcurve_rem_q( ak_uint64 *r, ak_uint64 *x, ak_wcurve wc )
+{
+  ak_mpznmax u = ak_mpznmax_zero;
+
+  memcpy( u, x, wc->size*sizeof( ak_uint64 ));
+  ak_mpzn_rem_barrett( r, u, wc->q, wc->muq, wc->size );
+  memset( u, 0, sizeof( u ));
+}
 
 /* ----------------------------------------------------------------------------------------------- */
 /*! \brief Установление или изменение маски секретного ключа ассиметричного криптографического
@@ -37,7 +59,7 @@
 #ifndef AK_LITTLE_ENDIAN
   int i = 0;
 #endif
-  ak_mpznmax u, zeta;
+  ak_mpznmax zeta;
   ak_wcurve wc = NULL;
   int error = ak_error_ok;
   ak_uint64 *key = NULL, *mask = NULL;
@@ -71,19 +93,16 @@
 #endif
 
     /* приводим случайное число по модулю q и сразу считаем, что это число в представлении Монтгомери */
-     ak_mpzn_rem( mask, mask, wc->q, wc->size );
+     ak_wcurve_rem_q( mask, mask, wc );
 
     /* приводим значение ключа по модулю q, а потом переводим в представление Монтгомери
        при этом мы предполагаем, что значение ключа установлено в естественном представлении */
-     ak_mpzn_rem( key, key, wc->q, wc->size );
+     ak_wcurve_rem_q( key, key, wc );
      ak_mpzn_mul_montgomery( key, key, wc->r2q, wc->q, wc->nq, wc->size);
      ak_mpzn_mul_montgomery( key, key, mask, wc->q, wc->nq, wc->size);
 
     /* вычисляем обратное значение для маски */
-     ak_mpzn_set_ui( u, wc->size, 2 );
-     ak_mpzn_sub( u, wc->q, u, wc->size );
-     ak_mpzn_modpow_montgomery( mask, // m <- m^{q-2} (mod q)
-                                    mask, u, wc->q, wc->nq, wc->size );
+     ak_mpzn_inverse_montgomery( mask, mask, wc->q, wc->nq, wc->r2q, wc->size ); // m <- m^{-1} (mod q)
     /* меняем значение флага */
      skey->flags |= key_flag_set_mask;
 
@@ -95,14 +114,12 @@
        return ak_error_message( error, __func__ , "wrong mask generation for key buffer" );
 
     /* приводим случайное число по модулю q и сразу считаем, что это число в представлении Монтгомери */
-     ak_mpzn_rem( zeta, zeta, wc->q, wc->size );
+     ak_wcurve_rem_q( zeta, zeta, wc );
 
     /* домножаем ключ на случайное число */
      ak_mpzn_mul_montgomery( key, key, zeta, wc->q, wc->nq, wc->size );
     /* вычисляем обратное значение zeta */
-     ak_mpzn_set_ui( u, wc->size, 2 );
-     ak_mpzn_sub( u, wc->q, u, wc->size );
-     ak_mpzn_modpow_montgomery( zeta, zeta, u, wc->q, wc->nq, wc->size ); // z <- z^{q-2} (mod q)
+     ak_mpzn_inverse_montgomery( zeta, zeta, wc->q, wc->nq, wc->r2q, wc->size ); // z <- z^{-1} (mod q)
 
     /* домножаем маску на обратное значение zeta */
      ak_mpzn_mul_montgomery( mask, mask, zeta, wc->q, wc->nq, wc->size );
@@ -407,6 +424,7 @@
   int error = ak_error_ok;
   if( sctx == NULL ) return ak_error_message( ak_error_null_pointer, __func__ ,
                            "destroying a null pointer to digital signature secret key context" );
+  ak_signkey_nonce_pool_destroy( sctx );
   if(( error = ak_skey_destroy( &sctx->key )) != ak_error_ok )
     ak_error_message( error, __func__ , "incorrect destroying of digital signature secret key" );
   if(( error = ak_hash_destroy( &sctx->ctx )) != ak_error_ok )
@@ -552,6 +570,48 @@
  return ak_error_ok;
 }
 
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Вычисление второй половинки подписи \f$ s \equiv rd + ke \pmod{q}\f$ по известным
+    значениям \f$ r \f$ и \f$ k \f$ (в представлении Монтгомери) и экспорт подписи
+    \f$ (r, s) \f$; после вычисления маска секретного ключа изменяется.                            */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_signkey_sign_finish( ak_signkey sctx, ak_uint64 *r, ak_uint64 *km,
+                                                                  ak_uint64 *e, ak_pointer out )
+{
+  ak_mpzn512 s, t, u;
+  ak_wcurve wc = ( ak_wcurve ) sctx->key.data;
+
+ /* приводим r к виду Монтгомери и помещаем во временную переменную t <- r */
+  ak_mpzn_mul_montgomery( t, r, wc->r2q, wc->q, wc->nq, wc->size );
+
+ /* вычисляем значение s <- r*d (mod q) (сначала домножаем на ключ, потом на его маску) */
+  ak_mpzn_mul_montgomery( s, t, (ak_uint64 *)sctx->key.key, wc->q, wc->nq, wc->size );
+  ak_mpzn_mul_montgomery( s, s,
+              (ak_uint64 *)(sctx->key.key+sctx->key.key_size), wc->q, wc->nq, wc->size );
+
+ /* приводим e к виду Монтгомери и помещаем во временную переменную u <- e */
+  ak_wcurve_rem_q( u, e, wc );
+  if( ak_mpzn_cmp_ui( u, wc->size, 0 )) ak_mpzn_set_ui( u, wc->size, 1 );
+  ak_mpzn_mul_montgomery( u, u, wc->r2q, wc->q, wc->nq, wc->size );
+
+ /* вычисляем k*e (mod q) и вычисляем s = r*d + k*e (mod q) (в форме Монтгомери) */
+  ak_mpzn_mul_montgomery( t, km, u, wc->q, wc->nq, wc->size ); /* t <- k*e */
+  ak_mpzn_add_montgomery( s, s, t, wc->q, wc->size );
+
+ /* приводим s к обычной форме */
+  ak_mpzn_mul_montgomery( s, s,  wc->point.z, /* для экономии памяти пользуемся равенством z = 1 */
+                                 wc->q, wc->nq, wc->size );
+ /* экспортируем результат */
+  ak_mpzn_to_little_endian( s, wc->size, out, sizeof(ak_uint64)*wc->size, ak_true );
+  ak_mpzn_to_little_endian( r, wc->size, (ak_uint64 *)out + wc->size,
+                                                             sizeof(ak_uint64)*wc->size, ak_true );
+ /* завершаемся */
+  sctx->key.set_mask( &sctx->key );
+  memset( s, 0, sizeof( ak_mpzn512 ));
+  memset( t, 0, sizeof( ak_mpzn512 ));
+  memset( u, 0, sizeof( ak_mpzn512 ));
+}
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! Функция вырабатывает электронную подпись для \f$ e \f$ - вычисленного хеш-кода подписываемого
     сообщения и заданного случайного числа \f$ k \f$. Для этого
@@ -588,48 +648,379 @@
 /* ----------------------------------------------------------------------------------------------- */
  void ak_signkey_sign_const_values( ak_signkey sctx, ak_uint64 *k, ak_uint64 *e, ak_pointer out )
 {
-  ak_mpzn512 r, s;
+  ak_mpzn512 r, km;
   struct wpoint wr;
   ak_wcurve wc = ( ak_wcurve ) sctx->key.data;
 
  /* поскольку функция не экспортируется, мы оставляем все проверки функциям верхнего уровня */
  /* вычисляем r */
-  ak_wpoint_pow( &wr, &wc->point, k, wc->size, wc );
+  ak_wpoint_pow_base( &wr, k, wc );
   ak_wpoint_reduce( &wr, wc );
   ak_mpzn_rem( r, wr.x, wc->q, wc->size );
 
- /* приводим r к виду Монтгомери и помещаем во временную переменную wr.x <- r */
-  ak_mpzn_mul_montgomery( wr.x, r, wc->r2q, wc->q, wc->nq, wc->size );
+ /* приводим k к виду Монтгомери и вычисляем подпись */
+  ak_mpzn_mul_montgomery( km, k, wc->r2q, wc->q, wc->nq, wc->size );
+  ak_signkey_sign_finish( sctx, r, km, e, out );
 
- /* вычисляем значение s <- r*d (mod q) (сначала домножаем на ключ, потом на его маску) */
-  ak_mpzn_mul_montgomery( s, wr.x, (ak_uint64 *)sctx->key.key, wc->q, wc->nq, wc->size );
-  ak_mpzn_mul_montgomery( s, s,
-              (ak_uint64 *)(sctx->key.key+sctx->key.key_size), wc->q, wc->nq, wc->size );
+  memset( &wr, 0, sizeof( struct wpoint ));
+  memset( r, 0, sizeof( ak_mpzn512 ));
+  memset( km, 0, sizeof( ak_mpzn512 ));
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*                   пул заранее вычисленных значений (k, r) для выработки подписи                 */
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Заранее вычисленные значения, используемые для выработки одной подписи.
+
+    Случайное число \f$ k \f$ хранится в маскированном виде, аналогично секретному ключу:
+    хранятся значения \f$ km \pmod{q} \f$ и \f$ m^{-1} \pmod{q} \f$ в представлении Монтгомери,
+    где \f$ m \f$ - случайная маска.                                                               */
+ typedef struct signkey_nonce {
+  /*! \brief Значение \f$ r \equiv x_C \pmod{q} \f$, где \f$ C = [k]P \f$. */
+   ak_mpzn512 r;
+  /*! \brief Маскированное значение \f$ km \f$. */
+   ak_mpzn512 k;
+  /*! \brief Обратное значение маски \f$ m^{-1} \f$. */
+   ak_mpzn512 mask;
+ } *ak_signkey_nonce;
+
+/*! \brief Пул заранее вычисленных значений, связанный с секретным ключом. */
+ typedef struct signkey_nonce_pool {
+  /*! \brief Эллиптическая кривая, для которой вычисляются значения. */
+   ak_wcurve wc;
+  /*! \brief Максимальное количество значений в пуле. */
+   size_t capacity;
+  /*! \brief Текущее количество значений в пуле. */
+   size_t count;
+  /*! \brief Массив значений. */
+   ak_signkey_nonce nonces;
+  /*! \brief Метка процесса, в котором были вычислены значения (см. ak_random_fork_stamp()). */
+   ak_uint64 stamp;
+ #ifdef AK_HAVE_PTHREAD_H
+  /*! \brief Признак того, что пул заполняется фоновым потоком. */
+   bool_t background;
+  /*! \brief Признак завершения работы фонового потока. */
+   bool_t stop;
+  /*! \brief Фоновый поток, заполняющий пул. */
+   pthread_t thread;
+  /*! \brief Мьютекс, защищающий массив значений. */
+   pthread_mutex_t mutex;
+  /*! \brief Условная переменная, сигнализирующая об извлечении значения из пула
+      или о необходимости завершения работы фонового потока. */
+   pthread_cond_t cond;
+ #endif
+ } *ak_signkey_nonce_pool;
 
- /* приводим k к виду Монтгомери и помещаем во временную переменную wr.y <- k */
-  ak_mpzn_mul_montgomery( wr.y, k, wc->r2q, wc->q, wc->nq, wc->size );
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Выработка случайного числа \f$ k \f$, вычисление \f$ r \f$ и маскирование \f$ k \f$.
+    Для выработки случайных значений используется генератор, связанный с текущим потоком
+    (см. ak_random_thread_local()).                                                                */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_signkey_nonce_create( ak_signkey_nonce nc, ak_wcurve wc )
+{
+  int error = ak_error_ok;
+  struct wpoint wr;
+  ak_mpzn512 k;
+  ak_random generator = ak_random_thread_local();
 
- /* приводим e к виду Монтгомери и помещаем во временную переменную wr.z <- e */
-  ak_mpzn_rem( wr.z, e, wc->q, wc->size );
-  if( ak_mpzn_cmp_ui( wr.z, wc->size, 0 )) ak_mpzn_set_ui( wr.z, wc->size, 1 );
-  ak_mpzn_mul_montgomery( wr.z, wr.z, wc->r2q, wc->q, wc->nq, wc->size );
+  if( generator == NULL ) return ak_error_message( ak_error_get_value(), __func__,
+                                                  "incorrect access to thread random generator" );
+  memset( k, 0, sizeof( ak_mpzn512 ));
+  if((( error = ak_mpzn_set_random_modulo( k, wc->q, wc->size, generator )) != ak_error_ok ) ||
+     (( error = ak_mpzn_set_random_modulo( nc->mask, wc->q, wc->size, generator )) != ak_error_ok ))
+    return ak_error_message( error, __func__ , "invalid generation of random value" );
+  if( ak_mpzn_cmp_ui( nc->mask, wc->size, 0 )) ak_mpzn_set_ui( nc->mask, wc->size, 1 );
 
- /* вычисляем k*e (mod q) и вычисляем s = r*d + k*e (mod q) (в форме Монтгомери) */
-  ak_mpzn_mul_montgomery( wr.y, wr.y, wr.z, wc->q, wc->nq, wc->size ); /* wr.y <- k*e */
-  ak_mpzn_add_montgomery( s, s, wr.y, wc->q, wc->size );
+ /* вычисляем r */
+  ak_wpoint_pow_base( &wr, k, wc );
+  ak_wpoint_reduce( &wr, wc );
+  ak_mpzn_rem( nc->r, wr.x, wc->q, wc->size );
 
- /* приводим s к обычной форме */
-  ak_mpzn_mul_montgomery( s, s,  wc->point.z, /* для экономии памяти пользуемся равенством z = 1 */
-                                 wc->q, wc->nq, wc->size );
- /* экспортируем результат */
-  ak_mpzn_to_little_endian( s, wc->size, out, sizeof(ak_uint64)*wc->size, ak_true );
-  ak_mpzn_to_little_endian( r, wc->size, (ak_uint64 *)out + wc->size,
-                                                             sizeof(ak_uint64)*wc->size, ak_true );
- /* завершаемся */
+ /* маскируем k: случайное число m сразу считаем записанным в представлении Монтгомери */
+  ak_mpzn_mul_montgomery( nc->k, k, wc->r2q, wc->q, wc->nq, wc->size );
+  ak_mpzn_mul_montgomery( nc->k, nc->k, nc->mask, wc->q, wc->nq, wc->size );
+  ak_mpzn_inverse_montgomery( nc->mask, nc->mask, wc->q, wc->nq, wc->r2q, wc->size );
+
+  memset( k, 0, sizeof( ak_mpzn512 ));
   memset( &wr, 0, sizeof( struct wpoint ));
-  sctx->key.set_mask( &sctx->key );
-  memset( r, 0, sizeof( ak_mpzn512 ));
-  memset( s, 0, sizeof( ak_mpzn512 ));
+ return ak_error_ok;
+}
+
+#ifdef AK_HAVE_PTHREAD_H
+/*! \brief Мьютекс, упорядочивающий восстановление пулов в дочернем процессе. */
+ static pthread_mutex_t ak_signkey_nonce_pool_fork_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Уничтожение значений пула, скопированных в дочерний процесс.
+
+    После вызова fork() родительский и дочерний процессы получают одинаковые копии пула.
+    Использование одного значения \f$ k \f$ для подписи двух различных сообщений позволяет
+    вычислить секретный ключ, поэтому в дочернем процессе все значения пула уничтожаются.
+
+    Фоновый поток в дочерний процесс не копируется. Если в момент вызова fork() мьютекс пула
+    был захвачен другим потоком, то в дочернем процессе он останется захваченным навсегда,
+    а состояние условной переменной не определено. Поэтому функция вызывается до блокировки
+    пула и в дочернем процессе инициализирует мьютекс и условную переменную заново.
+    В родительском процессе метка не изменяется, и функция сводится к одному сравнению.         */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_signkey_nonce_pool_check_fork( ak_signkey_nonce_pool pool )
+{
+  ak_uint64 stamp = ak_random_fork_stamp();
+
+  if( pool->stamp == stamp ) return;
+ #ifdef AK_HAVE_PTHREAD_H
+  pthread_mutex_lock( &ak_signkey_nonce_pool_fork_mutex );
+  if( pool->stamp != stamp ) {
+    pthread_mutex_init( &pool->mutex, NULL );
+    pthread_cond_init( &pool->cond, NULL );
+    pool->background = ak_false;
+    pool->stop = ak_false;
+ #endif
+    memset( pool->nonces, 0, pool->capacity*sizeof( struct signkey_nonce ));
+    pool->count = 0;
+    pool->stamp = stamp;
+ #ifdef AK_HAVE_PTHREAD_H
+  }
+  pthread_mutex_unlock( &ak_signkey_nonce_pool_fork_mutex );
+ #endif
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Извлечение из пула одного значения; извлеченное значение удаляется из пула.
+    \return Функция возвращает истину, если значение было извлечено, и ложь, если пул пуст.       */
+/* ----------------------------------------------------------------------------------------------- */
+ static bool_t ak_signkey_nonce_pool_pop( ak_signkey_nonce_pool pool, ak_signkey_nonce nc )
+{
+  bool_t result = ak_false;
+
+  ak_signkey_nonce_pool_check_fork( pool );
+ #ifdef AK_HAVE_PTHREAD_H
+  pthread_mutex_lock( &pool->mutex );
+ #endif
+  if( pool->count > 0 ) {
+    ak_signkey_nonce top = pool->nonces +( --pool->count );
+    memcpy( nc, top, sizeof( struct signkey_nonce ));
+    memset( top, 0, sizeof( struct signkey_nonce ));
+    result = ak_true;
+  }
+ #ifdef AK_HAVE_PTHREAD_H
+  pthread_cond_signal( &pool->cond );
+  pthread_mutex_unlock( &pool->mutex );
+ #endif
+ return result;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Помещение значения в пул, если пул не заполнен.
+    \return Функция возвращает истину, если значение помещено в пул.                              */
+/* ----------------------------------------------------------------------------------------------- */
+ static bool_t ak_signkey_nonce_pool_push( ak_signkey_nonce_pool pool, ak_signkey_nonce nc )
+{
+  bool_t result = ak_false;
+
+  ak_signkey_nonce_pool_check_fork( pool );
+ #ifdef AK_HAVE_PTHREAD_H
+  pthread_mutex_lock( &pool->mutex );
+ #endif
+  if( pool->count < pool->capacity ) {
+    memcpy( pool->nonces +( pool->count++ ), nc, sizeof( struct signkey_nonce ));
+    result = ak_true;
+  }
+ #ifdef AK_HAVE_PTHREAD_H
+  pthread_mutex_unlock( &pool->mutex );
+ #endif
+  memset( nc, 0, sizeof( struct signkey_nonce ));
+ return result;
+}
+
+#ifdef AK_HAVE_PTHREAD_H
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция фонового потока, дополняющего пул по мере извлечения из него значений. */
+/* ----------------------------------------------------------------------------------------------- */
+ static void *ak_signkey_nonce_pool_worker( void *ptr )
+{
+  struct signkey_nonce nc;
+  ak_signkey_nonce_pool pool = ptr;
+
+  for( ;; ) {
+     pthread_mutex_lock( &pool->mutex );
+     while(( pool->count == pool->capacity ) && ( !pool->stop ))
+       pthread_cond_wait( &pool->cond, &pool->mutex );
+     if( pool->stop ) {
+       pthread_mutex_unlock( &pool->mutex );
+       break;
+     }
+     pthread_mutex_unlock( &pool->mutex );
+
+    /* значения вычисляются без блокировки пула */
+     if( ak_signkey_nonce_create( &nc, pool->wc ) != ak_error_ok ) break;
+     ak_signkey_nonce_pool_push( pool, &nc );
+  }
+
+ return NULL;
+}
+#endif
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция связывает с контекстом секретного ключа пул, содержащий не более `capacity`
+    заранее вычисленных пар \f$ (k, r) \f$, где \f$ k \f$ - случайное число,
+    а \f$ r \equiv x_C \pmod{q} \f$ для точки \f$ C = [k]P \f$. Поскольку эти значения не зависят
+    ни от подписываемого сообщения, ни от значения секретного ключа, они могут быть вычислены
+    заранее, в период простоя. После этого функции ak_signkey_sign_hash(),
+    ak_signkey_sign_ptr() и ak_signkey_sign_file() извлекают из пула одну пару и вычисляют
+    подпись с помощью нескольких умножений по модулю \f$ q \f$, без вычисления кратной точки.
+    Каждая пара извлекается из пула ровно один раз и сразу же уничтожается; если пул пуст,
+    то подпись вырабатывается обычным образом. После вызова fork() пул дочернего процесса
+    очищается, а фоновый поток в нем не создается; пул может быть заполнен заново вызовом
+    функции ak_signkey_nonce_pool_fill().
+
+    Значения \f$ k \f$ хранятся в маскированном виде и вырабатываются генератором,
+    связанным с потоком, в котором выполняются вычисления (см. ak_random_thread_local()).
+
+    Если значение `background` истинно, то создается фоновый поток, заполняющий пул
+    и дополняющий его по мере извлечения значений; в противном случае пул заполняется
+    вызовами функции ak_signkey_nonce_pool_fill(). Пул уничтожается функциями
+    ak_signkey_nonce_pool_destroy() и ak_signkey_destroy().
+
+    @param sctx Контекст секретного ключа алгоритма электронной подписи.
+    @param capacity Максимальное количество пар в пуле.
+    @param background Признак заполнения пула фоновым потоком (для сборки без поддержки
+    pthread значение должно быть ложным).
+    @return В случае успеха возвращается ноль (\ref ak_error_ok). В противном случае возвращается
+    код ошибки.                                                                                    */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_signkey_nonce_pool_create( ak_signkey sctx, const size_t capacity, bool_t background )
+{
+  ak_signkey_nonce_pool pool = NULL;
+
+  if( sctx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                      "using null pointer to secret key context" );
+  if( sctx->key.data == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                 "using secret key with undefined elliptic curve" );
+  if( !capacity ) return ak_error_message( ak_error_zero_length, __func__,
+                                                            "using pool with zero capacity" );
+ #ifndef AK_HAVE_PTHREAD_H
+  if( background ) return ak_error_message( ak_error_undefined_function, __func__,
+                                             "background computations require pthread support" );
+ #endif
+  if( sctx->nonces != NULL ) ak_signkey_nonce_pool_destroy( sctx );
+
+  if(( pool = calloc( 1, sizeof( struct signkey_nonce_pool ))) == NULL )
+    return ak_error_message( ak_error_out_of_memory, __func__, "incorrect memory allocation" );
+  if(( pool->nonces = calloc( capacity, sizeof( struct signkey_nonce ))) == NULL ) {
+    free( pool );
+    return ak_error_message( ak_error_out_of_memory, __func__,
+                                                        "incorrect memory allocation for pool" );
+  }
+  pool->wc = ( ak_wcurve ) sctx->key.data;
+  pool->capacity = capacity;
+  pool->count = 0;
+  pool->stamp = ak_random_fork_stamp();
+ #ifdef AK_HAVE_PTHREAD_H
+  pool->stop = ak_false;
+  pthread_mutex_init( &pool->mutex, NULL );
+  pthread_cond_init( &pool->cond, NULL );
+  if(( pool->background = background ) == ak_true ) {
+    if( pthread_create( &pool->thread, NULL, ak_signkey_nonce_pool_worker, pool ) != 0 ) {
+      pthread_cond_destroy( &pool->cond );
+      pthread_mutex_destroy( &pool->mutex );
+      free( pool->nonces );
+      free( pool );
+      return ak_error_message( ak_error_undefined_function, __func__,
+                                                      "incorrect creation of background thread" );
+    }
+  }
+ #endif
+  sctx->nonces = pool;
+
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция вычисляет недостающие пары \f$ (k, r) \f$ и помещает их в пул, связанный с
+    контекстом секретного ключа, до его полного заполнения. Функция может вызываться
+    в любом потоке, в том числе одновременно с выработкой подписи.
+
+    @param sctx Контекст секретного ключа алгоритма электронной подписи.
+    @return В случае успеха возвращается ноль (\ref ak_error_ok). В противном случае возвращается
+    код ошибки.                                                                                    */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_signkey_nonce_pool_fill( ak_signkey sctx )
+{
+  int error = ak_error_ok;
+  struct signkey_nonce nc;
+  ak_signkey_nonce_pool pool = NULL;
+
+  if( sctx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                      "using null pointer to secret key context" );
+  if(( pool = sctx->nonces ) == NULL ) return ak_error_message( ak_error_not_ready, __func__,
+                                                        "using secret key without nonce pool" );
+  while( ak_signkey_nonce_pool_count( sctx ) < pool->capacity ) {
+     if(( error = ak_signkey_nonce_create( &nc, pool->wc )) != ak_error_ok )
+       return ak_error_message( error, __func__, "incorrect computation of nonce" );
+     if( !ak_signkey_nonce_pool_push( pool, &nc )) break;
+  }
+
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! @param sctx Контекст секретного ключа алгоритма электронной подписи.
+    @return Функция возвращает количество пар \f$ (k, r) \f$, содержащихся в пуле. Если пул
+    не связан с ключом, возвращается ноль.                                                          */
+/* ----------------------------------------------------------------------------------------------- */
+ size_t ak_signkey_nonce_pool_count( ak_signkey sctx )
+{
+  size_t count = 0;
+  ak_signkey_nonce_pool pool = NULL;
+
+  if(( sctx == NULL ) || (( pool = sctx->nonces ) == NULL )) return 0;
+  ak_signkey_nonce_pool_check_fork( pool );
+ #ifdef AK_HAVE_PTHREAD_H
+  pthread_mutex_lock( &pool->mutex );
+ #endif
+  count = pool->count;
+ #ifdef AK_HAVE_PTHREAD_H
+  pthread_mutex_unlock( &pool->mutex );
+ #endif
+ return count;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция останавливает фоновый поток (если он был создан), уничтожает все содержащиеся
+    в пуле значения и освобождает память.
+
+    @param sctx Контекст секретного ключа алгоритма электронной подписи.
+    @return В случае успеха возвращается ноль (\ref ak_error_ok). В противном случае возвращается
+    код ошибки.                                                                                    */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_signkey_nonce_pool_destroy( ak_signkey sctx )
+{
+  ak_signkey_nonce_pool pool = NULL;
+
+  if( sctx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                      "using null pointer to secret key context" );
+  if(( pool = sctx->nonces ) == NULL ) return ak_error_ok;
+
+ #ifdef AK_HAVE_PTHREAD_H
+ /* в дочернем процессе фоновый поток отсутствует */
+  ak_signkey_nonce_pool_check_fork( pool );
+  pthread_mutex_lock( &pool->mutex );
+  pool->stop = ak_true;
+  pthread_cond_signal( &pool->cond );
+  pthread_mutex_unlock( &pool->mutex );
+  if( pool->background ) pthread_join( pool->thread, NULL );
+  pthread_cond_destroy( &pool->cond );
+  pthread_mutex_destroy( &pool->mutex );
+ #endif
+  memset( pool->nonces, 0, pool->capacity*sizeof( struct signkey_nonce ));
+  free( pool->nonces );
+  memset( pool, 0, sizeof( struct signkey_nonce_pool ));
+  free( pool );
+  sctx->nonces = NULL;
+
+ return ak_error_ok;
 }
 
 /* ----------------------------------------------------------------------------------------------- */
@@ -656,6 +1047,7 @@
   size_t lb = 0;
   ak_mpzn512 k, h;
   int error = ak_error_ok;
+  struct signkey_nonce nc;
 
   if( sctx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
                                                       "using null pointer to secret key context" );
@@ -669,18 +1061,27 @@
   if( out_size < 2*lb ) return ak_error_message( ak_error_wrong_length, __func__,
                                                        "using small buffer for digital sigature" );
 
- /* вырабатываем случайное число */
-  memset( k, 0, sizeof( ak_uint64 )*ak_mpzn512_size );
-  if(( error = ak_mpzn_set_random_modulo( k, (( ak_wcurve )sctx->key.data)->q,
-                                (( ak_wcurve )sctx->key.data)->size, generator )) != ak_error_ok )
-    return ak_error_message( error, __func__ , "invalid generation of random value");
-
  /* превращаем хеш от сообщения в последовательность 64х битных слов  */
   memcpy( h, hash, sctx->ctx.data.sctx.hsize );
 #ifndef AK_LITTLE_ENDIAN
   for( i = 0; i < (( ak_wcurve )sctx->key.data)->size; i++ ) h[i] = bswap_64( h[i] );
 #endif
 
+ /* используем заранее вычисленные значения, если они есть */
+  if(( sctx->nonces != NULL ) && ak_signkey_nonce_pool_pop( sctx->nonces, &nc )) {
+    ak_wcurve wc = ( ak_wcurve )sctx->key.data;
+    ak_mpzn_mul_montgomery( nc.k, nc.k, nc.mask, wc->q, wc->nq, wc->size );
+    ak_signkey_sign_finish( sctx, nc.r, nc.k, h, out );
+    ak_ptr_wipe( &nc, sizeof( struct signkey_nonce ), &sctx->key.generator );
+    return ak_error_ok;
+  }
+
+ /* вырабатываем случайное число */
+  memset( k, 0, sizeof( ak_uint64 )*ak_mpzn512_size );
+  if(( error = ak_mpzn_set_random_modulo( k, (( ak_wcurve )sctx->key.data)->q,
+                                (( ak_wcurve )sctx->key.data)->size, generator )) != ak_error_ok )
+    return ak_error_message( error, __func__ , "invalid generation of random value");
+
  /* и только теперь вычисляем электронную подпись */
   ak_signkey_sign_const_values( sctx, k, h, out );
   ak_ptr_wipe( k, sizeof( ak_uint64 )*ak_mpzn512_size, &sctx->key.generator );
@@ -872,7 +1273,7 @@
  /* теперь определяем открытый ключ */
   ak_mpzn_mul_montgomery( k, ( ak_uint64 *)sctx->key.key, one,
                                                       pctx->wc->q, pctx->wc->nq, pctx->wc->size );
-  ak_wpoint_pow( &pctx->qpoint, &pctx->wc->point, k, pctx->wc->size, pctx->wc );
+  ak_wpoint_pow_base( &pctx->qpoint, k, pctx->wc );
 
   ak_mpzn_mul_montgomery( k, ( ak_uint64 *)( sctx->key.key + sctx->key.key_size ),
                                                   one, pctx->wc->q, pctx->wc->nq, pctx->wc->size);
@@ -894,6 +1295,213 @@
 }
 
 
+/* ----------------------------------------------------------------------------------------------- */
+/*                 кэш таблиц предвычислений для открытых ключей электронной подписи               */
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Ширина окна таблиц нечетных кратных, вычисляемых для открытых ключей. */
+ #define ak_verifykey_table_width      (7)
+/*! \brief Максимальное количество таблиц, хранящихся в кэше. */
+ #define ak_verifykey_tables_max      (64)
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Таблица предвычислений открытого ключа, совместно используемая несколькими контекстами. */
+ typedef struct verifykey_table {
+ /*! \brief таблица нечетных кратных точки (должна быть первым полем структуры) */
+  struct wpoint_table table;
+ /*! \brief номер открытого ключа, для которого вычислена таблица */
+  ak_uint8 number[32];
+ /*! \brief длина номера (в октетах) */
+  ak_uint32 number_length;
+ /*! \brief количество ссылок на таблицу (из кэша и из контекстов открытых ключей) */
+  size_t refs;
+ /*! \brief метка последнего обращения к таблице */
+  ak_uint64 stamp;
+} *ak_verifykey_table;
+
+/*! \brief Кэш таблиц предвычислений, упорядочиваемый по времени последнего использования (LRU). */
+ static ak_verifykey_table ak_verifykey_tables[ ak_verifykey_tables_max ];
+/*! \brief Количество таблиц в кэше. */
+ static size_t ak_verifykey_tables_used = 0;
+/*! \brief Счетчик обращений к кэшу. */
+ static ak_uint64 ak_verifykey_tables_stamp = 0;
+#ifdef AK_HAVE_PTHREAD_H
+/*! \brief Мьютекс, защищающий кэш и счетчики ссылок. */
+ static pthread_mutex_t ak_verifykey_tables_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Уменьшение количества ссылок на таблицу и ее удаление при отсутствии ссылок
+    (функция вызывается при заблокированном кэше). */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_verifykey_table_release( ak_verifykey_table vt )
+{
+  if( --vt->refs > 0 ) return;
+  ak_wpoint_table_destroy( &vt->table );
+  free( vt );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Проверка соответствия таблицы предвычислений номеру и значению открытого ключа. */
+/* ----------------------------------------------------------------------------------------------- */
+ static bool_t ak_verifykey_table_is_equal( ak_verifykey_table vt, ak_verifykey vk, ak_wpoint wp )
+{
+  if( vt->table.wc != vk->wc ) return ak_false;
+  if( vt->number_length != vk->number_length ) return ak_false;
+  if( memcmp( vt->number, vk->number, vk->number_length ) != 0 ) return ak_false;
+  if( ak_mpzn_cmp( vt->table.point.x, wp->x, vk->wc->size ) != 0 ) return ak_false;
+  if( ak_mpzn_cmp( vt->table.point.y, wp->y, vk->wc->size ) != 0 ) return ak_false;
+ return ak_true;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Поиск таблицы в кэше (функция вызывается при заблокированном кэше). */
+/* ----------------------------------------------------------------------------------------------- */
+ static ak_verifykey_table ak_verifykey_tables_find( ak_verifykey vk, ak_wpoint wp )
+{
+  size_t i = 0;
+  for( i = 0; i < ak_verifykey_tables_used; i++ )
+     if( ak_verifykey_table_is_equal( ak_verifykey_tables[i], vk, wp )) {
+       ak_verifykey_tables[i]->stamp = ++ak_verifykey_tables_stamp;
+       return ak_verifykey_tables[i];
+     }
+ return NULL;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Помещение таблицы в кэш с вытеснением давно не используемых таблиц
+    (функция вызывается при заблокированном кэше). */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_verifykey_tables_insert( ak_verifykey_table vt, const size_t size )
+{
+  size_t i = 0, idx = 0;
+
+ /* вытесняем таблицы, к которым дольше всего не было обращений */
+  while( ak_verifykey_tables_used > 0 && ak_verifykey_tables_used >= size ) {
+    for( i = 1, idx = 0; i < ak_verifykey_tables_used; i++ )
+       if( ak_verifykey_tables[i]->stamp < ak_verifykey_tables[idx]->stamp ) idx = i;
+    ak_verifykey_table_release( ak_verifykey_tables[idx] );
+    ak_verifykey_tables[idx] = ak_verifykey_tables[--ak_verifykey_tables_used];
+  }
+  if( size == 0 ) return;
+
+  vt->refs++;
+  vt->stamp = ++ak_verifykey_tables_stamp;
+  ak_verifykey_tables[ak_verifykey_tables_used++] = vt;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Освобождение таблицы предвычислений, связанной с контекстом открытого ключа. */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_verifykey_release_table( ak_verifykey vk )
+{
+  if( vk->table == NULL ) return;
+#ifdef AK_HAVE_PTHREAD_H
+  pthread_mutex_lock( &ak_verifykey_tables_mutex );
+#endif
+  ak_verifykey_table_release(( ak_verifykey_table ) vk->table );
+#ifdef AK_HAVE_PTHREAD_H
+  pthread_mutex_unlock( &ak_verifykey_tables_mutex );
+#endif
+  vk->table = NULL;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция связывает с контекстом открытого ключа таблицу нечетных кратных точки \f$ Q \f$,
+    используемую функцией ak_verifykey_verify_hash() для ускорения проверки подписи.
+    Вычисление таблицы требует времени, сравнимого с временем проверки одной подписи, поэтому
+    функцию следует вызывать для ключей, используемых для проверки большого количества подписей.
+
+    Вычисленные таблицы помещаются в общий для всех потоков кэш, индексируемый номером
+    открытого ключа. Если таблица для ключа с тем же номером и значением уже присутствует
+    в кэше, то она используется повторно без вычислений. Размер кэша определяется опцией
+    `verifykey_cache_size`; при заполнении кэша из него удаляются таблицы, к которым дольше
+    всего не было обращений. Таблица, связанная с контекстом ключа, остается доступной до вызова
+    функции ak_verifykey_destroy(), даже если она была удалена из кэша.
+
+    Функция автоматически вызывается для открытых ключей сертификатов, импортируемых
+    функциями ak_certificate_import_from_*(), если значение опции `verifykey_cache_size`
+    отлично от нуля.
+
+    @param vk Контекст открытого ключа, содержащий значение ключа.
+    @return В случае успеха возвращается \ref ak_error_ok. В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_verifykey_precompute( ak_verifykey vk )
+{
+  struct wpoint wp;
+  int error = ak_error_ok;
+  ak_verifykey_table vt = NULL;
+  size_t size = ( size_t )ak_libakrypt_get_option_by_name( "verifykey_cache_size" );
+
+  if( vk == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                      "using null pointer to public key context" );
+  if(( vk->wc == NULL ) || ( !( vk->flags&key_flag_set_key )))
+    return ak_error_message( ak_error_key_value, __func__,
+                                                    "using public key context with undefined key" );
+  ak_wpoint_set_wpoint( &wp, &vk->qpoint, vk->wc );
+  if( !ak_mpzn_cmp_ui( wp.z, vk->wc->size, 1 )) ak_wpoint_reduce( &wp, vk->wc );
+
+ /* таблица уже связана с ключом */
+  if( vk->table != NULL ) {
+    if( ak_verifykey_table_is_equal(( ak_verifykey_table ) vk->table, vk, &wp ))
+      return ak_error_ok;
+    ak_verifykey_release_table( vk );
+  }
+
+ /* ищем таблицу в кэше */
+#ifdef AK_HAVE_PTHREAD_H
+  pthread_mutex_lock( &ak_verifykey_tables_mutex );
+#endif
+  if(( vt = ak_verifykey_tables_find( vk, &wp )) != NULL ) vt->refs++;
+#ifdef AK_HAVE_PTHREAD_H
+  pthread_mutex_unlock( &ak_verifykey_tables_mutex );
+#endif
+  if( vt != NULL ) {
+    vk->table = &vt->table;
+    return ak_error_ok;
+  }
+
+ /* вычисляем новую таблицу */
+  if(( vt = calloc( 1, sizeof( struct verifykey_table ))) == NULL )
+    return ak_error_message( ak_error_out_of_memory, __func__,
+                                                   "incorrect memory allocation for table" );
+  if(( error = ak_wpoint_table_create( &vt->table, &wp,
+                                          ak_verifykey_table_width, vk->wc )) != ak_error_ok ) {
+    free( vt );
+    return ak_error_message( error, __func__, "incorrect creation of precomputed table" );
+  }
+  memcpy( vt->number, vk->number, vt->number_length = vk->number_length );
+  vt->refs = 1;
+
+#ifdef AK_HAVE_PTHREAD_H
+  pthread_mutex_lock( &ak_verifykey_tables_mutex );
+#endif
+  ak_verifykey_tables_insert( vt, ak_min( size, ak_verifykey_tables_max ));
+#ifdef AK_HAVE_PTHREAD_H
+  pthread_mutex_unlock( &ak_verifykey_tables_mutex );
+#endif
+  vk->table = &vt->table;
+
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция удаляет из кэша все таблицы предвычислений; таблицы, связанные с контекстами
+    открытых ключей, удаляются при уничтожении этих контекстов.                                   */
+/* ----------------------------------------------------------------------------------------------- */
+ void ak_verifykey_tables_destroy( void )
+{
+#ifdef AK_HAVE_PTHREAD_H
+  pthread_mutex_lock( &ak_verifykey_tables_mutex );
+#endif
+  while( ak_verifykey_tables_used > 0 )
+    ak_verifykey_table_release( ak_verifykey_tables[--ak_verifykey_tables_used] );
+  ak_verifykey_tables_stamp = 0;
+#ifdef AK_HAVE_PTHREAD_H
+  pthread_mutex_unlock( &ak_verifykey_tables_mutex );
+#endif
+}
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! @param pctx контекст открытого ключа алгоритма электронной подписи.
     @return В случае успеха возвращается ноль (\ref ak_error_ok). В противном случае возвращается
@@ -906,66 +1514,58 @@
                                                       "using null pointer to public key context" );
   if(( error = ak_hash_destroy( &pctx->ctx )) != ak_error_ok )
     ak_error_message( error, __func__ , "incorrect destroying hash function context" );
+  ak_verifykey_release_table( pctx );
 
   memset( pctx, 0, sizeof( struct verifykey ));
  return error;
 }
 
 /* ----------------------------------------------------------------------------------------------- */
-/*! @param pctx контекст открытого ключа.
-    @param hash хеш-код сообщения (последовательность байт), для которого проверяется электронная подпись.
-    @param hsize размер хеш-кода, в байтах.
-    @param sign электронная подпись, для которой выполняется проверка.
-    @return Функция возыращает истину, если подпись верна. Если функция не верна или если
-    возникла ошибка, то возвращается ложь. Код Ошибки может получен с помощью
-    вызова функции ak_error_get_value().                                                           */
+/*! \brief Импорт электронной подписи \f$ (r, s) \f$ и вычисление ненулевого вычета
+    \f$ e \equiv h \pmod{q} \f$ для хеш-кода \f$ h \f$.
+
+    @return В случае успеха возвращается \ref ak_error_ok. В противном случае
+    возвращается код ошибки.                                                                       */
 /* ----------------------------------------------------------------------------------------------- */
- bool_t ak_verifykey_verify_hash( ak_verifykey pctx,
-                                        const ak_pointer hash, const size_t hsize, ak_pointer sign )
+ static int ak_verifykey_import_sign( ak_verifykey pctx, const ak_pointer hash,
+                  const size_t hsize, ak_pointer sign, ak_uint64 *r, ak_uint64 *s, ak_uint64 *e )
 {
 #ifndef AK_LITTLE_ENDIAN
   int i = 0;
 #endif
-  ak_mpzn512 v, z1, z2, u, r, s, h;
-  struct wpoint cpoint, tpoint;
 
-  if( pctx == NULL ) {
-    ak_error_message( ak_error_null_pointer, __func__,
+  if( pctx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
                                                "using a null pointer to secret key context" );
-    return ak_false;
-  }
-  if( hash == NULL ) {
-    ak_error_message( ak_error_null_pointer, __func__, "using a null pointer to hash value" );
-    return ak_false;
-  }
-  if( hsize != sizeof( ak_uint64 )*(pctx->wc->size )) {
-    ak_error_message( ak_error_wrong_length, __func__, "using hash value with wrong length" );
-    return ak_false;
-  }
-  if( sign == NULL ) {
-    ak_error_message( ak_error_null_pointer, __func__, "using a null pointer to sign value" );
-    return ak_false;
-  }
-
+  if( hash == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                           "using a null pointer to hash value" );
+  if( hsize != sizeof( ak_uint64 )*(pctx->wc->size ))
+    return ak_error_message( ak_error_wrong_length, __func__, "using hash value with wrong length" );
+  if( sign == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                           "using a null pointer to sign value" );
  /* импортируем подпись */
   ak_mpzn_set_little_endian( s, pctx->wc->size, sign, sizeof(ak_uint64)*pctx->wc->size, ak_true );
   ak_mpzn_set_little_endian( r, pctx->wc->size, ( ak_uint64* )sign + pctx->wc->size,
                                                       sizeof(ak_uint64)*pctx->wc->size, ak_true );
 
-  memcpy( h, hash, sizeof( ak_uint64 )*pctx->wc->size );
+  memcpy( e, hash, sizeof( ak_uint64 )*pctx->wc->size );
 #ifndef AK_LITTLE_ENDIAN
-  for( i = 0; i < pctx->wc->size; i++ ) h[i] = bswap_64( h[i] );
+  for( i = 0; i < pctx->wc->size; i++ ) e[i] = bswap_64( e[i] );
 #endif
+  ak_wcurve_rem_q( e, e, pctx->wc );
+  if( ak_mpzn_cmp_ui( e, pctx->wc->size, 0 )) ak_mpzn_set_ui( e, pctx->wc->size, 1 );
 
-  ak_mpzn_set( v, h, pctx->wc->size );
-  ak_mpzn_rem( v, v, pctx->wc->q, pctx->wc->size );
-  if( ak_mpzn_cmp_ui( v, pctx->wc->size, 0 )) ak_mpzn_set_ui( v, pctx->wc->size, 1 );
-  ak_mpzn_mul_montgomery( v, v, pctx->wc->r2q, pctx->wc->q, pctx->wc->nq, pctx->wc->size );
+ return ak_error_ok;
+}
 
-  /* вычисляем v (в представлении Монтгомери) */
-  ak_mpzn_set_ui( u, pctx->wc->size, 2 );
-  ak_mpzn_sub( u, pctx->wc->q, u, pctx->wc->size );
-  ak_mpzn_modpow_montgomery( v, v, u, pctx->wc->q, pctx->wc->nq, pctx->wc->size ); // v <- v^{q-2} (mod q)
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Вычисление точки \f$ C = [z_1]P + [z_2]Q \f$, где \f$ z_1 \equiv sv \pmod{q} \f$,
+    \f$ z_2 \equiv -rv \pmod{q} \f$, по значению \f$ v \equiv e^{-1} \pmod{q} \f$,
+    заданному в представлении Монтгомери.                                                         */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_verifykey_verify_point( ak_verifykey pctx, ak_wpoint cpoint,
+                                                     ak_uint64 *r, ak_uint64 *s, ak_uint64 *v )
+{
+  ak_mpzn512 z1, z2;
 
   /* вычисляем z1 */
   ak_mpzn_mul_montgomery( z1, s, pctx->wc->r2q, pctx->wc->q, pctx->wc->nq, pctx->wc->size );
@@ -978,20 +1578,250 @@
   ak_mpzn_mul_montgomery( z2, z2, v, pctx->wc->q, pctx->wc->nq, pctx->wc->size );
   ak_mpzn_mul_montgomery( z2, z2, pctx->wc->point.z, pctx->wc->q, pctx->wc->nq, pctx->wc->size );
 
- /* сложение точек и проверка */
-  ak_wpoint_pow( &cpoint, &pctx->wc->point, z1, pctx->wc->size, pctx->wc );
-  ak_wpoint_pow( &tpoint, &pctx->qpoint, z2, pctx->wc->size, pctx->wc );
-  ak_wpoint_add( &cpoint, &tpoint, pctx->wc );
-  ak_wpoint_reduce( &cpoint, pctx->wc );
-  ak_mpzn_rem( cpoint.x, cpoint.x, pctx->wc->q, pctx->wc->size );
+ /* сложение точек */
+  if(( pctx->table != NULL ) && ( pctx->table->wc == pctx->wc ) &&
+     ( ak_mpzn_cmp( pctx->table->point.x, pctx->qpoint.x, pctx->wc->size ) == 0 ) &&
+     ( ak_mpzn_cmp( pctx->table->point.y, pctx->qpoint.y, pctx->wc->size ) == 0 ) &&
+     ( ak_wpoint_pow_pair_table( cpoint, z1, pctx->table, z2, pctx->wc ) == ak_error_ok )) return;
+  ak_wpoint_pow_pair( cpoint, z1, &pctx->qpoint, z2, pctx->wc );
+}
 
-  if( ak_mpzn_cmp( cpoint.x, r, pctx->wc->size )) {
-    ak_ptr_is_equal_with_log( cpoint.x, r, pctx->wc->size*sizeof( ak_uint64 ));
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Сравнение x-координаты точки \f$ C \f$, приведенной к аффинной форме, со значением
+    \f$ r \f$ электронной подписи.                                                                 */
+/* ----------------------------------------------------------------------------------------------- */
+ static bool_t ak_verifykey_verify_compare( ak_verifykey pctx, ak_wpoint cpoint, ak_uint64 *r )
+{
+  ak_mpzn_rem( cpoint->x, cpoint->x, pctx->wc->q, pctx->wc->size );
+  if( ak_mpzn_cmp( cpoint->x, r, pctx->wc->size )) {
+    ak_ptr_is_equal_with_log( cpoint->x, r, pctx->wc->size*sizeof( ak_uint64 ));
     return ak_false;
   }
  return ak_true;
 }
 
+/* ----------------------------------------------------------------------------------------------- */
+/*! @param pctx контекст открытого ключа.
+    @param hash хеш-код сообщения (последовательность байт), для которого проверяется электронная подпись.
+    @param hsize размер хеш-кода, в байтах.
+    @param sign электронная подпись, для которой выполняется проверка.
+    @return Функция возыращает истину, если подпись верна. Если функция не верна или если
+    возникла ошибка, то возвращается ложь. Код Ошибки может получен с помощью
+    вызова функции ak_error_get_value().                                                           */
+/* ----------------------------------------------------------------------------------------------- */
+ bool_t ak_verifykey_verify_hash( ak_verifykey pctx,
+                                        const ak_pointer hash, const size_t hsize, ak_pointer sign )
+{
+  ak_mpzn512 v, r, s;
+  struct wpoint cpoint;
+
+  if( ak_verifykey_import_sign( pctx, hash, hsize, sign, r, s, v ) != ak_error_ok ) return ak_false;
+
+  /* вычисляем v = h^{-1} (mod q) и переводим в представление Монтгомери */
+  ak_mpzn_inverse( v, v, pctx->wc->q, pctx->wc->size );
+  ak_mpzn_mul_montgomery( v, v, pctx->wc->r2q, pctx->wc->q, pctx->wc->nq, pctx->wc->size );
+
+ /* сложение точек и проверка */
+  ak_verifykey_verify_point( pctx, &cpoint, r, s, v );
+  ak_wpoint_reduce( &cpoint, pctx->wc );
+
+ return ak_verifykey_verify_compare( pctx, &cpoint, r );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*                             пакетная проверка электронных подписей                              */
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Максимальное количество подписей, для которых обратные элементы вычисляются совместно. */
+ #define ak_verifykey_batch_size  (32)
+
+/*! \brief Группа подписей, проверяемых на одной эллиптической кривой. */
+ typedef struct verifykey_batch_group {
+  /*! \brief Эллиптическая кривая, общая для всех подписей группы. */
+   ak_wcurve wc;
+  /*! \brief Количество подписей в группе. */
+   size_t count;
+  /*! \brief Проверяемые подписи. */
+   ak_verifykey_batch_item items[ ak_verifykey_batch_size ];
+  /*! \brief Значения \f$ r \f$ подписей. */
+   ak_mpzn512 r[ ak_verifykey_batch_size ];
+  /*! \brief Значения \f$ s \f$ подписей. */
+   ak_mpzn512 s[ ak_verifykey_batch_size ];
+  /*! \brief Вычеты \f$ e \f$, а после обращения - значения \f$ v \equiv e^{-1} \pmod{q} \f$. */
+   ak_mpzn512 v[ ak_verifykey_batch_size ];
+  /*! \brief Произведения \f$ e_0 \cdots e_i \f$. */
+   ak_mpzn512 prod[ ak_verifykey_batch_size ];
+  /*! \brief Точки \f$ C \f$, вычисляемые для каждой подписи. */
+   struct wpoint points[ ak_verifykey_batch_size ];
+ } *ak_verifykey_batch_group;
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Проверка всех подписей группы.
+
+    Обратные элементы \f$ e_i^{-1} \pmod{q} \f$ вычисляются с помощью приема Монтгомери:
+    вычисляется только один обратный элемент (произведения всех \f$ e_i \f$), а остальные
+    получаются из него с помощью умножений. Аналогично, с помощью функции ak_wpoint_reduce_many(),
+    вычисляется только один обратный элемент по модулю \f$ p \f$ при приведении точек \f$ C \f$
+    к аффинной форме.                                                                              */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_verifykey_batch_group_verify( ak_verifykey_batch_group gr )
+{
+  size_t i = 0;
+  ak_mpzn512 u, t;
+  ak_wcurve wc = gr->wc;
+
+  if( gr->count == 0 ) return;
+
+ /* переводим e_i в представление Монтгомери и накапливаем произведения */
+  for( i = 0; i < gr->count; i++ ) {
+     ak_mpzn_mul_montgomery( gr->v[i], gr->v[i], wc->r2q, wc->q, wc->nq, wc->size );
+     if( i > 0 )
+       ak_mpzn_mul_montgomery( gr->prod[i], gr->prod[i-1], gr->v[i], wc->q, wc->nq, wc->size );
+      else ak_mpzn_set( gr->prod[0], gr->v[0], wc->size );
+  }
+
+ /* вычисляем единственный обратный элемент и получаем из него v_i = e_i^{-1} */
+  ak_mpzn_inverse_montgomery( u, gr->prod[gr->count-1], wc->q, wc->nq, wc->r2q, wc->size );
+  for( i = gr->count -1; i > 0; i-- ) {
+     ak_mpzn_mul_montgomery( t, u, gr->prod[i-1], wc->q, wc->nq, wc->size );
+     ak_mpzn_mul_montgomery( u, u, gr->v[i], wc->q, wc->nq, wc->size );
+     ak_mpzn_set( gr->v[i], t, wc->size );
+  }
+  ak_mpzn_set( gr->v[0], u, wc->size );
+
+ /* вычисляем точки и приводим их к аффинной форме */
+  for( i = 0; i < gr->count; i++ )
+     ak_verifykey_verify_point( gr->items[i]->key, gr->points +i, gr->r[i], gr->s[i], gr->v[i] );
+  if( ak_wpoint_reduce_many( gr->points, gr->count, wc ) != ak_error_ok )
+    for( i = 0; i < gr->count; i++ ) ak_wpoint_reduce( gr->points +i, wc );
+
+  for( i = 0; i < gr->count; i++ )
+     gr->items[i]->result =
+                  ak_verifykey_verify_compare( gr->items[i]->key, gr->points +i, gr->r[i] );
+  gr->count = 0;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Структура, распределяющая подписи между потоками. */
+ typedef struct verifykey_batch_pool {
+  /*! \brief Массив проверяемых подписей. */
+   ak_verifykey_batch_item items;
+  /*! \brief Количество подписей. */
+   size_t count;
+  /*! \brief Индекс первой подписи, еще не переданной ни одному потоку. */
+   size_t next;
+  /*! \brief Код первой из возникших ошибок. */
+   int error;
+ #ifdef AK_HAVE_PTHREAD_H
+  /*! \brief Мьютекс, защищающий индекс следующей подписи и код ошибки. */
+   pthread_mutex_t mutex;
+ #endif
+ } *ak_verifykey_batch_pool;
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция потока, проверяющего подписи фрагментами по ak_verifykey_batch_size штук. */
+/* ----------------------------------------------------------------------------------------------- */
+ static void *ak_verifykey_batch_pool_worker( void *ptr )
+{
+  ak_verifykey_batch_pool pool = ptr;
+  struct verifykey_batch_group gr;
+
+  gr.wc = NULL;
+  gr.count = 0;
+  for( ;; ) {
+     size_t idx = 0, end = 0;
+
+    #ifdef AK_HAVE_PTHREAD_H
+     pthread_mutex_lock( &pool->mutex );
+    #endif
+     idx = pool->next;
+     pool->next = end = ak_min( idx +ak_verifykey_batch_size, pool->count );
+    #ifdef AK_HAVE_PTHREAD_H
+     pthread_mutex_unlock( &pool->mutex );
+    #endif
+     if( idx >= pool->count ) break;
+
+     for( ; idx < end; idx++ ) {
+        ak_verifykey_batch_item item = pool->items +idx;
+
+        item->result = ak_false;
+        if(( item->error = ak_verifykey_import_sign( item->key, item->hash, item->hsize,
+                    item->sign, gr.r[gr.count], gr.s[gr.count], gr.v[gr.count] )) != ak_error_ok ) {
+         #ifdef AK_HAVE_PTHREAD_H
+          pthread_mutex_lock( &pool->mutex );
+         #endif
+          if( pool->error == ak_error_ok ) pool->error = item->error;
+         #ifdef AK_HAVE_PTHREAD_H
+          pthread_mutex_unlock( &pool->mutex );
+         #endif
+          continue;
+        }
+       /* совместно обрабатываются только подписи, проверяемые на одной кривой */
+        if(( gr.count > 0 ) && ( gr.wc != item->key->wc )) {
+          size_t last = gr.count;
+          ak_verifykey_batch_group_verify( &gr );
+          ak_mpzn_set( gr.r[0], gr.r[last], item->key->wc->size );
+          ak_mpzn_set( gr.s[0], gr.s[last], item->key->wc->size );
+          ak_mpzn_set( gr.v[0], gr.v[last], item->key->wc->size );
+        }
+        gr.wc = item->key->wc;
+        gr.items[gr.count++] = item;
+     }
+     ak_verifykey_batch_group_verify( &gr );
+  }
+
+  memset( &gr, 0, sizeof( struct verifykey_batch_group ));
+ return NULL;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция проверяет `count` электронных подписей, каждая из которых задается
+    контекстом открытого ключа, хеш-кодом сообщения и значением подписи. Результат проверки
+    каждой подписи помещается в поле `result` соответствующего элемента массива, а код ошибки,
+    возникшей при ее проверке, - в поле `error`. Результаты совпадают с последовательным вызовом
+    функции ak_verifykey_verify_hash() для каждого элемента массива.
+
+    Подписи проверяются фрагментами по \ref ak_verifykey_batch_size штук; для подписей
+    фрагмента, проверяемых на одной эллиптической кривой, вычисляется только один обратный
+    элемент по модулю \f$ q \f$ и один обратный элемент по модулю \f$ p \f$ вместо двух
+    обращений для каждой подписи. Фрагменты распределяются между потоками; открытые ключи
+    могут совпадать для различных элементов массива.
+
+    \param items Указатель на массив проверяемых подписей
+    \param count Количество подписей в массиве
+    \param threads Количество потоков; если значение равно нулю, то используется
+    количество доступных процессоров (для сборки без поддержки pthread значение игнорируется).
+    \return Функция возвращает \ref ak_error_ok, если все подписи были проверены
+    (в том числе, если некоторые из них оказались неверными). В противном случае
+    возвращается код первой из возникших ошибок.                                                   */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_verifykey_verify_hash_batch( ak_verifykey_batch_item items,
+                                                            const size_t count, size_t threads )
+{
+  struct verifykey_batch_pool pool;
+
+  if( items == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                          "using null pointer to signatures array" );
+  if( !count ) return ak_error_message( ak_error_zero_length, __func__,
+                                                                "using zero count of signatures" );
+  pool.items = items;
+  pool.count = count;
+  pool.next = 0;
+  pool.error = ak_error_ok;
+
+  if( threads == 0 ) threads = ak_libakrypt_cpu_count();
+  threads = ak_min( threads, ( count +ak_verifykey_batch_size -1 )/ak_verifykey_batch_size );
+
+ #ifdef AK_HAVE_PTHREAD_H
+  pthread_mutex_init( &pool.mutex, NULL );
+ #endif
+  ak_thread_pool_run( ak_verifykey_batch_pool_worker, &pool, threads );
+ #ifdef AK_HAVE_PTHREAD_H
+  pthread_mutex_destroy( &pool.mutex );
+ #endif
+
+ return pool.error;
+}
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! @param pctx контекст открытого ключа.
     @param in область памяти для которой проверяется электронная подпись.
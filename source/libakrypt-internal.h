@@ -69,6 +69,76 @@
  int ak_mac_file( ak_mac , const char* , ak_pointer , const size_t );
 /** @} */
 
+/* ----------------------------------------------------------------------------------------------- */
+/** \addtogroup gf2n-doc Конечные поля характеристики два
+ @{ */
+/*! \brief Количество коэффициентов многочлена, обрабатываемых с одним приведением по модулю. */
+ #define ak_gf2n_horner_block            (16)
+
+/*! \brief Степени элемента конечного поля, используемые для вычисления значений многочленов. */
+ typedef struct gf2n_powers {
+  /*! \brief количество октетов, образующих один элемент конечного поля */
+   size_t count;
+  /*! \brief значения \f$ x, x^2, \ldots, x^K \f$ */
+   ak_uint64 x[ak_gf2n_horner_block][8];
+ } *ak_gf2n_powers;
+
+/*! \brief Вычисление степеней элемента конечного поля. */
+ int ak_gf2n_powers_create( ak_gf2n_powers , ak_pointer , const size_t );
+/*! \brief Очистка контекста степеней элемента конечного поля. */
+ int ak_gf2n_powers_destroy( ak_gf2n_powers );
+/*! \brief Вычисление значения многочлена над полем GF(2^256) или GF(2^512). */
+ void ak_gf2n_polynomial( ak_pointer , ak_pointer , const size_t , ak_gf2n_powers );
+/** @} */
+
+/* ----------------------------------------------------------------------------------------------- */
+/** \addtogroup curves-doc Эллиптические кривые
+ @{ */
+/*! \brief Удаление таблиц кратных точек, вычисленных для образующих точек кривых. */
+ void ak_wcurve_tables_destroy( void );
+/** @} */
+
+/* ----------------------------------------------------------------------------------------------- */
+/** \addtogroup sign-doc Электронная подпись
+ @{ */
+/*! \brief Удаление кэша таблиц предвычислений для открытых ключей. */
+ void ak_verifykey_tables_destroy( void );
+/** @} */
+
+/* ----------------------------------------------------------------------------------------------- */
+/** \addtogroup options-doc Инициализация и настройка параметров библиотеки
+ @{ */
+/*! \brief Процессор поддерживает команду pclmulqdq. */
+ #define ak_cpu_feature_pclmul            (0x01)
+/*! \brief Процессор поддерживает наборы команд BMI2 и ADX (команды mulx, adcx и adox). */
+ #define ak_cpu_feature_bmi2_adx          (0x02)
+
+/*! \brief Проверка поддержки процессором заданных наборов команд. */
+ bool_t ak_libakrypt_cpu_has( const ak_uint32 );
+/*! \brief Выбор реализаций вычислительных ядер в соответствии с возможностями процессора. */
+ int ak_libakrypt_dispatch_kernels( void );
+/*! \brief Выбор реализации умножения в конечных полях характеристики два. */
+ bool_t ak_gf2n_set_kernel( bool_t );
+/*! \brief Выбор реализации умножения Монтгомери для вычетов длины 256 и 512 бит. */
+ bool_t ak_mpzn_set_montgomery_kernel( bool_t );
+
+/*! \brief Функция, выполняемая потоком пула. */
+ typedef void *( ak_function_thread )( void * );
+/*! \brief Количество доступных процессоров. */
+ size_t ak_libakrypt_cpu_count( void );
+/*! \brief Выполнение функции заданным количеством потоков, включая вызывающий. */
+ void ak_thread_pool_run( ak_function_thread * , ak_pointer , size_t );
+/** @} */
+
+/* ----------------------------------------------------------------------------------------------- */
+/** \addtogroup random-doc Генераторы псевдо-случайных чисел
+ @{ */
+/*! \brief Уничтожение генератора, связанного с вызывающим потоком. */
+ void ak_random_thread_local_destroy( void );
+/*! \brief Метка текущего процесса, изменяющаяся после вызова fork(). */
+ ak_uint64 ak_random_fork_stamp( void );
+/** @} */
+
 /* ----------------------------------------------------------------------------------------------- */
 /** \addtogroup aead-doc Аутентифицированное шифрование данных
  @{ */
@@ -163,6 +163,10 @@ extern "C" {
  dll_export void ak_libakrypt_log_options( void );
 
 /* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция возвращает имя реализации вычислительного ядра, выбранной для используемого процессора. */
+ dll_export const char *ak_libakrypt_get_kernel( const char * );
+/*! \brief Функция устанавливает заданную реализацию вычислительного ядра. */
+ dll_export int ak_libakrypt_set_kernel( const char * , const char * );
 /*! \brief Функция устанавливает режим совместимости криптографических преобразований с библиотекой openssl. */
  dll_export int ak_libakrypt_set_openssl_compability( bool_t );
 /*! \brief Функция создает полное имя файла в домашем каталоге библиотеки. */
@@ -463,6 +467,11 @@ extern "C" {
 /*! \brief Инициализация контекста генератора, считывающего случайные значения из /dev/urandom. */
  dll_export int ak_random_create_urandom( ak_random );
 #endif
+#ifdef AK_HAVE_SYSRANDOM_H
+/*! \brief Инициализация контекста генератора, получающего случайные значения с помощью
+    системного вызова getrandom() и буферизующего их. */
+ dll_export int ak_random_create_getrandom( ak_random );
+#endif
 #ifdef _WIN32
 /*! \brief Инициализация контекста, реализующего интерфейс доступа к генератору псевдо-случайных чисел, предоставляемому ОС Windows. */
  dll_export int ak_random_create_winrtl( ak_random );
@@ -475,6 +484,29 @@ extern "C" {
  dll_export int ak_random_create_nlfsr_with_params( ak_random , size_t , ak_uint64 );
 /*! \brief Инициализация контекста генератора на основе функции хеширования согласно Р 1323565.1.006-2017. */
  dll_export int ak_random_create_hrng( ak_random );
+/*! \brief Инициализация контекста генератора на основе блочного шифра Кузнечик в режиме гаммирования
+    с буферизацией выходных значений. */
+ dll_export int ak_random_create_ctr_kuznechik( ak_random );
+/*! \brief Статистика использования генераторов, связанных с потоками выполнения. */
+ typedef struct random_thread_stat {
+  /*! \brief Количество существующих в данный момент генераторов. */
+   size_t generators;
+  /*! \brief Общее количество созданных генераторов. */
+   size_t created;
+  /*! \brief Объем выданных генераторами данных (в октетах). */
+   ak_uint64 served;
+  /*! \brief Количество повторных инициализаций значениями операционной системы. */
+   ak_uint64 reseeds;
+  /*! \brief Количество повторных инициализаций, выполненных в дочерних процессах после fork(). */
+   ak_uint64 forks;
+ } *ak_random_thread_stat;
+
+/*! \brief Получение генератора псевдо-случайных чисел, принадлежащего вызывающему потоку. */
+ dll_export ak_random ak_random_thread_local( void );
+/*! \brief Установка интервала повторной инициализации для всех генераторов, связанных с потоками. */
+ dll_export int ak_random_thread_local_set_reseed_interval( const ak_uint64 );
+/*! \brief Получение статистики использования генераторов, связанных с потоками. */
+ dll_export int ak_random_thread_local_get_stat( ak_random_thread_stat );
 /*! \brief Инициализация контекста генератора по заданному OID алгоритма генерации псевдо-случайных чисел. */
  dll_export int ak_random_create_oid( ak_random, ak_oid );
 /*! \brief Установка внутреннего состояния генератора псевдо-случайных чисел. */
@@ -990,6 +1022,14 @@ extern "C" {
 /*! \brief Функция выработки производного ключа, согласно Р 50.1.113-2016, раздел 4.4. */
  dll_export ak_pointer ak_skey_new_derive_kdf256_from_skey( ak_oid , ak_pointer ,
                                                ak_uint8* , const size_t, ak_uint8*, const size_t );
+/*! \brief Выработка нескольких производных ключей от одного исходного ключа,
+    согласно Р 50.1.113-2016, раздел 4.4. */
+ dll_export int ak_skey_derive_kdf256_multi( ak_pointer , ak_uint8 ** , const size_t * ,
+                                             ak_uint8 ** , const size_t * , ak_uint8 ** , const size_t );
+/*! \brief Выработка нескольких производных ключей от одного исходного ключа и присвоение
+    их созданным ранее контекстам секретных ключей. */
+ dll_export int ak_skey_derive_kdf256_multi_to_skey( ak_pointer , ak_uint8 ** , const size_t * ,
+                                            ak_uint8 ** , const size_t * , ak_pointer * , const size_t );
 
 /* ----------------------------------------------------------------------------------------------- */
 /*! \brief Предопределенные константы для алгоритма выработки производных ключей tlstree */
@@ -1025,6 +1065,51 @@ extern "C" {
  dll_export ak_uint8 *ak_tlstree_state_get_key( ak_tlstree_state );
 /*! \brief Функция уничтожает контекст алгоритма TLSTREE. */
  dll_export int ak_tlstree_state_destroy( ak_tlstree_state );
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Количество промежуточных ключей каждого уровня, хранящихся в кэше алгоритма TLSTREE */
+ #define ak_tlstree_cache_size (16)
+
+/*! \brief Промежуточный ключ алгоритма TLSTREE, хранящийся в кэше. */
+ typedef struct tlstree_cache_entry {
+   /*! \brief Значение индекса, для которого выработан ключ (index&C1 или index&C2) */
+    ak_uint64 index;
+   /*! \brief Момент последнего использования ключа (для вытеснения давно не использованных) */
+    ak_uint64 stamp;
+   /*! \brief Маскированное значение ключа (32 октета) и маска (32 октета) */
+    ak_uint8 key[64];
+ } *ak_tlstree_cache_entry;
+
+/*! \brief Контекст алгоритма TLSTREE, обеспечивающий выработку производного ключа
+    для произвольного номера с кэшированием промежуточных ключей первого и второго уровней. */
+ typedef struct tlstree_cache {
+   /*! \brief Маскированное значение исходного ключа (32 октета) и маска (32 октета) */
+    ak_uint8 master[64];
+   /*! \brief Промежуточные ключи первого уровня */
+    struct tlstree_cache_entry level1[ak_tlstree_cache_size];
+   /*! \brief Промежуточные ключи второго уровня */
+    struct tlstree_cache_entry level2[ak_tlstree_cache_size];
+   /*! \brief Количество занятых элементов кэша первого и второго уровней */
+    size_t count1, count2;
+   /*! \brief Счетчик обращений к кэшу */
+    ak_uint64 clock;
+   /*! \brief Количество обращений, при которых промежуточные ключи были найдены в кэше */
+    ak_uint64 hits;
+   /*! \brief Генератор, используемый для выработки масок */
+    struct random generator;
+   /*! \brief Множество предопределенных констант алгоритма выработки производных ключей */
+    tlstree_t state;
+ } *ak_tlstree_cache;
+
+/*! \brief Создание контекста алгоритма TLSTREE с кэшированием промежуточных ключей. */
+ dll_export int ak_tlstree_cache_create( ak_tlstree_cache , ak_uint8 *, const size_t , tlstree_t );
+/*! \brief Создание контекста алгоритма TLSTREE с кэшированием по заданному секретному ключу. */
+ dll_export int ak_tlstree_cache_create_from_skey( ak_tlstree_cache , ak_pointer , tlstree_t );
+/*! \brief Выработка производного ключа для произвольного номера. */
+ dll_export int ak_tlstree_cache_get_key( ak_tlstree_cache , ak_uint64 , ak_uint8 *, const size_t );
+/*! \brief Уничтожение контекста алгоритма TLSTREE с кэшированием промежуточных ключей. */
+ dll_export int ak_tlstree_cache_destroy( ak_tlstree_cache );
+
 /*! \brief Функция TLSTREE для выработки производного ключа согласно
  *  рекомендациям Р 1323565.1.030-2019, раздел 10.1.2.1. */
  dll_export int ak_skey_derive_tlstree( ak_uint8 *, const size_t , ak_uint64 , tlstree_t ,
@@ -1114,6 +1199,9 @@ extern "C" {
  dll_export size_t ak_kdf_state_get_block_size( ak_kdf_state );
 /*! \brief Функция вырабатывает следующий фрагмент ключевой информации */
  dll_export int ak_kdf_state_next( ak_kdf_state , ak_pointer , const size_t );
+/*! \brief Функция вырабатывает ключевую информацию для массива независимых контекстов */
+ dll_export int ak_kdf_state_next_many( ak_kdf_state , const size_t , ak_pointer ,
+                                                                     const size_t , size_t );
 /*! \brief Удаление контекста выработки производных ключей */
  dll_export int ak_kdf_state_destroy( ak_kdf_state );
 
@@ -1145,6 +1233,83 @@ extern "C" {
                    const ak_pointer , const size_t, const size_t , const size_t , ak_pointer );
 /** @}*/
 
+/* ----------------------------------------------------------------------------------------------- */
+/** \defgroup icode-doc Контроль целостности каталогов
+ @{ */
+/*! \brief Запись индекса контроля целостности, соответствующая одному файлу. */
+ typedef struct icode_record {
+  /*! \brief Полное имя файла. */
+   char *name;
+  /*! \brief Размер файла в октетах. */
+   ak_uint64 size;
+  /*! \brief Время последней модификации файла (в наносекундах, если доступно). */
+   ak_int64 mtime;
+  /*! \brief Номер индексного дескриптора файла. */
+   ak_uint64 inode;
+  /*! \brief Хеш-код содержимого файла. */
+   ak_uint8 tag[64];
+ } *ak_icode_record;
+
+/*! \brief Индекс контроля целостности: набор записей, упорядоченных по именам файлов. */
+ typedef struct icode_index {
+  /*! \brief Идентификатор функции хеширования. */
+   ak_oid oid;
+  /*! \brief Длина хеш-кода в октетах. */
+   size_t tag_size;
+  /*! \brief Количество записей. */
+   size_t count;
+  /*! \brief Массив записей. */
+   struct icode_record *records;
+ } *ak_icode_index;
+
+/*! \brief Статистика, собранная при проверке каталога. */
+ typedef struct icode_stat {
+  /*! \brief Общее количество найденных файлов. */
+   size_t total;
+  /*! \brief Количество файлов, для которых вычислялся хеш-код. */
+   size_t hashed;
+  /*! \brief Количество файлов, пропущенных из-за совпадения метаданных. */
+   size_t skipped;
+  /*! \brief Количество новых файлов. */
+   size_t added;
+  /*! \brief Количество файлов, содержимое которых изменилось. */
+   size_t changed;
+  /*! \brief Количество файлов, отсутствующих в каталоге, но присутствующих в индексе. */
+   size_t removed;
+  /*! \brief Количество файлов, которые не удалось прочесть. */
+   size_t failed;
+ } *ak_icode_stat;
+
+/*! \brief События, о которых сообщается при проверке каталога. */
+ typedef enum {
+  /*! \brief Файл отсутствует в индексе. */
+   icode_added,
+  /*! \brief Хеш-код файла изменился. */
+   icode_changed,
+  /*! \brief Файл, присутствующий в индексе, не найден. */
+   icode_removed,
+  /*! \brief Ошибка чтения файла. */
+   icode_failed
+ } icode_event_t;
+
+/*! \brief Функция, вызываемая для каждого файла, целостность которого нарушена. */
+ typedef int ( ak_function_icode_report )( const char * , icode_event_t , ak_pointer );
+
+/*! \brief Создание пустого индекса контроля целостности. */
+ dll_export int ak_icode_index_create( ak_icode_index , ak_oid );
+/*! \brief Создание индекса контроля целостности и считывание его из файла. */
+ dll_export int ak_icode_index_create_from_file( ak_icode_index , const char * );
+/*! \brief Уничтожение индекса контроля целостности. */
+ dll_export int ak_icode_index_destroy( ak_icode_index );
+/*! \brief Сохранение индекса контроля целостности в файл. */
+ dll_export int ak_icode_index_save( ak_icode_index , const char * );
+/*! \brief Поиск записи для заданного файла. */
+ dll_export ak_icode_record ak_icode_index_find( ak_icode_index , const char * );
+/*! \brief Проверка каталога и обновление индекса контроля целостности. */
+ dll_export int ak_icode_index_scan( ak_icode_index , const char * , const char * , bool_t ,
+                       size_t , bool_t , ak_icode_stat , ak_function_icode_report * , ak_pointer );
+/** @}*/
+
 /* ----------------------------------------------------------------------------------------------- */
 /** \defgroup aead-doc Аутентифицированное шифрование данных
  @{ */
@@ -1384,6 +1549,8 @@ extern "C" {
  dll_export void ak_mpzn_mul( ak_uint64 *, ak_uint64 *, ak_uint64 *, const size_t );
 /*! \brief Вычисление остатка от деления одного вычета на другой */
  dll_export void ak_mpzn_rem( ak_uint64 *, ak_uint64 *, ak_uint64 *, const size_t );
+/*! \brief Вычисление остатка от деления вычета двойной длины на модуль с помощью редукции Барретта */
+ dll_export void ak_mpzn_rem_barrett( ak_uint64 *, ak_uint64 *, ak_uint64 *, ak_uint64 *, const size_t );
 /*! \brief Вычисление остатка от деления вычета на одноразрядное число */
  dll_export ak_uint32 ak_mpzn_rem_uint32( ak_uint64 *, const size_t , ak_uint32 );
 
@@ -1396,9 +1563,17 @@ extern "C" {
 /*! \brief Умножение двух вычетов в представлении Монтгомери. */
  dll_export void ak_mpzn_mul_montgomery( ak_uint64 *, ak_uint64 *, ak_uint64 *,
                                                            ak_uint64 *, ak_uint64, const size_t );
+/*! \brief Возведение в квадрат вычета в представлении Монтгомери. */
+ dll_export void ak_mpzn_sqr_montgomery( ak_uint64 *, ak_uint64 *,
+                                                           ak_uint64 *, ak_uint64, const size_t );
 /*! \brief Модульное возведение в степень в представлении Монтгомери. */
  dll_export void ak_mpzn_modpow_montgomery( ak_uint64 *, ak_uint64 *, ak_uint64 *,
                                                            ak_uint64 *, ak_uint64, const size_t );
+/*! \brief Обращение вычета в постоянное время. */
+ dll_export void ak_mpzn_inverse( ak_uint64 *, ak_uint64 *, ak_uint64 *, const size_t );
+/*! \brief Обращение вычета в представлении Монтгомери в постоянное время. */
+ dll_export void ak_mpzn_inverse_montgomery( ak_uint64 *, ak_uint64 *, ak_uint64 *,
+                                                ak_uint64, ak_uint64 *, const size_t );
 /* ----------------------------------------------------------------------------------------------- */
 #ifdef AK_HAVE_GMP_H
 /*! \brief Преобразование ak_mpznxxx в mpz_t. */
@@ -1415,6 +1590,34 @@ extern "C" {
 /*! \brief Контекст эллиптической кривой, заданной в короткой форме Вейерштрасса. */
  typedef struct wcurve *ak_wcurve;
 
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Вид эллиптической кривой, определяющий используемые формулы удвоения точек. */
+ typedef enum {
+  /*! \brief Произвольное значение коэффициента \f$ a \f$. */
+   wcurve_a_generic,
+  /*! \brief Коэффициент \f$ a \f$ удовлетворяет сравнению \f$ a \equiv -3 \pmod{p} \f$. */
+   wcurve_a_minus_three
+} wcurve_variant_t;
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Параметры скрученной кривой Эдвардса, бирационально эквивалентной кривой,
+    заданной в короткой форме Вейерштрасса.
+
+    Кривая задается уравнением \f$ u^2 + v^2 \equiv 1 + du^2v^2 \pmod{p} \f$, т.е. коэффициент
+    \f$ e \f$ из рекомендаций Р 50.1.114-2016 равен единице. Переход к координатам кривой
+    в форме Вейерштрасса выполняется с помощью величин \f$ s = (1-d)/4 \f$ и \f$ t = (1+d)/6 \f$:
+    \f$ x = s(1+v)/(1-v) + t \f$, \f$ y = s(1+v)/((1-v)u) \f$.                                   */
+/* ----------------------------------------------------------------------------------------------- */
+ struct ecurve
+{
+ /*! \brief Коэффициент \f$ d \f$ кривой (в представлении Монтгомери). */
+  ak_uint64 d[ak_mpzn512_size];
+ /*! \brief Величина \f$ s = (1-d)/4 \f$ (в представлении Монтгомери). */
+  ak_uint64 s[ak_mpzn512_size];
+ /*! \brief Величина \f$ t = (1+d)/6 \f$ (в представлении Монтгомери). */
+  ak_uint64 t[ak_mpzn512_size];
+};
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! \brief Класс, реализующий точку эллиптической кривой.
 
@@ -1455,8 +1658,43 @@ extern "C" {
  dll_export void ak_wpoint_add( ak_wpoint , ak_wpoint , ak_wcurve );
 /*! \brief Приведение проективной точки к аффинному виду. */
  dll_export void ak_wpoint_reduce( ak_wpoint , ak_wcurve );
+/*! \brief Приведение массива проективных точек к аффинному виду. */
+ dll_export int ak_wpoint_reduce_many( ak_wpoint , const size_t , ak_wcurve );
 /*! \brief Вычисление кратной точки эллиптической кривой. */
  dll_export void ak_wpoint_pow( ak_wpoint , ak_wpoint , ak_uint64 *, size_t , ak_wcurve );
+/*! \brief Вычисление кратной точки для образующей точки эллиптической кривой
+    с использованием таблицы предвычислений. */
+ dll_export void ak_wpoint_pow_base( ak_wpoint , ak_uint64 *, ak_wcurve );
+/*! \brief Вычисление суммы кратных образующей и произвольной точек эллиптической кривой
+    (метод Штрауса с wNAF представлениями степеней). */
+ dll_export void ak_wpoint_pow_pair( ak_wpoint , ak_uint64 *, ak_wpoint , ak_uint64 *, ak_wcurve );
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Таблица нечетных кратных точки эллиптической кривой.
+
+    Таблица содержит точки \f$ [1]Q, [3]Q, \ldots, [2^{w-1}-1]Q \f$ в аффинных координатах
+    и используется для вычисления суммы кратных точек в случае, когда точка \f$ Q \f$
+    (например, открытый ключ проверки электронной подписи) используется многократно.            */
+/* ----------------------------------------------------------------------------------------------- */
+ typedef struct wpoint_table {
+ /*! \brief эллиптическая кривая, для которой вычислена таблица */
+  ak_wcurve wc;
+ /*! \brief ширина окна wNAF представления */
+  size_t width;
+ /*! \brief точка \f$ Q \f$ в аффинной форме */
+  struct wpoint point;
+ /*! \brief координаты нечетных кратных точки \f$ Q \f$ */
+  ak_uint64 *data;
+} *ak_wpoint_table;
+
+/*! \brief Вычисление таблицы нечетных кратных точки эллиптической кривой. */
+ dll_export int ak_wpoint_table_create( ak_wpoint_table , ak_wpoint , const size_t , ak_wcurve );
+/*! \brief Уничтожение таблицы нечетных кратных точки эллиптической кривой. */
+ dll_export int ak_wpoint_table_destroy( ak_wpoint_table );
+/*! \brief Вычисление суммы кратных образующей и произвольной точек эллиптической кривой
+    с использованием таблицы нечетных кратных второй точки. */
+ dll_export int ak_wpoint_pow_pair_table( ak_wpoint , ak_uint64 *, ak_wpoint_table ,
+                                                                        ak_uint64 *, ak_wcurve );
 
 /* ----------------------------------------------------------------------------------------------- */
 /*! \brief Класс, реализующий эллиптическую кривую, заданную в короткой форме Вейерштрасса
@@ -1480,6 +1718,12 @@ extern "C" {
   ak_uint32 size;
  /*! \brief Кофактор эллиптической кривой - делитель порядка группы точек. */
   ak_uint32 cofactor;
+ /*! \brief Вид кривой, определяемый значением коэффициента \f$ a \f$. */
+  wcurve_variant_t variant;
+ /*! \brief Параметры эквивалентной скрученной кривой Эдвардса или NULL, если кривая
+     не имеет формы Эдвардса. При наличии параметров кратные точки вычисляются
+     в расширенных координатах кривой Эдвардса. */
+  struct ecurve *edwards;
  /*! \brief Коэффициент \f$ a \f$ эллиптической кривой (в представлении Монтгомери) */
   ak_uint64 a[ak_mpzn512_size];
  /*! \brief Коэффициент \f$ b \f$ эллиптической кривой (в представлении Монтгомери). */
@@ -1488,10 +1732,16 @@ extern "C" {
   ak_uint64 p[ak_mpzn512_size];
  /*! \brief Величина \f$ r^2\f$, взятая по модулю \f$ p \f$ и используемая в арифметике Монтгомери. */
   ak_uint64 r2[ak_mpzn512_size];
+ /*! \brief Величина \f$ \mu = \lfloor 2^{128\cdot size}/p \rfloor \f$, используемая
+     при редукции Барретта по модулю \f$ p \f$. */
+  ak_uint64 mu[ak_mpzn512_size+1];
  /*! \brief Порядок \f$ q \f$ подгруппы, порождаемой образующей точкой \f$ P \f$. */
   ak_uint64 q[ak_mpzn512_size];
  /*! \brief Величина \f$ r^2\f$, взятая по модулю \f$ q \f$ и используемая в арифметике Монтгомери. */
   ak_uint64 r2q[ak_mpzn512_size];
+ /*! \brief Величина \f$ \mu_q = \lfloor 2^{128\cdot size}/q \rfloor \f$, используемая
+     при редукции Барретта по модулю \f$ q \f$. */
+  ak_uint64 muq[ak_mpzn512_size+1];
  /*! \brief Точка \f$ P \f$ эллиптической кривой, порождающая подгруппу порядка \f$ q \f$. */
   struct wpoint point;
  /*! \brief Константа \f$ n \f$, используемая в арифметике Монтгомери по модулю \f$ p \f$. */
@@ -1575,18 +1825,19 @@ extern "C" {
 /*! \brief Умножение двух элементов поля \f$ \mathbb F_{2^{512}}\f$. */
  dll_export void ak_gf512_mul_pcmulqdq( ak_pointer z, ak_pointer a, ak_pointer b );
 
- #define ak_gf64_mul ak_gf64_mul_pcmulqdq
- #define ak_gf128_mul ak_gf128_mul_pcmulqdq
- #define ak_gf256_mul ak_gf256_mul_pcmulqdq
- #define ak_gf512_mul ak_gf512_mul_pcmulqdq
-#else
-
- #define ak_gf64_mul ak_gf64_mul_uint64
- #define ak_gf128_mul ak_gf128_mul_uint64
- #define ak_gf256_mul ak_gf256_mul_uint64
- #define ak_gf512_mul ak_gf512_mul_uint64
 #endif
 
+/*! \brief Функция умножения двух элементов конечного поля характеристики два. */
+ typedef void ( ak_function_gf_mul )( ak_pointer , ak_pointer , ak_pointer );
+/*! \brief Умножение в поле \f$ \mathbb F_{2^{64}}\f$ (реализация выбирается при инициализации библиотеки). */
+ dll_export extern ak_function_gf_mul *ak_gf64_mul;
+/*! \brief Умножение в поле \f$ \mathbb F_{2^{128}}\f$ (реализация выбирается при инициализации библиотеки). */
+ dll_export extern ak_function_gf_mul *ak_gf128_mul;
+/*! \brief Умножение в поле \f$ \mathbb F_{2^{256}}\f$ (реализация выбирается при инициализации библиотеки). */
+ dll_export extern ak_function_gf_mul *ak_gf256_mul;
+/*! \brief Умножение в поле \f$ \mathbb F_{2^{512}}\f$ (реализация выбирается при инициализации библиотеки). */
+ dll_export extern ak_function_gf_mul *ak_gf512_mul;
+
 /* Размеры конечных полей (в октетах) */
 /*! \brief Размер поля \f$ \mathbb F_{2^{64}}\f$ в байтах. */
  #define ak_galois64_size               (8)
@@ -1967,6 +2218,9 @@ extern "C" {
   struct hash ctx;
  /*! \brief номер открытого ключа, выработанного из данного секретного ключа. */
   ak_uint8 verifykey_number[32];
+ /*! \brief пул заранее вычисленных значений, используемых при выработке подписи
+     (см. ak_signkey_nonce_pool_create()) */
+  ak_pointer nonces;
 } *ak_signkey;
 
 /* ----------------------------------------------------------------------------------------------- */
@@ -2005,6 +2259,15 @@ extern "C" {
  dll_export int ak_signkey_set_key( ak_signkey , const ak_pointer , const size_t );
 /*! \brief Присвоение секретному ключу электронной подписи случайного значения. */
  dll_export int ak_signkey_set_key_random( ak_signkey , ak_random );
+/*! \brief Создание пула заранее вычисленных значений \f$ (k, r) \f$, используемых
+    при выработке электронной подписи. */
+ dll_export int ak_signkey_nonce_pool_create( ak_signkey , const size_t , bool_t );
+/*! \brief Заполнение пула заранее вычисленных значений. */
+ dll_export int ak_signkey_nonce_pool_fill( ak_signkey );
+/*! \brief Количество значений, содержащихся в пуле. */
+ dll_export size_t ak_signkey_nonce_pool_count( ak_signkey );
+/*! \brief Уничтожение пула заранее вычисленных значений. */
+ dll_export int ak_signkey_nonce_pool_destroy( ak_signkey );
 /** @}*/
 
 /* ----------------------------------------------------------------------------------------------- */
@@ -2044,6 +2307,9 @@ extern "C" {
   struct wpoint qpoint;
  /*! \brief флаги состояния ключа */
   ak_uint64 flags;
+ /*! \brief таблица нечетных кратных точки qpoint, используемая при проверке подписи
+     (может совместно использоваться несколькими контекстами одного и того же ключа) */
+  ak_wpoint_table table;
 } *ak_verifykey;
 
 /* ----------------------------------------------------------------------------------------------- */
@@ -2061,6 +2327,9 @@ extern "C" {
  dll_export int ak_verifykey_create_from_signkey( ak_verifykey , ak_signkey );
 /*! \brief Функция вырабатывает номер открытого ключа. */
  dll_export int ak_verifykey_set_number( ak_verifykey );
+/*! \brief Вычисление (или получение из кэша) таблицы предвычислений для многократной
+    проверки электронной подписи. */
+ dll_export int ak_verifykey_precompute( ak_verifykey );
 /*! \brief Уничтожение контекста открытого ключа. */
  dll_export int ak_verifykey_destroy( ak_verifykey );
 /** @}*/
@@ -2090,6 +2359,26 @@ extern "C" {
 /*! \brief Проверка электронной подписи для заданного файла. */
  dll_export bool_t ak_verifykey_verify_file( ak_verifykey , const char * , ak_pointer );
 
+/*! \brief Электронная подпись, проверяемая функцией ak_verifykey_verify_hash_batch(). */
+ typedef struct verifykey_batch_item {
+  /*! \brief Контекст открытого ключа. */
+   ak_verifykey key;
+  /*! \brief Хеш-код сообщения, для которого проверяется подпись. */
+   ak_pointer hash;
+  /*! \brief Размер хеш-кода (в октетах). */
+   size_t hsize;
+  /*! \brief Проверяемая электронная подпись. */
+   ak_pointer sign;
+  /*! \brief Результат проверки: истина, если подпись верна. */
+   bool_t result;
+  /*! \brief Код ошибки, возникшей при проверке подписи. */
+   int error;
+ } *ak_verifykey_batch_item;
+
+/*! \brief Проверка массива электронных подписей с совместным вычислением обратных элементов
+    и распределением вычислений между потоками. */
+ dll_export int ak_verifykey_verify_hash_batch( ak_verifykey_batch_item , const size_t , size_t );
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! \brief Параметры запроса на сертификат открытого ключа */
  typedef struct request_opts {
@@ -2384,8 +2673,18 @@ extern "C" {
     /*! \brief секретный ключ клиента, представляющий собой вектор-строку */
      blom_abonent_key
    } type;
+  /*! \brief кэш ключей парной связи (если кэш не создан, то значение равно NULL) */
+   ak_pointer cache;
  } *ak_blomkey;
 
+/*! \brief Правило вытеснения элементов из кэша ключей парной связи. */
+ typedef enum {
+  /*! \brief вытесняется ключ, к которому дольше всего не было обращений */
+   blom_cache_lru,
+  /*! \brief вытесняется ключ, раньше всех помещенный в кэш */
+   blom_cache_fifo
+ } blom_cache_t;
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! \brief Функция создает мастер-ключ для схемы Блома. */
  dll_export int ak_blomkey_create_matrix( ak_blomkey , const ak_uint32 ,
@@ -2393,12 +2692,42 @@ extern "C" {
 /*! \brief Функция создает ключ абонента для схемы Блома. */
  dll_export int ak_blomkey_create_abonent_key( ak_blomkey , ak_blomkey ,
                                                                        ak_pointer , const size_t );
+/*! \brief Ключ абонента, вырабатываемый функцией ak_blomkey_create_abonent_keys(). */
+ typedef struct blomkey_batch_item {
+  /*! \brief Идентификатор абонента. */
+   ak_pointer id;
+  /*! \brief Длина идентификатора (в октетах). */
+   size_t idsize;
+  /*! \brief Контекст, в который помещается ключ абонента (может быть равен NULL). */
+   ak_blomkey key;
+  /*! \brief Пароль, используемый для экспорта ключа. */
+   const char *password;
+  /*! \brief Длина пароля (в октетах). */
+   size_t pass_size;
+  /*! \brief Имя файла, в который экспортируется ключ (если NULL, то экспорт не выполняется). */
+   char *filename;
+  /*! \brief Размер области памяти для имени файла (ноль для константной строки). */
+   size_t fsize;
+  /*! \brief Код ошибки, возникшей при выработке или экспорте ключа. */
+   int error;
+ } *ak_blomkey_batch_item;
+
+/*! \brief Функция создает ключи для массива абонентов с распределением вычислений
+    и экспорта ключей между потоками. */
+ dll_export int ak_blomkey_create_abonent_keys( ak_blomkey , ak_blomkey_batch_item ,
+                                                                     const size_t , size_t );
 /*! \brief Функция создает ключ парной связи (в виде последовательности октетов) */
  dll_export int ak_blomkey_create_pairwise_key_as_ptr( ak_blomkey ,
                                                  ak_pointer , const size_t , ak_pointer , size_t );
 /*! \brief Функция создает ключ парной связи и помещает его в контекст секретного ключа */
  dll_export ak_pointer ak_blomkey_new_pairwise_key( ak_blomkey , ak_pointer ,
                                                                            const size_t , ak_oid );
+/*! \brief Создание кэша ключей парной связи для ключа абонента */
+ dll_export int ak_blomkey_cache_create( ak_blomkey , const size_t , const blom_cache_t );
+/*! \brief Получение количества ключей в кэше и количества успешных и неуспешных обращений */
+ dll_export int ak_blomkey_cache_get_stat( ak_blomkey , size_t * , size_t * , size_t * );
+/*! \brief Уничтожение кэша ключей парной связи */
+ dll_export int ak_blomkey_cache_destroy( ak_blomkey );
 /*! \brief Функция возвращает элемент ключа с заданным индексом */
  dll_export ak_uint8 *ak_blomkey_get_element_by_index( ak_blomkey ,
                                                                const ak_uint32 , const ak_uint32 );